@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef _BENCHCOMMON_H
+#define _BENCHCOMMON_H
+
+#include "Platform/Define.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+ * Helpers of the contrib micro-benchmarks: the seeded generator replaying the same
+ * workload for every compared run, the stopwatch, the checksum of the results, the
+ * command line and the final comparison.
+ */
+
+// xorshift, same sequence for every run with the same seed
+class BenchRandom
+{
+    public:
+        explicit BenchRandom(uint32 seed) : m_state(seed * 2654435761ULL + 1) {}
+
+        uint64 Next64()
+        {
+            m_state ^= m_state << 13;
+            m_state ^= m_state >> 7;
+            m_state ^= m_state << 17;
+            return m_state;
+        }
+
+        uint32 Next(uint32 range) { return uint32(Next64() % range); }
+        float NextFloat(float range) { return float(Next(1 << 20)) * range / float(1 << 20); }
+        double NextNorm() { return double(Next64() >> 11) / double(1ULL << 53); }     // [0, 1)
+        double NextChance() { return NextNorm() * 100.0; }
+
+    private:
+        uint64 m_state;
+};
+
+class BenchClock
+{
+    public:
+        BenchClock() : m_start(std::chrono::steady_clock::now()) {}
+
+        double Elapsed() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count(); }
+
+    private:
+        std::chrono::steady_clock::time_point m_start;
+};
+
+// FNV-1a over the values, the order of the values matters
+#define BENCH_CHECKSUM_SEED 14695981039346656037ULL
+
+inline uint64 BenchChecksum(uint64 checksum, uint64 value) { return (checksum ^ value) * 1099511628211ULL; }
+
+// "-<flag> <number>" option, the value holds the default
+struct BenchOption
+{
+    char flag;
+    uint32* value;
+    uint32 min;
+    char const* help;
+};
+
+template<size_t N>
+void BenchUsage(char const* prog, BenchOption const (&options)[N], uint32 const* defaults = NULL)
+{
+    printf("Usage: %s [options]\n", prog);
+    for (size_t i = 0; i < N; ++i)
+        printf("    -%c  %s (default %u)\n", options[i].flag, options[i].help, defaults ? defaults[i] : *options[i].value);
+}
+
+// false after printing the usage on -h, an unknown option or a value below its minimum
+template<size_t N>
+bool BenchParseOptions(int argc, char** argv, BenchOption const (&options)[N])
+{
+    std::string optstring;
+    std::vector<uint32> defaults;
+    for (size_t i = 0; i < N; ++i)
+    {
+        optstring += options[i].flag;
+        optstring += ':';
+        defaults.push_back(*options[i].value);
+    }
+    optstring += 'h';
+
+    int c;
+    while ((c = getopt(argc, argv, optstring.c_str())) != -1)
+    {
+        size_t i = 0;
+        while (i < N && options[i].flag != c)
+            ++i;
+
+        if (i == N)
+        {
+            BenchUsage(argv[0], options, &defaults[0]);
+            return false;
+        }
+
+        *options[i].value = atoi(optarg);
+    }
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (*options[i].value < options[i].min)
+        {
+            BenchUsage(argv[0], options, &defaults[0]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// exit code of the benchmark: the compared runs must agree, then the former time over the new one
+inline int BenchReport(bool match, char const* mismatch, double before, double after)
+{
+    if (!match)
+    {
+        printf("MISMATCH, %s\n", mismatch);
+        return 1;
+    }
+
+    printf("speedup x%.2f\n", before / after);
+    return 0;
+}
+
+#endif
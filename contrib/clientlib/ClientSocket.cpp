@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include "ClientSocket.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define CLIENTSOCKET_INPUT_SIZE 16384
+
+ClientSocket::ClientSocket() :
+    _fd(-1), _connecting(false),
+    _inBuffer(CLIENTSOCKET_INPUT_SIZE), _inLength(0),
+    _outPos(0), _bytesSent(0), _bytesReceived(0)
+{
+}
+
+ClientSocket::~ClientSocket()
+{
+    if (_fd != -1)
+        close(_fd);
+}
+
+bool ClientSocket::Connect(std::string const& host, uint16 port)
+{
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* res = NULL;
+    if (getaddrinfo(host.c_str(), NULL, &hints, &res) != 0 || !res)
+        return false;
+
+    sockaddr_in addr = *((sockaddr_in*)res->ai_addr);
+    addr.sin_port = htons(port);
+    freeaddrinfo(res);
+
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd == -1)
+        return false;
+
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    int nodelay = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    if (connect(_fd, (sockaddr*)&addr, sizeof(addr)) == -1 && errno != EINPROGRESS)
+    {
+        close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    _connecting = true;
+    return true;
+}
+
+void ClientSocket::Close()
+{
+    if (_fd == -1)
+        return;
+
+    close(_fd);
+    _fd = -1;
+    _connecting = false;
+
+    OnClose();
+}
+
+void ClientSocket::Send(uint8 const* data, size_t len)
+{
+    if (_outPos && _outPos == _outBuffer.size())
+    {
+        _outBuffer.clear();
+        _outPos = 0;
+    }
+
+    _outBuffer.insert(_outBuffer.end(), data, data + len);
+}
+
+void ClientSocket::ReserveInput(size_t size)
+{
+    if (_inBuffer.size() < size)
+        _inBuffer.resize(size);
+}
+
+bool ClientSocket::HandleOutput()
+{
+    if (_fd == -1)
+        return false;
+
+    if (_connecting)
+    {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1 || error)
+        {
+            Close();
+            return false;
+        }
+
+        _connecting = false;
+        OnConnect();
+
+        if (_fd == -1)
+            return false;
+    }
+
+    while (_outPos < _outBuffer.size())
+    {
+        ssize_t n = send(_fd, &_outBuffer[_outPos], _outBuffer.size() - _outPos, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+
+            Close();
+            return false;
+        }
+
+        _outPos += n;
+        _bytesSent += n;
+    }
+
+    _outBuffer.clear();
+    _outPos = 0;
+    return true;
+}
+
+bool ClientSocket::HandleInput()
+{
+    if (_fd == -1 || _connecting)
+        return _fd != -1;
+
+    for (;;)
+    {
+        if (_inLength == _inBuffer.size())
+            _inBuffer.resize(_inBuffer.size() * 2);
+
+        ssize_t n = recv(_fd, &_inBuffer[_inLength], _inBuffer.size() - _inLength, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            Close();
+            return false;
+        }
+
+        if (n < 0)
+            return true;
+
+        _inLength += n;
+        _bytesReceived += n;
+
+        size_t consumed = OnRead(&_inBuffer[0], _inLength);
+        if (_fd == -1)
+            return false;
+
+        // keep the incomplete message at the front
+        if (consumed)
+        {
+            memmove(&_inBuffer[0], &_inBuffer[consumed], _inLength - consumed);
+            _inLength -= consumed;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef TRINITY_CLIENTSOCKET_H
+#define TRINITY_CLIENTSOCKET_H
+
+#include "Common.h"
+
+#include <vector>
+
+/**
+ * Non blocking TCP connection of the test clients.
+ *
+ * The socket is driven by the poll loop of the tool: HandleInput and
+ * HandleOutput are called when the handle is readable or writable.
+ * Received data is handed to OnRead, which consumes complete messages
+ * and leaves the rest in the buffer. Send appends to the output buffer,
+ * written when the socket is writable.
+ */
+class ClientSocket
+{
+    public:
+        ClientSocket();
+        virtual ~ClientSocket();
+
+        /// Start the connection, false if it failed immediately.
+        bool Connect(std::string const& host, uint16 port);
+        void Close();
+
+        int GetHandle() const { return _fd; }
+        bool IsConnecting() const { return _connecting; }
+        bool IsClosed() const { return _fd == -1; }
+        /// True if the poll loop has to wait for the socket to be writable.
+        bool WantWrite() const { return _connecting || _outPos < _outBuffer.size(); }
+
+        /// Called by the poll loop, false when the connection is lost.
+        bool HandleInput();
+        bool HandleOutput();
+
+        uint64 GetBytesSent() const { return _bytesSent; }
+        uint64 GetBytesReceived() const { return _bytesReceived; }
+
+    protected:
+        /// Append data to the output buffer.
+        void Send(uint8 const* data, size_t len);
+        /// Make room for a message of size bytes in the input buffer.
+        void ReserveInput(size_t size);
+
+        /// Connection established.
+        virtual void OnConnect() {}
+        /// Handle received data, returns the number of bytes consumed.
+        virtual size_t OnRead(uint8* data, size_t len) = 0;
+        /// Connection lost or closed.
+        virtual void OnClose() {}
+
+    private:
+        ClientSocket(ClientSocket const&);
+        ClientSocket& operator=(ClientSocket const&);
+
+        int _fd;
+        bool _connecting;
+
+        std::vector<uint8> _inBuffer;
+        size_t _inLength;
+
+        std::vector<uint8> _outBuffer;
+        size_t _outPos;
+
+        uint64 _bytesSent;
+        uint64 _bytesReceived;
+};
+
+#endif
@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include "RealmClient.h"
+#include "ByteBuffer.h"
+#include "Auth/Sha1.h"
+
+#include <algorithm>
+#include <ctype.h>
+
+// realmd commands, see AuthSocket.cpp
+#define REALMCLIENT_LOGON_CHALLENGE     0x00
+#define REALMCLIENT_LOGON_PROOF         0x01
+#define REALMCLIENT_REALM_LIST          0x10
+
+/// Client build sent in the logon challenge
+#define REALMCLIENT_BUILD               8606
+
+/// Size of a successful logon challenge answer (B, g, N, s, unk3, security flags)
+#define REALMCLIENT_CHALLENGE_SIZE      (3 + 32 + 1 + 1 + 1 + 32 + 32 + 16 + 1)
+/// Size of a successful logon proof answer (sAuthLogonProof_S)
+#define REALMCLIENT_PROOF_SIZE          (1 + 1 + 20 + 4 + 4 + 2)
+
+RealmClient::RealmClient() : _state(REALMCLIENT_CHALLENGE), _error(0)
+{
+}
+
+bool RealmClient::Connect(std::string const& host, uint16 port, std::string const& account, std::string const& password)
+{
+    _account = account;
+    _password = password;
+    std::transform(_account.begin(), _account.end(), _account.begin(), ::toupper);
+    std::transform(_password.begin(), _password.end(), _password.begin(), ::toupper);
+
+    _state = REALMCLIENT_CHALLENGE;
+    _error = 0;
+
+    return ClientSocket::Connect(host, port);
+}
+
+void RealmClient::OnConnect()
+{
+    ByteBuffer pkt;
+    pkt << uint8(REALMCLIENT_LOGON_CHALLENGE);
+    pkt << uint8(3);
+    pkt << uint16(30 + _account.size());
+    pkt.append((uint8 const*)"WoW", 4);
+    pkt << uint8(2) << uint8(4) << uint8(3);
+    pkt << uint16(REALMCLIENT_BUILD);
+    pkt.append((uint8 const*)"68x", 4);                    // strings are reversed
+    pkt.append((uint8 const*)"niW", 4);
+    pkt.append((uint8 const*)"SUne", 4);
+    pkt << uint32(0);                                       // timezone bias
+    pkt << uint32(0x0100007F);                              // 127.0.0.1
+    pkt << uint8(_account.size());
+    pkt.append((uint8 const*)_account.c_str(), _account.size());
+
+    Send(pkt.contents(), pkt.size());
+}
+
+void RealmClient::OnClose()
+{
+    if (_state != REALMCLIENT_DONE)
+        _state = REALMCLIENT_FAILED;
+}
+
+void RealmClient::Fail(uint8 error)
+{
+    _error = error;
+    _state = REALMCLIENT_FAILED;
+    Close();
+}
+
+size_t RealmClient::OnRead(uint8* data, size_t len)
+{
+    switch (_state)
+    {
+        case REALMCLIENT_CHALLENGE: return HandleChallenge(data, len);
+        case REALMCLIENT_PROOF:     return HandleProof(data, len);
+        case REALMCLIENT_REALMLIST: return HandleRealmList(data, len);
+        default:                    return len;
+    }
+}
+
+size_t RealmClient::HandleChallenge(uint8 const* data, size_t len)
+{
+    if (len < 3)
+        return 0;
+
+    if (data[2] != 0)
+    {
+        Fail(data[2]);
+        return len;
+    }
+
+    if (len < REALMCLIENT_CHALLENGE_SIZE)
+        return 0;
+
+    BigNumber B, g, N, s;
+    B.SetBinary(data + 3, 32);
+    g.SetBinary(data + 36, 1);
+    N.SetBinary(data + 38, 32);
+    s.SetBinary(data + 70, 32);
+
+    // x = H(s | H(I:P)), the same as realmd computes from sha_pass_hash
+    Sha1Hash sha;
+    sha.UpdateData(_account + ":" + _password);
+    sha.Finalize();
+    uint8 passHash[SHA_DIGEST_LENGTH];
+    memcpy(passHash, sha.GetDigest(), SHA_DIGEST_LENGTH);
+
+    sha.Initialize();
+    sha.UpdateData(s.AsByteArray(), s.GetNumBytes());
+    sha.UpdateData(passHash, SHA_DIGEST_LENGTH);
+    sha.Finalize();
+    BigNumber x;
+    x.SetBinary(sha.GetDigest(), sha.GetLength());
+
+    BigNumber a;
+    a.SetRand(19 * 8);
+    BigNumber A = g.ModExp(a, N);
+
+    sha.Initialize();
+    sha.UpdateBigNumbers(&A, &B, NULL);
+    sha.Finalize();
+    BigNumber u;
+    u.SetBinary(sha.GetDigest(), 20);
+
+    // S = (B - k * g^x) ^ (a + u * x), k = 3, kept positive before the exponentiation
+    BigNumber v = g.ModExp(x, N);
+    BigNumber base = (B + N * 3 - v * 3) % N;
+    BigNumber S = base.ModExp(a + u * x, N);
+
+    // session key, interleaved hashes of S as in AuthSocket::_HandleLogonProof
+    uint8 t[32];
+    uint8 t1[16];
+    uint8 vK[40];
+    memcpy(t, S.AsByteArray(32), 32);
+    for (int i = 0; i < 16; ++i)
+        t1[i] = t[i * 2];
+    sha.Initialize();
+    sha.UpdateData(t1, 16);
+    sha.Finalize();
+    for (int i = 0; i < 20; ++i)
+        vK[i * 2] = sha.GetDigest()[i];
+    for (int i = 0; i < 16; ++i)
+        t1[i] = t[i * 2 + 1];
+    sha.Initialize();
+    sha.UpdateData(t1, 16);
+    sha.Finalize();
+    for (int i = 0; i < 20; ++i)
+        vK[i * 2 + 1] = sha.GetDigest()[i];
+    _sessionKey.SetBinary(vK, 40);
+
+    // M1 = H(H(N) xor H(g), H(I), s, A, B, K)
+    uint8 hash[SHA_DIGEST_LENGTH];
+    sha.Initialize();
+    sha.UpdateBigNumbers(&N, NULL);
+    sha.Finalize();
+    memcpy(hash, sha.GetDigest(), SHA_DIGEST_LENGTH);
+    sha.Initialize();
+    sha.UpdateBigNumbers(&g, NULL);
+    sha.Finalize();
+    for (int i = 0; i < SHA_DIGEST_LENGTH; ++i)
+        hash[i] ^= sha.GetDigest()[i];
+    BigNumber t3;
+    t3.SetBinary(hash, SHA_DIGEST_LENGTH);
+
+    sha.Initialize();
+    sha.UpdateData(_account);
+    sha.Finalize();
+    uint8 t4[SHA_DIGEST_LENGTH];
+    memcpy(t4, sha.GetDigest(), SHA_DIGEST_LENGTH);
+
+    sha.Initialize();
+    sha.UpdateBigNumbers(&t3, NULL);
+    sha.UpdateData(t4, SHA_DIGEST_LENGTH);
+    sha.UpdateBigNumbers(&s, &A, &B, &_sessionKey, NULL);
+    sha.Finalize();
+
+    ByteBuffer pkt;
+    pkt << uint8(REALMCLIENT_LOGON_PROOF);
+    pkt.append(A.AsByteArray(32), 32);
+    pkt.append(sha.GetDigest(), 20);
+    for (int i = 0; i < 20; ++i)                            // crc hash
+        pkt << uint8(0);
+    pkt << uint8(0);                                        // number of keys
+    pkt << uint8(0);                                        // security flags
+
+    Send(pkt.contents(), pkt.size());
+
+    _state = REALMCLIENT_PROOF;
+    return REALMCLIENT_CHALLENGE_SIZE;
+}
+
+size_t RealmClient::HandleProof(uint8 const* data, size_t len)
+{
+    if (len < 2)
+        return 0;
+
+    if (data[1] != 0)
+    {
+        Fail(data[1]);
+        return len;
+    }
+
+    if (len < REALMCLIENT_PROOF_SIZE)
+        return 0;
+
+    uint8 const request[5] = { REALMCLIENT_REALM_LIST, 0, 0, 0, 0 };
+    Send(request, sizeof(request));
+
+    _state = REALMCLIENT_REALMLIST;
+    return REALMCLIENT_PROOF_SIZE;
+}
+
+size_t RealmClient::HandleRealmList(uint8 const* data, size_t len)
+{
+    if (len < 3)
+        return 0;
+
+    size_t size = data[1] | (data[2] << 8);
+    if (len < 3 + size)
+        return 0;
+
+    ByteBuffer pkt;
+    pkt.append(data + 3, size);
+
+    uint32 unk;
+    uint16 count;
+    pkt >> unk >> count;
+
+    for (uint16 i = 0; i < count; ++i)
+    {
+        Realm realm;
+        uint8 icon, lock, color, characters, timezone, unk2;
+        float population;
+
+        pkt >> icon >> lock >> color;
+        pkt >> realm.name >> realm.address;
+        pkt >> population >> characters >> timezone >> unk2;
+
+        _realms.push_back(realm);
+    }
+
+    _state = REALMCLIENT_DONE;
+    Close();
+    return 3 + size;
+}
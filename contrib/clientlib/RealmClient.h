@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef TRINITY_REALMCLIENT_H
+#define TRINITY_REALMCLIENT_H
+
+#include "ClientSocket.h"
+#include "Auth/BigNumber.h"
+
+/**
+ * Client side of the realmd logon, used by the test tools.
+ *
+ * Runs the SRP6 logon challenge and proof with the account name and
+ * password, then asks the realm list like the client does (realmd stores
+ * the v/s checked by the worldserver at that point). Once REALMCLIENT_DONE
+ * is reached the session key and the realm list are available and the
+ * connection may be closed.
+ */
+class RealmClient : public ClientSocket
+{
+    public:
+        enum State
+        {
+            REALMCLIENT_CHALLENGE,                          // logon challenge sent
+            REALMCLIENT_PROOF,                              // logon proof sent
+            REALMCLIENT_REALMLIST,                          // realm list asked
+            REALMCLIENT_DONE,
+            REALMCLIENT_FAILED
+        };
+
+        struct Realm
+        {
+            std::string name;
+            std::string address;
+        };
+
+        RealmClient();
+
+        /// Start the logon, false if the connection failed immediately.
+        bool Connect(std::string const& host, uint16 port, std::string const& account, std::string const& password);
+
+        State GetState() const { return _state; }
+        /// Result code of realmd for a failed logon (eAuthResults), 0 if the connection was lost.
+        uint8 GetError() const { return _error; }
+
+        BigNumber const& GetSessionKey() const { return _sessionKey; }
+        std::vector<Realm> const& GetRealms() const { return _realms; }
+
+    protected:
+        void OnConnect();
+        size_t OnRead(uint8* data, size_t len);
+        void OnClose();
+
+    private:
+        size_t HandleChallenge(uint8 const* data, size_t len);
+        size_t HandleProof(uint8 const* data, size_t len);
+        size_t HandleRealmList(uint8 const* data, size_t len);
+
+        void Fail(uint8 error);
+
+        State _state;
+        uint8 _error;
+
+        std::string _account;                               // upper case, as the client sends it
+        std::string _password;
+
+        BigNumber _sessionKey;
+        std::vector<Realm> _realms;
+};
+
+#endif
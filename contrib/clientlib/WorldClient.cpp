@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include "WorldClient.h"
+#include "WorldPacket.h"
+#include "Opcodes.h"
+#include "SharedDefines.h"
+#include "Util.h"
+#include "Auth/AuthCrypt.h"
+#include "Auth/Sha1.h"
+
+/// Client build sent in CMSG_AUTH_SESSION
+#define WORLDCLIENT_BUILD       8606
+
+#if defined( __GNUC__ )
+#pragma pack(1)
+#else
+#pragma pack(push,1)
+#endif
+
+struct ServerPktHeader
+{
+    uint16 size;
+    uint16 cmd;
+};
+
+struct ClientPktHeader
+{
+    uint16 size;
+    uint32 cmd;
+};
+
+#if defined( __GNUC__ )
+#pragma pack()
+#else
+#pragma pack(pop)
+#endif
+
+WorldClient::WorldClient() :
+    _authed(false), _send_i(0), _send_j(0), _recv_i(0), _recv_j(0), _crypted(false),
+    _haveHeader(false), _packetSize(0), _packetOpcode(0)
+{
+}
+
+bool WorldClient::Connect(std::string const& host, uint16 port, std::string const& account, BigNumber const& sessionKey)
+{
+    _account = account;
+    _sessionKey = sessionKey;
+    return ClientSocket::Connect(host, port);
+}
+
+WorldClient::State WorldClient::GetState() const
+{
+    if (IsClosed())
+        return WORLDCLIENT_CLOSED;
+    if (IsConnecting())
+        return WORLDCLIENT_CONNECTING;
+    return _authed ? WORLDCLIENT_AUTHED : WORLDCLIENT_AUTHENTICATING;
+}
+
+void WorldClient::SendPacket(WorldPacket const& packet)
+{
+    if (IsClosed())
+        return;
+
+    if (!_authed)
+    {
+        _pending.push_back(packet);
+        return;
+    }
+
+    AppendPacket(packet);
+}
+
+void WorldClient::AppendPacket(WorldPacket const& packet)
+{
+    ClientPktHeader header;
+    header.size = uint16(packet.size() + 4);
+    header.cmd = packet.GetOpcode();
+    EndianConvertReverse(header.size);
+    EndianConvert(header.cmd);
+    EncryptHeader((uint8*)&header);
+
+    Send((uint8*)&header, sizeof(header));
+    if (!packet.empty())
+        Send(packet.contents(), packet.size());
+}
+
+size_t WorldClient::OnRead(uint8* data, size_t len)
+{
+    size_t pos = 0;
+    for (;;)
+    {
+        if (!_haveHeader)
+        {
+            if (len - pos < sizeof(ServerPktHeader))
+                break;
+
+            ServerPktHeader& header = *((ServerPktHeader*)(data + pos));
+            DecryptHeader((uint8*)&header);
+            EndianConvertReverse(header.size);
+            EndianConvert(header.cmd);
+
+            if (header.size < 2)
+            {
+                Close();
+                return pos;
+            }
+
+            _packetSize = header.size - 2;
+            _packetOpcode = header.cmd;
+            _haveHeader = true;
+            pos += sizeof(ServerPktHeader);
+        }
+
+        if (len - pos < _packetSize)
+        {
+            // server packets may be bigger than the buffer (SMSG_UPDATE_OBJECT)
+            ReserveInput(_packetSize);
+            break;
+        }
+
+        WorldPacket packet(_packetOpcode, _packetSize);
+        if (_packetSize)
+            packet.append(data + pos, _packetSize);
+        pos += _packetSize;
+        _haveHeader = false;
+
+        DispatchPacket(packet);
+        if (IsClosed())
+            break;
+    }
+
+    return pos;
+}
+
+void WorldClient::DispatchPacket(WorldPacket& packet)
+{
+    switch (packet.GetOpcode())
+    {
+        case SMSG_AUTH_CHALLENGE:
+            HandleAuthChallenge(packet);
+            break;
+        case SMSG_AUTH_RESPONSE:
+        {
+            uint8 result = 0;
+            if (!packet.empty())
+                packet >> result;
+
+            if (result == AUTH_OK && !_authed)
+            {
+                _authed = true;
+                for (std::vector<WorldPacket>::const_iterator itr = _pending.begin(); itr != _pending.end(); ++itr)
+                    AppendPacket(*itr);
+                _pending.clear();
+            }
+
+            OnAuthResponse(result);
+            break;
+        }
+        default:
+            OnPacket(packet);
+            break;
+    }
+}
+
+void WorldClient::HandleAuthChallenge(WorldPacket& packet)
+{
+    uint32 serverSeed;
+    packet >> serverSeed;
+
+    uint32 clientSeed = rand32();
+    uint32 t = 0;
+
+    // same digest as checked by WorldSocket::HandleAuthSession
+    Sha1Hash sha;
+    sha.UpdateData(_account);
+    sha.UpdateData((uint8*)&t, 4);
+    sha.UpdateData((uint8*)&clientSeed, 4);
+    sha.UpdateData((uint8*)&serverSeed, 4);
+    sha.UpdateBigNumbers(&_sessionKey, NULL);
+    sha.Finalize();
+
+    WorldPacket auth(CMSG_AUTH_SESSION, 4 + 4 + _account.size() + 1 + 4 + 20 + 4);
+    auth << uint32(WORLDCLIENT_BUILD);
+    auth << uint32(0);
+    auth << _account;
+    auth << clientSeed;
+    auth.append(sha.GetDigest(), 20);
+    auth << uint32(0);                                      // no addon data
+
+    AppendPacket(auth);
+
+    // everything after the auth session is encrypted
+    _key.resize(SHA_DIGEST_LENGTH);
+    AuthCrypt::GenerateKey(&_key[0], &_sessionKey);
+    _send_i = _send_j = _recv_i = _recv_j = 0;
+    _crypted = true;
+}
+
+void WorldClient::EncryptHeader(uint8* header)
+{
+    if (!_crypted)
+        return;
+
+    for (size_t t = 0; t < sizeof(ClientPktHeader); ++t)
+    {
+        _send_i %= _key.size();
+        uint8 x = (header[t] ^ _key[_send_i]) + _send_j;
+        ++_send_i;
+        header[t] = _send_j = x;
+    }
+}
+
+void WorldClient::DecryptHeader(uint8* header)
+{
+    if (!_crypted)
+        return;
+
+    for (size_t t = 0; t < sizeof(ServerPktHeader); ++t)
+    {
+        _recv_i %= _key.size();
+        uint8 x = (header[t] - _recv_j) ^ _key[_recv_i];
+        ++_recv_i;
+        _recv_j = header[t];
+        header[t] = x;
+    }
+}
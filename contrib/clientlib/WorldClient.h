@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef TRINITY_WORLDCLIENT_H
+#define TRINITY_WORLDCLIENT_H
+
+#include "ClientSocket.h"
+#include "Auth/BigNumber.h"
+
+class WorldPacket;
+
+/**
+ * Client side of a world server connection, used by the test tools.
+ *
+ * The auth challenge is answered with the account and session key given to
+ * Connect, from then on the headers are encrypted like the real client does.
+ * Packets sent before AUTH_OK are held back and sent in order once the
+ * session is authenticated.
+ */
+class WorldClient : public ClientSocket
+{
+    public:
+        enum State
+        {
+            WORLDCLIENT_CONNECTING,                         // connect() in progress
+            WORLDCLIENT_AUTHENTICATING,                     // waiting for the challenge or the auth response
+            WORLDCLIENT_AUTHED,                             // AUTH_OK received
+            WORLDCLIENT_CLOSED
+        };
+
+        WorldClient();
+
+        /// Start the connection, false if it failed immediately.
+        bool Connect(std::string const& host, uint16 port, std::string const& account, BigNumber const& sessionKey);
+
+        /// Queue a packet, it is sent when the socket is writable.
+        void SendPacket(WorldPacket const& packet);
+
+        State GetState() const;
+
+    protected:
+        /// SMSG_AUTH_RESPONSE result (AUTH_OK, AUTH_WAIT_QUEUE...).
+        virtual void OnAuthResponse(uint8 /*result*/) {}
+        /// Every other packet of the server.
+        virtual void OnPacket(WorldPacket& /*packet*/) {}
+
+        size_t OnRead(uint8* data, size_t len);
+
+    private:
+        void HandleAuthChallenge(WorldPacket& packet);
+        void DispatchPacket(WorldPacket& packet);
+
+        void AppendPacket(WorldPacket const& packet);
+        void EncryptHeader(uint8* header);
+        void DecryptHeader(uint8* header);
+
+        std::string _account;
+        BigNumber _sessionKey;
+        bool _authed;
+
+        // header cipher, the client encrypts with the transform the server decrypts with and the other way around
+        std::vector<uint8> _key;
+        uint8 _send_i, _send_j, _recv_i, _recv_j;
+        bool _crypted;
+
+        bool _haveHeader;                                   // header of the next packet decrypted
+        uint16 _packetSize;
+        uint16 _packetOpcode;
+
+        std::vector<WorldPacket> _pending;                  // sent before AUTH_OK
+};
+
+#endif
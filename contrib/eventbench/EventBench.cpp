@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * EventProcessor micro-benchmark.
+ *
+ * Simulates the event volume of a raid: every unit casts spells (one event that
+ * re-adds itself for the travel time, like SpellEvent), gets aura and script
+ * timers of a few seconds and rare long timers (despawns, battleground invites),
+ * and units die now and then (KillAllEvents). The same workload, driven by a
+ * seeded generator, runs on the timing wheel and on a copy of the former
+ * multimap processor with heap allocated events. Both runs must execute the same
+ * events at the same times, the checksums are compared.
+ */
+
+#include "BenchCommon.h"
+#include "Utilities/EventProcessor.h"
+
+#include <map>
+#include <vector>
+#include <stdio.h>
+
+struct BenchConfig
+{
+    BenchConfig() : units(60), seconds(3600), diff(50), castInterval(1500), seed(1) {}
+
+    uint32 units;
+    uint32 seconds;                                         // simulated time
+    uint32 diff;                                            // update interval, ms
+    uint32 castInterval;                                    // average time between two casts of a unit, ms
+    uint32 seed;
+};
+
+struct BenchStats
+{
+    BenchStats() : added(0), executed(0), aborted(0), checksum(BENCH_CHECKSUM_SEED) {}
+
+    uint64 added;
+    uint64 executed;
+    uint64 aborted;
+    uint64 checksum;                                        // order and time of every execution
+};
+
+static BenchStats* s_stats;
+
+static inline void Account(uint32 id, uint64 e_time)
+{
+    s_stats->checksum = BenchChecksum(s_stats->checksum, id * 0x9E3779B97F4A7C15ULL + e_time);
+    ++s_stats->executed;
+}
+
+// the processor as it was before the timing wheel
+class LegacyEvent
+{
+    public:
+        LegacyEvent() { to_Abort = false; }
+        virtual ~LegacyEvent() {}
+
+        virtual bool Execute(uint64 /*e_time*/, uint32 /*p_time*/) { return true; }
+        virtual bool IsDeletable() const { return true; }
+        virtual void Abort(uint64 /*e_time*/) {}
+
+        bool to_Abort;
+        uint64 m_addTime;
+        uint64 m_execTime;
+};
+
+class LegacyEventProcessor
+{
+    public:
+        LegacyEventProcessor() : m_time(0) {}
+        ~LegacyEventProcessor() { KillAllEvents(true); }
+
+        void Update(uint32 p_time)
+        {
+            m_time += p_time;
+
+            std::multimap<uint64, LegacyEvent*>::iterator i;
+            while (((i = m_events.begin()) != m_events.end()) && i->first <= m_time)
+            {
+                LegacyEvent* Event = i->second;
+                m_events.erase(i);
+
+                if (!Event->to_Abort)
+                {
+                    if (Event->Execute(m_time, p_time))
+                        delete Event;
+                }
+                else
+                {
+                    Event->Abort(m_time);
+                    delete Event;
+                }
+            }
+        }
+
+        void KillAllEvents(bool force)
+        {
+            for (std::multimap<uint64, LegacyEvent*>::iterator i = m_events.begin(); i != m_events.end();)
+            {
+                std::multimap<uint64, LegacyEvent*>::iterator i_old = i;
+                ++i;
+
+                i_old->second->to_Abort = true;
+                i_old->second->Abort(m_time);
+                if (force || i_old->second->IsDeletable())
+                {
+                    delete i_old->second;
+
+                    if (!force)
+                        m_events.erase(i_old);
+                }
+            }
+
+            if (force)
+                m_events.clear();
+        }
+
+        void AddEvent(LegacyEvent* Event, uint64 e_time, bool set_addtime = true)
+        {
+            if (set_addtime) Event->m_addTime = m_time;
+            Event->m_execTime = e_time;
+            m_events.insert(std::pair<uint64, LegacyEvent*>(e_time, Event));
+        }
+
+        uint64 CalculateTime(uint64 t_offset) { return m_time + t_offset; }
+
+    private:
+        uint64 m_time;
+        std::multimap<uint64, LegacyEvent*> m_events;
+};
+
+// cast, then hit after the travel time
+template<class Base, class Processor>
+class CastEvent : public Base
+{
+    public:
+        CastEvent(Processor& events, uint32 id, uint32 travel) : m_events(events), m_id(id), m_travel(travel), m_launched(false) {}
+
+        bool Execute(uint64 e_time, uint32 /*p_time*/)
+        {
+            Account(m_id, e_time);
+
+            if (!m_launched && m_travel)
+            {
+                m_launched = true;
+                m_events.AddEvent(this, e_time + m_travel, false);
+                return false;
+            }
+
+            return true;
+        }
+
+        void Abort(uint64 /*e_time*/) { ++s_stats->aborted; }
+
+    private:
+        Processor& m_events;
+        uint32 m_id;
+        uint32 m_travel;
+        bool m_launched;
+};
+
+template<class Base>
+class TimerEvent : public Base
+{
+    public:
+        explicit TimerEvent(uint32 id) : m_id(id) {}
+
+        bool Execute(uint64 e_time, uint32 /*p_time*/)
+        {
+            Account(m_id, e_time);
+            return true;
+        }
+
+        void Abort(uint64 /*e_time*/) { ++s_stats->aborted; }
+
+    private:
+        uint32 m_id;
+};
+
+template<class Base, class Processor>
+static double RunWorkload(BenchConfig const& config, BenchStats& stats)
+{
+    s_stats = &stats;
+
+    std::vector<Processor*> units;
+    for (uint32 i = 0; i < config.units; ++i)
+        units.push_back(new Processor());
+
+    BenchRandom rand(config.seed);
+    uint32 nextId = 0;
+
+    BenchClock clock;
+
+    for (uint64 now = 0; now < uint64(config.seconds) * 1000; now += config.diff)
+    {
+        for (uint32 i = 0; i < config.units; ++i)
+        {
+            Processor& events = *units[i];
+            events.Update(config.diff);
+
+            // spells, queued for the next update like Spell::prepare does
+            if (rand.Next(config.castInterval) < config.diff)
+            {
+                events.AddEvent(new CastEvent<Base, Processor>(events, ++nextId, rand.Next(1500)), events.CalculateTime(1));
+                ++stats.added;
+            }
+
+            // aura and script timers
+            if (rand.Next(1000) < config.diff)
+            {
+                events.AddEvent(new TimerEvent<Base>(++nextId), events.CalculateTime(1000 + rand.Next(29000)));
+                ++stats.added;
+            }
+
+            // despawns, invites
+            if (rand.Next(60000) < config.diff)
+            {
+                events.AddEvent(new TimerEvent<Base>(++nextId), events.CalculateTime(120000 + rand.Next(480000)));
+                ++stats.added;
+            }
+        }
+
+        // a unit dies
+        if (rand.Next(5000) < config.diff)
+            units[rand.Next(config.units)]->KillAllEvents(false);
+    }
+
+    for (uint32 i = 0; i < config.units; ++i)
+        delete units[i];
+
+    return clock.Elapsed();
+}
+
+static void PrintRun(char const* name, BenchStats const& stats, double seconds)
+{
+    printf("%-8s %10llu added %10llu executed %8llu aborted  %8.3f s  %7.1f ns/event  checksum %016llx\n", name,
+        (unsigned long long)stats.added, (unsigned long long)stats.executed, (unsigned long long)stats.aborted,
+        seconds, seconds * 1e9 / double(stats.added ? stats.added : 1), (unsigned long long)stats.checksum);
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+
+    BenchOption const options[] =
+    {
+        { 'u', &config.units, 1, "units, each with its own event processor" },
+        { 's', &config.seconds, 0, "simulated seconds" },
+        { 'd', &config.diff, 1, "update interval in ms" },
+        { 'c', &config.castInterval, 1, "average time between two casts of a unit in ms" },
+        { 'r', &config.seed, 0, "random seed" },
+    };
+
+    if (!BenchParseOptions(argc, argv, options))
+        return 1;
+
+    BenchStats legacy, wheel;
+    double legacyTime = RunWorkload<LegacyEvent, LegacyEventProcessor>(config, legacy);
+    double wheelTime = RunWorkload<BasicEvent, EventProcessor>(config, wheel);
+
+    PrintRun("multimap", legacy, legacyTime);
+    PrintRun("wheel", wheel, wheelTime);
+
+    bool match = legacy.executed == wheel.executed && legacy.aborted == wheel.aborted && legacy.checksum == wheel.checksum;
+    return BenchReport(match, "the wheel did not execute the same events", legacyTime, wheelTime);
+}
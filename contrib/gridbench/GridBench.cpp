@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+/*
+ * Grid cell container micro-benchmark.
+ *
+ * Replays Map::Update on one populated city grid: every tick each cell is
+ * visited to update its creatures and players, wanderers and players move and
+ * change cells through a move list like the creature move list of the map,
+ * every player runs a visibility pass over the cells around it and some of
+ * them cast area spells. The same world runs on the former GridRefManager
+ * linked lists and on the dense GridObjectList used by the cells now. Objects
+ * are allocated over time like on a live server, so list order does not match
+ * memory order. Every object keeps its own random state, the results do not
+ * depend on the visit order and the checksums are compared.
+ */
+
+#include "BenchCommon.h"
+#include "GameSystem/GridRefManager.h"
+#include "GameSystem/GridReference.h"
+#include "GameSystem/GridObjectList.h"
+
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+
+#define BENCH_CELLS         8                               // cells per side, as MAX_NUMBER_OF_CELLS
+#define BENCH_CELL_SIZE     (533.33333f / BENCH_CELLS)
+#define BENCH_VISIBILITY    100.0f
+
+struct BenchConfig
+{
+    BenchConfig() : creatures(1500), players(300), seconds(60), diff(100), casts(5), objectSize(1024), seed(1) {}
+
+    uint32 creatures;
+    uint32 players;
+    uint32 seconds;                                         // simulated time
+    uint32 diff;                                            // map update interval, ms
+    uint32 casts;                                           // area spells per second and per 100 players
+    uint32 objectSize;                                      // bytes of object state, creatures and players are big
+    uint32 seed;
+};
+
+struct BenchResult
+{
+    BenchResult() : updates(0), cellChanges(0), visibility(0), targets(0), checksum(0) {}
+
+    uint64 updates;
+    uint64 cellChanges;
+    uint64 visibility;                                      // objects in range of the visibility passes
+    uint64 targets;                                         // objects in range of the area spells
+    uint64 checksum;                                        // order independent sum of the object states
+};
+
+class BenchObject
+{
+    public:
+        BenchObject(uint32 guid, uint32 seed, bool player, float x, float y, uint32 stateSize)
+            : m_guid(guid), m_player(player), m_wanderer(player || guid % 4 == 0), m_x(x), m_y(y), m_z(0.0f),
+            m_size(1.5f), m_timer(0), m_state(guid), m_random(seed + guid), m_data(stateSize / sizeof(uint64) + 1, guid) {}
+
+        GridReference<BenchObject>& GetGridRef() { return m_gridRef; }
+        GridPositionSlot& GetGridPosition() { return m_gridPosition; }
+
+        float GetPositionX() const { return m_x; }
+        float GetPositionY() const { return m_y; }
+        float GetPositionZ() const { return m_z; }
+        float GetObjectSize() const { return m_size; }
+        bool IsPlayer() const { return m_player; }
+        uint64 GetState() const { return m_state; }
+
+        void Relocate(float x, float y)
+        {
+            m_x = x;
+            m_y = y;
+            m_gridPosition.Relocate(m_x, m_y, m_z);
+        }
+
+        // timers and a walk step, returns true with the destination when the object moves
+        bool Update(uint32 diff, float& x, float& y)
+        {
+            m_timer += diff;
+            m_state = m_state * 6364136223846793005ULL + m_timer;
+            m_data[m_state % m_data.size()] += m_state;
+
+            if (!m_wanderer || m_random.Next(4))
+                return false;
+
+            x = m_x + m_random.NextFloat(8.0f) - 4.0f;
+            y = m_y + m_random.NextFloat(8.0f) - 4.0f;
+            x = x < 0.0f ? 0.0f : (x >= BENCH_CELLS * BENCH_CELL_SIZE ? BENCH_CELLS * BENCH_CELL_SIZE - 0.01f : x);
+            y = y < 0.0f ? 0.0f : (y >= BENCH_CELLS * BENCH_CELL_SIZE ? BENCH_CELLS * BENCH_CELL_SIZE - 0.01f : y);
+            return true;
+        }
+
+        void See(BenchObject const* other) { m_state += other->m_guid; }
+        void Hit(BenchObject const* caster) { m_state ^= caster->m_guid * 0x9E3779B97F4A7C15ULL; }
+
+    private:
+        uint32 m_guid;
+        bool m_player;
+        bool m_wanderer;
+        float m_x, m_y, m_z;
+        float m_size;
+        uint32 m_timer;
+        uint64 m_state;
+        BenchRandom m_random;
+        std::vector<uint64> m_data;
+        GridReference<BenchObject> m_gridRef;
+        GridPositionSlot m_gridPosition;
+};
+
+static uint32 CellOf(float coord)
+{
+    uint32 cell = uint32(coord / BENCH_CELL_SIZE);
+    return cell < BENCH_CELLS ? cell : BENCH_CELLS - 1;
+}
+
+// cells of the former implementation, linked lists through the objects
+class LegacyGrid
+{
+    public:
+        typedef GridRefManager<BenchObject> Cell;
+
+        void Insert(Cell& cell, BenchObject* obj) { obj->GetGridRef().link(&cell, obj); }
+        void Remove(Cell&, BenchObject* obj) { obj->GetGridRef().unlink(); }
+
+        template<class F> void Visit(Cell& cell, F& f)
+        {
+            for (Cell::iterator itr = cell.begin(); itr != cell.end(); ++itr)
+                f(itr->getSource());
+        }
+
+        // area search as the notifiers did it, every object of the cell is read
+        template<class F> void VisitInRange(Cell& cell, float x, float y, float range, F& f)
+        {
+            for (Cell::iterator itr = cell.begin(); itr != cell.end(); ++itr)
+            {
+                BenchObject* obj = itr->getSource();
+                float dx = obj->GetPositionX() - x;
+                float dy = obj->GetPositionY() - y;
+                float dz = obj->GetPositionZ();
+                if (dx*dx + dy*dy + dz*dz < range * range)
+                    f(obj);
+            }
+        }
+
+        Cell cells[BENCH_CELLS][BENCH_CELLS];
+};
+
+// dense cells with the position arrays
+class DenseGrid
+{
+    public:
+        typedef GridObjectList<BenchObject> Cell;
+
+        DenseGrid() {}
+
+        void Insert(Cell& cell, BenchObject* obj) { cell.insert(obj); }
+        void Remove(Cell&, BenchObject* obj) { Cell::remove(obj); }
+
+        template<class F> void Visit(Cell& cell, F& f)
+        {
+            cell.BeginVisit();
+            for (Cell::iterator itr = cell.begin(); itr != cell.end(); ++itr)
+                f(*itr);
+            cell.EndVisit();
+        }
+
+        template<class F> void VisitInRange(Cell& cell, float x, float y, float range, F& f)
+        {
+            cell.FilterInRange(x, y, 0.0f, range, m_candidates);
+            for (std::vector<uint32>::const_iterator itr = m_candidates.begin(); itr != m_candidates.end(); ++itr)
+            {
+                BenchObject* obj = cell.getObject<BenchObject>(*itr);
+                float dx = obj->GetPositionX() - x;
+                float dy = obj->GetPositionY() - y;
+                float dz = obj->GetPositionZ();
+                if (dx*dx + dy*dy + dz*dz < range * range)
+                    f(obj);
+            }
+        }
+
+        Cell cells[BENCH_CELLS][BENCH_CELLS];
+
+    private:
+        std::vector<uint32> m_candidates;
+};
+
+struct MoveOrder
+{
+    BenchObject* obj;
+    float x, y;
+};
+
+struct Updater
+{
+    Updater(uint32 diff, std::vector<MoveOrder>& moves, BenchResult& result) : diff(diff), moves(moves), result(result) {}
+
+    void operator()(BenchObject* obj)
+    {
+        MoveOrder order;
+        ++result.updates;
+        if (obj->Update(diff, order.x, order.y))
+        {
+            order.obj = obj;
+            moves.push_back(order);
+        }
+    }
+
+    uint32 diff;
+    std::vector<MoveOrder>& moves;
+    BenchResult& result;
+};
+
+struct Viewer
+{
+    Viewer(BenchObject* player, uint64& count) : player(player), count(count) {}
+
+    void operator()(BenchObject* obj) { player->See(obj); ++count; }
+
+    BenchObject* player;
+    uint64& count;
+};
+
+struct Hitter
+{
+    Hitter(BenchObject* caster, uint64& count) : caster(caster), count(count) {}
+
+    void operator()(BenchObject* obj) { obj->Hit(caster); ++count; }
+
+    BenchObject* caster;
+    uint64& count;
+};
+
+template<class Grid, class F>
+static void VisitAround(Grid& grid, float x, float y, float range, F& f)
+{
+    uint32 minX = CellOf(x > range ? x - range : 0.0f), maxX = CellOf(x + range);
+    uint32 minY = CellOf(y > range ? y - range : 0.0f), maxY = CellOf(y + range);
+    for (uint32 cx = minX; cx <= maxX; ++cx)
+        for (uint32 cy = minY; cy <= maxY; ++cy)
+            grid.VisitInRange(grid.cells[cx][cy], x, y, range, f);
+}
+
+template<class Grid>
+static double RunCity(BenchConfig const& config, BenchResult& result)
+{
+    Grid* grid = new Grid();
+    BenchRandom rand(config.seed);
+
+    // objects spawn over time, garbage allocations in between scatter them on the heap
+    std::vector<BenchObject*> objects;
+    std::vector<BenchObject*> players;
+    std::vector<std::vector<uint64>*> garbage;
+    uint32 count = config.creatures + config.players;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        bool player = rand.Next(count) < config.players;
+        BenchObject* obj = new BenchObject(i + 1, config.seed, player,
+            rand.NextFloat(BENCH_CELLS * BENCH_CELL_SIZE), rand.NextFloat(BENCH_CELLS * BENCH_CELL_SIZE), config.objectSize);
+        objects.push_back(obj);
+        if (player)
+            players.push_back(obj);
+        garbage.push_back(new std::vector<uint64>(rand.Next(64) + 1));
+        grid->Insert(grid->cells[CellOf(obj->GetPositionX())][CellOf(obj->GetPositionY())], obj);
+    }
+
+    for (uint32 i = 0; i < garbage.size(); ++i)
+        delete garbage[i];
+
+    std::vector<MoveOrder> moves;
+    uint32 castsPerTick = std::max(1u, config.casts * uint32(players.size()) * config.diff / 100000);
+
+    BenchClock clock;
+
+    for (uint32 now = 0; now < config.seconds * 1000; now += config.diff)
+    {
+        Updater updater(config.diff, moves, result);
+        for (uint32 x = 0; x < BENCH_CELLS; ++x)
+            for (uint32 y = 0; y < BENCH_CELLS; ++y)
+                grid->Visit(grid->cells[x][y], updater);
+
+        for (std::vector<MoveOrder>::const_iterator itr = moves.begin(); itr != moves.end(); ++itr)
+        {
+            BenchObject* obj = itr->obj;
+            uint32 oldX = CellOf(obj->GetPositionX()), oldY = CellOf(obj->GetPositionY());
+            uint32 newX = CellOf(itr->x), newY = CellOf(itr->y);
+            if (oldX != newX || oldY != newY)
+            {
+                grid->Remove(grid->cells[oldX][oldY], obj);
+                obj->Relocate(itr->x, itr->y);
+                grid->Insert(grid->cells[newX][newY], obj);
+                ++result.cellChanges;
+            }
+            else
+                obj->Relocate(itr->x, itr->y);
+        }
+        moves.clear();
+
+        for (std::vector<BenchObject*>::const_iterator itr = players.begin(); itr != players.end(); ++itr)
+        {
+            Viewer viewer(*itr, result.visibility);
+            VisitAround(*grid, (*itr)->GetPositionX(), (*itr)->GetPositionY(), BENCH_VISIBILITY, viewer);
+        }
+
+        for (uint32 i = 0; i < castsPerTick; ++i)
+        {
+            BenchObject* caster = players[rand.Next(players.size())];
+            Hitter hitter(caster, result.targets);
+            VisitAround(*grid, caster->GetPositionX(), caster->GetPositionY(), float(8 + rand.Next(30)), hitter);
+        }
+    }
+
+    double seconds = clock.Elapsed();
+
+    for (std::vector<BenchObject*>::const_iterator itr = objects.begin(); itr != objects.end(); ++itr)
+    {
+        result.checksum += (*itr)->GetState();
+        delete *itr;
+    }
+    delete grid;
+
+    return seconds;
+}
+
+static void PrintRun(char const* name, BenchResult const& result, double seconds)
+{
+    printf("%-6s %10llu updates %8llu cell changes %10llu seen %8llu hit  %8.3f s  checksum %016llx\n", name,
+        (unsigned long long)result.updates, (unsigned long long)result.cellChanges, (unsigned long long)result.visibility,
+        (unsigned long long)result.targets, seconds, (unsigned long long)result.checksum);
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+
+    BenchOption const options[] =
+    {
+        { 'c', &config.creatures, 0, "creatures in the grid" },
+        { 'p', &config.players, 1, "players in the grid" },
+        { 's', &config.seconds, 0, "simulated seconds" },
+        { 'd', &config.diff, 1, "map update interval in ms" },
+        { 'a', &config.casts, 0, "area spells per second and per 100 players" },
+        { 'o', &config.objectSize, 0, "bytes of state per object" },
+        { 'r', &config.seed, 0, "random seed" },
+    };
+
+    if (!BenchParseOptions(argc, argv, options))
+        return 1;
+
+    BenchResult listResult, denseResult;
+    double listTime = RunCity<LegacyGrid>(config, listResult);
+    double denseTime = RunCity<DenseGrid>(config, denseResult);
+
+    PrintRun("list", listResult, listTime);
+    PrintRun("dense", denseResult, denseTime);
+
+    bool match = listResult.checksum == denseResult.checksum && listResult.visibility == denseResult.visibility
+        && listResult.targets == denseResult.targets;
+    return BenchReport(match, "the dense cells did not visit the same objects", listTime, denseTime);
+}
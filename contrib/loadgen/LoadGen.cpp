@@ -0,0 +1,853 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+/*
+ * Headless load generator, puts synthetic players on a local realm.
+ *
+ * Every bot logs on to realmd with SRP6 (accounts PREFIX1..PREFIXn, one
+ * password for all), connects to the worldserver with the session key,
+ * creates a character if the account has none and enters the world.
+ * In the world the bots run the selected behaviours:
+ *   move  - walk to random points around the login position (heartbeats every 500ms)
+ *   cast  - cast a self spell (Frost Armor by default, characters are human mages)
+ *   chat  - say something
+ *   ah    - browse the auction house (needs -A, the bots have to stand near that auctioneer)
+ *
+ * Round trips are measured with CMSG_PING (answered by the network thread)
+ * and CMSG_QUERY_TIME (answered in the world update), the percentiles are
+ * printed every report interval and at the end.
+ *
+ * Bots are spread over worker threads, each one runs its own poll loop.
+ */
+
+#include "Common.h"
+#include "RealmClient.h"
+#include "WorldClient.h"
+#include "WorldPacket.h"
+#include "Opcodes.h"
+#include "SharedDefines.h"
+#include "Timer.h"
+#include "Util.h"
+#include "Database/DatabaseEnv.h"
+
+#include <poll.h>
+#include <getopt.h>
+#include <signal.h>
+#include <math.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+DatabaseType LoginDatabase;
+
+/// Seconds between two reports
+#define LOADGEN_REPORT_INTERVAL     10
+
+/// Longest poll wait of the worker threads
+#define LOADGEN_POLL_TIMEOUT        10
+
+/// MOVEMENTFLAG_FORWARD
+#define LOADGEN_MOVE_FORWARD        0x00000001
+
+#define LOADGEN_RUN_SPEED           7.0f
+#define LOADGEN_HEARTBEAT_INTERVAL  500
+#define LOADGEN_PING_INTERVAL       30000               // the worldserver kicks clients pinging faster than every 27s
+#define LOADGEN_QUERY_INTERVAL      2000
+#define LOADGEN_CAST_INTERVAL       10000
+#define LOADGEN_CHAT_INTERVAL       15000
+#define LOADGEN_AUCTION_INTERVAL    20000
+
+enum LoadBehaviour
+{
+    BEHAVIOUR_MOVE      = 0x01,
+    BEHAVIOUR_CAST      = 0x02,
+    BEHAVIOUR_CHAT      = 0x04,
+    BEHAVIOUR_AUCTION   = 0x08
+};
+
+struct LoadConfig
+{
+    LoadConfig() : realmPort(3724), worldPort(0), prefix("LOADBOT"), password("loadbot"), first(1), count(100),
+        rampPerSecond(20), threads(1), duration(0), behaviours(BEHAVIOUR_MOVE | BEHAVIOUR_CAST | BEHAVIOUR_CHAT),
+        spellId(168), auctioneer(0), radius(20.0f) {}
+
+    std::string realmHost;
+    uint16 realmPort;
+    std::string worldHost;                              // empty: address of the first realm of the list
+    uint16 worldPort;
+    std::string prefix;
+    std::string password;
+    uint32 first;
+    uint32 count;
+    uint32 rampPerSecond;
+    uint32 threads;
+    uint32 duration;                                    // seconds, 0 until interrupted
+    uint32 behaviours;
+    uint32 spellId;
+    uint64 auctioneer;
+    float radius;
+    std::string loginDatabase;                          // create the missing accounts
+};
+
+/// Round trip samples in microseconds
+class RttSamples
+{
+    public:
+        void Add(uint32 us)
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _interval.push_back(us);
+        }
+
+        /// Move the samples of the interval to the run, returns the interval ones sorted
+        void TakeInterval(std::vector<uint32>& samples)
+        {
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                samples.swap(_interval);
+                _interval.clear();
+            }
+            std::sort(samples.begin(), samples.end());
+            _run.insert(_run.end(), samples.begin(), samples.end());
+        }
+
+        void GetRun(std::vector<uint32>& samples)
+        {
+            samples = _run;
+            std::sort(samples.begin(), samples.end());
+        }
+
+    private:
+        std::mutex _lock;
+        std::vector<uint32> _interval;
+        std::vector<uint32> _run;                       // only touched by the report thread
+};
+
+struct LoadStats
+{
+    LoadStats() : realmFailed(0), worldFailed(0), inWorld(0), disconnected(0), packetsSent(0), packetsReceived(0) {}
+
+    std::atomic<uint32> realmFailed;
+    std::atomic<uint32> worldFailed;                    // auth, character creation or login refused
+    std::atomic<uint32> inWorld;
+    std::atomic<uint32> disconnected;                   // lost once in the world
+    std::atomic<uint64> packetsSent;
+    std::atomic<uint64> packetsReceived;
+
+    RttSamples ping;
+    RttSamples world;
+};
+
+static LoadStats s_stats;
+static volatile bool s_stop = false;
+
+/// Synthetic player
+class Bot : public WorldClient
+{
+    public:
+        enum BotState
+        {
+            BOT_WAITING,                                // not started yet
+            BOT_REALM,
+            BOT_WORLD_AUTH,
+            BOT_CHAR_ENUM,
+            BOT_CHAR_CREATE,
+            BOT_LOGIN,
+            BOT_IN_WORLD,
+            BOT_STOPPED
+        };
+
+        Bot(LoadConfig const& config, uint32 index) : _config(config), _index(index), _state(BOT_WAITING),
+            _race(0), _x(0.0f), _y(0.0f), _z(0.0f), _o(0.0f), _homeX(0.0f), _homeY(0.0f),
+            _moving(false), _moveEnd(0), _nextMove(0), _nextHeartbeat(0), _lastMove(0),
+            _nextPing(0), _nextQuery(0), _nextCast(0), _nextChat(0), _nextAuction(0),
+            _pingSeq(0), _pingSent(0), _querySent(0)
+        {
+            std::ostringstream ss;
+            ss << config.prefix << index;
+            _account = ss.str();
+        }
+
+        void Start()
+        {
+            _state = BOT_REALM;
+            if (!_realm.Connect(_config.realmHost, _config.realmPort, _account, _config.password))
+                FailRealm();
+        }
+
+        BotState GetBotState() const { return _state; }
+
+        /// Socket to poll, NULL when the bot does not wait for anything
+        ClientSocket* GetSocket()
+        {
+            if (_state == BOT_REALM)
+                return _realm.IsClosed() ? NULL : (ClientSocket*)&_realm;
+            if (_state > BOT_REALM && _state < BOT_STOPPED)
+                return IsClosed() ? NULL : (ClientSocket*)this;
+            return NULL;
+        }
+
+        void Update(uint32 now);
+
+    protected:
+        void OnAuthResponse(uint8 result);
+        void OnPacket(WorldPacket& packet);
+
+    private:
+        void FailRealm();
+        void FailWorld();
+
+        void Send(WorldPacket const& packet)
+        {
+            SendPacket(packet);
+            ++s_stats.packetsSent;
+        }
+
+        void SendCharCreate();
+        void SendMovement(uint16 opcode, uint32 flags, uint32 now);
+        void UpdateMovement(uint32 now);
+        void UpdateBehaviours(uint32 now);
+
+        /// Character name of the bot, letters only
+        std::string GetCharacterName() const;
+
+        LoadConfig const& _config;
+        uint32 _index;
+        BotState _state;
+        std::string _account;
+        RealmClient _realm;
+
+        uint8 _race;
+        float _x, _y, _z, _o;
+        float _homeX, _homeY;
+
+        bool _moving;
+        uint32 _moveEnd;
+        uint32 _nextMove;
+        uint32 _nextHeartbeat;
+        uint32 _lastMove;
+
+        uint32 _nextPing;
+        uint32 _nextQuery;
+        uint32 _nextCast;
+        uint32 _nextChat;
+        uint32 _nextAuction;
+
+        uint32 _pingSeq;
+        uint64 _pingSent;                               // ns, 0 if no ping is waiting for its pong
+        uint64 _querySent;
+};
+
+void Bot::FailRealm()
+{
+    ++s_stats.realmFailed;
+    _state = BOT_STOPPED;
+}
+
+void Bot::FailWorld()
+{
+    ++s_stats.worldFailed;
+    _state = BOT_STOPPED;
+    Close();
+}
+
+void Bot::Update(uint32 now)
+{
+    switch (_state)
+    {
+        case BOT_REALM:
+        {
+            if (_realm.GetState() == RealmClient::REALMCLIENT_FAILED)
+            {
+                FailRealm();
+                break;
+            }
+
+            if (_realm.GetState() != RealmClient::REALMCLIENT_DONE)
+                break;
+
+            std::string host = _config.worldHost;
+            uint16 port = _config.worldPort;
+            if (host.empty())
+            {
+                if (_realm.GetRealms().empty())
+                {
+                    FailRealm();
+                    break;
+                }
+
+                std::string const& address = _realm.GetRealms()[0].address;
+                std::string::size_type pos = address.find(':');
+                host = address.substr(0, pos);
+                port = pos != std::string::npos ? uint16(atoi(address.c_str() + pos + 1)) : 8085;
+            }
+
+            _state = BOT_WORLD_AUTH;
+            if (!Connect(host, port, _account, _realm.GetSessionKey()))
+                FailWorld();
+            break;
+        }
+        case BOT_IN_WORLD:
+            if (IsClosed())
+            {
+                --s_stats.inWorld;
+                ++s_stats.disconnected;
+                _state = BOT_STOPPED;
+                break;
+            }
+
+            UpdateBehaviours(now);
+            break;
+        case BOT_WORLD_AUTH:
+        case BOT_CHAR_ENUM:
+        case BOT_CHAR_CREATE:
+        case BOT_LOGIN:
+            if (IsClosed())
+                FailWorld();
+            break;
+        default:
+            break;
+    }
+}
+
+void Bot::OnAuthResponse(uint8 result)
+{
+    if (result == AUTH_WAIT_QUEUE)
+        return;
+
+    if (result != AUTH_OK)
+    {
+        FailWorld();
+        return;
+    }
+
+    _state = BOT_CHAR_ENUM;
+    Send(WorldPacket(CMSG_CHAR_ENUM, 0));
+}
+
+void Bot::OnPacket(WorldPacket& packet)
+{
+    ++s_stats.packetsReceived;
+
+    switch (packet.GetOpcode())
+    {
+        case SMSG_CHAR_ENUM:
+        {
+            if (_state != BOT_CHAR_ENUM)
+                break;
+
+            uint8 count;
+            packet >> count;
+
+            if (!count)
+            {
+                SendCharCreate();
+                break;
+            }
+
+            uint64 guid;
+            std::string name;
+            packet >> guid >> name >> _race;
+
+            WorldPacket login(CMSG_PLAYER_LOGIN, 8);
+            login << guid;
+            Send(login);
+            _state = BOT_LOGIN;
+            break;
+        }
+        case SMSG_CHAR_CREATE:
+        {
+            uint8 result;
+            packet >> result;
+
+            if (result != CHAR_CREATE_SUCCESS)
+            {
+                FailWorld();
+                break;
+            }
+
+            _state = BOT_CHAR_ENUM;
+            Send(WorldPacket(CMSG_CHAR_ENUM, 0));
+            break;
+        }
+        case SMSG_LOGIN_VERIFY_WORLD:
+        {
+            uint32 mapId;
+            packet >> mapId >> _x >> _y >> _z >> _o;
+            _homeX = _x;
+            _homeY = _y;
+
+            // spread the timers so the bots do not act in the same tick
+            uint32 now = getMSTime();
+            _nextMove = now + urand(0, 3000);
+            _nextPing = now + urand(0, LOADGEN_PING_INTERVAL);
+            _nextQuery = now + urand(0, LOADGEN_QUERY_INTERVAL);
+            _nextCast = now + urand(0, LOADGEN_CAST_INTERVAL);
+            _nextChat = now + urand(0, LOADGEN_CHAT_INTERVAL);
+            _nextAuction = now + urand(0, LOADGEN_AUCTION_INTERVAL);
+
+            _state = BOT_IN_WORLD;
+            ++s_stats.inWorld;
+            break;
+        }
+        case SMSG_PONG:
+        {
+            uint32 seq;
+            packet >> seq;
+            if (_pingSent && seq == _pingSeq)
+            {
+                s_stats.ping.Add(uint32((getNSTime() - _pingSent) / 1000));
+                _pingSent = 0;
+            }
+            break;
+        }
+        case SMSG_QUERY_TIME_RESPONSE:
+            if (_querySent)
+            {
+                s_stats.world.Add(uint32((getNSTime() - _querySent) / 1000));
+                _querySent = 0;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+std::string Bot::GetCharacterName() const
+{
+    // "Bot" and the index in base 26, names may not contain digits
+    std::string name = "Bot";
+    uint32 index = _index;
+    do
+    {
+        name += char('a' + index % 26);
+        index /= 26;
+    }
+    while (index);
+
+    return name;
+}
+
+void Bot::SendCharCreate()
+{
+    WorldPacket create(CMSG_CHAR_CREATE, 20);
+    create << GetCharacterName();
+    create << uint8(RACE_HUMAN);
+    create << uint8(CLASS_MAGE);
+    create << uint8(GENDER_MALE);
+    create << uint8(0);                                 // skin
+    create << uint8(0);                                 // face
+    create << uint8(0);                                 // hair style
+    create << uint8(0);                                 // hair color
+    create << uint8(0);                                 // facial hair
+    create << uint8(0);                                 // outfit
+    Send(create);
+
+    _state = BOT_CHAR_CREATE;
+}
+
+void Bot::SendMovement(uint16 opcode, uint32 flags, uint32 now)
+{
+    WorldPacket data(opcode, 4 + 1 + 4 + 4 * 4 + 4);
+    data << uint32(flags);
+    data << uint8(0);
+    data << uint32(now);
+    data << _x << _y << _z << _o;
+    data << uint32(0);                                  // fall time
+    Send(data);
+}
+
+void Bot::UpdateMovement(uint32 now)
+{
+    if (_moving)
+    {
+        uint32 end = std::min(now, _moveEnd);
+        float dist = LOADGEN_RUN_SPEED * GetMSTimeDiff(_lastMove, end) / 1000.0f;
+        _x += cos(_o) * dist;
+        _y += sin(_o) * dist;
+        _lastMove = end;
+
+        if (now >= _moveEnd)
+        {
+            SendMovement(MSG_MOVE_STOP, 0, now);
+            _moving = false;
+            _nextMove = now + urand(1000, 3000);
+        }
+        else if (now >= _nextHeartbeat)
+        {
+            SendMovement(MSG_MOVE_HEARTBEAT, LOADGEN_MOVE_FORWARD, now);
+            _nextHeartbeat = now + LOADGEN_HEARTBEAT_INTERVAL;
+        }
+    }
+    else if (now >= _nextMove)
+    {
+        // walk to a random point around the login position
+        float angle = float(rand_norm() * 2 * M_PI);
+        float radius = float(rand_norm() * _config.radius);
+        float dx = _homeX + cos(angle) * radius - _x;
+        float dy = _homeY + sin(angle) * radius - _y;
+        float dist = sqrt(dx * dx + dy * dy);
+        if (dist < 1.0f)
+        {
+            _nextMove = now + 1000;
+            return;
+        }
+
+        _o = atan2(dy, dx);
+        if (_o < 0)
+            _o += float(2 * M_PI);
+
+        _moving = true;
+        _lastMove = now;
+        _moveEnd = now + uint32(dist / LOADGEN_RUN_SPEED * 1000);
+        _nextHeartbeat = now + LOADGEN_HEARTBEAT_INTERVAL;
+        SendMovement(MSG_MOVE_START_FORWARD, LOADGEN_MOVE_FORWARD, now);
+    }
+}
+
+void Bot::UpdateBehaviours(uint32 now)
+{
+    if (_config.behaviours & BEHAVIOUR_MOVE)
+        UpdateMovement(now);
+
+    if (now >= _nextPing && !_pingSent)
+    {
+        WorldPacket ping(CMSG_PING, 8);
+        ping << ++_pingSeq;
+        ping << uint32(0);                              // latency
+        Send(ping);
+        _pingSent = getNSTime();
+        _nextPing = now + LOADGEN_PING_INTERVAL;
+    }
+
+    if (now >= _nextQuery && !_querySent)
+    {
+        Send(WorldPacket(CMSG_QUERY_TIME, 0));
+        _querySent = getNSTime();
+        _nextQuery = now + LOADGEN_QUERY_INTERVAL;
+    }
+
+    if ((_config.behaviours & BEHAVIOUR_CAST) && now >= _nextCast)
+    {
+        WorldPacket cast(CMSG_CAST_SPELL, 4 + 1 + 4);
+        cast << uint32(_config.spellId);
+        cast << uint8(0);                               // cast count
+        cast << uint32(0);                              // TARGET_FLAG_SELF
+        Send(cast);
+        _nextCast = now + LOADGEN_CAST_INTERVAL;
+    }
+
+    if ((_config.behaviours & BEHAVIOUR_CHAT) && now >= _nextChat)
+    {
+        bool alliance = _race == RACE_HUMAN || _race == RACE_DWARF || _race == RACE_NIGHTELF || _race == RACE_GNOME || _race == RACE_DRAENEI;
+
+        WorldPacket chat(CMSG_MESSAGECHAT, 4 + 4 + 32);
+        chat << uint32(CHAT_MSG_SAY);
+        chat << uint32(alliance ? LANG_COMMON : LANG_ORCISH);
+        chat << std::string("load test message");
+        Send(chat);
+        _nextChat = now + LOADGEN_CHAT_INTERVAL;
+    }
+
+    if ((_config.behaviours & BEHAVIOUR_AUCTION) && _config.auctioneer && now >= _nextAuction)
+    {
+        WorldPacket list(CMSG_AUCTION_LIST_ITEMS, 8 + 4 + 1 + 1 + 1 + 4 * 4 + 1);
+        list << uint64(_config.auctioneer);
+        list << uint32(0);                              // list from
+        list << std::string("");                        // searched name
+        list << uint8(0) << uint8(0);                   // level min, max
+        list << uint32(0xFFFFFFFF);                     // slot
+        list << uint32(0xFFFFFFFF);                     // main category
+        list << uint32(0xFFFFFFFF);                     // sub category
+        list << uint32(0xFFFFFFFF);                     // quality
+        list << uint8(0);                               // usable
+        Send(list);
+        _nextAuction = now + LOADGEN_AUCTION_INTERVAL;
+    }
+}
+
+/// Runs the bots index % threads == thread
+static void WorkerThread(LoadConfig const& config, uint32 thread)
+{
+    std::vector<Bot*> bots;
+    for (uint32 i = thread; i < config.count; i += config.threads)
+        bots.push_back(new Bot(config, config.first + i));
+
+    std::vector<pollfd> fds;
+    std::vector<ClientSocket*> sockets;
+
+    uint32 start = getMSTime();
+    size_t started = 0;
+
+    while (!s_stop)
+    {
+        uint32 now = getMSTime();
+
+        // ramp up, the rate is shared by the threads
+        size_t due = size_t(uint64(GetMSTimeDiff(start, now)) * config.rampPerSecond / 1000 / config.threads) + 1;
+        for (; started < bots.size() && started < due; ++started)
+            bots[started]->Start();
+
+        fds.clear();
+        sockets.clear();
+        for (size_t i = 0; i < started; ++i)
+        {
+            bots[i]->Update(now);
+
+            ClientSocket* socket = bots[i]->GetSocket();
+            if (!socket)
+                continue;
+
+            pollfd fd;
+            fd.fd = socket->GetHandle();
+            fd.events = POLLIN | (socket->WantWrite() ? POLLOUT : 0);
+            fd.revents = 0;
+            fds.push_back(fd);
+            sockets.push_back(socket);
+        }
+
+        if (fds.empty())
+        {
+            usleep(LOADGEN_POLL_TIMEOUT * 1000);
+            continue;
+        }
+
+        if (poll(&fds[0], fds.size(), LOADGEN_POLL_TIMEOUT) <= 0)
+            continue;
+
+        for (size_t i = 0; i < fds.size(); ++i)
+        {
+            if (fds[i].revents & (POLLIN | POLLERR | POLLHUP))
+                sockets[i]->HandleInput();
+            if (fds[i].revents & POLLOUT)
+                sockets[i]->HandleOutput();
+        }
+    }
+
+    for (size_t i = 0; i < bots.size(); ++i)
+        delete bots[i];
+}
+
+static uint32 Percentile(std::vector<uint32> const& sorted, float percentile)
+{
+    if (sorted.empty())
+        return 0;
+
+    size_t index = size_t(percentile / 100.0f * (sorted.size() - 1) + 0.5f);
+    return sorted[index];
+}
+
+static void PrintRtt(char const* name, std::vector<uint32> const& sorted)
+{
+    printf("  %-6s %7u samples  p50 %6.1f ms  p90 %6.1f ms  p99 %6.1f ms  max %6.1f ms\n", name, uint32(sorted.size()),
+        Percentile(sorted, 50) / 1000.0f, Percentile(sorted, 90) / 1000.0f, Percentile(sorted, 99) / 1000.0f,
+        (sorted.empty() ? 0 : sorted.back()) / 1000.0f);
+}
+
+static void PrintReport(uint32 elapsed)
+{
+    std::vector<uint32> ping, world;
+    s_stats.ping.TakeInterval(ping);
+    s_stats.world.TakeInterval(world);
+
+    printf("%6us in world %u | realm failed %u world failed %u disconnected %u | packets sent %llu received %llu\n",
+        elapsed / 1000, uint32(s_stats.inWorld), uint32(s_stats.realmFailed), uint32(s_stats.worldFailed), uint32(s_stats.disconnected),
+        (unsigned long long)s_stats.packetsSent, (unsigned long long)s_stats.packetsReceived);
+    PrintRtt("ping", ping);
+    PrintRtt("world", world);
+    fflush(stdout);
+}
+
+/// Create the accounts that do not exist yet
+static bool CreateAccounts(LoadConfig const& config)
+{
+    if (!LoginDatabase.Open(config.loginDatabase, 1))
+    {
+        printf("Cannot connect to the login database\n");
+        return false;
+    }
+
+    std::string prefix = config.prefix;
+    std::string password = config.password;
+    LoginDatabase.escape_string(prefix);
+    LoginDatabase.escape_string(password);
+
+    for (uint32 i = config.first; i < config.first + config.count; ++i)
+        LoginDatabase.DirectPExecute("INSERT IGNORE INTO account(username,sha_pass_hash,joindate,expansion) "
+            "VALUES(UPPER('%s%u'),SHA1(CONCAT(UPPER('%s%u'),':',UPPER('%s'))),NOW(),1)",
+            prefix.c_str(), i, prefix.c_str(), i, password.c_str());
+
+    LoginDatabase.DirectExecute("INSERT INTO realmcharacters (realmid, acctid, numchars) SELECT realmlist.id, account.id, 0 FROM realmlist,account LEFT JOIN realmcharacters ON acctid=account.id WHERE acctid IS NULL");
+
+    LoginDatabase.Close();
+    return true;
+}
+
+static bool ParseBehaviours(char const* list, uint32& behaviours)
+{
+    behaviours = 0;
+
+    std::string str = list;
+    std::string::size_type start = 0;
+    while (start <= str.size())
+    {
+        std::string::size_type end = str.find(',', start);
+        std::string name = str.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+        if (name == "move")
+            behaviours |= BEHAVIOUR_MOVE;
+        else if (name == "cast")
+            behaviours |= BEHAVIOUR_CAST;
+        else if (name == "chat")
+            behaviours |= BEHAVIOUR_CHAT;
+        else if (name == "ah")
+            behaviours |= BEHAVIOUR_AUCTION;
+        else if (!name.empty())
+            return false;
+
+        if (end == std::string::npos)
+            break;
+        start = end + 1;
+    }
+
+    return true;
+}
+
+static void Usage(char const* prog)
+{
+    printf("Usage: %s -r <host[:port]> [options]\n"
+        "    -r  realmd address, port 3724 by default\n"
+        "    -w  worldserver address, by default the address of the first realm of the list\n"
+        "    -n  number of bots (default 100)\n"
+        "    -f  index of the first account (default 1)\n"
+        "    -a  account prefix, accounts are PREFIX<index> (default LOADBOT)\n"
+        "    -p  password of the accounts (default loadbot)\n"
+        "    -l  login database \"host;port;user;password;database\", creates the missing accounts\n"
+        "    -b  behaviours, comma separated: move,cast,chat,ah (default move,cast,chat)\n"
+        "    -S  spell cast by the cast behaviour (default 168, Frost Armor)\n"
+        "    -A  guid of the auctioneer browsed by the ah behaviour\n"
+        "    -R  radius of the wandering around the login position (default 20)\n"
+        "    -u  bots started per second (default 20)\n"
+        "    -j  worker threads (default 1)\n"
+        "    -d  duration in seconds, 0 runs until interrupted (default 0)\n", prog);
+}
+
+static void ParseAddress(char const* arg, std::string& host, uint16& port)
+{
+    std::string address = arg;
+    std::string::size_type pos = address.find(':');
+    host = address.substr(0, pos);
+    if (pos != std::string::npos)
+        port = uint16(atoi(address.c_str() + pos + 1));
+}
+
+static void OnSignal(int)
+{
+    s_stop = true;
+}
+
+int main(int argc, char** argv)
+{
+    LoadConfig config;
+
+    int c;
+    while ((c = getopt(argc, argv, "r:w:n:f:a:p:l:b:S:A:R:u:j:d:h")) != -1)
+    {
+        switch (c)
+        {
+            case 'r': ParseAddress(optarg, config.realmHost, config.realmPort); break;
+            case 'w':
+                config.worldPort = 8085;
+                ParseAddress(optarg, config.worldHost, config.worldPort);
+                break;
+            case 'n': config.count = atoi(optarg); break;
+            case 'f': config.first = atoi(optarg); break;
+            case 'a': config.prefix = optarg; break;
+            case 'p': config.password = optarg; break;
+            case 'l': config.loginDatabase = optarg; break;
+            case 'b':
+                if (!ParseBehaviours(optarg, config.behaviours))
+                {
+                    Usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'S': config.spellId = atoi(optarg); break;
+            case 'A': config.auctioneer = strtoull(optarg, NULL, 10); break;
+            case 'R': config.radius = float(atof(optarg)); break;
+            case 'u': config.rampPerSecond = atoi(optarg); break;
+            case 'j': config.threads = atoi(optarg); break;
+            case 'd': config.duration = atoi(optarg); break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (config.realmHost.empty() || !config.count || !config.threads || !config.rampPerSecond)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    config.threads = std::min(config.threads, config.count);
+
+    if (!config.loginDatabase.empty() && !CreateAccounts(config))
+        return 1;
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::thread> workers;
+    for (uint32 i = 0; i < config.threads; ++i)
+        workers.push_back(std::thread(WorkerThread, std::cref(config), i));
+
+    uint32 start = getMSTime();
+    uint32 lastReport = 0;
+    while (!s_stop)
+    {
+        usleep(100 * 1000);
+
+        uint32 elapsed = GetMSTimeDiffToNow(start);
+        if (config.duration && elapsed >= config.duration * 1000)
+            s_stop = true;
+
+        if (elapsed - lastReport >= LOADGEN_REPORT_INTERVAL * 1000)
+        {
+            lastReport = elapsed;
+            PrintReport(elapsed);
+        }
+    }
+
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+
+    PrintReport(GetMSTimeDiffToNow(start));
+
+    std::vector<uint32> ping, world;
+    s_stats.ping.GetRun(ping);
+    s_stats.world.GetRun(world);
+    printf("whole run:\n");
+    PrintRtt("ping", ping);
+    PrintRtt("world", world);
+    return 0;
+}
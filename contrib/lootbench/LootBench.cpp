@@ -0,0 +1,437 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+/*
+ * Loot generation micro-benchmark.
+ *
+ * Fills loot from a synthetic set of loot templates like the ones of the
+ * world database: plain entries rolled one by one, references to shared
+ * reference templates and groups of explicitly and equally chanced items.
+ * The same templates are processed the former way (references looked up by
+ * id, drop rate looked up through the item quality, groups walked until the
+ * roll is spent) and the compiled way of LootTemplate::Compile (references
+ * and rates resolved at load, one alias table per group built by the
+ * LootAliasTable.h code LootMgr uses). Both runs use the same seed but not
+ * the same number of random draws, so the drops are compared as
+ * distributions: the count of every item must agree within the statistical
+ * error.
+ */
+
+#include "BenchCommon.h"
+#include "LootAliasTable.h"
+#include "Utilities/UnorderedMap.h"
+
+#include <algorithm>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+
+#define BENCH_QUALITIES 7
+
+struct BenchConfig
+{
+    BenchConfig() : templates(5000), references(500), items(30000), loots(2000000), seed(1) {}
+
+    uint32 templates;
+    uint32 references;                                      // reference templates
+    uint32 items;                                           // item entries
+    uint32 loots;                                           // filled loots
+    uint32 seed;
+};
+
+struct BenchResult
+{
+    BenchResult() : rolls(0), drops(0) {}
+
+    uint64 rolls;                                           // processed templates, references included
+    uint64 drops;
+    std::vector<uint64> counts;                             // drops by item entry
+};
+
+struct BenchStoreItem
+{
+    uint32 itemid;
+    float chance;
+    int32 mincountOrRef;                                    // negative for references
+    uint8 group;
+    uint8 maxcount;
+};
+
+class BenchTemplate;
+
+struct BenchCompiledEntry
+{
+    float chance;
+    uint32 rate;
+    BenchTemplate const* reference;
+    BenchStoreItem const* item;
+};
+
+typedef UNORDERED_MAP<uint32, BenchTemplate*> BenchTemplateMap;
+
+struct BenchWorld
+{
+    std::vector<uint8> quality;                             // by item entry, as the item prototypes
+    float rates[BENCH_QUALITIES + 1];                       // quality rates, then the reference rate
+    BenchTemplateMap references;
+    std::vector<BenchTemplate*> templates;
+};
+
+class BenchGroup
+{
+    public:
+        void AddEntry(BenchStoreItem const& item)
+        {
+            if (item.chance != 0)
+                m_explicit.push_back(item);
+            else
+                m_equal.push_back(item);
+        }
+
+        bool Empty() const { return m_explicit.empty() && m_equal.empty(); }
+
+        // former LootGroup::Roll
+        BenchStoreItem const* RollLegacy(BenchRandom& random) const
+        {
+            if (!m_explicit.empty())
+            {
+                float roll = float(random.NextChance());
+                for (uint32 i = 0; i < m_explicit.size(); ++i)
+                {
+                    if (m_explicit[i].chance >= 100.f)
+                        return &m_explicit[i];
+
+                    roll -= m_explicit[i].chance;
+                    if (roll < 0)
+                        return &m_explicit[i];
+                }
+            }
+            if (!m_equal.empty())
+                return &m_equal[random.Next(m_equal.size())];
+
+            return NULL;
+        }
+
+        void Compile() { BuildLootGroupTable(m_table, m_explicit, m_equal); }
+
+        BenchStoreItem const* RollCompiled(BenchRandom& random) const { return m_table.Roll(random.NextNorm()); }
+
+    private:
+        std::vector<BenchStoreItem> m_explicit;
+        std::vector<BenchStoreItem> m_equal;
+        LootAliasTable<BenchStoreItem> m_table;
+};
+
+class BenchTemplate
+{
+    public:
+        void AddEntry(BenchStoreItem const& item)
+        {
+            if (item.group > 0 && item.mincountOrRef > 0)
+            {
+                if (item.group > m_groups.size())
+                    m_groups.resize(item.group);
+                m_groups[item.group - 1].AddEntry(item);
+            }
+            else
+                m_entries.push_back(item);
+        }
+
+        uint32 GetGroupCount() const { return m_groups.size(); }
+
+        void Compile(BenchWorld const& world)
+        {
+            for (std::vector<BenchStoreItem>::const_iterator i = m_entries.begin(); i != m_entries.end(); ++i)
+            {
+                BenchCompiledEntry entry;
+                entry.chance = i->chance;
+                entry.item = &*i;
+                entry.reference = NULL;
+                entry.rate = world.quality[i->itemid];
+
+                if (i->mincountOrRef < 0)
+                {
+                    BenchTemplateMap::const_iterator ref = world.references.find(-i->mincountOrRef);
+                    if (ref == world.references.end())
+                        continue;
+                    entry.reference = ref->second;
+                    entry.rate = BENCH_QUALITIES;
+                }
+
+                m_compiled.push_back(entry);
+            }
+
+            for (std::vector<BenchGroup>::iterator i = m_groups.begin(); i != m_groups.end(); ++i)
+                i->Compile();
+        }
+
+        // former LootTemplate::Process
+        void ProcessLegacy(BenchWorld const& world, BenchRandom& random, BenchResult& result, uint8 groupId = 0) const
+        {
+            ++result.rolls;
+
+            if (groupId)
+            {
+                if (groupId <= m_groups.size())
+                    AddItem(m_groups[groupId - 1].RollLegacy(random), result);
+                return;
+            }
+
+            for (std::vector<BenchStoreItem>::const_iterator i = m_entries.begin(); i != m_entries.end(); ++i)
+            {
+                if (i->chance < 100.f)
+                {
+                    float rate = i->mincountOrRef < 0 ? world.rates[BENCH_QUALITIES] : world.rates[world.quality[i->itemid]];
+                    if (!(i->chance * rate > random.NextChance()))
+                        continue;
+                }
+
+                if (i->mincountOrRef < 0)
+                {
+                    BenchTemplateMap::const_iterator ref = world.references.find(-i->mincountOrRef);
+                    if (ref == world.references.end())
+                        continue;
+
+                    for (uint32 loop = 0; loop < i->maxcount; ++loop)
+                        ref->second->ProcessLegacy(world, random, result, i->group);
+                }
+                else
+                    AddItem(&*i, result);
+            }
+
+            for (std::vector<BenchGroup>::const_iterator i = m_groups.begin(); i != m_groups.end(); ++i)
+                AddItem(i->RollLegacy(random), result);
+        }
+
+        // LootTemplate::Process on the compiled entries
+        void ProcessCompiled(BenchWorld const& world, BenchRandom& random, BenchResult& result, uint8 groupId = 0) const
+        {
+            ++result.rolls;
+
+            if (groupId)
+            {
+                if (groupId <= m_groups.size())
+                    AddItem(m_groups[groupId - 1].RollCompiled(random), result);
+                return;
+            }
+
+            for (std::vector<BenchCompiledEntry>::const_iterator i = m_compiled.begin(); i != m_compiled.end(); ++i)
+            {
+                if (i->chance < 100.f && !(i->chance * world.rates[i->rate] > random.NextChance()))
+                    continue;
+
+                if (i->reference)
+                {
+                    for (uint32 loop = 0; loop < i->item->maxcount; ++loop)
+                        i->reference->ProcessCompiled(world, random, result, i->item->group);
+                }
+                else
+                    AddItem(i->item, result);
+            }
+
+            for (std::vector<BenchGroup>::const_iterator i = m_groups.begin(); i != m_groups.end(); ++i)
+                AddItem(i->RollCompiled(random), result);
+        }
+
+    private:
+        static void AddItem(BenchStoreItem const* item, BenchResult& result)
+        {
+            if (!item)
+                return;
+
+            ++result.drops;
+            ++result.counts[item->itemid];
+        }
+
+        std::vector<BenchStoreItem> m_entries;
+        std::vector<BenchGroup> m_groups;
+        std::vector<BenchCompiledEntry> m_compiled;
+};
+
+// group of 1-maxExplicit explicit entries summing to 20-100% and of 0-6 equal chanced entries,
+// some groups end with an entry of 100% which takes what the others leave
+static void AddGroup(BenchTemplate* lootTemplate, uint8 group, uint32 items, uint32 maxExplicit, BenchRandom& random)
+{
+    uint32 explicitCount = random.Next(4) ? 1 + random.Next(maxExplicit) : 0;
+    uint32 equalCount = random.Next(7);
+    if (!explicitCount && !equalCount)
+        equalCount = 1;
+
+    float total = explicitCount ? float(20 + random.Next(81)) : 0.0f;
+    for (uint32 i = 0; i < explicitCount; ++i)
+    {
+        BenchStoreItem item = { 1 + random.Next(items - 1), total / explicitCount, 1, group, 1 };
+        lootTemplate->AddEntry(item);
+    }
+
+    if (explicitCount && !random.Next(5))
+    {
+        BenchStoreItem item = { 1 + random.Next(items - 1), 100.0f, 1, group, 1 };
+        lootTemplate->AddEntry(item);
+    }
+
+    for (uint32 i = 0; i < equalCount; ++i)
+    {
+        BenchStoreItem item = { 1 + random.Next(items - 1), 0.0f, 1, group, 1 };
+        lootTemplate->AddEntry(item);
+    }
+}
+
+static BenchTemplate* CreateTemplate(BenchConfig const& config, BenchWorld const& world, bool reference, BenchRandom& random)
+{
+    BenchTemplate* lootTemplate = new BenchTemplate();
+
+    // plain entries, a few of them always drop
+    uint32 plainCount = 2 + random.Next(6);
+    for (uint32 i = 0; i < plainCount; ++i)
+    {
+        float chance = random.Next(10) ? float(random.Next(600) + 1) / 10.0f : 100.0f;
+        BenchStoreItem item = { 1 + random.Next(config.items - 1), chance, 1, 0, 1 };
+        lootTemplate->AddEntry(item);
+    }
+
+    // reference templates hold the world drops, their groups are much bigger
+    uint32 groupCount = random.Next(reference ? 3 : 4);
+    for (uint32 i = 0; i < groupCount; ++i)
+        AddGroup(lootTemplate, uint8(i + 1), config.items, reference ? 64 : 8, random);
+
+    // references to the whole reference template or to one of its groups
+    if (!reference && !world.references.empty())
+    {
+        uint32 refCount = random.Next(3);
+        for (uint32 i = 0; i < refCount; ++i)
+        {
+            uint32 refId = 1 + random.Next(world.references.size());
+            BenchTemplate const* referenced = world.references.find(refId)->second;
+            uint8 group = referenced->GetGroupCount() && random.Next(2) ? uint8(1 + random.Next(referenced->GetGroupCount())) : 0;
+            BenchStoreItem item = { 0, float(5 + random.Next(96)), -int32(refId), group, uint8(1 + random.Next(2)) };
+            lootTemplate->AddEntry(item);
+        }
+    }
+
+    return lootTemplate;
+}
+
+static void CreateWorld(BenchConfig const& config, BenchWorld& world)
+{
+    BenchRandom random(config.seed);
+
+    world.quality.resize(config.items);
+    for (uint32 i = 0; i < config.items; ++i)
+        world.quality[i] = uint8(random.Next(5));
+
+    // default rates of the config, a raised rare rate
+    for (uint32 i = 0; i <= BENCH_QUALITIES; ++i)
+        world.rates[i] = 1.0f;
+    world.rates[3] = 1.5f;
+
+    for (uint32 i = 1; i <= config.references; ++i)
+        world.references[i] = CreateTemplate(config, world, true, random);
+
+    for (uint32 i = 0; i < config.templates; ++i)
+        world.templates.push_back(CreateTemplate(config, world, false, random));
+
+    for (BenchTemplateMap::const_iterator i = world.references.begin(); i != world.references.end(); ++i)
+        i->second->Compile(world);
+    for (std::vector<BenchTemplate*>::const_iterator i = world.templates.begin(); i != world.templates.end(); ++i)
+        (*i)->Compile(world);
+}
+
+static double RunLoot(BenchConfig const& config, BenchWorld const& world, bool compiled, BenchResult& result)
+{
+    BenchRandom random(config.seed);
+    BenchRandom pick(config.seed + 1);                          // looted templates, same for both runs
+    result.counts.assign(config.items, 0);
+
+    BenchClock clock;
+
+    for (uint32 i = 0; i < config.loots; ++i)
+    {
+        BenchTemplate const* lootTemplate = world.templates[pick.Next(world.templates.size())];
+        if (compiled)
+            lootTemplate->ProcessCompiled(world, random, result);
+        else
+            lootTemplate->ProcessLegacy(world, random, result);
+    }
+
+    return clock.Elapsed();
+}
+
+// largest difference of the per item counts in standard deviations
+static double MaxDeviation(BenchResult const& left, BenchResult const& right)
+{
+    double worst = 0.0;
+    for (uint32 i = 0; i < left.counts.size(); ++i)
+    {
+        double sum = double(left.counts[i] + right.counts[i]);
+        if (sum == 0.0)
+            continue;
+
+        double deviation = fabs(double(left.counts[i]) - double(right.counts[i])) / sqrt(sum);
+        worst = std::max(worst, deviation);
+    }
+    return worst;
+}
+
+static void PrintRun(char const* name, BenchResult const& result, double seconds, uint32 loots)
+{
+    printf("%-9s %10llu rolls %10llu drops  %8.3f s  %8.0f loots/ms\n", name,
+        (unsigned long long)result.rolls, (unsigned long long)result.drops, seconds, loots / seconds / 1000.0);
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+
+    BenchOption const options[] =
+    {
+        { 't', &config.templates, 1, "loot templates" },
+        { 'f', &config.references, 0, "reference templates" },
+        { 'i', &config.items, 2, "item entries" },
+        { 'l', &config.loots, 1, "filled loots" },
+        { 'r', &config.seed, 0, "random seed" },
+    };
+
+    if (!BenchParseOptions(argc, argv, options))
+        return 1;
+
+    BenchWorld world;
+    CreateWorld(config, world);
+
+    BenchResult legacyResult, compiledResult;
+    double legacyTime = RunLoot(config, world, false, legacyResult);
+    double compiledTime = RunLoot(config, world, true, compiledResult);
+
+    PrintRun("legacy", legacyResult, legacyTime, config.loots);
+    PrintRun("compiled", compiledResult, compiledTime, config.loots);
+
+    // counts are binomial, a correct table stays well below 6 deviations on every item
+    double deviation = MaxDeviation(legacyResult, compiledResult);
+    printf("max item deviation %.2f sigma\n", deviation);
+    int result = BenchReport(deviation <= 6.0, "the compiled templates do not drop with the same chances", legacyTime, compiledTime);
+
+    for (BenchTemplateMap::const_iterator i = world.references.begin(); i != world.references.end(); ++i)
+        delete i->second;
+    for (std::vector<BenchTemplate*>::const_iterator i = world.templates.begin(); i != world.templates.end(); ++i)
+        delete *i;
+
+    return result;
+}
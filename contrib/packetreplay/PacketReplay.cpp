@@ -0,0 +1,479 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+/*
+ * Replays a binary packet capture (PacketCaptureFile of the worldserver)
+ * against a local worldserver, through its normal WorldSocket path.
+ *
+ * Every captured connection gets its own client connection, opened at the
+ * captured time, and its packets are sent with the captured timing (scaled
+ * by the speed factor) and order. The server answers are read and dropped,
+ * only SMSG_PONG is used to measure the round trip of the captured pings.
+ *
+ * The realm daemon is bypassed: the captured accounts must exist in the
+ * login database given with -l, the tool stores a fresh session key (and
+ * the matching v/s) for every replayed connection, like realmd does after
+ * a successful logon. Only use it against a test database.
+ *
+ * Tick time and server side throughput are read from the worldserver
+ * metrics (Metrics.Enable) during the replay.
+ */
+
+#include "Common.h"
+#include "WorldClient.h"
+#include "PacketCaptureDefines.h"
+#include "WorldPacket.h"
+#include "Opcodes.h"
+#include "SharedDefines.h"
+#include "Timer.h"
+#include "Database/DatabaseEnv.h"
+#include "Auth/BigNumber.h"
+#include "Auth/Sha1.h"
+
+#include <poll.h>
+#include <getopt.h>
+#include <signal.h>
+
+DatabaseType LoginDatabase;
+
+/// Seconds between two progress reports
+#define REPLAY_REPORT_INTERVAL  10
+
+/// Longest poll wait, bounds the lateness of the scheduled packets
+#define REPLAY_POLL_TIMEOUT     5
+
+struct ReplayStats
+{
+    ReplayStats() : sessionsOpened(0), sessionsAuthed(0), sessionsFailed(0), packetsSent(0), packetsReceived(0),
+        bytesSent(0), bytesReceived(0), pings(0), pingTotal(0), pingMax(0), maxLateness(0) {}
+
+    uint32 sessionsOpened;
+    uint32 sessionsAuthed;
+    uint32 sessionsFailed;                                  // auth refused or connection lost before AUTH_OK
+    uint64 packetsSent;
+    uint64 packetsReceived;
+    uint64 bytesSent;
+    uint64 bytesReceived;
+    uint32 pings;
+    uint64 pingTotal;                                       // ms
+    uint32 pingMax;                                         // ms
+    uint32 maxLateness;                                     // ms a record was applied after its schedule
+};
+
+static ReplayStats s_stats;
+static volatile bool s_stop = false;
+
+/// Connection replaying one captured session
+class ReplaySession : public WorldClient
+{
+    public:
+        ReplaySession() : _authed(false), _closeRequested(false), _pingSeq(0), _pingTime(0) {}
+
+        void SendCaptured(WorldPacket const& packet)
+        {
+            if (packet.GetOpcode() == CMSG_PING && packet.size() >= 4)
+            {
+                _pingSeq = packet.read<uint32>(0);
+                _pingTime = getMSTime();
+            }
+
+            SendPacket(packet);
+            ++s_stats.packetsSent;
+        }
+
+        /// Close once everything queued is sent
+        void RequestClose() { _closeRequested = true; }
+
+        /// Close a requested session when its output is sent
+        void Update()
+        {
+            if (_closeRequested && !IsClosed() && (!_authed || !WantWrite()))
+                Close();
+        }
+
+    protected:
+        void OnAuthResponse(uint8 result)
+        {
+            if (result == AUTH_OK)
+            {
+                _authed = true;
+                ++s_stats.sessionsAuthed;
+            }
+            else if (result != AUTH_WAIT_QUEUE)
+            {
+                ++s_stats.sessionsFailed;
+                Close();
+            }
+        }
+
+        void OnPacket(WorldPacket& packet)
+        {
+            ++s_stats.packetsReceived;
+
+            if (packet.GetOpcode() == SMSG_PONG && _pingTime && packet.size() >= 4 && packet.read<uint32>(0) == _pingSeq)
+            {
+                uint32 rtt = GetMSTimeDiffToNow(_pingTime);
+                ++s_stats.pings;
+                s_stats.pingTotal += rtt;
+                s_stats.pingMax = std::max(s_stats.pingMax, rtt);
+                _pingTime = 0;
+            }
+        }
+
+        void OnClose()
+        {
+            s_stats.bytesSent += GetBytesSent();
+            s_stats.bytesReceived += GetBytesReceived();
+
+            if (!_authed && !_closeRequested)
+                ++s_stats.sessionsFailed;
+        }
+
+    private:
+        bool _authed;
+        bool _closeRequested;
+        uint32 _pingSeq;
+        uint32 _pingTime;
+};
+
+typedef std::map<uint32, ReplaySession*> ReplaySessionMap;
+
+/// Store a new session key for the account, with the v/s the worldserver checks it against
+static bool PrepareAccount(std::string const& account, BigNumber& sessionKey)
+{
+    std::string safe_account = account;
+    LoginDatabase.escape_string(safe_account);
+
+    QueryResult* result = LoginDatabase.PQuery("SELECT sha_pass_hash FROM account WHERE username = '%s'", safe_account.c_str());
+    if (!result)
+        return false;
+
+    BigNumber I;
+    I.SetHexStr((*result)[0].GetString());
+    delete result;
+
+    // same computation as AuthSocket::_SetVSFields
+    uint8 mDigest[SHA_DIGEST_LENGTH];
+    memset(mDigest, 0, SHA_DIGEST_LENGTH);
+    if (I.GetNumBytes() <= SHA_DIGEST_LENGTH)
+        memcpy(mDigest, I.AsByteArray(), I.GetNumBytes());
+    std::reverse(mDigest, mDigest + SHA_DIGEST_LENGTH);
+
+    BigNumber s, N, g;
+    s.SetRand(32 * 8);
+    N.SetHexStr("894B645E89E1535BBDAD5B8B290650530801B18EBFBF5E8FAB3C82872A3E9BB7");
+    g.SetDword(7);
+
+    Sha1Hash sha;
+    sha.UpdateData(s.AsByteArray(), s.GetNumBytes());
+    sha.UpdateData(mDigest, SHA_DIGEST_LENGTH);
+    sha.Finalize();
+    BigNumber x;
+    x.SetBinary(sha.GetDigest(), sha.GetLength());
+    BigNumber v = g.ModExp(x, N);
+
+    sessionKey.SetRand(40 * 8);
+
+    const char* K_hex = sessionKey.AsHexStr();
+    const char* v_hex = v.AsHexStr();
+    const char* s_hex = s.AsHexStr();
+    LoginDatabase.DirectPExecute("UPDATE account SET sessionkey = '%s', v = '%s', s = '%s' WHERE username = '%s'",
+        K_hex, v_hex, s_hex, safe_account.c_str());
+    OPENSSL_free((void*)K_hex);
+    OPENSSL_free((void*)v_hex);
+    OPENSSL_free((void*)s_hex);
+    return true;
+}
+
+/// Reads the capture one record at a time
+class CaptureReader
+{
+    public:
+        CaptureReader() : _file(NULL) {}
+        ~CaptureReader() { if (_file) fclose(_file); }
+
+        bool Open(char const* filename)
+        {
+            _file = fopen(filename, "rb");
+            if (!_file)
+                return false;
+
+            PacketCaptureFileHeader header;
+            if (fread(&header, sizeof(header), 1, _file) != 1 || header.magic != PACKET_CAPTURE_MAGIC)
+                return false;
+
+            if (header.version != PACKET_CAPTURE_VERSION)
+            {
+                printf("Unsupported capture version %u\n", header.version);
+                return false;
+            }
+
+            return true;
+        }
+
+        /// false at the end of the capture (a truncated last record is dropped)
+        bool Next(PacketCaptureRecordHeader& record, std::vector<uint8>& payload)
+        {
+            if (fread(&record, sizeof(record), 1, _file) != 1)
+                return false;
+
+            payload.resize(record.size);
+            return !record.size || fread(&payload[0], record.size, 1, _file) == 1;
+        }
+
+    private:
+        FILE* _file;
+};
+
+struct ReplayConfig
+{
+    ReplayConfig() : port(8085), speed(1.0f) {}
+
+    std::string capture;
+    std::string host;
+    uint16 port;
+    std::string loginDatabase;
+    float speed;
+};
+
+static void ApplyRecord(ReplayConfig const& config, ReplaySessionMap& sessions, PacketCaptureRecordHeader const& record, std::vector<uint8> const& payload)
+{
+    switch (record.type)
+    {
+        case CAPTURE_SESSION_OPEN:
+        {
+            if (record.size < 4 || sessions.find(record.session) != sessions.end())
+                break;
+
+            std::string account((char const*)&payload[4], record.size - 4);
+
+            BigNumber K;
+            if (!PrepareAccount(account, K))
+            {
+                printf("Account %s not found in the login database, session %u skipped\n", account.c_str(), record.session);
+                ++s_stats.sessionsFailed;
+                break;
+            }
+
+            ReplaySession* session = new ReplaySession();
+            if (!session->Connect(config.host, config.port, account, K))
+            {
+                printf("Cannot connect to %s:%u\n", config.host.c_str(), config.port);
+                delete session;
+                ++s_stats.sessionsFailed;
+                break;
+            }
+
+            sessions[record.session] = session;
+            ++s_stats.sessionsOpened;
+            break;
+        }
+        case CAPTURE_CLIENT_PACKET:
+        {
+            ReplaySessionMap::iterator itr = sessions.find(record.session);
+            if (itr == sessions.end())
+                break;
+
+            WorldPacket packet(record.opcode, record.size);
+            if (record.size)
+                packet.append(&payload[0], record.size);
+            itr->second->SendCaptured(packet);
+            break;
+        }
+        case CAPTURE_SESSION_CLOSE:
+        {
+            ReplaySessionMap::iterator itr = sessions.find(record.session);
+            if (itr != sessions.end())
+                itr->second->RequestClose();
+            break;
+        }
+    }
+}
+
+static void PrintStats(uint32 elapsed, size_t active)
+{
+    float seconds = elapsed / 1000.0f;
+    printf("%6.1fs sessions %u open %u authed %u failed %u active | packets sent %llu (%.0f/s) received %llu | ping avg %u ms max %u ms | late %u ms\n",
+        seconds, s_stats.sessionsOpened, s_stats.sessionsAuthed, s_stats.sessionsFailed, uint32(active),
+        (unsigned long long)s_stats.packetsSent, seconds > 0 ? s_stats.packetsSent / seconds : 0.0f,
+        (unsigned long long)s_stats.packetsReceived,
+        s_stats.pings ? uint32(s_stats.pingTotal / s_stats.pings) : 0, s_stats.pingMax, s_stats.maxLateness);
+    fflush(stdout);
+}
+
+static void Usage(char const* prog)
+{
+    printf("Usage: %s -c <capture> -w <host[:port]> -l <login database info> [-s <speed>]\n"
+        "    -c  capture file written by the worldserver (PacketCaptureFile)\n"
+        "    -w  worldserver address, port 8085 by default\n"
+        "    -l  login database of the test realm, \"host;port;user;password;database\"\n"
+        "        session keys of the captured accounts are overwritten\n"
+        "    -s  replay speed factor, 2 replays twice as fast (default 1)\n", prog);
+}
+
+static void OnSignal(int)
+{
+    s_stop = true;
+}
+
+int main(int argc, char** argv)
+{
+    ReplayConfig config;
+
+    int c;
+    while ((c = getopt(argc, argv, "c:w:l:s:h")) != -1)
+    {
+        switch (c)
+        {
+            case 'c': config.capture = optarg; break;
+            case 'w':
+            {
+                std::string address = optarg;
+                std::string::size_type pos = address.find(':');
+                config.host = address.substr(0, pos);
+                if (pos != std::string::npos)
+                    config.port = uint16(atoi(address.c_str() + pos + 1));
+                break;
+            }
+            case 'l': config.loginDatabase = optarg; break;
+            case 's': config.speed = float(atof(optarg)); break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (config.capture.empty() || config.host.empty() || config.loginDatabase.empty() || config.speed <= 0.0f)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    CaptureReader reader;
+    if (!reader.Open(config.capture.c_str()))
+    {
+        printf("Cannot read capture %s\n", config.capture.c_str());
+        return 1;
+    }
+
+    if (!LoginDatabase.Open(config.loginDatabase, 1))
+    {
+        printf("Cannot connect to the login database\n");
+        return 1;
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    ReplaySessionMap sessions;
+    std::vector<pollfd> fds;
+    std::vector<ReplaySession*> polled;
+
+    PacketCaptureRecordHeader record;
+    std::vector<uint8> payload;
+    bool haveRecord = reader.Next(record, payload);
+
+    uint32 start = getMSTime();
+    uint32 lastReport = 0;
+
+    while (!s_stop && (haveRecord || !sessions.empty()))
+    {
+        uint32 elapsed = GetMSTimeDiffToNow(start);
+
+        // apply everything due, in capture order
+        while (haveRecord)
+        {
+            uint32 due = uint32(record.time / config.speed);
+            if (due > elapsed)
+                break;
+
+            s_stats.maxLateness = std::max(s_stats.maxLateness, elapsed - due);
+            ApplyRecord(config, sessions, record, payload);
+            haveRecord = reader.Next(record, payload);
+        }
+
+        fds.clear();
+        polled.clear();
+        for (ReplaySessionMap::iterator itr = sessions.begin(); itr != sessions.end();)
+        {
+            ReplaySession* session = itr->second;
+            session->Update();
+
+            if (session->IsClosed())
+            {
+                delete session;
+                sessions.erase(itr++);
+                continue;
+            }
+
+            pollfd fd;
+            fd.fd = session->GetHandle();
+            fd.events = POLLIN | (session->WantWrite() ? POLLOUT : 0);
+            fd.revents = 0;
+            fds.push_back(fd);
+            polled.push_back(session);
+            ++itr;
+        }
+
+        int timeout = REPLAY_POLL_TIMEOUT;
+        if (haveRecord)
+        {
+            uint32 due = uint32(record.time / config.speed);
+            elapsed = GetMSTimeDiffToNow(start);
+            timeout = due > elapsed ? std::min<int>(timeout, due - elapsed) : 0;
+        }
+
+        if (fds.empty())
+        {
+            if (timeout)
+                usleep(timeout * 1000);
+        }
+        else if (poll(&fds[0], fds.size(), timeout) > 0)
+        {
+            for (size_t i = 0; i < fds.size(); ++i)
+            {
+                if (fds[i].revents & (POLLIN | POLLERR | POLLHUP))
+                    polled[i]->HandleInput();
+                if (fds[i].revents & POLLOUT)
+                    polled[i]->HandleOutput();
+            }
+        }
+
+        elapsed = GetMSTimeDiffToNow(start);
+        if (elapsed - lastReport >= REPLAY_REPORT_INTERVAL * 1000)
+        {
+            lastReport = elapsed;
+            PrintStats(elapsed, sessions.size());
+        }
+    }
+
+    for (ReplaySessionMap::iterator itr = sessions.begin(); itr != sessions.end(); ++itr)
+    {
+        itr->second->Close();
+        delete itr->second;
+    }
+
+    PrintStats(GetMSTimeDiffToNow(start), 0);
+    printf("bytes sent %llu received %llu\n", (unsigned long long)s_stats.bytesSent, (unsigned long long)s_stats.bytesReceived);
+
+    LoginDatabase.Close();
+    return 0;
+}
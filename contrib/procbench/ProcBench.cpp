@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * Proc dispatch micro-benchmark.
+ *
+ * Replays the proc events of a 25 man raid on one boss: every player carries
+ * raid buffs, passive talents and a few auras able to proc (talents, trinkets,
+ * enchants), the boss carries the debuffs of the raid. Every melee swing,
+ * spell hit or periodic tick is a proc event on the attacker and on the
+ * victim, the boss swings at the tanks, some procs trigger a nested event on
+ * their owner, and buffs fall off and are applied again all along.
+ * The auras are kept in the AuraStorage of Unit (AuraStorage.cpp is built in),
+ * the Aura objects are stand-ins carrying their proc flags. Candidates are
+ * collected the former way (new vector per event, walk of every aura of the
+ * unit) and the way of Unit::ProcDamageAndSpellFor (proc buckets of the
+ * storage, one reused buffer per proc depth). Both must visit the same auras
+ * in the same order, the checksums are compared.
+ */
+
+#include "BenchCommon.h"
+#include "AuraStorage.h"
+
+#include <vector>
+#include <stdio.h>
+
+#define BENCH_PROC_DEPTH 5                                  // MAX_PROC_DEPTH of Unit.h
+
+// proc flags of SpellMgr.h the events and auras are built from
+enum BenchProcFlags
+{
+    BENCH_PROC_MELEE_HIT        = 0x00000004,               // PROC_FLAG_SUCCESSFUL_MELEE_HIT
+    BENCH_PROC_TAKEN_MELEE_HIT  = 0x00000008,               // PROC_FLAG_TAKEN_MELEE_HIT
+    BENCH_PROC_MELEE_SPELL_HIT  = 0x00000010,               // PROC_FLAG_SUCCESSFUL_MELEE_SPELL_HIT
+    BENCH_PROC_TAKEN_MELEE_SPELL= 0x00000020,               // PROC_FLAG_TAKEN_MELEE_SPELL_HIT
+    BENCH_PROC_POSITIVE_SPELL   = 0x00004000,               // PROC_FLAG_SUCCESSFUL_POSITIVE_SPELL
+    BENCH_PROC_NEGATIVE_SPELL   = 0x00010000,               // PROC_FLAG_SUCCESSFUL_NEGATIVE_SPELL_HIT
+    BENCH_PROC_TAKEN_NEGATIVE   = 0x00020000,               // PROC_FLAG_TAKEN_NEGATIVE_SPELL_HIT
+    BENCH_PROC_DO_PERIODIC      = 0x00040000,               // PROC_FLAG_ON_DO_PERIODIC
+    BENCH_PROC_TAKE_PERIODIC    = 0x00080000,               // PROC_FLAG_ON_TAKE_PERIODIC
+    BENCH_PROC_TAKEN_DAMAGE     = 0x00100000,               // PROC_FLAG_TAKEN_ANY_DAMAGE
+};
+
+static uint32 const s_auraProcFlags[] =
+{
+    BENCH_PROC_MELEE_HIT,                                                   // weapon enchant
+    BENCH_PROC_MELEE_HIT | BENCH_PROC_MELEE_SPELL_HIT,                      // talent on melee
+    BENCH_PROC_NEGATIVE_SPELL,                                              // caster trinket
+    BENCH_PROC_NEGATIVE_SPELL | BENCH_PROC_DO_PERIODIC,                     // dot talent
+    BENCH_PROC_POSITIVE_SPELL,                                              // healer trinket
+    BENCH_PROC_TAKEN_MELEE_HIT | BENCH_PROC_TAKEN_MELEE_SPELL,               // tank talent
+    BENCH_PROC_TAKEN_DAMAGE,                                                // shields
+    BENCH_PROC_TAKEN_NEGATIVE | BENCH_PROC_TAKE_PERIODIC,                   // debuff on the boss
+};
+
+#define BENCH_AURA_PROC_FLAGS (sizeof(s_auraProcFlags) / sizeof(s_auraProcFlags[0]))
+
+// stand-in of the aura object, AuraStorage only stores the pointer
+class Aura
+{
+    public:
+        Aura() : spellId(0), auraType(0), procFlags(0) {}
+
+        uint32 spellId;
+        uint32 auraType;
+        uint32 procFlags;
+};
+
+struct BenchConfig
+{
+    BenchConfig() : players(25), tanks(2), seconds(3600), buffs(30), procs(6), debuffs(2), hits(10), churn(2), seed(1) {}
+
+    uint32 players;
+    uint32 tanks;
+    uint32 seconds;                                         // encounter length
+    uint32 buffs;                                           // auras without proc flags per player
+    uint32 procs;                                           // auras with proc flags per player
+    uint32 debuffs;                                         // auras per player on the boss
+    uint32 hits;                                            // attacks per second and per player
+    uint32 churn;                                           // auras reapplied per second and per unit
+    uint32 seed;
+};
+
+struct BenchResult
+{
+    BenchResult() : events(0), candidates(0), checksum(BENCH_CHECKSUM_SEED) {}
+
+    uint64 events;
+    uint64 candidates;
+    uint64 checksum;                                        // every candidate of every event
+};
+
+struct BenchUnit
+{
+    AuraStorage storage;
+    std::vector<Aura*> auras;
+};
+
+// the dispatch before the proc buckets
+class ScanDispatch
+{
+    public:
+        template<class Visit>
+        void Dispatch(AuraStorage const& storage, uint32 procFlag, uint32 /*depth*/, Visit& visit)
+        {
+            std::vector<Aura*> procCandidates;
+            for (AuraStorage::const_iterator itr = storage.begin(); itr != storage.end(); ++itr)
+                if (itr->second->procFlags & procFlag)
+                    procCandidates.push_back(itr->second);
+
+            for (std::vector<Aura*>::const_iterator itr = procCandidates.begin(); itr != procCandidates.end(); ++itr)
+                visit(*itr);
+        }
+};
+
+// Unit::ProcDamageAndSpellFor
+class BucketDispatch
+{
+    public:
+        template<class Visit>
+        void Dispatch(AuraStorage const& storage, uint32 procFlag, uint32 depth, Visit& visit)
+        {
+            std::vector<Aura*>& procCandidates = m_procCandidates[depth];
+            procCandidates.clear();
+            storage.GetProcCandidates(procFlag, procCandidates);
+
+            for (std::vector<Aura*>::const_iterator itr = procCandidates.begin(); itr != procCandidates.end(); ++itr)
+                visit(*itr);
+        }
+
+    private:
+        std::vector<Aura*> m_procCandidates[BENCH_PROC_DEPTH];
+};
+
+template<class Dispatcher>
+class BenchRaid
+{
+    public:
+        BenchRaid(BenchConfig const& config, BenchResult& result) : m_config(config), m_result(result), m_rand(config.seed), m_owner(NULL), m_depth(0), m_nextSpell(1)
+        {
+            m_units.resize(config.players + 1);
+            for (uint32 i = 0; i < config.players; ++i)
+            {
+                for (uint32 j = 0; j < config.buffs; ++j)
+                    AddAura(m_units[i], 0);
+                for (uint32 j = 0; j < config.procs; ++j)
+                    AddAura(m_units[i], s_auraProcFlags[m_rand.Next(BENCH_AURA_PROC_FLAGS)]);
+            }
+
+            // debuffs, a few of them proc on the hits the boss takes
+            for (uint32 i = 0; i < config.players * config.debuffs; ++i)
+                AddAura(Boss(), m_rand.Next(8) ? 0 : s_auraProcFlags[BENCH_AURA_PROC_FLAGS - 1 - m_rand.Next(2)]);
+        }
+
+        ~BenchRaid()
+        {
+            for (std::vector<BenchUnit>::iterator itr = m_units.begin(); itr != m_units.end(); ++itr)
+                for (std::vector<Aura*>::iterator aura = itr->auras.begin(); aura != itr->auras.end(); ++aura)
+                    delete *aura;
+        }
+
+        void Run()
+        {
+            uint32 swingsPerSecond = 2 * m_config.tanks;
+            for (uint32 second = 0; second < m_config.seconds; ++second)
+            {
+                for (uint32 i = 0; i < m_config.players * m_config.hits; ++i)
+                {
+                    BenchUnit& player = m_units[m_rand.Next(m_config.players)];
+                    switch (m_rand.Next(4))
+                    {
+                        case 0:
+                            Proc(player, Boss(), BENCH_PROC_MELEE_HIT, BENCH_PROC_TAKEN_MELEE_HIT | BENCH_PROC_TAKEN_DAMAGE);
+                            break;
+                        case 1:
+                            Proc(player, Boss(), BENCH_PROC_MELEE_SPELL_HIT, BENCH_PROC_TAKEN_MELEE_SPELL | BENCH_PROC_TAKEN_DAMAGE);
+                            break;
+                        case 2:
+                            Proc(player, Boss(), BENCH_PROC_NEGATIVE_SPELL, BENCH_PROC_TAKEN_NEGATIVE | BENCH_PROC_TAKEN_DAMAGE);
+                            break;
+                        default:
+                            Proc(player, Boss(), BENCH_PROC_DO_PERIODIC, BENCH_PROC_TAKE_PERIODIC | BENCH_PROC_TAKEN_DAMAGE);
+                            break;
+                    }
+                }
+
+                // the boss swings at the tanks, the healers answer
+                for (uint32 i = 0; i < swingsPerSecond; ++i)
+                {
+                    BenchUnit& tank = m_units[m_rand.Next(m_config.tanks)];
+                    Proc(Boss(), tank, BENCH_PROC_MELEE_HIT, BENCH_PROC_TAKEN_MELEE_HIT | BENCH_PROC_TAKEN_DAMAGE);
+                    Proc(m_units[m_rand.Next(m_config.players)], tank, BENCH_PROC_POSITIVE_SPELL, 0);
+                }
+
+                for (uint32 i = 0; i < m_units.size(); ++i)
+                    for (uint32 j = 0; j < m_config.churn; ++j)
+                        Reapply(m_units[i]);
+            }
+        }
+
+        void operator()(Aura* aura)
+        {
+            m_result.checksum = BenchChecksum(m_result.checksum, aura->spellId);
+            ++m_result.candidates;
+
+            // a proc casting a spell on its own, the handlers of Unit run inside the candidate loop
+            if (aura->spellId % 16 == 0 && m_depth + 1 < BENCH_PROC_DEPTH)
+                Event(*m_owner, BENCH_PROC_NEGATIVE_SPELL);
+        }
+
+    private:
+        BenchUnit& Boss() { return m_units.back(); }
+
+        void AddAura(BenchUnit& unit, uint32 procFlags)
+        {
+            Aura* aura = new Aura();
+            aura->procFlags = procFlags;
+            Apply(unit, aura);
+            unit.auras.push_back(aura);
+        }
+
+        void Apply(BenchUnit& unit, Aura* aura)
+        {
+            aura->spellId = m_nextSpell++;
+            aura->auraType = m_rand.Next(TOTAL_AURAS);
+            unit.storage.insert(AuraStorage::value_type(AuraStorage::key_type(aura->spellId, 0), aura), aura->auraType, aura->procFlags);
+        }
+
+        // a buff falls off and is cast again, a new spell id keeps the storage order moving
+        void Reapply(BenchUnit& unit)
+        {
+            Aura* aura = unit.auras[m_rand.Next(unit.auras.size())];
+            AuraStorage::const_iterator itr = unit.storage.find(AuraStorage::key_type(aura->spellId, 0));
+            for (; itr != unit.storage.end(); ++itr)
+                if (itr->second == aura && unit.storage.erase(itr))
+                    break;
+
+            unit.storage.Compact();                         // _DeleteAuras
+            Apply(unit, aura);
+        }
+
+        void Proc(BenchUnit& attacker, BenchUnit& victim, uint32 procAttacker, uint32 procVictim)
+        {
+            m_depth = 0;
+            if (procAttacker)
+                Event(attacker, procAttacker);
+            if (procVictim)
+                Event(victim, procVictim);
+        }
+
+        void Event(BenchUnit& unit, uint32 procFlag)
+        {
+            BenchUnit* owner = m_owner;
+            ++m_result.events;
+            m_owner = &unit;
+            m_dispatcher.Dispatch(unit.storage, procFlag, m_depth++, *this);
+            --m_depth;
+            m_owner = owner;
+        }
+
+        BenchConfig const& m_config;
+        BenchResult& m_result;
+        BenchRandom m_rand;
+        Dispatcher m_dispatcher;
+        std::vector<BenchUnit> m_units;
+        BenchUnit* m_owner;
+        uint32 m_depth;
+        uint32 m_nextSpell;
+};
+
+template<class Dispatcher>
+static double RunRaid(BenchConfig const& config, BenchResult& result)
+{
+    BenchRaid<Dispatcher> raid(config, result);
+
+    BenchClock clock;
+    raid.Run();
+    return clock.Elapsed();
+}
+
+static void PrintRun(char const* name, BenchResult const& result, double seconds)
+{
+    printf("%-7s %10llu events %11llu candidates  %8.3f s  %6.1f ns/event  checksum %016llx\n", name,
+        (unsigned long long)result.events, (unsigned long long)result.candidates, seconds,
+        seconds * 1e9 / double(result.events ? result.events : 1), (unsigned long long)result.checksum);
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+
+    BenchOption const options[] =
+    {
+        { 'p', &config.players, 1, "players in the raid" },
+        { 't', &config.tanks, 1, "tanks the boss swings at" },
+        { 's', &config.seconds, 0, "encounter length in seconds" },
+        { 'b', &config.buffs, 0, "auras without proc flags per player" },
+        { 'c', &config.procs, 0, "auras with proc flags per player" },
+        { 'd', &config.debuffs, 1, "auras per player on the boss" },
+        { 'a', &config.hits, 0, "attacks per second and per player" },
+        { 'u', &config.churn, 0, "auras reapplied per second and per unit" },
+        { 'r', &config.seed, 0, "random seed" },
+    };
+
+    if (!BenchParseOptions(argc, argv, options))
+        return 1;
+
+    if (config.tanks > config.players)
+        config.tanks = config.players;
+
+    BenchResult scan, bucket;
+    double scanTime = RunRaid<ScanDispatch>(config, scan);
+    double bucketTime = RunRaid<BucketDispatch>(config, bucket);
+
+    PrintRun("scan", scan, scanTime);
+    PrintRun("bucket", bucket, bucketTime);
+
+    return BenchReport(scan.checksum == bucket.checksum, "the proc buckets did not return the same auras", scanTime, bucketTime);
+}
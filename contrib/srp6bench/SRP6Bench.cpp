@@ -0,0 +1,409 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * SRP6 logon micro-benchmark.
+ *
+ * Runs complete logon handshakes without sockets or database: the server
+ * computes the verifier of the account and B for the challenge, a client
+ * answers with A and its proof M1, the server computes the session key,
+ * checks M1 and builds M2. Only the server side is timed, the result is in
+ * handshakes per second and per core.
+ * The server side runs the former way (N and g set up by every connection,
+ * BigNumber::ModExp, H(N) xor H(g) hashed by every proof) and through the
+ * SRP6 class of realmd (Auth/SRP6.cpp, shared N, g, Montgomery context of
+ * N and H(N) xor H(g)). Both start from the same s, b and a: B, K and M2
+ * must agree, the checksums are compared, and every client proof must be
+ * accepted. The verifier cache of AuthSocket is not used, every handshake
+ * computes v.
+ */
+
+#include "BenchCommon.h"
+#include "Auth/BigNumber.h"
+#include "Auth/Sha1.h"
+#include "Auth/SRP6.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_MODULUS "894B645E89E1535BBDAD5B8B290650530801B18EBFBF5E8FAB3C82872A3E9BB7"
+
+struct BenchConfig
+{
+    BenchConfig() : handshakes(20000), accounts(1000), threads(1), seed(1) {}
+
+    uint32 handshakes;                                      // per thread
+    uint32 accounts;
+    uint32 threads;
+    uint32 seed;
+};
+
+struct BenchResult
+{
+    BenchResult() : handshakes(0), accepted(0), seconds(0.0), checksum(BENCH_CHECKSUM_SEED) {}
+
+    uint64 handshakes;
+    uint64 accepted;                                        // client proofs matching the server one
+    double seconds;                                         // server side only
+    uint64 checksum;                                        // B and M2 of every handshake
+};
+
+struct BenchAccount
+{
+    std::string login;                                      // upper case, as the client sends it
+    uint8 passHash[SHA_DIGEST_LENGTH];                      // H(I:P), the client side of sha_pass_hash
+    std::string shaPassHash;                                // account.sha_pass_hash
+    BigNumber s;
+};
+
+// numbits random bits with the top one set, from the bench generator instead of the OpenSSL one
+static void BenchSetRand(BigNumber& bn, BenchRandom& rand, int numbits)
+{
+    uint8 bytes[64];
+    int len = (numbits + 7) / 8;
+    for (int i = 0; i < len; ++i)
+        bytes[i] = uint8(rand.Next(256));
+    bytes[len - 1] |= 0x80;
+    bn.SetBinary(bytes, len);
+}
+
+// session key, interleaved hashes of S as in SRP6::ComputeSessionKey
+static void BenchSessionKey(BigNumber& S, BigNumber& K)
+{
+    uint8 t[32];
+    uint8 t1[16];
+    uint8 vK[40];
+    memset(t, 0, 32);
+    memcpy(t, S.AsByteArray(), std::min(S.GetNumBytes(), 32));
+
+    Sha1Hash sha;
+    for (int half = 0; half < 2; ++half)
+    {
+        for (int i = 0; i < 16; ++i)
+            t1[i] = t[i * 2 + half];
+        sha.Initialize();
+        sha.UpdateData(t1, 16);
+        sha.Finalize();
+        for (int i = 0; i < 20; ++i)
+            vK[i * 2 + half] = sha.GetDigest()[i];
+    }
+    K.SetBinary(vK, 40);
+}
+
+// M1 = H(H(N) xor H(g), H(I), s, A, B, K)
+static void BenchClientProof(uint8 const* ngHash, std::string const& login, BigNumber& s, BigNumber& A, BigNumber& B, BigNumber& K, BigNumber& M)
+{
+    BigNumber t3;
+    t3.SetBinary(ngHash, SHA_DIGEST_LENGTH);
+
+    Sha1Hash sha;
+    sha.UpdateData(login);
+    sha.Finalize();
+    uint8 t4[SHA_DIGEST_LENGTH];
+    memcpy(t4, sha.GetDigest(), SHA_DIGEST_LENGTH);
+
+    sha.Initialize();
+    sha.UpdateBigNumbers(&t3, NULL);
+    sha.UpdateData(t4, SHA_DIGEST_LENGTH);
+    sha.UpdateBigNumbers(&s, &A, &B, &K, NULL);
+    sha.Finalize();
+    M.SetBinary(sha.GetDigest(), 20);
+}
+
+// x = H(s, P), P the sha_pass_hash digest
+static void BenchPrivateKey(BigNumber& s, uint8 const* passHash, BigNumber& x)
+{
+    Sha1Hash sha;
+    sha.UpdateData(s.AsByteArray(), s.GetNumBytes());
+    sha.UpdateData(passHash, SHA_DIGEST_LENGTH);
+    sha.Finalize();
+    x.SetBinary(sha.GetDigest(), sha.GetLength());
+}
+
+// logon server side before SRP6, one per connection
+class LegacyServer
+{
+    public:
+        LegacyServer()
+        {
+            N.SetHexStr(BENCH_MODULUS);
+            g.SetDword(7);
+        }
+
+        void Challenge(BenchAccount& account, BigNumber const& serverB)
+        {
+            BigNumber I;
+            I.SetHexStr(account.shaPassHash.c_str());
+
+            uint8 mDigest[SHA_DIGEST_LENGTH];
+            memset(mDigest, 0, SHA_DIGEST_LENGTH);
+            if (I.GetNumBytes() <= SHA_DIGEST_LENGTH)
+                memcpy(mDigest, I.AsByteArray(), I.GetNumBytes());
+            std::reverse(mDigest, mDigest + SHA_DIGEST_LENGTH);
+
+            BigNumber x;
+            BenchPrivateKey(account.s, mDigest, x);
+            v = g.ModExp(x, N);
+
+            b = serverB;
+            BigNumber gmod = g.ModExp(b, N);
+            B = ((v * SRP6_K) + gmod) % N;
+        }
+
+        void Proof(BenchAccount& account, BigNumber& A, BigNumber& M, uint8* M2)
+        {
+            Sha1Hash sha;
+            sha.UpdateBigNumbers(&A, &B, NULL);
+            sha.Finalize();
+            BigNumber u;
+            u.SetBinary(sha.GetDigest(), 20);
+            BigNumber S = (A * (v.ModExp(u, N))).ModExp(b, N);
+            BenchSessionKey(S, K);
+
+            uint8 ngHash[SHA_DIGEST_LENGTH];
+            sha.Initialize();
+            sha.UpdateBigNumbers(&N, NULL);
+            sha.Finalize();
+            memcpy(ngHash, sha.GetDigest(), SHA_DIGEST_LENGTH);
+            sha.Initialize();
+            sha.UpdateBigNumbers(&g, NULL);
+            sha.Finalize();
+            for (int i = 0; i < SHA_DIGEST_LENGTH; ++i)
+                ngHash[i] ^= sha.GetDigest()[i];
+            BenchClientProof(ngHash, account.login, account.s, A, B, K, M);
+
+            sha.Initialize();
+            sha.UpdateBigNumbers(&A, &M, &K, NULL);
+            sha.Finalize();
+            memcpy(M2, sha.GetDigest(), SHA_DIGEST_LENGTH);
+        }
+
+        BigNumber N, g, v, b, B, K;
+};
+
+// logon server side of AuthSocket
+class SRP6Server
+{
+    public:
+        explicit SRP6Server(SRP6 const& srp) : _srp(srp) {}
+
+        void Challenge(BenchAccount& account, BigNumber const& serverB)
+        {
+            v = _srp.ComputeVerifier(account.s, account.shaPassHash);
+            b = serverB;
+            B = _srp.ComputeB(v, b);
+        }
+
+        void Proof(BenchAccount& account, BigNumber& A, BigNumber& M, uint8* M2)
+        {
+            K = _srp.ComputeSessionKey(A, B, v, b);
+            M = _srp.ComputeClientProof(account.login, account.s, A, B, K);
+            _srp.ComputeServerProof(A, M, K, M2);
+        }
+
+        BigNumber v, b, B, K;
+
+    private:
+        SRP6 const& _srp;
+};
+
+// the client answer to the challenge: A and M1
+class BenchClient
+{
+    public:
+        BenchClient()
+        {
+            N.SetHexStr(BENCH_MODULUS);
+            g.SetDword(7);
+
+            Sha1Hash sha;
+            sha.UpdateBigNumbers(&N, NULL);
+            sha.Finalize();
+            memcpy(ngHash, sha.GetDigest(), SHA_DIGEST_LENGTH);
+            sha.Initialize();
+            sha.UpdateBigNumbers(&g, NULL);
+            sha.Finalize();
+            for (int i = 0; i < SHA_DIGEST_LENGTH; ++i)
+                ngHash[i] ^= sha.GetDigest()[i];
+        }
+
+        void Answer(BenchAccount& account, BigNumber& B, BigNumber const& a, BigNumber& A, BigNumber& M1)
+        {
+            BigNumber x;
+            BenchPrivateKey(account.s, account.passHash, x);
+
+            A = g.ModExp(a, N);
+
+            Sha1Hash sha;
+            sha.UpdateBigNumbers(&A, &B, NULL);
+            sha.Finalize();
+            BigNumber u;
+            u.SetBinary(sha.GetDigest(), 20);
+
+            // S = (B - k * g^x) ^ (a + u * x), kept positive before the exponentiation
+            BigNumber v = g.ModExp(x, N);
+            BigNumber base = (B + N * SRP6_K - v * SRP6_K) % N;
+            BigNumber exp = u * x;
+            exp += a;
+            BigNumber S = base.ModExp(exp, N);
+
+            BigNumber K;
+            BenchSessionKey(S, K);
+            BenchClientProof(ngHash, account.login, account.s, A, B, K, M1);
+        }
+
+    private:
+        BigNumber N, g;
+        uint8 ngHash[SHA_DIGEST_LENGTH];
+};
+
+static void MakeAccounts(BenchConfig const& config, std::vector<BenchAccount>& accounts)
+{
+    BenchRandom rand(config.seed);
+    accounts.resize(config.accounts);
+    for (uint32 i = 0; i < config.accounts; ++i)
+    {
+        BenchAccount& account = accounts[i];
+        char buf[32];
+        snprintf(buf, sizeof(buf), "BENCH%u", i);
+        account.login = buf;
+        snprintf(buf, sizeof(buf), "BENCH%u:PASSWORD%u", i, i);
+
+        Sha1Hash sha;
+        sha.UpdateData(std::string(buf));
+        sha.Finalize();
+        memcpy(account.passHash, sha.GetDigest(), SHA_DIGEST_LENGTH);
+
+        // sha_pass_hash as stored by the account tools: upper case hex of H(I:P)
+        account.shaPassHash.clear();
+        for (int j = 0; j < SHA_DIGEST_LENGTH; ++j)
+        {
+            snprintf(buf, sizeof(buf), "%02X", account.passHash[j]);
+            account.shaPassHash += buf;
+        }
+
+        BenchSetRand(account.s, rand, 32 * 8);
+    }
+}
+
+template<class Server, class Factory>
+static void RunThread(BenchConfig const& config, uint32 thread, Factory const& factory, BenchResult& result)
+{
+    std::vector<BenchAccount> accounts;
+    MakeAccounts(config, accounts);
+
+    BenchRandom rand(config.seed * 7919 + thread);
+    BenchClient client;
+
+    for (uint32 i = 0; i < config.handshakes; ++i)
+    {
+        BenchAccount& account = accounts[rand.Next(accounts.size())];
+        BigNumber b, a, A, M1, M;
+        BenchSetRand(b, rand, 19 * 8);
+        BenchSetRand(a, rand, 19 * 8);
+        uint8 M2[SHA_DIGEST_LENGTH];
+
+        BenchClock challenge;
+        Server server = factory();
+        server.Challenge(account, b);
+        result.seconds += challenge.Elapsed();
+
+        client.Answer(account, server.B, a, A, M1);
+
+        BenchClock proof;
+        server.Proof(account, A, M, M2);
+        result.seconds += proof.Elapsed();
+
+        // AsByteArray() is shorter than 20 bytes when M starts with a zero byte
+        if (!memcmp(M.AsByteArray(20), M1.AsByteArray(20), 20))
+            ++result.accepted;
+
+        result.checksum = BenchChecksum(result.checksum, BenchChecksum(*(uint64*)server.B.AsByteArray(32), *(uint64*)M2));
+        ++result.handshakes;
+    }
+}
+
+template<class Server, class Factory>
+static void RunHandshakes(BenchConfig const& config, Factory const& factory, BenchResult& total)
+{
+    std::vector<BenchResult> results(config.threads);
+    std::vector<std::thread> threads;
+    for (uint32 i = 0; i < config.threads; ++i)
+        threads.push_back(std::thread(RunThread<Server, Factory>, std::cref(config), i, std::cref(factory), std::ref(results[i])));
+
+    for (uint32 i = 0; i < config.threads; ++i)
+    {
+        threads[i].join();
+        total.handshakes += results[i].handshakes;
+        total.accepted += results[i].accepted;
+        total.seconds += results[i].seconds;
+        total.checksum = BenchChecksum(total.checksum, results[i].checksum);
+    }
+}
+
+struct LegacyFactory
+{
+    LegacyServer operator()() const { return LegacyServer(); }
+};
+
+struct SRP6Factory
+{
+    SRP6 srp;
+
+    SRP6Server operator()() const { return SRP6Server(srp); }
+};
+
+static void PrintRun(char const* name, BenchResult const& result)
+{
+    printf("%-7s %8llu handshakes %8llu accepted  %8.3f s  %8.1f us/handshake  %8.0f handshakes/s/core  checksum %016llx\n", name,
+        (unsigned long long)result.handshakes, (unsigned long long)result.accepted, result.seconds,
+        result.seconds * 1e6 / double(result.handshakes ? result.handshakes : 1),
+        double(result.handshakes) / (result.seconds > 0.0 ? result.seconds : 1.0), (unsigned long long)result.checksum);
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+
+    BenchOption const options[] =
+    {
+        { 'n', &config.handshakes, 1, "handshakes per thread" },
+        { 'a', &config.accounts, 1, "accounts logging in" },
+        { 't', &config.threads, 1, "threads running handshakes" },
+        { 'r', &config.seed, 0, "random seed" },
+    };
+
+    if (!BenchParseOptions(argc, argv, options))
+        return 1;
+
+    BenchResult legacy, shared;
+    RunHandshakes<LegacyServer>(config, LegacyFactory(), legacy);
+    SRP6Factory factory;
+    RunHandshakes<SRP6Server>(config, factory, shared);
+
+    PrintRun("legacy", legacy);
+    PrintRun("srp6", shared);
+
+    bool match = legacy.checksum == shared.checksum && legacy.accepted == legacy.handshakes && shared.accepted == shared.handshakes;
+    return BenchReport(match, "the SRP6 handshakes did not agree or a client proof was refused", legacy.seconds, shared.seconds);
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * Threat container micro-benchmark.
+ *
+ * Replays the threat stream of a raid encounter: the boss hates every player
+ * and pet, every damage or heal adds threat to one of them (tanks and dps
+ * weighted), fades and threat wipes lower it, some targets are out of reach
+ * now and then, and the victim is selected on every AI update with the 110%
+ * rule. Scripts read the sorted threat list every few seconds.
+ * The stream runs on the former container (std::list sorted when dirty,
+ * linear lookups) and on the ThreatReferenceSet ThreatContainer keeps its
+ * references in. The victim selection rule is the one of selectNextVictim
+ * without the unit checks, which need a map. Both must pick the same victims,
+ * the checksums are compared.
+ */
+
+#include "BenchCommon.h"
+#include "ThreatReferenceSet.h"
+
+#include <list>
+#include <vector>
+#include <stdio.h>
+
+struct BenchConfig
+{
+    BenchConfig() : players(25), pets(10), seconds(600), diff(100), hits(40), seed(1) {}
+
+    uint32 players;
+    uint32 pets;
+    uint32 seconds;                                         // encounter length
+    uint32 diff;                                            // AI update interval, ms
+    uint32 hits;                                            // threat changes per second and per player
+    uint32 seed;
+};
+
+struct BenchResult
+{
+    BenchResult() : selections(0), changes(0), checksum(BENCH_CHECKSUM_SEED) {}
+
+    uint64 selections;
+    uint64 changes;
+    uint64 checksum;                                        // every selected victim
+};
+
+struct BenchRef
+{
+    BenchRef(uint64 guid, uint32 sequence) : threat(0.0f), guid(guid), sequence(sequence), heapIndex(0), reachable(true) {}
+
+    float threat;
+    uint64 guid;
+    uint32 sequence;
+    uint32 heapIndex;
+    std::list<BenchRef*>::iterator listPos;
+    bool reachable;
+};
+
+struct BenchRefTraits
+{
+    static bool Less(BenchRef const* lhs, BenchRef const* rhs)
+    {
+        if (lhs->threat != rhs->threat)
+            return lhs->threat < rhs->threat;
+        return lhs->sequence > rhs->sequence;
+    }
+
+    static uint32& Index(BenchRef* ref) { return ref->heapIndex; }
+    static uint32& Sequence(BenchRef* ref) { return ref->sequence; }
+    static uint64 Guid(BenchRef const* ref) { return ref->guid; }
+    static std::list<BenchRef*>::iterator& ListPos(BenchRef* ref) { return ref->listPos; }
+};
+
+static bool SortPredicate(BenchRef const* lhs, BenchRef const* rhs) { return BenchRefTraits::Less(rhs, lhs); }
+
+// selection rule of ThreatContainer::selectNextVictim without the unit checks
+template<class Walk>
+static BenchRef* SelectVictim(Walk& walk, BenchRef* current)
+{
+    while (BenchRef* ref = walk.Next())
+    {
+        if (!ref->reachable)
+        {
+            if (ref == current)
+                current = NULL;
+            continue;
+        }
+
+        if (!current || ref == current || ref->threat <= 1.1f * current->threat)
+            return current ? current : ref;
+
+        if (ref->threat > 1.1f * current->threat)
+            return ref;
+    }
+
+    return NULL;
+}
+
+// the container before the heap
+class ListContainer
+{
+    public:
+        struct Walk
+        {
+            Walk(std::list<BenchRef*>& list) : itr(list.begin()), end(list.end()) {}
+            BenchRef* Next() { return itr != end ? *itr++ : NULL; }
+
+            std::list<BenchRef*>::iterator itr, end;
+        };
+
+        ListContainer() : m_dirty(false), m_victim(NULL) {}
+
+        void Add(BenchRef* ref) { m_list.push_back(ref); }
+
+        void AddThreat(uint64 guid, float threat)
+        {
+            for (std::list<BenchRef*>::iterator itr = m_list.begin(); itr != m_list.end(); ++itr)
+            {
+                if ((*itr)->guid != guid)
+                    continue;
+
+                (*itr)->threat += threat;
+                if ((m_victim == *itr && threat < 0.0f) || (m_victim != *itr && threat > 0.0f))
+                    m_dirty = true;
+                return;
+            }
+        }
+
+        BenchRef* Select()
+        {
+            if (m_dirty && m_list.size() > 1)
+                m_list.sort(SortPredicate);
+            m_dirty = false;
+
+            Walk walk(m_list);
+            return m_victim = SelectVictim(walk, m_victim);
+        }
+
+        std::list<BenchRef*>& GetSorted() { return m_list; }
+
+    private:
+        std::list<BenchRef*> m_list;
+        bool m_dirty;
+        BenchRef* m_victim;
+};
+
+// ThreatContainer without the units
+class SetContainer
+{
+    public:
+        typedef ThreatReferenceSet<BenchRef, BenchRefTraits> ReferenceSet;
+
+        SetContainer() : m_victim(NULL) {}
+
+        void Add(BenchRef* ref) { m_refs.add(ref); }
+
+        void AddThreat(uint64 guid, float threat)
+        {
+            if (BenchRef* ref = m_refs.find(guid))
+            {
+                ref->threat += threat;
+                m_refs.update(ref);
+            }
+        }
+
+        BenchRef* Select()
+        {
+            ReferenceSet::Walker walk(m_refs.heap());
+            return m_victim = SelectVictim(walk, m_victim);
+        }
+
+        std::list<BenchRef*>& GetSorted() { return m_refs.getSorted(); }
+
+    private:
+        ReferenceSet m_refs;
+        BenchRef* m_victim;
+};
+
+template<class Container>
+static double RunEncounter(BenchConfig const& config, BenchResult& result)
+{
+    uint32 count = config.players + config.pets;
+    std::vector<BenchRef*> refs;
+    for (uint32 i = 0; i < count; ++i)
+        refs.push_back(new BenchRef(0x1000 + i, i));
+
+    Container container;
+    for (uint32 i = 0; i < count; ++i)
+        container.Add(refs[i]);
+
+    BenchRandom rand(config.seed);
+    uint32 hitsPerUpdate = std::max(1u, config.hits * config.players * config.diff / 1000);
+
+    BenchClock clock;
+
+    for (uint32 now = 0; now < config.seconds * 1000; now += config.diff)
+    {
+        for (uint32 i = 0; i < hitsPerUpdate; ++i)
+        {
+            uint32 index = rand.Next(count);
+            float threat;
+            if (index < 2)                                  // tanks
+                threat = float(1500 + rand.Next(3000));
+            else if (rand.Next(40) == 0)                    // fade, feint
+                threat = -float(rand.Next(2000));
+            else
+                threat = float(200 + rand.Next(1500));
+
+            container.AddThreat(refs[index]->guid, threat);
+            ++result.changes;
+        }
+
+        // threat wipe on a random target
+        if (rand.Next(300) == 0)
+        {
+            BenchRef* ref = refs[rand.Next(count)];
+            container.AddThreat(ref->guid, -ref->threat);
+            ++result.changes;
+        }
+
+        // a target flies out of reach or comes back
+        if (rand.Next(50) == 0)
+        {
+            BenchRef* ref = refs[rand.Next(count)];
+            ref->reachable = !ref->reachable;
+        }
+
+        BenchRef* victim = container.Select();
+        result.checksum = BenchChecksum(result.checksum, victim ? victim->guid : 0);
+        ++result.selections;
+
+        // script looking at the second on threat
+        if (rand.Next(20) == 0)
+        {
+            std::list<BenchRef*>& list = container.GetSorted();
+            std::list<BenchRef*>::const_iterator itr = list.begin();
+            if (list.size() > 1)
+                ++itr;
+            result.checksum = BenchChecksum(result.checksum, (*itr)->guid);
+        }
+    }
+
+    double seconds = clock.Elapsed();
+
+    for (uint32 i = 0; i < count; ++i)
+        delete refs[i];
+
+    return seconds;
+}
+
+static void PrintRun(char const* name, BenchResult const& result, double seconds)
+{
+    printf("%-6s %10llu threat changes %8llu selections  %8.3f s  %6.1f ns/change  checksum %016llx\n", name,
+        (unsigned long long)result.changes, (unsigned long long)result.selections, seconds,
+        seconds * 1e9 / double(result.changes ? result.changes : 1), (unsigned long long)result.checksum);
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+
+    BenchOption const options[] =
+    {
+        { 'p', &config.players, 1, "players on the threat list" },
+        { 'e', &config.pets, 0, "pets on the threat list" },
+        { 's', &config.seconds, 0, "encounter length in seconds" },
+        { 'd', &config.diff, 1, "AI update interval in ms" },
+        { 't', &config.hits, 0, "threat changes per second and per player" },
+        { 'r', &config.seed, 0, "random seed" },
+    };
+
+    if (!BenchParseOptions(argc, argv, options))
+        return 1;
+
+    BenchResult list, heap;
+    double listTime = RunEncounter<ListContainer>(config, list);
+    double heapTime = RunEncounter<SetContainer>(config, heap);
+
+    PrintRun("list", list, listTime);
+    PrintRun("heap", heap, heapTime);
+
+    return BenchReport(list.checksum == heap.checksum, "the heap did not select the same victims", listTime, heapTime);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef _GRIDOBJECTLIST_H
+#define _GRIDOBJECTLIST_H
+
+#include "GameSystem/GridPositions.h"
+
+/*
+ * Objects of one type in one cell, replaces the GridRefManager linked list.
+ * OBJECT provides GetGridPosition() returning its GridPositionSlot, and its position and size.
+ * Iterators are index based and skip the holes of objects removed during the visit, objects
+ * added during the visit are visited too.
+ */
+template<class OBJECT>
+class GridObjectList : public GridPositions
+{
+    public:
+        class iterator
+        {
+            public:
+                iterator() : i_list(NULL), i_index(0) {}
+                iterator(GridObjectList const* list, uint32 index) : i_list(list), i_index(index) { _Skip(); }
+
+                OBJECT* operator*() const { return i_list->template getObject<OBJECT>(i_index); }
+
+                iterator& operator++() { ++i_index; _Skip(); return *this; }
+                iterator operator++(int) { iterator tmp = *this; ++*this; return tmp; }
+
+                bool operator==(iterator const& right) const
+                {
+                    bool end = _AtEnd();
+                    return end == right._AtEnd() && (end || i_index == right.i_index);
+                }
+                bool operator!=(iterator const& right) const { return !(*this == right); }
+
+            private:
+                bool _AtEnd() const { return !i_list || i_index >= i_list->entries(); }
+                void _Skip()
+                {
+                    while (!_AtEnd() && !i_list->template getObject<OBJECT>(i_index))
+                        ++i_index;
+                }
+
+                GridObjectList const* i_list;
+                uint32 i_index;
+        };
+
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(); }
+
+        void insert(OBJECT* obj)
+        {
+            link(&obj->GetGridPosition(), obj, obj->GetPositionX(), obj->GetPositionY(), obj->GetPositionZ(), obj->GetObjectSize());
+        }
+
+        static void remove(OBJECT* obj) { obj->GetGridPosition().unlink(); }
+};
+#endif
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include "GridPositions.h"
+
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GRIDPOSITIONS_SSE2
+#endif
+
+// relative slack added to the query range, covers the rounding differences with the exact checks
+#define GRIDPOSITIONS_RANGE_SLACK 1.0001f
+
+GridPositions::~GridPositions()
+{
+    for (std::vector<GridPositionSlot*>::const_iterator itr = i_slots.begin(); itr != i_slots.end(); ++itr)
+        if (*itr)
+            (*itr)->i_positions = NULL;
+}
+
+void GridPositions::link(GridPositionSlot* slot, void* object, float x, float y, float z, float size)
+{
+    slot->unlink();
+
+    slot->i_positions = this;
+    slot->i_index = i_objects.size();
+
+    i_x.push_back(x);
+    i_y.push_back(y);
+    i_z.push_back(z);
+    i_size.push_back(size);
+    i_objects.push_back(object);
+    i_slots.push_back(slot);
+    ++i_count;
+}
+
+void GridPositions::_unlink(GridPositionSlot* slot)
+{
+    uint32 index = slot->i_index;
+
+    slot->i_positions = NULL;
+    slot->i_index = 0;
+    --i_count;
+
+    if (!i_visits)
+    {
+        _Erase(index);
+        return;
+    }
+
+    // keep the entry as a hole, NaN coordinates never pass the filters
+    i_x[index] = std::numeric_limits<float>::quiet_NaN();
+    i_objects[index] = NULL;
+    i_slots[index] = NULL;
+    i_holes = true;
+}
+
+void GridPositions::_Erase(uint32 index)
+{
+    uint32 last = i_objects.size() - 1;
+
+    if (index != last)
+    {
+        i_x[index] = i_x[last];
+        i_y[index] = i_y[last];
+        i_z[index] = i_z[last];
+        i_size[index] = i_size[last];
+        i_objects[index] = i_objects[last];
+        i_slots[index] = i_slots[last];
+        if (i_slots[index])
+            i_slots[index]->i_index = index;
+    }
+
+    i_x.pop_back();
+    i_y.pop_back();
+    i_z.pop_back();
+    i_size.pop_back();
+    i_objects.pop_back();
+    i_slots.pop_back();
+}
+
+void GridPositions::_Compact()
+{
+    // from the end, an entry moved down by _Erase was already checked
+    for (uint32 index = i_objects.size(); index > 0; --index)
+        if (!i_objects[index - 1])
+            _Erase(index - 1);
+
+    i_holes = false;
+}
+
+void GridPositions::FilterInRange(float x, float y, float z, float range, std::vector<uint32>& candidates) const
+{
+    uint32 count = i_objects.size();
+    candidates.resize(count);
+    if (!count)
+        return;
+
+    float const* px = &i_x[0];
+    float const* py = &i_y[0];
+    float const* pz = &i_z[0];
+    uint32* out = &candidates[0];
+    uint32 found = 0;
+    uint32 i = 0;
+
+    range *= GRIDPOSITIONS_RANGE_SLACK;
+    float rangeSq = range * range;
+
+#ifdef GRIDPOSITIONS_SSE2
+    __m128 cx = _mm_set1_ps(x);
+    __m128 cy = _mm_set1_ps(y);
+    __m128 cz = _mm_set1_ps(z);
+    __m128 limit = _mm_set1_ps(rangeSq);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(px + i), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(py + i), cy);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(pz + i), cz);
+        __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(distSq, limit));
+
+        // branchless compaction of the passing lanes
+        out[found] = i;     found += mask & 1;
+        out[found] = i + 1; found += (mask >> 1) & 1;
+        out[found] = i + 2; found += (mask >> 2) & 1;
+        out[found] = i + 3; found += (mask >> 3) & 1;
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        float dx = px[i] - x;
+        float dy = py[i] - y;
+        float dz = pz[i] - z;
+        out[found] = i;
+        found += (dx*dx + dy*dy + dz*dz < rangeSq) ? 1 : 0;
+    }
+
+    candidates.resize(found);
+}
+
+void GridPositions::FilterInReach(float x, float y, float z, float range, std::vector<uint32>& candidates) const
+{
+    uint32 count = i_objects.size();
+    candidates.resize(count);
+    if (!count)
+        return;
+
+    float const* px = &i_x[0];
+    float const* py = &i_y[0];
+    float const* pz = &i_z[0];
+    float const* ps = &i_size[0];
+    uint32* out = &candidates[0];
+    uint32 found = 0;
+    uint32 i = 0;
+
+#ifdef GRIDPOSITIONS_SSE2
+    __m128 cx = _mm_set1_ps(x);
+    __m128 cy = _mm_set1_ps(y);
+    __m128 cz = _mm_set1_ps(z);
+    __m128 r = _mm_set1_ps(range);
+    __m128 slack = _mm_set1_ps(GRIDPOSITIONS_RANGE_SLACK);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(px + i), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(py + i), cy);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(pz + i), cz);
+        __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 reach = _mm_mul_ps(_mm_add_ps(r, _mm_loadu_ps(ps + i)), slack);
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(distSq, _mm_mul_ps(reach, reach)));
+
+        out[found] = i;     found += mask & 1;
+        out[found] = i + 1; found += (mask >> 1) & 1;
+        out[found] = i + 2; found += (mask >> 2) & 1;
+        out[found] = i + 3; found += (mask >> 3) & 1;
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        float dx = px[i] - x;
+        float dy = py[i] - y;
+        float dz = pz[i] - z;
+        float reach = (range + ps[i]) * GRIDPOSITIONS_RANGE_SLACK;
+        out[found] = i;
+        found += (dx*dx + dy*dy + dz*dz < reach * reach) ? 1 : 0;
+    }
+
+    candidates.resize(found);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef _GRIDPOSITIONS_H
+#define _GRIDPOSITIONS_H
+
+#include "Platform/Define.h"
+
+#include <vector>
+
+class GridPositions;
+
+/*
+ * Entry of an object in the position mirror of its cell, embedded in the object.
+ * The slot unlinks itself when the object is destroyed, copies are never linked.
+ */
+class GridPositionSlot
+{
+    friend class GridPositions;
+
+    public:
+        GridPositionSlot() : i_positions(NULL), i_index(0) {}
+        GridPositionSlot(GridPositionSlot const&) : i_positions(NULL), i_index(0) {}
+        ~GridPositionSlot() { unlink(); }
+
+        GridPositionSlot& operator=(GridPositionSlot const&) { return *this; }
+
+        bool isLinked() const { return i_positions != NULL; }
+        inline void unlink();
+
+        inline void Relocate(float x, float y, float z);
+        inline void SetSize(float size);
+
+    private:
+        GridPositions* i_positions;
+        uint32 i_index;
+};
+
+/*
+ * Objects of one cell in a dense array, with a structure of arrays mirror of their positions
+ * and sizes so range queries run over contiguous coordinates with SIMD and only touch the
+ * objects that pass. Every object keeps its index in a slot, insert and remove are O(1).
+ * Entries are swap removed, the slot of the moved object is updated. While the container is
+ * visited a removed entry is only cleared, so indexes held by iterators stay valid, and the
+ * holes are compacted when the last visit ends.
+ */
+class GridPositions
+{
+    friend class GridPositionSlot;
+
+    public:
+        GridPositions() : i_count(0), i_visits(0), i_holes(false) {}
+        ~GridPositions();
+
+        void link(GridPositionSlot* slot, void* object, float x, float y, float z, float size);
+
+        // number of linked objects
+        uint32 size() const { return i_count; }
+        bool empty() const { return i_count == 0; }
+
+        // entries include the holes left by removals during a visit, their object is NULL
+        uint32 entries() const { return i_objects.size(); }
+        template<class OBJECT> OBJECT* getObject(uint32 index) const { return static_cast<OBJECT*>(i_objects[index]); }
+
+        // visits nest, removals are deferred until the last one ends
+        void BeginVisit() { ++i_visits; }
+        void EndVisit()
+        {
+            if (--i_visits == 0 && i_holes)
+                _Compact();
+        }
+
+        // The filters are a conservative prefilter: candidates may be slightly out of range
+        // because of rounding, callers keep their exact check on the candidates. Holes never pass.
+        // indexes of the entries whose position is closer than range to x, y, z
+        void FilterInRange(float x, float y, float z, float range, std::vector<uint32>& candidates) const;
+        // indexes of the entries whose position is closer than range plus their size to x, y, z
+        void FilterInReach(float x, float y, float z, float range, std::vector<uint32>& candidates) const;
+
+    private:
+        GridPositions(GridPositions const&);
+        GridPositions& operator=(GridPositions const&);
+
+        void _unlink(GridPositionSlot* slot);
+        void _Erase(uint32 index);
+        void _Compact();
+
+        std::vector<float> i_x;
+        std::vector<float> i_y;
+        std::vector<float> i_z;
+        std::vector<float> i_size;
+        std::vector<void*> i_objects;
+        std::vector<GridPositionSlot*> i_slots;
+        uint32 i_count;
+        uint32 i_visits;
+        bool i_holes;
+};
+
+inline void GridPositionSlot::unlink()
+{
+    if (i_positions)
+        i_positions->_unlink(this);
+}
+
+inline void GridPositionSlot::Relocate(float x, float y, float z)
+{
+    if (!i_positions)
+        return;
+
+    i_positions->i_x[i_index] = x;
+    i_positions->i_y[i_index] = y;
+    i_positions->i_z[i_index] = z;
+}
+
+inline void GridPositionSlot::SetSize(float size)
+{
+    if (i_positions)
+        i_positions->i_size[i_index] = size;
+}
+#endif
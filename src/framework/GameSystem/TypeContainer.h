@@ -30,7 +30,7 @@
 #include <vector>
 #include "Platform/Define.h"
 #include "Utilities/TypeList.h"
-#include "GameSystem/GridRefManager.h"
+#include "GameSystem/GridObjectList.h"
 
 /*
  * @class ContainerMapList is a mulit-type container for map elements
@@ -39,7 +39,7 @@
  */
 template<class OBJECT> struct ContainerMapList
 {
-    GridRefManager<OBJECT> _element;
+    GridObjectList<OBJECT> _element;
 };
 
 template<> struct ContainerMapList<TypeNull>                /* nothing is in type null */
@@ -37,7 +37,7 @@ namespace Trinity
     // count functions
     template<class SPECIFIC_TYPE> size_t Count(const ContainerMapList<SPECIFIC_TYPE> &elements, SPECIFIC_TYPE* /*fake*/)
     {
-        return elements._element.getSize();
+        return elements._element.size();
     };
 
     template<class SPECIFIC_TYPE> size_t Count(const ContainerMapList<TypeNull> &/*elements*/, SPECIFIC_TYPE* /*fake*/)
@@ -63,8 +63,7 @@ namespace Trinity
     // non-const insert functions
     template<class SPECIFIC_TYPE> SPECIFIC_TYPE* Insert(ContainerMapList<SPECIFIC_TYPE> &elements, SPECIFIC_TYPE *obj)
     {
-        //elements._element[hdl] = obj;
-        obj->GetGridRef().link(&elements._element, obj);
+        elements._element.insert(obj);
         return obj;
     };
 
@@ -87,9 +86,9 @@ namespace Trinity
     }
 
     // non-const remove method
-    template<class SPECIFIC_TYPE> SPECIFIC_TYPE* Remove(ContainerMapList<SPECIFIC_TYPE> & /*elements*/, SPECIFIC_TYPE *obj)
+    template<class SPECIFIC_TYPE> SPECIFIC_TYPE* Remove(ContainerMapList<SPECIFIC_TYPE> &elements, SPECIFIC_TYPE *obj)
     {
-        obj->GetGridRef().unlink();
+        elements._element.remove(obj);
         return obj;
     }
 
@@ -46,7 +46,10 @@ template<class VISITOR> void VisitorHelper(VISITOR &/*v*/, ContainerMapList<Type
 
 template<class VISITOR, class T> void VisitorHelper(VISITOR &v, ContainerMapList<T> &c)
 {
+    // objects removed by the visitor leave holes until the visit ends
+    c._element.BeginVisit();
     v.Visit(c._element);
+    c._element.EndVisit();
 }
 
 // recursion container map list
@@ -18,17 +18,202 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
+
 #include "EventProcessor.h"
 
+#include <ace/Guard_T.h>
+#include <ace/Thread_Mutex.h>
+#include <algorithm>
+#include <new>
+
+namespace
+{
+    const size_t EVENT_BLOCK_ALIGN      = 16;
+    const size_t EVENT_MAX_BLOCK        = 256;              // bigger events come from the global heap
+    const size_t EVENT_SIZE_CLASS_COUNT = EVENT_MAX_BLOCK / EVENT_BLOCK_ALIGN;
+    const size_t EVENT_CHUNK_SIZE       = 0x4000;
+    const size_t EVENT_THREAD_CACHE     = 1024;             // blocks per size class, above that half goes to the depot
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    // only used with static or thread storage, zero initialized
+    struct FreeList
+    {
+        void Push(FreeBlock* block)
+        {
+            block->next = head;
+            head = block;
+            ++count;
+        }
+
+        FreeBlock* Pop()
+        {
+            FreeBlock* block = head;
+            head = block->next;
+            --count;
+            return block;
+        }
+
+        FreeBlock* head;
+        size_t count;
+    };
+
+    FreeList s_depot[EVENT_SIZE_CLASS_COUNT];
+
+    // never destroyed, events of static objects may be freed after the other statics
+    ACE_Thread_Mutex& DepotLock()
+    {
+        static ACE_Thread_Mutex* lock = new ACE_Thread_Mutex();
+        return *lock;
+    }
+
+    inline uint32 SizeClassOf(size_t size) { return uint32((size - 1) / EVENT_BLOCK_ALIGN); }
+
+    void MoveToDepot(FreeList& list, uint32 sizeClass, size_t count)
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard(DepotLock());
+
+        for (; count > 0 && list.head; --count)
+            s_depot[sizeClass].Push(list.Pop());
+    }
+
+    // blocks are never given back to the system, the pool is bounded by the peak event count
+    void Refill(FreeList& list, uint32 sizeClass)
+    {
+        {
+            ACE_Guard<ACE_Thread_Mutex> guard(DepotLock());
+
+            FreeList& depot = s_depot[sizeClass];
+            for (size_t count = EVENT_THREAD_CACHE / 2; count > 0 && depot.head; --count)
+                list.Push(depot.Pop());
+        }
+
+        if (list.head)
+            return;
+
+        size_t blockSize = (sizeClass + 1) * EVENT_BLOCK_ALIGN;
+        char* chunk = static_cast<char*>(::operator new(EVENT_CHUNK_SIZE));
+        for (size_t offset = 0; offset + blockSize <= EVENT_CHUNK_SIZE; offset += blockSize)
+            list.Push(reinterpret_cast<FreeBlock*>(chunk + offset));
+    }
+
+    thread_local FreeList* t_lists;
+    thread_local bool t_exited;
+
+    struct ThreadCache
+    {
+        FreeList lists[EVENT_SIZE_CLASS_COUNT];
+
+        // blocks of an exiting thread stay usable by the others
+        ~ThreadCache()
+        {
+            for (uint32 i = 0; i < EVENT_SIZE_CLASS_COUNT; ++i)
+                MoveToDepot(lists[i], i, lists[i].count);
+
+            t_lists = NULL;
+            t_exited = true;
+        }
+    };
+
+    // NULL once the thread cache is destroyed, the depot is then used directly
+    inline FreeList* ThreadLists()
+    {
+        if (!t_lists && !t_exited)
+        {
+            static thread_local ThreadCache cache;
+            t_lists = cache.lists;
+        }
+
+        return t_lists;
+    }
+
+    inline uint32 LowestBit(uint64 bits)
+    {
+#if COMPILER == COMPILER_GNU
+        return __builtin_ctzll(bits);
+#else
+        uint32 bit = 0;
+        for (; !(bits & 1); bits >>= 1)
+            ++bit;
+        return bit;
+#endif
+    }
+}
+
+void* BasicEvent::operator new(size_t size)
+{
+    if (size > EVENT_MAX_BLOCK)
+        return ::operator new(size);
+
+    uint32 sizeClass = SizeClassOf(size);
+
+    FreeList* lists = ThreadLists();
+    if (!lists)
+    {
+        FreeList list = FreeList();
+        Refill(list, sizeClass);
+        void* ptr = list.Pop();
+        MoveToDepot(list, sizeClass, list.count);
+        return ptr;
+    }
+
+    FreeList& list = lists[sizeClass];
+    if (!list.head)
+        Refill(list, sizeClass);
+
+    return list.Pop();
+}
+
+void BasicEvent::operator delete(void* ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+    if (size > EVENT_MAX_BLOCK)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+
+    uint32 sizeClass = SizeClassOf(size);
+
+    FreeList* lists = ThreadLists();
+    if (!lists)
+    {
+        FreeList list = FreeList();
+        list.Push(static_cast<FreeBlock*>(ptr));
+        MoveToDepot(list, sizeClass, 1);
+        return;
+    }
+
+    FreeList& list = lists[sizeClass];
+    list.Push(static_cast<FreeBlock*>(ptr));
+
+    if (list.count > EVENT_THREAD_CACHE)
+        MoveToDepot(list, sizeClass, EVENT_THREAD_CACHE / 2);
+}
+
 EventProcessor::EventProcessor()
 {
     m_time = 0;
+    m_wheelTime = 1;
+    m_count = 0;
+    for (uint32 i = 0; i < EVENT_WHEEL_LEVELS; ++i)
+        m_levels[i] = NULL;
+    m_overflow.head = m_overflow.tail = NULL;
+    m_due.head = m_due.tail = NULL;
     m_aborting = false;
 }
 
 EventProcessor::~EventProcessor()
 {
     KillAllEvents(true);
+
+    for (uint32 i = 0; i < EVENT_WHEEL_LEVELS; ++i)
+        delete m_levels[i];
 }
 
 void EventProcessor::Update(uint32 p_time)
@@ -36,27 +221,71 @@ void EventProcessor::Update(uint32 p_time)
     // update time
     m_time += p_time;
 
-    // main event loop
-    EventList::iterator i;
-    while (((i = m_events.begin()) != m_events.end()) && i->first <= m_time)
+    // main event loop, one iteration per occupied millisecond or level 0 wrap
+    while (m_wheelTime <= m_time)
     {
-        // get and remove event from queue
-        BasicEvent* Event = i->second;
-        m_events.erase(i);
+        // nothing queued, no slot to visit
+        if (!m_count)
+        {
+            m_wheelTime = m_time + 1;
+            break;
+        }
+
+        uint32 index = uint32(m_wheelTime & (EVENT_WHEEL_SLOTS - 1));
 
-        if (!Event->to_Abort)
+        // level 0 wrapped, spread the next slot of level 1 (and of the upper levels when they wrap too)
+        if (!index)
         {
-            if (Event->Execute(m_time, p_time))
+            uint32 level = 1;
+            for (; level < EVENT_WHEEL_LEVELS; ++level)
             {
-                // completely destroy event if it is not re-added
-                delete Event;
+                uint32 levelIndex = uint32((m_wheelTime >> (EVENT_WHEEL_BITS * level)) & (EVENT_WHEEL_SLOTS - 1));
+                _Cascade(level, levelIndex);
+                if (levelIndex)
+                    break;
+            }
+
+            // far events get back into the wheel once they are in its range
+            if (level == EVENT_WHEEL_LEVELS)
+            {
+                BasicEvent* list = m_overflow.head;
+                m_overflow.head = m_overflow.tail = NULL;
+                _InsertAll(list);
             }
         }
-        else
+
+        // get and remove events from the queue, events added while executing for this millisecond are
+        // appended to the slot and the ones added for an earlier time go first, as with the multimap
+        Level* level0 = m_levels[0];
+        for (;;)
         {
-            Event->Abort(m_time);
-            delete Event;
+            Slot* slot = m_due.head ? &m_due : (level0 && level0->slots[index].head ? &level0->slots[index] : NULL);
+            if (!slot)
+                break;
+
+            BasicEvent* Event = slot->head;
+            slot->head = Event->m_next;
+            if (!slot->head)
+                slot->tail = NULL;
+            Event->m_next = NULL;
+            --m_count;
+
+            _Execute(Event, p_time);
+
+            // an executed event may have added the first event of the processor
+            level0 = m_levels[0];
         }
+
+        // skip to the next occupied slot of level 0, or to its wrap
+        uint64 next = (m_wheelTime | (EVENT_WHEEL_SLOTS - 1)) + 1;
+        if (level0)
+        {
+            level0->occupied &= ~(uint64(1) << index);
+            if (uint64 later = index + 1 < EVENT_WHEEL_SLOTS ? level0->occupied & (~uint64(0) << (index + 1)) : 0)
+                next = (m_wheelTime & ~uint64(EVENT_WHEEL_SLOTS - 1)) + LowestBit(later);
+        }
+
+        m_wheelTime = std::min(next, m_time + 1);
     }
 }
 
@@ -65,33 +294,33 @@ void EventProcessor::KillAllEvents(bool force)
     // prevent event insertions
     m_aborting = true;
 
-    // first, abort all existing events
-    for (EventList::iterator i = m_events.begin(); i != m_events.end();)
+    // abort all existing events, in force case all of them are deleted
+    for (uint32 i = 0; i < EVENT_WHEEL_LEVELS; ++i)
     {
-        EventList::iterator i_old = i;
-        ++i;
+        Level* level = m_levels[i];
+        if (!level)
+            continue;
 
-        i_old->second->to_Abort = true;
-        i_old->second->Abort(m_time);
-        if(force || i_old->second->IsDeletable())
+        for (uint64 occupied = level->occupied; occupied; occupied &= occupied - 1)
         {
-            delete i_old->second;
-
-            if(!force)                                      // need per-element cleanup
-                m_events.erase (i_old);
+            uint32 index = LowestBit(occupied);
+            if (_KillSlot(level->slots[index], force))
+                level->occupied &= ~(uint64(1) << index);
         }
     }
 
-    // fast clear event list (in force case)
-    if(force)
-        m_events.clear();
+    _KillSlot(m_overflow, force);
+    _KillSlot(m_due, force);
 }
 
 void EventProcessor::AddEvent(BasicEvent* Event, uint64 e_time, bool set_addtime)
 {
     if (set_addtime) Event->m_addTime = m_time;
     Event->m_execTime = e_time;
-    m_events.insert(std::pair<uint64, BasicEvent*>(e_time, Event));
+    Event->m_wheelTime = e_time;
+    Event->m_next = NULL;
+    _Insert(Event);
+    ++m_count;
 }
 
 uint64 EventProcessor::CalculateTime(uint64 t_offset)
@@ -99,3 +328,147 @@ uint64 EventProcessor::CalculateTime(uint64 t_offset)
     return(m_time + t_offset);
 }
 
+void EventProcessor::_Link(Slot& slot, BasicEvent* Event)
+{
+    if (slot.tail)
+        slot.tail->m_next = Event;
+    else
+        slot.head = Event;
+    slot.tail = Event;
+}
+
+void EventProcessor::_LinkFront(Slot& slot, BasicEvent* Event)
+{
+    Event->m_next = slot.head;
+    slot.head = Event;
+    if (!slot.tail)
+        slot.tail = Event;
+}
+
+void EventProcessor::_Insert(BasicEvent* Event, bool front)
+{
+    uint64 e_time = Event->m_wheelTime;
+
+    // already due, executed before anything of the wheel
+    if (e_time < m_wheelTime)
+    {
+        BasicEvent* prev = NULL;
+        for (BasicEvent* itr = m_due.head; itr && itr->m_wheelTime <= e_time; itr = itr->m_next)
+            prev = itr;
+
+        if (!prev)
+            _LinkFront(m_due, Event);
+        else
+        {
+            Event->m_next = prev->m_next;
+            prev->m_next = Event;
+            if (m_due.tail == prev)
+                m_due.tail = Event;
+        }
+        return;
+    }
+
+    uint64 delta = e_time - m_wheelTime;
+
+    uint32 level = 0;
+    while (level < EVENT_WHEEL_LEVELS && delta >> (EVENT_WHEEL_BITS * (level + 1)))
+        ++level;
+
+    if (level == EVENT_WHEEL_LEVELS)
+    {
+        if (front)
+            _LinkFront(m_overflow, Event);
+        else
+            _Link(m_overflow, Event);
+        return;
+    }
+
+    if (!m_levels[level])
+        m_levels[level] = new Level();
+
+    // slot of the current position was spread already, delta >= slot width always picks a later one
+    uint32 index = uint32((e_time >> (EVENT_WHEEL_BITS * level)) & (EVENT_WHEEL_SLOTS - 1));
+    if (front)
+        _LinkFront(m_levels[level]->slots[index], Event);
+    else
+        _Link(m_levels[level]->slots[index], Event);
+    m_levels[level]->occupied |= uint64(1) << index;
+}
+
+void EventProcessor::_Cascade(uint32 level, uint32 index)
+{
+    Level* from = m_levels[level];
+    if (!from || !(from->occupied & (uint64(1) << index)))
+        return;
+
+    BasicEvent* list = from->slots[index].head;
+    from->slots[index].head = from->slots[index].tail = NULL;
+    from->occupied &= ~(uint64(1) << index);
+
+    _InsertAll(list);
+}
+
+void EventProcessor::_InsertAll(BasicEvent* list)
+{
+    // events of a lower level with the same time were added later (closer to their time), so the spread
+    // events are linked in front of them: reverse the list and link each event at the head of its slot
+    BasicEvent* reversed = NULL;
+    while (list)
+    {
+        BasicEvent* next = list->m_next;
+        list->m_next = reversed;
+        reversed = list;
+        list = next;
+    }
+
+    while (reversed)
+    {
+        BasicEvent* next = reversed->m_next;
+        reversed->m_next = NULL;
+        _Insert(reversed, true);
+        reversed = next;
+    }
+}
+
+void EventProcessor::_Execute(BasicEvent* Event, uint32 p_time)
+{
+    if (!Event->to_Abort)
+    {
+        if (Event->Execute(m_time, p_time))
+        {
+            // completely destroy event if it is not re-added
+            delete Event;
+        }
+    }
+    else
+    {
+        Event->Abort(m_time);
+        delete Event;
+    }
+}
+
+bool EventProcessor::_KillSlot(Slot& slot, bool force)
+{
+    BasicEvent* Event = slot.head;
+    slot.head = slot.tail = NULL;
+
+    while (Event)
+    {
+        BasicEvent* next = Event->m_next;
+        Event->m_next = NULL;
+
+        Event->to_Abort = true;
+        Event->Abort(m_time);
+        if (force || Event->IsDeletable())
+        {
+            delete Event;
+            --m_count;
+        }
+        else                                                // kept, deleted when its time comes
+            _Link(slot, Event);
+
+        Event = next;
+    }
+
+    return !slot.head;
+}
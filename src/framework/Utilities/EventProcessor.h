@@ -23,18 +23,24 @@
 
 #include "Platform/Define.h"
 
-#include<map>
+#include <cstddef>
 
 // Note. All times are in milliseconds here.
 
 class BasicEvent
 {
+    friend class EventProcessor;
+
     public:
-        BasicEvent() { to_Abort = false; }
+        BasicEvent() { to_Abort = false; m_next = NULL; }
         virtual ~BasicEvent()                               // override destructor to perform some actions on event removal
         {
         };
 
+        // events are allocated from a per thread pool of small blocks, see EventProcessor.cpp
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr, size_t size);
+
         // this method executes when the event is triggered
         // return false if event does not want to be deleted
         // e_time is execution time, p_time is update interval
@@ -50,10 +56,26 @@ class BasicEvent
         // these can be used for time offset control
         uint64 m_addTime;                                   // time when the event was added to queue, filled by event handler
         uint64 m_execTime;                                  // planned time of next execution, filled by event handler
+
+    private:
+        uint64 m_wheelTime;                                 // time the event is queued for in the wheel, m_execTime may be changed by the event
+        BasicEvent* m_next;                                 // next event of the same wheel slot
 };
 
-typedef std::multimap<uint64, BasicEvent*> EventList;
+#define EVENT_WHEEL_BITS    6
+#define EVENT_WHEEL_SLOTS   (1 << EVENT_WHEEL_BITS)
+#define EVENT_WHEEL_LEVELS  4                               // events due in more than 2^24 ms (4.6 hours) wait in an overflow list
 
+/*
+ * Events are kept in a hierarchical timing wheel. Level 0 has one slot per millisecond for the next
+ * 64 ms, each next level has 64 slots 64 times as wide. Adding an event links it into the slot of its
+ * level, each time level 0 wraps the next slot of level 1 is spread into level 0 (and so on for the
+ * upper levels), so every event is moved at most EVENT_WHEEL_LEVELS times. Update only visits the
+ * occupied level 0 slots and the slot boundaries up to the current time.
+ * Events are executed in the same order as with the former multimap: by time, events of the same
+ * millisecond in the order they were added. Levels are allocated
+ * on first use, units without events only pay for the empty processor.
+ */
 class EventProcessor
 {
     public:
@@ -65,9 +87,32 @@ class EventProcessor
         void AddEvent(BasicEvent* Event, uint64 e_time, bool set_addtime = true);
         uint64 CalculateTime(uint64 t_offset);
     protected:
+        struct Slot
+        {
+            BasicEvent* head;
+            BasicEvent* tail;
+        };
+
+        struct Level
+        {
+            Slot slots[EVENT_WHEEL_SLOTS];
+            uint64 occupied;                                // bit per non empty slot
+        };
+
+        static void _Link(Slot& slot, BasicEvent* Event);
+        static void _LinkFront(Slot& slot, BasicEvent* Event);
+        void _Insert(BasicEvent* Event, bool front = false);
+        void _InsertAll(BasicEvent* list);                  // events of a spread slot, in order before the ones added later
+        void _Cascade(uint32 level, uint32 index);
+        void _Execute(BasicEvent* Event, uint32 p_time);
+        bool _KillSlot(Slot& slot, bool force);             // true if the slot is left empty
+
         uint64 m_time;
-        EventList m_events;
+        uint64 m_wheelTime;                                 // next millisecond the wheel has to process
+        uint32 m_count;                                     // queued events, overflow included
+        Level* m_levels[EVENT_WHEEL_LEVELS];
+        Slot m_overflow;
+        Slot m_due;                                         // added for an already processed time, sorted by time
         bool m_aborting;
 };
 #endif
-
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef _INDEXEDHEAP_H
+#define _INDEXEDHEAP_H
+
+#include "Platform/Define.h"
+
+#include <algorithm>
+#include <vector>
+
+/*
+ * Binary max heap of pointers where every element knows its position, so an element whose
+ * key changed can be moved or removed in O(log n) and membership is checked in O(1).
+ * Traits provides:
+ *   static bool Less(T const* lhs, T const* rhs)      - strict weak order, the greatest is on top
+ *   static uint32& Index(T* elem)                     - position storage inside the element
+ * An element is in at most one heap at a time.
+ */
+template<class T, class Traits>
+class IndexedHeap
+{
+    public:
+        // walks the elements from the greatest down without touching the heap, O(log k) per step
+        // for the k first ones. The heap must not be modified during the walk
+        class OrderedWalker
+        {
+            public:
+                explicit OrderedWalker(IndexedHeap const& heap) : m_heap(heap)
+                {
+                    if (!heap.empty())
+                        m_frontier.push_back(0);
+                }
+
+                T* Next()
+                {
+                    if (m_frontier.empty())
+                        return NULL;
+
+                    std::pop_heap(m_frontier.begin(), m_frontier.end(), FrontierLess(m_heap));
+                    uint32 index = m_frontier.back();
+                    m_frontier.pop_back();
+
+                    for (uint32 child = 2 * index + 1; child <= 2 * index + 2 && child < m_heap.size(); ++child)
+                    {
+                        m_frontier.push_back(child);
+                        std::push_heap(m_frontier.begin(), m_frontier.end(), FrontierLess(m_heap));
+                    }
+
+                    return m_heap[index];
+                }
+
+            private:
+                struct FrontierLess
+                {
+                    explicit FrontierLess(IndexedHeap const& heap) : m_heap(heap) {}
+                    bool operator()(uint32 lhs, uint32 rhs) const { return Traits::Less(m_heap[lhs], m_heap[rhs]); }
+                    IndexedHeap const& m_heap;
+                };
+
+                IndexedHeap const& m_heap;
+                std::vector<uint32> m_frontier;             // heap positions not walked yet whose parent was
+        };
+
+        bool empty() const { return m_heap.empty(); }
+        uint32 size() const { return uint32(m_heap.size()); }
+        T* top() const { return m_heap.empty() ? NULL : m_heap.front(); }
+        T* operator[](uint32 index) const { return m_heap[index]; }        // heap order, not sorted
+
+        bool contains(T* elem) const
+        {
+            uint32 index = Traits::Index(elem);
+            return index < m_heap.size() && m_heap[index] == elem;
+        }
+
+        void push(T* elem)
+        {
+            Traits::Index(elem) = uint32(m_heap.size());
+            m_heap.push_back(elem);
+            _SiftUp(uint32(m_heap.size() - 1));
+        }
+
+        // false if elem is not in the heap
+        bool remove(T* elem)
+        {
+            if (!contains(elem))
+                return false;
+
+            uint32 index = Traits::Index(elem);
+            T* last = m_heap.back();
+            m_heap.pop_back();
+            if (last != elem)
+            {
+                _Place(last, index);
+                _Fix(index);
+            }
+            return true;
+        }
+
+        // key of elem changed
+        void update(T* elem)
+        {
+            if (contains(elem))
+                _Fix(Traits::Index(elem));
+        }
+
+        void clear() { m_heap.clear(); }
+
+    private:
+        void _Place(T* elem, uint32 index)
+        {
+            m_heap[index] = elem;
+            Traits::Index(elem) = index;
+        }
+
+        void _Fix(uint32 index)
+        {
+            if (index > 0 && Traits::Less(m_heap[(index - 1) / 2], m_heap[index]))
+                _SiftUp(index);
+            else
+                _SiftDown(index);
+        }
+
+        void _SiftUp(uint32 index)
+        {
+            T* elem = m_heap[index];
+            while (index > 0)
+            {
+                uint32 parent = (index - 1) / 2;
+                if (!Traits::Less(m_heap[parent], elem))
+                    break;
+                _Place(m_heap[parent], index);
+                index = parent;
+            }
+            _Place(elem, index);
+        }
+
+        void _SiftDown(uint32 index)
+        {
+            T* elem = m_heap[index];
+            uint32 size = uint32(m_heap.size());
+            for (;;)
+            {
+                uint32 child = 2 * index + 1;
+                if (child >= size)
+                    break;
+                if (child + 1 < size && Traits::Less(m_heap[child], m_heap[child + 1]))
+                    ++child;
+                if (!Traits::Less(elem, m_heap[child]))
+                    break;
+                _Place(m_heap[child], index);
+                index = child;
+            }
+            _Place(elem, index);
+        }
+
+        std::vector<T*> m_heap;
+};
+
+#endif
@@ -360,6 +360,8 @@ void WorldSession::HandleAuctionPlaceBid( WorldPacket & recv_data )
         return;
     }
 
+    SQLTransaction trans = CharacterDatabase.BeginTransaction();
+
     if ((price < auction->buyout) || (auction->buyout == 0))
     {
         if (auction->bidder > 0)
@@ -405,19 +407,18 @@ void WorldSession::HandleAuctionPlaceBid( WorldPacket & recv_data )
         auction->bidder = pl->GetGUIDLow();
         auction->bid = auction->buyout;
 
-        sAHMgr.SendAuctionSalePendingMail( auction );
-        sAHMgr.SendAuctionSuccessfulMail( auction );
-        sAHMgr.SendAuctionWonMail( auction );
+        sAHMgr.SendAuctionSalePendingMail( auction, trans );
+        sAHMgr.SendAuctionSuccessfulMail( auction, trans );
+        sAHMgr.SendAuctionWonMail( auction, trans );
 
         SendAuctionCommandResult(auction->Id, AUCTION_PLACE_BID, AUCTION_OK);
 
         sAHMgr.RemoveAItem(auction->item_guidlow);
         auctionHouse->RemoveAuction(auction->Id);
-        auction->DeleteFromDB();
+        auction->DeleteFromDB(trans);
 
         delete auction;
     }
-    SQLTransaction trans = CharacterDatabase.BeginTransaction();
     pl->SaveInventoryAndGoldToDB(trans);
     CharacterDatabase.CommitTransaction(trans);
 }
@@ -493,9 +494,8 @@ void WorldSession::HandleAuctionRemoveItem( WorldPacket & recv_data )
     //inform player, that auction is removed
     SendAuctionCommandResult( auction->Id, AUCTION_CANCEL, AUCTION_OK );
     // Now remove the auction
-    // TODO: SQL Transaction
     SQLTransaction trans = CharacterDatabase.BeginTransaction();
-    auction->DeleteFromDB();
+    auction->DeleteFromDB(trans);
     pl->SaveInventoryAndGoldToDB(trans);
     CharacterDatabase.CommitTransaction(trans);
     sAHMgr.RemoveAItem( auction->item_guidlow );
@@ -36,7 +36,7 @@
 
 INSTANTIATE_SINGLETON_1( AuctionHouseMgr );
 
-AuctionHouseMgr::AuctionHouseMgr()
+AuctionHouseMgr::AuctionHouseMgr() : mExpiryBacklog(false)
 {
 }
 
@@ -99,7 +99,7 @@ uint32 AuctionHouseMgr::GetAuctionDeposit(AuctionHouseEntry const* entry, uint32
 }
 
 //does not clear ram
-void AuctionHouseMgr::SendAuctionWonMail( AuctionEntry *auction )
+void AuctionHouseMgr::SendAuctionWonMail( AuctionEntry *auction, SQLTransaction& trans )
 {
     Item *pItem = GetAItem(auction->item_guidlow);
     if(!pItem)
@@ -164,7 +164,7 @@ void AuctionHouseMgr::SendAuctionWonMail( AuctionEntry *auction )
 
         // set owner to bidder (to prevent delete item with sender char deleting)
         // owner in `data` will set at mail receive and item extracting
-        CharacterDatabase.PExecute("UPDATE item_instance SET owner_guid = '%u' WHERE guid='%u'",auction->bidder,pItem->GetGUIDLow());
+        trans->PAppend("UPDATE item_instance SET owner_guid = '%u' WHERE guid='%u'",auction->bidder,pItem->GetGUIDLow());
 
         MailItemsInfo mi;
         mi.AddItem(auction->item_guidlow, auction->item_template, pItem);
@@ -175,18 +175,18 @@ void AuctionHouseMgr::SendAuctionWonMail( AuctionEntry *auction )
             RemoveAItem(pItem->GetGUIDLow()); // we have to remove the item, before we delete it !!
 
         // will delete item or place to receiver mail list
-        WorldSession::SendMailTo(bidder, MAIL_AUCTION, MAIL_STATIONERY_AUCTION, auction->GetHouseId(), auction->bidder, msgAuctionWonSubject.str(), itemTextId, &mi, 0, 0, MAIL_CHECK_MASK_AUCTION);
+        WorldSession::SendMailTo(trans, bidder, MAIL_AUCTION, MAIL_STATIONERY_AUCTION, auction->GetHouseId(), auction->bidder, msgAuctionWonSubject.str(), itemTextId, &mi, 0, 0, MAIL_CHECK_MASK_AUCTION);
     }
     // receiver not exist
     else
     {
-        CharacterDatabase.PExecute("DELETE FROM item_instance WHERE guid='%u'", pItem->GetGUIDLow());
+        trans->PAppend("DELETE FROM item_instance WHERE guid='%u'", pItem->GetGUIDLow());
         RemoveAItem(pItem->GetGUIDLow()); // we have to remove the item, before we delete it !!
         delete pItem;
     }
 }
 
-void AuctionHouseMgr::SendAuctionSalePendingMail( AuctionEntry * auction )
+void AuctionHouseMgr::SendAuctionSalePendingMail( AuctionEntry * auction, SQLTransaction& trans )
 {
     uint64 owner_guid = MAKE_NEW_GUID(auction->owner, 0, HIGHGUID_PLAYER);
     Player *owner = objmgr.GetPlayer(owner_guid);
@@ -210,12 +210,12 @@ void AuctionHouseMgr::SendAuctionSalePendingMail( AuctionEntry * auction )
 
         uint32 itemTextId = objmgr.CreateItemText( msgAuctionSalePendingBody.str() );
 
-        WorldSession::SendMailTo(owner, MAIL_AUCTION, MAIL_STATIONERY_AUCTION, auction->GetHouseId(), auction->owner, msgAuctionSalePendingSubject.str(), itemTextId, NULL, 0, 0, MAIL_CHECK_MASK_AUCTION);
+        WorldSession::SendMailTo(trans, owner, MAIL_AUCTION, MAIL_STATIONERY_AUCTION, auction->GetHouseId(), auction->owner, msgAuctionSalePendingSubject.str(), itemTextId, NULL, 0, 0, MAIL_CHECK_MASK_AUCTION);
     }
 }
 
 //call this method to send mail to auction owner, when auction is successful, it does not clear ram
-void AuctionHouseMgr::SendAuctionSuccessfulMail( AuctionEntry * auction )
+void AuctionHouseMgr::SendAuctionSuccessfulMail( AuctionEntry * auction, SQLTransaction& trans )
 {
     uint64 owner_guid = MAKE_NEW_GUID(auction->owner, 0, HIGHGUID_PLAYER);
     Player *owner = objmgr.GetPlayer(owner_guid);
@@ -248,14 +248,14 @@ void AuctionHouseMgr::SendAuctionSuccessfulMail( AuctionEntry * auction )
             owner->GetSession()->SendAuctionOwnerNotification( auction );
         }
 
-        WorldSession::SendMailTo(owner, MAIL_AUCTION, MAIL_STATIONERY_AUCTION, auction->GetHouseId(), auction->owner, msgAuctionSuccessfulSubject.str(), itemTextId, NULL, profit, 0, MAIL_CHECK_MASK_AUCTION, sWorld.getConfig(CONFIG_MAIL_DELIVERY_DELAY));
+        WorldSession::SendMailTo(trans, owner, MAIL_AUCTION, MAIL_STATIONERY_AUCTION, auction->GetHouseId(), auction->owner, msgAuctionSuccessfulSubject.str(), itemTextId, NULL, profit, 0, MAIL_CHECK_MASK_AUCTION, sWorld.getConfig(CONFIG_MAIL_DELIVERY_DELAY));
     }
     else
         sLog.outError("SendAuctionSuccessfulMail: Mail not sent for some reason to player %s (GUID %u, account %u).", owner ? owner->GetName() : "<unknown> (maybe offline)", owner ? owner->GetGUIDLow() : 0, owner_accId);
 }
 
 //does not clear ram
-void AuctionHouseMgr::SendAuctionExpiredMail( AuctionEntry * auction )
+void AuctionHouseMgr::SendAuctionExpiredMail( AuctionEntry * auction, SQLTransaction& trans )
 { //return an item in auction to its owner by mail
     Item *pItem = GetAItem(auction->item_guidlow);
     if(!pItem)
@@ -286,12 +286,12 @@ void AuctionHouseMgr::SendAuctionExpiredMail( AuctionEntry * auction )
         mi.AddItem(auction->item_guidlow, auction->item_template, pItem);
 
         // will delete item or place to receiver mail list
-        WorldSession::SendMailTo(owner, MAIL_AUCTION, MAIL_STATIONERY_AUCTION, auction->GetHouseId(), GUID_LOPART(owner_guid), subject.str(), 0, &mi, 0, 0, MAIL_CHECK_MASK_NONE);
+        WorldSession::SendMailTo(trans, owner, MAIL_AUCTION, MAIL_STATIONERY_AUCTION, auction->GetHouseId(), GUID_LOPART(owner_guid), subject.str(), 0, &mi, 0, 0, MAIL_CHECK_MASK_NONE);
     }
     // owner not found
     else
     {
-        CharacterDatabase.PExecute("DELETE FROM item_instance WHERE guid='%u'",pItem->GetGUIDLow());
+        trans->PAppend("DELETE FROM item_instance WHERE guid='%u'",pItem->GetGUIDLow());
         RemoveAItem(pItem->GetGUIDLow()); // we have to remove the item, before we delete it !!
         delete pItem;
     }
@@ -375,6 +375,9 @@ void AuctionHouseMgr::LoadAuctions()
 
     AuctionEntry *aItem;
 
+    // dropped auctions are returned to their owners in one transaction
+    SQLTransaction trans = CharacterDatabase.BeginTransaction();
+
     do
     {
         fields = result->Fetch();
@@ -396,8 +399,8 @@ void AuctionHouseMgr::LoadAuctions()
         CreatureData const* auctioneerData = objmgr.GetCreatureData(aItem->auctioneer);
         if(!auctioneerData)
         {
-            AuctionHouseMgr::SendAuctionExpiredMail(aItem);
-            aItem->DeleteFromDB();
+            SendAuctionExpiredMail(aItem, trans);
+            aItem->DeleteFromDB(trans);
             sLog.outError("Auction %u has not a existing auctioneer (GUID : %u)", aItem->Id, aItem->auctioneer);
             delete aItem;
             continue;
@@ -406,8 +409,8 @@ void AuctionHouseMgr::LoadAuctions()
         CreatureInfo const* auctioneerInfo = objmgr.GetCreatureTemplate(auctioneerData->id);
         if(!auctioneerInfo)
         {
-            AuctionHouseMgr::SendAuctionExpiredMail(aItem);
-            aItem->DeleteFromDB();
+            SendAuctionExpiredMail(aItem, trans);
+            aItem->DeleteFromDB(trans);
             sLog.outError("Auction %u has not a existing auctioneer (GUID : %u Entry: %u)", aItem->Id, aItem->auctioneer,auctioneerData->id);
             delete aItem;
             continue;
@@ -416,8 +419,8 @@ void AuctionHouseMgr::LoadAuctions()
         aItem->auctionHouseEntry = AuctionHouseMgr::GetAuctionHouseEntry(auctioneerInfo->faction_A);
         if(!aItem->auctionHouseEntry)
         {
-            AuctionHouseMgr::SendAuctionExpiredMail(aItem);
-            aItem->DeleteFromDB();
+            SendAuctionExpiredMail(aItem, trans);
+            aItem->DeleteFromDB(trans);
             sLog.outError("Auction %u has auctioneer (GUID : %u Entry: %u) with wrong faction %u",
                 aItem->Id, aItem->auctioneer,auctioneerData->id,auctioneerInfo->faction_A);
             delete aItem;
@@ -428,7 +431,7 @@ void AuctionHouseMgr::LoadAuctions()
         // and item_template in fact (GetAItem will fail if problematic in result check in ObjectMgr::LoadAuctionItems)
         if ( !GetAItem( aItem->item_guidlow ) )
         {
-            aItem->DeleteFromDB();
+            aItem->DeleteFromDB(trans);
             sLog.outError("Auction %u has not a existing item : %u", aItem->Id, aItem->item_guidlow);
             delete aItem;
             continue;
@@ -439,6 +442,9 @@ void AuctionHouseMgr::LoadAuctions()
     } while (result->NextRow());
     delete result;
 
+    if (trans->GetSize())
+        CharacterDatabase.CommitTransaction(trans);
+
     sLog.outString();
     sLog.outString( ">> Loaded %u auctions", AuctionCount );
 }
@@ -463,16 +469,36 @@ bool AuctionHouseMgr::RemoveAItem( uint32 id )
 
 void AuctionHouseMgr::Update()
 {
-    mHordeAuctions.Update();
-    mAllianceAuctions.Update();
-    mNeutralAuctions.Update();
+    time_t curTime = sWorld.GetGameTime();
+
+    uint32 maxCount = sWorld.getConfig(CONFIG_AUCTION_EXPIRY_BATCH);
+    if (!maxCount)
+        maxCount = 0xFFFFFFFF;
+
+    ///- Settle the expired auctions of the three houses in one transaction
+    SQLTransaction trans = CharacterDatabase.BeginTransaction();
+
+    uint32 count = mHordeAuctions.Update(curTime, maxCount, trans);
+    count += mAllianceAuctions.Update(curTime, maxCount - count, trans);
+    count += mNeutralAuctions.Update(curTime, maxCount - count, trans);
+
+    if (trans->GetSize())
+        CharacterDatabase.CommitTransaction(trans);
+
+    mExpiryBacklog = mHordeAuctions.HasExpiredAuctions(curTime) || mAllianceAuctions.HasExpiredAuctions(curTime) ||
+        mNeutralAuctions.HasExpiredAuctions(curTime);
 }
 
 void AuctionHouseMgr::RemoveAllAuctionsOf(uint32 ownerGUID)
 {
-    mHordeAuctions.RemoveAllAuctionsOf(ownerGUID);
-    mAllianceAuctions.RemoveAllAuctionsOf(ownerGUID);
-    mNeutralAuctions.RemoveAllAuctionsOf(ownerGUID);
+    SQLTransaction trans = CharacterDatabase.BeginTransaction();
+
+    mHordeAuctions.RemoveAllAuctionsOf(ownerGUID, trans);
+    mAllianceAuctions.RemoveAllAuctionsOf(ownerGUID, trans);
+    mNeutralAuctions.RemoveAllAuctionsOf(ownerGUID, trans);
+
+    if (trans->GetSize())
+        CharacterDatabase.CommitTransaction(trans);
 }
 
 AuctionHouseEntry const* AuctionHouseMgr::GetAuctionHouseEntry(uint32 factionTemplateId)
@@ -515,55 +541,85 @@ AuctionHouseEntry const* AuctionHouseMgr::GetAuctionHouseEntry(uint32 factionTem
     return sAuctionHouseStore.LookupEntry(houseid);
 }
 
-void AuctionHouseObject::Update()
+bool AuctionHouseObject::RemoveAuction(uint32 id)
 {
-    time_t curTime = sWorld.GetGameTime();
-    ///- Handle expired auctions
-    AuctionEntryMap::iterator next;
-    for (AuctionEntryMap::iterator itr = AuctionsMap.begin(); itr != AuctionsMap.end();itr = next)
+    AuctionEntryMap::iterator itr = AuctionsMap.find(id);
+    if (itr == AuctionsMap.end())
+        return false;
+
+    std::pair<AuctionExpiryMap::iterator, AuctionExpiryMap::iterator> range = ExpiryIndex.equal_range(itr->second->expire_time);
+    for (AuctionExpiryMap::iterator expiryItr = range.first; expiryItr != range.second; ++expiryItr)
     {
-        next = itr;
-        ++next;
-        if (curTime > (itr->second->expire_time))
+        if (expiryItr->second == id)
         {
-            ///- Either cancel the auction if there was no bidder
-            if (itr->second->bidder == 0)
-            {
-                sAHMgr.SendAuctionExpiredMail( itr->second );
-            }
-            ///- Or perform the transaction
-            else
-            {
-                //we should send an "item sold" message if the seller is online
-                //we send the item to the winner
-                //we send the money to the seller
-                sAHMgr.SendAuctionSuccessfulMail( itr->second );
-                sAHMgr.SendAuctionWonMail( itr->second );
-            }
+            ExpiryIndex.erase(expiryItr);
+            break;
+        }
+    }
 
-            ///- In any case clear the auction
-            itr->second->DeleteFromDB();
-            sAHMgr.RemoveAItem(itr->second->item_guidlow);
-            delete itr->second;
-            RemoveAuction(itr->first);
+    SearchIndex.Remove(id);
+    AuctionsMap.erase(itr);
+    return true;
+}
+
+uint32 AuctionHouseObject::Update(time_t curTime, uint32 maxCount, SQLTransaction& trans)
+{
+    uint32 count = 0;
+
+    ///- Handle expired auctions, only the due ones are touched
+    while (count < maxCount && HasExpiredAuctions(curTime))
+    {
+        AuctionEntry* auction = GetAuction(ExpiryIndex.begin()->second);
+        if (!auction)
+        {
+            ExpiryIndex.erase(ExpiryIndex.begin());
+            continue;
+        }
+
+        ///- Either cancel the auction if there was no bidder
+        if (auction->bidder == 0)
+        {
+            sAHMgr.SendAuctionExpiredMail( auction, trans );
+        }
+        ///- Or perform the transaction
+        else
+        {
+            //we should send an "item sold" message if the seller is online
+            //we send the item to the winner
+            //we send the money to the seller
+            sAHMgr.SendAuctionSuccessfulMail( auction, trans );
+            sAHMgr.SendAuctionWonMail( auction, trans );
         }
+
+        ///- In any case clear the auction
+        auction->DeleteFromDB(trans);
+        sAHMgr.RemoveAItem(auction->item_guidlow);
+        RemoveAuction(auction->Id);
+        delete auction;
+        ++count;
     }
+
+    ///- Forget the browse results nobody paged through lately
+    SearchIndex.PruneResults(time(NULL) - 5*MINUTE);
+
+    return count;
 }
 
 // NOT threadsafe!
-void AuctionHouseObject::RemoveAllAuctionsOf(uint32 ownerGUID)
+void AuctionHouseObject::RemoveAllAuctionsOf(uint32 ownerGUID, SQLTransaction& trans)
 {
     AuctionEntryMap::iterator next;
     for (AuctionEntryMap::iterator itr = AuctionsMap.begin(); itr != AuctionsMap.end();itr = next)
     {
         next = itr;
         ++next;
-        if (itr->second->owner == ownerGUID)
+        AuctionEntry* auction = itr->second;
+        if (auction->owner == ownerGUID)
         {
             ///- Either cancel the auction if there was no bidder
-            if (itr->second->bidder == 0)
+            if (auction->bidder == 0)
             {
-                sAHMgr.SendAuctionExpiredMail( itr->second );
+                sAHMgr.SendAuctionExpiredMail( auction, trans );
             }
             ///- Or perform the transaction
             else
@@ -571,15 +627,15 @@ void AuctionHouseObject::RemoveAllAuctionsOf(uint32 ownerGUID)
                 //we should send an "item sold" message if the seller is online
                 //we send the item to the winner
                 //we send the money to the seller
-                sAHMgr.SendAuctionSuccessfulMail( itr->second );
-                sAHMgr.SendAuctionWonMail( itr->second );
+                sAHMgr.SendAuctionSuccessfulMail( auction, trans );
+                sAHMgr.SendAuctionWonMail( auction, trans );
             }
 
             ///- In any case clear the auction
-            itr->second->DeleteFromDB();
-            sAHMgr.RemoveAItem(itr->second->item_guidlow);
-            delete itr->second;
-            RemoveAuction(itr->first);
+            auction->DeleteFromDB(trans);
+            sAHMgr.RemoveAItem(auction->item_guidlow);
+            RemoveAuction(auction->Id);
+            delete auction;
         }
     }
 }
@@ -632,61 +688,27 @@ void AuctionHouseObject::BuildListAuctionItems(WorldPacket& data, Player* player
     uint32 inventoryType, uint32 itemClass, uint32 itemSubClass, uint32 quality,
     uint32& count, uint32& totalcount)
 {
-    int loc_idx = player->GetSession()->GetSessionDbLocaleIndex();
-
-    for (AuctionEntryMap::const_iterator itr = AuctionsMap.begin();itr != AuctionsMap.end();++itr)
+    AuctionSearchQuery query;
+    query.locale = player->GetSession()->GetSessionDbLocaleIndex();
+    query.name = wsearchedname;
+    query.levelmin = levelmin;
+    query.levelmax = levelmax;
+    query.usable = usable;
+    query.inventoryType = inventoryType;
+    query.itemClass = itemClass;
+    query.itemSubClass = itemSubClass;
+    query.quality = quality;
+
+    std::vector<uint32> const& auctions = SearchIndex.Search(player, query);
+
+    for (size_t i = listfrom; i < auctions.size() && count < 50; ++i)
     {
-        AuctionEntry *Aentry = itr->second;
-        Item *item = sAHMgr.GetAItem(Aentry->item_guidlow);
-        if (!item)
-            continue;
-
-        ItemPrototype const *proto = item->GetProto();
-
-        if (itemClass != (0xffffffff) && proto->Class != itemClass)
-            continue;
-
-        if (itemSubClass != (0xffffffff) && proto->SubClass != itemSubClass)
-            continue;
-
-        if (inventoryType != (0xffffffff) && proto->InventoryType != inventoryType)
-            continue;
-
-        if (quality != (0xffffffff) && proto->Quality != quality)
-            continue;
-
-        if( levelmin != (0x00) && (proto->RequiredLevel < levelmin || levelmax != (0x00) && proto->RequiredLevel > levelmax ) )
-            continue;
-
-        if( usable != (0x00) && player->CanUseItem( item ) != EQUIP_ERR_OK )
-            continue;
-
-        std::string name = proto->Name1;
-        if(name.empty())
-            continue;
-
-        // local name
-        if ( loc_idx >= 0 )
-        {
-            ItemLocale const *il = objmgr.GetItemLocale(proto->ItemId);
-            if (il)
-            {
-                if (il->Name.size() > size_t(loc_idx) && !il->Name[loc_idx].empty())
-                    name = il->Name[loc_idx];
-            }
-        }
-
-        if( !wsearchedname.empty() && !Utf8FitTo(name, wsearchedname) )
-            continue;
-
-        if ((count < 50) && (totalcount >= listfrom))
-        {
+        AuctionEntry* Aentry = GetAuction(auctions[i]);
+        if (Aentry && Aentry->BuildAuctionInfo(data))
             ++count;
-            Aentry->BuildAuctionInfo(data);
-        }
-
-        ++totalcount;
     }
+
+    totalcount += auctions.size();
 }
 
 //this function inserts to WorldPacket auction's data
@@ -744,10 +766,10 @@ uint32 AuctionEntry::GetAuctionOutBid() const
     return outbid;
 }
 
-void AuctionEntry::DeleteFromDB() const
+void AuctionEntry::DeleteFromDB(SQLTransaction& trans) const
 {
     //No SQL injection (Id is integer)
-    CharacterDatabase.PExecute("DELETE FROM auctionhouse WHERE id = '%u'",Id);
+    trans->PAppend("DELETE FROM auctionhouse WHERE id = '%u'",Id);
 }
 
 void AuctionEntry::SaveToDB() const
@@ -23,6 +23,8 @@
 
 #include "SharedDefines.h"
 #include "Policies/Singleton.h"
+#include "AuctionSearchIndex.h"
+#include "Transaction.h"
 
 class Item;
 class Player;
@@ -69,7 +71,7 @@ struct AuctionEntry
     uint32 GetAuctionCut() const;
     uint32 GetAuctionOutBid() const;
     bool BuildAuctionInfo(WorldPacket & data) const;
-    void DeleteFromDB() const;
+    void DeleteFromDB(SQLTransaction& trans) const;
     void SaveToDB() const;
 };
 
@@ -95,6 +97,8 @@ class AuctionHouseObject
     {
         ASSERT( ah );
         AuctionsMap[ah->Id] = ah;
+        ExpiryIndex.insert(AuctionExpiryMap::value_type(ah->expire_time, ah->Id));
+        SearchIndex.Insert(ah);
     }
 
     AuctionEntry* GetAuction(uint32 id) const
@@ -103,14 +107,14 @@ class AuctionHouseObject
         return itr != AuctionsMap.end() ? itr->second : NULL;
     }
 
-    bool RemoveAuction(uint32 id)
-    {
-        return AuctionsMap.erase(id) ? true : false;
-    }
+    // the entry must still exist, delete it after
+    bool RemoveAuction(uint32 id);
     
-    void RemoveAllAuctionsOf(uint32 ownerGUID);
+    void RemoveAllAuctionsOf(uint32 ownerGUID, SQLTransaction& trans);
 
-    void Update();
+    // settle at most maxCount expired auctions in expiry order, returns the number settled
+    uint32 Update(time_t curTime, uint32 maxCount, SQLTransaction& trans);
+    bool HasExpiredAuctions(time_t curTime) const { return !ExpiryIndex.empty() && curTime > ExpiryIndex.begin()->first; }
 
     void BuildListBidderItems(WorldPacket& data, Player* player, uint32& count, uint32& totalcount);
     void BuildListOwnerItems(WorldPacket& data, Player* player, uint32& count, uint32& totalcount);
@@ -121,7 +125,11 @@ class AuctionHouseObject
         uint32& count, uint32& totalcount);
 
   private:
+    typedef std::multimap<time_t, uint32> AuctionExpiryMap;
+
     AuctionEntryMap AuctionsMap;
+    AuctionExpiryMap ExpiryIndex;                           // auction ids by expire time
+    AuctionSearchIndex SearchIndex;
 };
 
 class AuctionHouseMgr
@@ -145,10 +153,10 @@ class AuctionHouseMgr
     }
 
     //auction messages
-    void SendAuctionWonMail( AuctionEntry * auction );
-    void SendAuctionSalePendingMail( AuctionEntry * auction );
-    void SendAuctionSuccessfulMail( AuctionEntry * auction );
-    void SendAuctionExpiredMail( AuctionEntry * auction );
+    void SendAuctionWonMail( AuctionEntry * auction, SQLTransaction& trans );
+    void SendAuctionSalePendingMail( AuctionEntry * auction, SQLTransaction& trans );
+    void SendAuctionSuccessfulMail( AuctionEntry * auction, SQLTransaction& trans );
+    void SendAuctionExpiredMail( AuctionEntry * auction, SQLTransaction& trans );
     static uint32 GetAuctionDeposit(AuctionHouseEntry const* entry, uint32 time, Item *pItem);
     static AuctionHouseEntry const* GetAuctionHouseEntry(uint32 factionTemplateId);
     void RemoveAllAuctionsOf(uint32 ownerGUID);
@@ -162,6 +170,8 @@ class AuctionHouseMgr
     bool RemoveAItem(uint32 id);
 
     void Update();
+    // expired auctions are left after the last update, settled by the following world ticks
+    bool HasExpiryBacklog() const { return mExpiryBacklog; }
 
   private:
     AuctionHouseObject mHordeAuctions;
@@ -169,6 +179,7 @@ class AuctionHouseMgr
     AuctionHouseObject mNeutralAuctions;
 
     ItemMap mAitems;
+    bool mExpiryBacklog;
 };
 
 #define sAHMgr Trinity::Singleton<AuctionHouseMgr>::Instance()
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include "Database/DBCStores.h"
+#include "AuctionSearchIndex.h"
+#include "AuctionHouseMgr.h"
+#include "ObjectMgr.h"
+#include "Player.h"
+#include "Util.h"
+
+#include <algorithm>
+
+static void InsertId(std::vector<uint32>& list, uint32 id)
+{
+    // auction ids are generated in increasing order, nearly always appended
+    if (list.empty() || list.back() < id)
+        list.push_back(id);
+    else
+        list.insert(std::lower_bound(list.begin(), list.end(), id), id);
+}
+
+template<class Map>
+static void RemoveId(Map& lists, typename Map::key_type key, uint32 id)
+{
+    typename Map::iterator itr = lists.find(key);
+    if (itr == lists.end())
+        return;
+
+    std::vector<uint32>& list = itr->second;
+    std::vector<uint32>::iterator pos = std::lower_bound(list.begin(), list.end(), id);
+    if (pos != list.end() && *pos == id)
+        list.erase(pos);
+
+    if (list.empty())
+        lists.erase(itr);
+}
+
+template<class Map>
+static void SelectShortest(Map const& lists, typename Map::key_type key, std::vector<uint32> const*& shortest)
+{
+    static std::vector<uint32> const empty;
+
+    typename Map::const_iterator itr = lists.find(key);
+    std::vector<uint32> const* list = itr != lists.end() ? &itr->second : &empty;
+    if (list->size() < shortest->size())
+        shortest = list;
+}
+
+/// Distinct 3 character substrings of a name, 21 bits per character
+static void GetTrigrams(std::wstring const& name, std::vector<uint64>& trigrams)
+{
+    trigrams.clear();
+    for (size_t i = 0; i + 3 <= name.size(); ++i)
+        trigrams.push_back((uint64(name[i] & 0x1FFFFF) << 42) | (uint64(name[i + 1] & 0x1FFFFF) << 21) | uint64(name[i + 2] & 0x1FFFFF));
+
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+void AuctionSearchIndex::Insert(AuctionEntry const* auction)
+{
+    if (m_records.find(auction->Id) != m_records.end())
+        Remove(auction->Id);
+
+    AuctionRecord record;
+    record.itemGuid = auction->item_guidlow;
+    record.itemEntry = auction->item_template;
+
+    if (ItemPrototype const* proto = objmgr.GetItemPrototype(auction->item_template))
+    {
+        record.itemClass = proto->Class;
+        record.itemSubClass = proto->SubClass;
+        record.inventoryType = proto->InventoryType;
+        record.quality = proto->Quality;
+        record.requiredLevel = proto->RequiredLevel;
+        record.hasName = proto->Name1 && *proto->Name1;
+    }
+    else
+    {
+        record.itemClass = record.itemSubClass = record.inventoryType = record.quality = record.requiredLevel = 0;
+        record.hasName = false;
+    }
+
+    m_records[auction->Id] = record;
+
+    InsertId(m_all, auction->Id);
+    InsertId(m_byClass[record.itemClass], auction->Id);
+    InsertId(m_bySubClass[(record.itemClass << 16) | record.itemSubClass], auction->Id);
+    InsertId(m_byInventoryType[record.inventoryType], auction->Id);
+    InsertId(m_byQuality[record.quality], auction->Id);
+    InsertId(m_byLevel[record.requiredLevel], auction->Id);
+
+    for (NameIndexMap::iterator itr = m_names.begin(); itr != m_names.end(); ++itr)
+        _IndexName(itr->second, itr->first, auction->Id, record.itemEntry);
+
+    ++m_generation;
+}
+
+void AuctionSearchIndex::Remove(uint32 auctionId)
+{
+    UNORDERED_MAP<uint32, AuctionRecord>::iterator itr = m_records.find(auctionId);
+    if (itr == m_records.end())
+        return;
+
+    AuctionRecord const& record = itr->second;
+
+    std::vector<uint32>::iterator pos = std::lower_bound(m_all.begin(), m_all.end(), auctionId);
+    if (pos != m_all.end() && *pos == auctionId)
+        m_all.erase(pos);
+
+    RemoveId(m_byClass, record.itemClass, auctionId);
+    RemoveId(m_bySubClass, (record.itemClass << 16) | record.itemSubClass, auctionId);
+    RemoveId(m_byInventoryType, record.inventoryType, auctionId);
+    RemoveId(m_byQuality, record.quality, auctionId);
+    RemoveId(m_byLevel, record.requiredLevel, auctionId);
+
+    std::vector<uint64> trigrams;
+    for (NameIndexMap::iterator nameItr = m_names.begin(); nameItr != m_names.end(); ++nameItr)
+    {
+        GetTrigrams(_GetName(nameItr->second, nameItr->first, record.itemEntry), trigrams);
+        for (std::vector<uint64>::const_iterator trigram = trigrams.begin(); trigram != trigrams.end(); ++trigram)
+            RemoveId(nameItr->second.trigrams, *trigram, auctionId);
+    }
+
+    m_records.erase(itr);
+    ++m_generation;
+}
+
+std::vector<uint32> const& AuctionSearchIndex::Search(Player* player, AuctionSearchQuery const& query)
+{
+    SearchResult& result = m_results[player->GetGUIDLow()];
+
+    // next page of the previous search
+    if (result.time && result.generation == m_generation && result.query == query)
+    {
+        result.time = time(NULL);
+        return result.auctions;
+    }
+
+    result.query = query;
+    result.generation = m_generation;
+    result.time = time(NULL);
+    result.auctions.clear();
+
+    NameIndex* names = query.name.empty() ? NULL : &_GetNameIndex(query.locale);
+
+    ///- Shortest list of candidates among the criteria of the search
+    AuctionIdList const* candidates = &m_all;
+
+    if (query.itemClass != AUCTION_SEARCH_ANY)
+    {
+        if (query.itemSubClass != AUCTION_SEARCH_ANY)
+            SelectShortest(m_bySubClass, (query.itemClass << 16) | query.itemSubClass, candidates);
+        else
+            SelectShortest(m_byClass, query.itemClass, candidates);
+    }
+
+    if (query.inventoryType != AUCTION_SEARCH_ANY)
+        SelectShortest(m_byInventoryType, query.inventoryType, candidates);
+
+    if (query.quality != AUCTION_SEARCH_ANY)
+        SelectShortest(m_byQuality, query.quality, candidates);
+
+    if (names)
+    {
+        std::vector<uint64> trigrams;
+        GetTrigrams(query.name, trigrams);
+        for (std::vector<uint64>::const_iterator itr = trigrams.begin(); itr != trigrams.end(); ++itr)
+            SelectShortest(names->trigrams, *itr, candidates);
+    }
+
+    // level ranges cover several lists, merged only when they are shorter together
+    AuctionIdList levelCandidates;
+    if (query.levelmin)
+    {
+        size_t size = 0;
+        for (AuctionIdListMap::const_iterator itr = m_byLevel.begin(); itr != m_byLevel.end(); ++itr)
+            if (itr->first >= query.levelmin && (!query.levelmax || itr->first <= query.levelmax))
+                size += itr->second.size();
+
+        if (size < candidates->size())
+        {
+            levelCandidates.reserve(size);
+            for (AuctionIdListMap::const_iterator itr = m_byLevel.begin(); itr != m_byLevel.end(); ++itr)
+                if (itr->first >= query.levelmin && (!query.levelmax || itr->first <= query.levelmax))
+                    levelCandidates.insert(levelCandidates.end(), itr->second.begin(), itr->second.end());
+
+            std::sort(levelCandidates.begin(), levelCandidates.end());
+            candidates = &levelCandidates;
+        }
+    }
+
+    ///- Check every criterion on the candidates
+    for (AuctionIdList::const_iterator itr = candidates->begin(); itr != candidates->end(); ++itr)
+    {
+        UNORDERED_MAP<uint32, AuctionRecord>::const_iterator record = m_records.find(*itr);
+        if (record != m_records.end() && _Match(player, query, names, record->second))
+            result.auctions.push_back(*itr);
+    }
+
+    return result.auctions;
+}
+
+void AuctionSearchIndex::PruneResults(time_t before)
+{
+    for (SearchResultMap::iterator itr = m_results.begin(); itr != m_results.end();)
+    {
+        if (itr->second.time < before)
+            m_results.erase(itr++);
+        else
+            ++itr;
+    }
+}
+
+AuctionSearchIndex::NameIndex& AuctionSearchIndex::_GetNameIndex(int locale)
+{
+    NameIndexMap::iterator itr = m_names.find(locale);
+    if (itr != m_names.end())
+        return itr->second;
+
+    // first search in this locale, index the names of the current auctions
+    NameIndex& index = m_names[locale];
+    for (UNORDERED_MAP<uint32, AuctionRecord>::const_iterator record = m_records.begin(); record != m_records.end(); ++record)
+        _IndexName(index, locale, record->first, record->second.itemEntry);
+
+    return index;
+}
+
+std::wstring const& AuctionSearchIndex::_GetName(NameIndex& index, int locale, uint32 itemEntry)
+{
+    UNORDERED_MAP<uint32, std::wstring>::const_iterator itr = index.names.find(itemEntry);
+    if (itr != index.names.end())
+        return itr->second;
+
+    std::wstring& wname = index.names[itemEntry];
+
+    ItemPrototype const* proto = objmgr.GetItemPrototype(itemEntry);
+    if (!proto || !proto->Name1)
+        return wname;
+
+    std::string name = proto->Name1;
+
+    // local name
+    if (locale >= 0)
+    {
+        if (ItemLocale const* il = objmgr.GetItemLocale(itemEntry))
+            if (il->Name.size() > size_t(locale) && !il->Name[locale].empty())
+                name = il->Name[locale];
+    }
+
+    // names that are not valid utf8 never match a searched name
+    if (!Utf8toWStr(name, wname))
+        wname.clear();
+
+    wstrToLower(wname);
+    return wname;
+}
+
+void AuctionSearchIndex::_IndexName(NameIndex& index, int locale, uint32 auctionId, uint32 itemEntry)
+{
+    std::vector<uint64> trigrams;
+    GetTrigrams(_GetName(index, locale, itemEntry), trigrams);
+    for (std::vector<uint64>::const_iterator itr = trigrams.begin(); itr != trigrams.end(); ++itr)
+        InsertId(index.trigrams[*itr], auctionId);
+}
+
+bool AuctionSearchIndex::_Match(Player* player, AuctionSearchQuery const& query, NameIndex* names, AuctionRecord const& record)
+{
+    if (!record.hasName)
+        return false;
+
+    if (query.itemClass != AUCTION_SEARCH_ANY && record.itemClass != query.itemClass)
+        return false;
+
+    if (query.itemSubClass != AUCTION_SEARCH_ANY && record.itemSubClass != query.itemSubClass)
+        return false;
+
+    if (query.inventoryType != AUCTION_SEARCH_ANY && record.inventoryType != query.inventoryType)
+        return false;
+
+    if (query.quality != AUCTION_SEARCH_ANY && record.quality != query.quality)
+        return false;
+
+    if (query.levelmin && (record.requiredLevel < query.levelmin || query.levelmax && record.requiredLevel > query.levelmax))
+        return false;
+
+    if (names && _GetName(*names, query.locale, record.itemEntry).find(query.name) == std::wstring::npos)
+        return false;
+
+    Item* item = sAHMgr.GetAItem(record.itemGuid);
+    if (!item)
+        return false;
+
+    if (query.usable && player->CanUseItem(item) != EQUIP_ERR_OK)
+        return false;
+
+    return true;
+}
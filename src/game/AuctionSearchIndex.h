@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef _AUCTION_SEARCH_INDEX_H
+#define _AUCTION_SEARCH_INDEX_H
+
+#include "Common.h"
+#include "Utilities/UnorderedMap.h"
+
+struct AuctionEntry;
+class Player;
+
+#define AUCTION_SEARCH_ANY 0xffffffff
+
+/// Browse request of CMSG_AUCTION_LIST_ITEMS, fields at AUCTION_SEARCH_ANY (or 0 for levels and usable) are not filtered
+struct AuctionSearchQuery
+{
+    int locale;                                             // db locale index of the session, -1 for default names
+    std::wstring name;                                      // lower case
+    uint32 levelmin;
+    uint32 levelmax;
+    uint32 usable;
+    uint32 inventoryType;
+    uint32 itemClass;
+    uint32 itemSubClass;
+    uint32 quality;
+
+    bool operator==(AuctionSearchQuery const& right) const
+    {
+        return locale == right.locale && name == right.name && levelmin == right.levelmin && levelmax == right.levelmax &&
+            usable == right.usable && inventoryType == right.inventoryType && itemClass == right.itemClass &&
+            itemSubClass == right.itemSubClass && quality == right.quality;
+    }
+};
+
+/*
+ * Secondary indexes of the auctions of one auction house, avoids scanning every auction
+ * (and resolving its item, prototype and local name) for each browse request.
+ *
+ * Auctions are indexed by item class, class and subclass, inventory type, quality and
+ * required level, in sorted lists of auction ids. Item names are lowered once per item
+ * template and locale, each locale used for searching gets an index of the 3 character
+ * substrings of the names. A search takes the shortest list among its criteria and checks
+ * the other ones on a compact record of the auction.
+ *
+ * Results are kept per player, the following pages of the same search are served from
+ * them until an auction is added or removed.
+ */
+class AuctionSearchIndex
+{
+    public:
+        AuctionSearchIndex() : m_generation(0) {}
+
+        void Insert(AuctionEntry const* auction);
+        void Remove(uint32 auctionId);
+
+        /// Ids of the matching auctions in id order, valid until the next change of the index
+        std::vector<uint32> const& Search(Player* player, AuctionSearchQuery const& query);
+
+        /// Forget the results of the searches older than the given time
+        void PruneResults(time_t before);
+
+    private:
+        /// Item data of an auction needed by the search
+        struct AuctionRecord
+        {
+            uint32 itemGuid;
+            uint32 itemEntry;
+            uint32 itemClass;
+            uint32 itemSubClass;
+            uint32 inventoryType;
+            uint32 quality;
+            uint32 requiredLevel;
+            bool hasName;                                   // items without default name are never listed
+        };
+
+        typedef std::vector<uint32> AuctionIdList;          // sorted
+        typedef UNORDERED_MAP<uint32, AuctionIdList> AuctionIdListMap;
+
+        /// Lowered item names of one locale and the auctions by 3 character substring of their name
+        struct NameIndex
+        {
+            UNORDERED_MAP<uint32, std::wstring> names;      // by item entry
+            UNORDERED_MAP<uint64, AuctionIdList> trigrams;
+        };
+        typedef std::map<int, NameIndex> NameIndexMap;
+
+        struct SearchResult
+        {
+            SearchResult() : generation(0), time(0) {}
+
+            AuctionSearchQuery query;
+            uint32 generation;
+            time_t time;
+            std::vector<uint32> auctions;
+        };
+        typedef UNORDERED_MAP<uint32, SearchResult> SearchResultMap;
+
+        NameIndex& _GetNameIndex(int locale);
+        std::wstring const& _GetName(NameIndex& index, int locale, uint32 itemEntry);
+        void _IndexName(NameIndex& index, int locale, uint32 auctionId, uint32 itemEntry);
+
+        bool _Match(Player* player, AuctionSearchQuery const& query, NameIndex* names, AuctionRecord const& record);
+
+        UNORDERED_MAP<uint32, AuctionRecord> m_records;
+        AuctionIdList m_all;
+        AuctionIdListMap m_byClass;
+        AuctionIdListMap m_bySubClass;                      // class << 16 | subclass
+        AuctionIdListMap m_byInventoryType;
+        AuctionIdListMap m_byQuality;
+        AuctionIdListMap m_byLevel;
+        NameIndexMap m_names;
+
+        SearchResultMap m_results;                          // by player guid
+        uint32 m_generation;                                // changed by every insert and remove
+};
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "AuraStorage.h"
+
+#include <algorithm>
+
+void AuraList::push_back(Aura* aura)
+{
+    Entry entry;
+    entry.aura = aura;
+    entry.removed = false;
+    _entries.push_back(entry);
+    ++_size;
+}
+
+void AuraList::remove(Aura* aura)
+{
+    for (std::vector<Entry>::iterator itr = _entries.begin(); itr != _entries.end(); ++itr)
+    {
+        if (itr->aura == aura && !itr->removed)
+        {
+            itr->removed = true;
+            --_size;
+        }
+    }
+}
+
+void AuraList::Compact()
+{
+    if (!NeedCompact())
+        return;
+
+    std::vector<Entry>::iterator dest = _entries.begin();
+    for (std::vector<Entry>::iterator itr = _entries.begin(); itr != _entries.end(); ++itr)
+        if (!itr->removed)
+            *dest++ = *itr;
+
+    _entries.erase(dest, _entries.end());
+}
+
+AuraStorage::const_iterator AuraStorage::lower_bound(key_type const& key) const
+{
+    SpellSlotMap::const_iterator itr = _bySpell.find(key.first);
+    if (itr == _bySpell.end())
+        return end();
+
+    return const_iterator(this, &itr->second, key.second);
+}
+
+uint32 AuraStorage::count(key_type const& key) const
+{
+    uint32 count = 0;
+    for (const_iterator itr = lower_bound(key); itr != end(); ++itr)
+        ++count;
+    return count;
+}
+
+AuraStorage::const_iterator AuraStorage::insert(value_type const& value, uint32 auraType, uint32 procFlags)
+{
+    uint32 slotId;
+    if (!_freeSlots.empty())
+    {
+        slotId = _freeSlots.back();
+        _freeSlots.pop_back();
+    }
+    else
+    {
+        slotId = _slots.size();
+        _slots.resize(slotId + 1);
+    }
+
+    Slot& slot = _slots[slotId];
+    slot.value = value;
+    slot.procFlags = procFlags;
+    slot.auraType = auraType;
+    slot.live = true;
+    ++_size;
+
+    std::vector<uint32>& spellSlots = _bySpell[value.first.first];
+    spellSlots.push_back(slotId);
+
+    if (slot.auraType < TOTAL_AURAS)
+        _byType[slot.auraType].push_back(value.second);
+
+    // reused slots are not the highest ones, keep the buckets in storage order
+    for (uint32 bit = 0; bit < PROC_FLAG_BITS; ++bit)
+    {
+        if (procFlags & (uint32(1) << bit))
+        {
+            std::vector<uint32>& procSlots = _byProcFlag[bit];
+            procSlots.insert(std::upper_bound(procSlots.begin(), procSlots.end(), slotId), slotId);
+        }
+    }
+
+    const_iterator itr(this, &spellSlots, value.first.second);
+    itr._index = spellSlots.size() - 1;
+    return itr;
+}
+
+bool AuraStorage::erase(const_iterator const& itr)
+{
+    uint32 slotId = itr._GetSlot();
+    Slot& slot = _slots[slotId];
+    if (!slot.live)
+        return false;
+
+    slot.live = false;
+    --_size;
+
+    if (slot.auraType < TOTAL_AURAS)
+        _byType[slot.auraType].remove(slot.value.second);
+
+    _releasedSlots.push_back(slotId);
+    return true;
+}
+
+void AuraStorage::clear()
+{
+    _slots.clear();
+    _freeSlots.clear();
+    _releasedSlots.clear();
+    _bySpell.clear();
+    for (uint32 i = 0; i < TOTAL_AURAS; ++i)
+        _byType[i].clear();
+    for (uint32 i = 0; i < PROC_FLAG_BITS; ++i)
+        _byProcFlag[i].clear();
+    _size = 0;
+}
+
+void AuraStorage::Compact()
+{
+    for (std::vector<uint32>::const_iterator itr = _releasedSlots.begin(); itr != _releasedSlots.end(); ++itr)
+    {
+        Slot& slot = _slots[*itr];
+
+        SpellSlotMap::iterator spellItr = _bySpell.find(slot.value.first.first);
+        if (spellItr != _bySpell.end())
+        {
+            std::vector<uint32>& spellSlots = spellItr->second;
+            spellSlots.erase(std::remove(spellSlots.begin(), spellSlots.end(), *itr), spellSlots.end());
+            if (spellSlots.empty())
+                _bySpell.erase(spellItr);
+        }
+
+        if (slot.auraType < TOTAL_AURAS)
+            _byType[slot.auraType].Compact();
+
+        for (uint32 bit = 0; bit < PROC_FLAG_BITS; ++bit)
+        {
+            if (slot.procFlags & (uint32(1) << bit))
+            {
+                std::vector<uint32>& procSlots = _byProcFlag[bit];
+                procSlots.erase(std::remove(procSlots.begin(), procSlots.end(), *itr), procSlots.end());
+            }
+        }
+
+        slot.procFlags = 0;
+        slot.value.second = NULL;
+        _freeSlots.push_back(*itr);
+    }
+
+    _releasedSlots.clear();
+}
+
+void AuraStorage::GetProcCandidates(uint32 procFlags, std::vector<Aura*>& auras) const
+{
+    std::vector<uint32> const* single = NULL;
+    uint32 buckets = 0;
+    for (uint32 bit = 0; bit < PROC_FLAG_BITS; ++bit)
+    {
+        if ((procFlags & (uint32(1) << bit)) && !_byProcFlag[bit].empty())
+        {
+            single = &_byProcFlag[bit];
+            ++buckets;
+        }
+    }
+
+    if (!buckets)
+        return;
+
+    // a sorted bucket is already in storage order, several ones are merged in the scratch buffer:
+    // an aura triggering on several bits of the event is registered in several buckets
+    if (buckets > 1)
+    {
+        _procScratch.clear();
+        for (uint32 bit = 0; bit < PROC_FLAG_BITS; ++bit)
+            if (procFlags & (uint32(1) << bit))
+                _procScratch.insert(_procScratch.end(), _byProcFlag[bit].begin(), _byProcFlag[bit].end());
+
+        std::sort(_procScratch.begin(), _procScratch.end());
+        _procScratch.erase(std::unique(_procScratch.begin(), _procScratch.end()), _procScratch.end());
+        single = &_procScratch;
+    }
+
+    for (std::vector<uint32>::const_iterator itr = single->begin(); itr != single->end(); ++itr)
+        if (_slots[*itr].live)
+            auras.push_back(_slots[*itr].value.second);
+}
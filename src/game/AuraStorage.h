@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TRINITY_AURASTORAGE_H
+#define TRINITY_AURASTORAGE_H
+
+#include "Common.h"
+#include "SpellAuraDefines.h"
+#include "Utilities/UnorderedMap.h"
+#include <vector>
+
+class Aura;
+
+/*
+ * Aura removal protocol
+ *
+ * Removing an aura only flags its entry. Iterators are index based and skip flagged
+ * entries, so they stay valid when auras are added or removed while iterating, and an
+ * iterator sitting on a removed entry still returns the (not yet deleted) aura.
+ * Flagged entries are dropped by Compact(), which Unit only calls from _DeleteAuras,
+ * when no aura of the unit is iterated anymore and removed auras are freed.
+ */
+
+// Ordered list of aura pointers, replaces std::list<Aura*> for the per aura type lists
+class AuraList
+{
+    public:
+        class const_iterator
+        {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef Aura* value_type;
+                typedef ptrdiff_t difference_type;
+                typedef Aura* const* pointer;
+                typedef Aura* const& reference;
+
+                const_iterator() : _list(NULL), _index(0) {}
+                const_iterator(AuraList const* list, uint32 index) : _list(list), _index(index) { _Skip(); }
+
+                Aura* const& operator*() const { return _list->_entries[_index].aura; }
+                Aura* const* operator->() const { return &_list->_entries[_index].aura; }
+
+                const_iterator& operator++() { ++_index; _Skip(); return *this; }
+                const_iterator operator++(int) { const_iterator tmp = *this; ++*this; return tmp; }
+
+                bool operator==(const_iterator const& right) const
+                {
+                    bool end = _AtEnd();
+                    return end == right._AtEnd() && (end || _index == right._index);
+                }
+                bool operator!=(const_iterator const& right) const { return !(*this == right); }
+
+            private:
+                bool _AtEnd() const { return !_list || _index >= _list->_entries.size(); }
+                void _Skip()
+                {
+                    while (_list && _index < _list->_entries.size() && _list->_entries[_index].removed)
+                        ++_index;
+                }
+
+                AuraList const* _list;
+                uint32 _index;
+        };
+        typedef const_iterator iterator;
+
+        AuraList() : _size(0) {}
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(); }
+        bool empty() const { return _size == 0; }
+        uint32 size() const { return _size; }
+        Aura* front() const { return *begin(); }
+
+        void push_back(Aura* aura);
+        // flags every entry of this aura, entries are erased by Compact()
+        void remove(Aura* aura);
+        void clear() { _entries.clear(); _size = 0; }
+
+        bool NeedCompact() const { return _size != _entries.size(); }
+        void Compact();
+
+    private:
+        struct Entry
+        {
+            Aura* aura;
+            bool removed;
+        };
+
+        std::vector<Entry> _entries;
+        uint32 _size;
+};
+
+/*
+ * Auras of a unit, replaces the std::multimap<spellEffectPair, Aura*>.
+ * Records are kept in a contiguous pool and never move, released slots are only reused
+ * after Compact(). Lookups by spell go through a per spell index of slots, lookups by
+ * aura type through one AuraList per type. The multimap interface used by the core is
+ * kept: full iteration walks the pool, lower_bound/find/upper_bound walk the spell index.
+ * Auras that can proc are also indexed by every proc flag bit they trigger on, so a proc
+ * event only looks at the auras registered for one of its bits.
+ */
+class AuraStorage
+{
+    public:
+        typedef std::pair<uint32, uint8> key_type;                  // spell id, effect index
+        typedef std::pair<key_type, Aura*> value_type;
+
+        class const_iterator
+        {
+            friend class AuraStorage;
+
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef AuraStorage::value_type value_type;
+                typedef ptrdiff_t difference_type;
+                typedef value_type const* pointer;
+                typedef value_type const& reference;
+
+                const_iterator() : _storage(NULL), _spellSlots(NULL), _index(0), _effIndex(0) {}
+
+                value_type const& operator*() const { return _storage->_slots[_GetSlot()].value; }
+                value_type const* operator->() const { return &_storage->_slots[_GetSlot()].value; }
+
+                const_iterator& operator++() { ++_index; _Skip(); return *this; }
+                const_iterator operator++(int) { const_iterator tmp = *this; ++*this; return tmp; }
+
+                bool operator==(const_iterator const& right) const
+                {
+                    bool end = _AtEnd();
+                    return end == right._AtEnd() && (end || _GetSlot() == right._GetSlot());
+                }
+                bool operator!=(const_iterator const& right) const { return !(*this == right); }
+
+            private:
+                // full pool walk when spellSlots is NULL, else walk of the slots of one spell effect
+                const_iterator(AuraStorage const* storage, std::vector<uint32> const* spellSlots, uint8 effIndex)
+                    : _storage(storage), _spellSlots(spellSlots), _index(0), _effIndex(effIndex) { _Skip(); }
+
+                uint32 _GetSlot() const { return _spellSlots ? (*_spellSlots)[_index] : _index; }
+                bool _AtEnd() const
+                {
+                    if (!_storage)
+                        return true;
+                    return _index >= (_spellSlots ? _spellSlots->size() : _storage->_slots.size());
+                }
+                void _Skip()
+                {
+                    for (; !_AtEnd(); ++_index)
+                    {
+                        Slot const& slot = _storage->_slots[_GetSlot()];
+                        if (slot.live && (!_spellSlots || slot.value.first.second == _effIndex))
+                            break;
+                    }
+                }
+
+                AuraStorage const* _storage;
+                std::vector<uint32> const* _spellSlots;
+                uint32 _index;
+                uint8 _effIndex;
+        };
+        typedef const_iterator iterator;
+
+        AuraStorage() : _size(0) {}
+
+        const_iterator begin() const { return const_iterator(this, NULL, 0); }
+        const_iterator end() const { return const_iterator(); }
+        bool empty() const { return _size == 0; }
+        uint32 size() const { return _size; }
+
+        // iterators on the auras of one spell effect, upper_bound is always end()
+        const_iterator lower_bound(key_type const& key) const;
+        const_iterator upper_bound(key_type const&) const { return end(); }
+        const_iterator find(key_type const& key) const { return lower_bound(key); }
+        uint32 count(key_type const& key) const;
+
+        // aura is also added to the list of auraType and to the proc buckets of procFlags
+        const_iterator insert(value_type const& value, uint32 auraType, uint32 procFlags = 0);
+        // iterator is left on the removed record, incrementing it is safe. false if already removed
+        bool erase(const_iterator const& itr);
+        void clear();
+
+        AuraList const& GetAurasByType(AuraType type) const { return _byType[type]; }
+        // auras registered for at least one bit of procFlags, in storage order, each aura once
+        void GetProcCandidates(uint32 procFlags, std::vector<Aura*>& auras) const;
+        // remove flagged records from the indexes and release their slots
+        void Compact();
+
+    private:
+        struct Slot
+        {
+            value_type value;
+            uint32 procFlags;
+            uint16 auraType;
+            bool live;
+        };
+
+        typedef UNORDERED_MAP<uint32, std::vector<uint32> > SpellSlotMap;
+
+        enum { PROC_FLAG_BITS = 32 };
+
+        std::vector<Slot> _slots;
+        std::vector<uint32> _freeSlots;
+        std::vector<uint32> _releasedSlots;                         // reusable after next Compact()
+        SpellSlotMap _bySpell;
+        AuraList _byType[TOTAL_AURAS];
+        std::vector<uint32> _byProcFlag[PROC_FLAG_BITS];            // sorted slots, released ones dropped by Compact()
+        mutable std::vector<uint32> _procScratch;                   // GetProcCandidates merge buffer, keeps its capacity
+        uint32 _size;
+};
+
+#endif
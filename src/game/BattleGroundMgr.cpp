@@ -983,6 +983,8 @@ void BattleGroundMgr::DeleteAlllBattleGrounds()
 // used to update running battlegrounds, and delete finished ones
 void BattleGroundMgr::Update(time_t diff)
 {
+    PROFILE;
+
     BattleGroundSet::iterator itr, next;
     for(itr = m_BattleGrounds.begin(); itr != m_BattleGrounds.end(); itr = next)
     {
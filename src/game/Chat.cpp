@@ -103,6 +103,7 @@ ChatCommand * ChatHandler::getCommandTable()
         { "idlerestart",    SEC_ADMINISTRATOR,   true,  false, NULL,                                           "", serverIdleRestartCommandTable },
         { "idleshutdown",   SEC_ADMINISTRATOR,   true,  false, NULL,                                           "", serverShutdownCommandTable },
         { "info",           SEC_PLAYER,          true,  false, &ChatHandler::HandleServerInfoCommand,          "", NULL },
+        { "memory",         SEC_ADMINISTRATOR,   true,  false, &ChatHandler::HandleServerMemoryCommand,        "", NULL },
         { "motd",           SEC_PLAYER,          true,  false, &ChatHandler::HandleServerMotdCommand,          "", NULL },
         { "restart",        SEC_ADMINISTRATOR,   true,  false, NULL,                                           "", serverRestartCommandTable },
         { "shutdown",       SEC_ADMINISTRATOR,   true,  false, NULL,                                           "", serverShutdownCommandTable },
@@ -242,8 +243,9 @@ ChatCommand * ChatHandler::getCommandTable()
         { "zoneattack",     SEC_GAMEMASTER3,  false, false, &ChatHandler::HandleDebugSendZoneUnderAttack,   "", NULL },
         { "los",            SEC_GAMEMASTER1,  false, false, &ChatHandler::HandleDebugLoSCommand,            "", NULL },
         { "playerflags",    SEC_GAMEMASTER3,  false, false, &ChatHandler::HandleDebugPlayerFlags,           "", NULL },
-        { "profile",        SEC_GAMEMASTER3,  false, false, &ChatHandler::HandleDebugDumpProfilingCommand,  "", NULL },
-        { "clearprofile",   SEC_GAMEMASTER3,  false, false, &ChatHandler::HandleDebugClearProfilingCommand, "", NULL },
+        { "profile",        SEC_GAMEMASTER3,  true,  false, &ChatHandler::HandleDebugDumpProfilingCommand,  "", NULL },
+        { "clearprofile",   SEC_GAMEMASTER3,  true,  false, &ChatHandler::HandleDebugClearProfilingCommand, "", NULL },
+        { "tickstats",      SEC_GAMEMASTER3,  true,  false, &ChatHandler::HandleDebugTickStatsCommand,      "", NULL },
         { NULL,             0,                false, false, NULL,                                           "", NULL }
     };
 
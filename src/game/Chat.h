@@ -311,6 +311,7 @@ class ChatHandler
         bool HandleServerIdleRestartCommand(const char* args);
         bool HandleServerIdleShutDownCommand(const char* args);
         bool HandleServerInfoCommand(const char* args);
+        bool HandleServerMemoryCommand(const char* args);
         bool HandleServerMotdCommand(const char* args);
         bool HandleServerRestartCommand(const char* args);
         bool HandleServerSetMotdCommand(const char* args);
@@ -341,6 +342,7 @@ class ChatHandler
         bool HandleDebugPlayerFlags(const char* args);
         bool HandleDebugDumpProfilingCommand(const char* args);
         bool HandleDebugClearProfilingCommand(const char* args);
+        bool HandleDebugTickStatsCommand(const char* args);
 
         bool HandleGUIDCommand(const char* args);
         bool HandleNameCommand(const char* args);
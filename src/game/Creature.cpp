@@ -161,7 +161,7 @@ m_gossipOptionLoaded(false), m_emoteState(0), m_IsPet(false), m_isTotem(false),
 m_regenTimer(2000), m_defaultMovementType(IDLE_MOTION_TYPE), m_equipmentId(0), m_areaCombatTimer(0),m_relocateTimer(60000),
 m_AlreadyCallAssistance(false), m_regenHealth(true), m_AI_locked(false), m_isDeadByDefault(false),
 m_meleeDamageSchoolMask(SPELL_SCHOOL_MASK_NORMAL),m_creatureInfo(NULL), m_creatureInfoAddon(NULL),m_DBTableGuid(0), m_formation(NULL),
-m_PlayerDamageReq(0), m_timeSinceSpawn(0), m_creaturePoolId(0), m_AI(NULL),
+m_PlayerDamageReq(0), m_timeSinceSpawn(0), m_creaturePoolId(0), m_delayedUpdateDiff(0), m_delayedUpdates(0), m_AI(NULL),
 m_isBeingEscorted(false), m_summoned(false), m_path_id(0)
 {
     m_valuesCount = UNIT_END;
@@ -454,6 +454,8 @@ bool Creature::UpdateEntry(uint32 Entry, uint32 team, const CreatureData *data )
 
 void Creature::Update(uint32 diff)
 {
+    PROFILE;
+
     if(m_GlobalCooldown <= diff)
         m_GlobalCooldown = 0;
     else
@@ -2473,6 +2475,40 @@ bool Creature::IsInEvadeMode() const
     return /*!i_motionMaster.empty() &&*/ i_motionMaster.GetCurrentMovementGeneratorType() == HOME_MOTION_TYPE;
 }
 
+bool Creature::NeedsFullUpdateRate() const
+{
+    if(IsInCombat() || IsInEvadeMode() || IsNonMeleeSpellCasted(false))
+        return true;
+
+    // pets, guardians, totems and charmed creatures follow their player
+    if(GetCharmerOrOwnerGUID() || isTotem())
+        return true;
+
+    if(isWorldBoss() || isActiveObject())
+        return true;
+
+    // scripts may rely on their timers
+    CreatureInfo const* cinfo = GetCreatureInfo();
+    return m_AI || cinfo->ScriptID || (cinfo->AIName && *cinfo->AIName);
+}
+
+bool Creature::DelayUpdate(uint32& diff, uint32 tick, uint32 interval)
+{
+    diff += m_delayedUpdateDiff;
+
+    // the guid spreads the creatures of a cell over the ticks, the counter bounds the delay
+    // when the creature is not visited at every tick
+    if(interval > 1 && ++m_delayedUpdates < interval && (tick + GetGUIDLow()) % interval && !NeedsFullUpdateRate())
+    {
+        m_delayedUpdateDiff = diff;
+        return true;
+    }
+
+    m_delayedUpdateDiff = 0;
+    m_delayedUpdates = 0;
+    return false;
+}
+
 bool Creature::HasSpell(uint32 spellID) const
 {
     uint8 i;
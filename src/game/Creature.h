@@ -521,6 +521,11 @@ class Creature : public Unit
         bool isMoving();
         bool IsInEvadeMode() const;
 
+        // update level of detail, creatures doing something are updated at every map update
+        bool NeedsFullUpdateRate() const;
+        // true if this update is skipped, else diff gets the time of the skipped updates
+        bool DelayUpdate(uint32& diff, uint32 tick, uint32 interval);
+
         bool AIM_Initialize(CreatureAI* ai = NULL);
 
         void AI_SendMoveToPacket(float x, float y, float z, uint32 time, uint32 MovementFlags, uint8 type);
@@ -667,7 +672,6 @@ class Creature : public Unit
         bool hasQuest(uint32 quest_id) const;
         bool hasInvolvedQuest(uint32 quest_id)  const;
 
-        GridReference<Creature> &GetGridRef() { return m_gridRef; }
         bool isRegeneratingHealth() { return m_regenHealth; }
         void setRegeneratingHealth(bool regenHealth) { m_regenHealth = regenHealth; }
         virtual uint8 GetPetAutoSpellSize() const { return CREATURE_MAX_SPELLS; }
@@ -810,6 +814,9 @@ class Creature : public Unit
         std::vector<uint64> m_allowedToLoot;
         
         uint64 m_timeSinceSpawn;                            // (msecs) elapsed time since (re)spawn
+
+        uint32 m_delayedUpdateDiff;                         // time of the updates skipped by DelayUpdate
+        uint32 m_delayedUpdates;
         
         CreatureAINew* m_AI;
 
@@ -827,7 +834,6 @@ class Creature : public Unit
         CreatureGroup *m_formation;
         bool TriggerJustRespawned;
 
-        GridReference<Creature> m_gridRef;
         CreatureInfo const* m_creatureInfo;                 // in heroic mode can different from ObjMgr::GetCreatureTemplate(GetEntry())
         CreatureDataAddon const* m_creatureInfoAddon;
 };
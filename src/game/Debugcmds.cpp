@@ -787,10 +787,30 @@ bool ChatHandler::HandleDebugPlayerFlags(const char* args)
     return true;
 }
 
+// .debug profile [on|off|tree [depth]|total [count]|p99 [count]]
 bool ChatHandler::HandleDebugDumpProfilingCommand(const char* args)
 {
-    PSendSysMessage("Dump done.");
-    sLog.outString(sProfilerMgr.dump().c_str());
+    char* mode = strtok((char*)args, " ");
+    char* value = strtok(NULL, " ");
+
+    std::string dump;
+    if (!mode || !strcmp(mode, "total"))
+        dump = sProfilerMgr.dump(value ? atoi(value) : 20, PROFILE_SORT_TOTAL);
+    else if (!strcmp(mode, "p99"))
+        dump = sProfilerMgr.dump(value ? atoi(value) : 20, PROFILE_SORT_P99);
+    else if (!strcmp(mode, "tree"))
+        dump = sProfilerMgr.dumpTree(value ? atoi(value) : 6);
+    else if (!strcmp(mode, "on") || !strcmp(mode, "off"))
+    {
+        Profiler::SetEnabled(!strcmp(mode, "on"));
+        PSendSysMessage("Profiler %s.", Profiler::IsEnabled() ? "enabled" : "disabled");
+        return true;
+    }
+    else
+        return false;
+
+    SendSysMessage(dump.c_str());
+    sLog.outString(dump.c_str());
     return true;
 }
 
@@ -799,4 +819,50 @@ bool ChatHandler::HandleDebugClearProfilingCommand(const char* args)
     PSendSysMessage("Profiling data cleared.");
     sProfilerMgr.clear();
     return true;
-}
\ No newline at end of file
+}
+
+struct MapLatencySorter
+{
+    bool operator()(std::pair<uint32, LatencySnapshot> const& a, std::pair<uint32, LatencySnapshot> const& b) const
+    {
+        return a.second.GetPercentile(0.99f) > b.second.GetPercentile(0.99f);
+    }
+};
+
+// .debug tickstats [seconds] : tick phases and slowest maps latency percentiles (ms)
+bool ChatHandler::HandleDebugTickStatsCommand(const char* args)
+{
+    uint32 seconds = (args && *args) ? atoi(args) : 60;
+    if (!seconds)
+        seconds = 60;
+
+    PSendSysMessage("Tick phases over the last %u seconds (ms):", seconds);
+    PSendSysMessage("%-22s %8s %8s %8s %8s %8s %8s", "phase", "samples", "avg", "p50", "p95", "p99", "max");
+    for (uint32 i = 0; i < TICK_PHASE_COUNT; ++i)
+    {
+        LatencySnapshot stats = sWorld.GetPhaseStats(TickPhase(i), seconds);
+        PSendSysMessage("%-22s %8u %8.2f %8.2f %8.2f %8.2f %8.2f", World::GetTickPhaseName(TickPhase(i)), uint32(stats.count),
+            stats.GetAverage() / 1000.0f, stats.GetPercentile(0.50f) / 1000.0f, stats.GetPercentile(0.95f) / 1000.0f,
+            stats.GetPercentile(0.99f) / 1000.0f, stats.max / 1000.0f);
+    }
+
+    std::map<uint32, LatencySnapshot> mapStats;
+    sWorld.GetMapUpdateStats(mapStats, seconds);
+
+    std::vector<std::pair<uint32, LatencySnapshot> > maps;
+    for (std::map<uint32, LatencySnapshot>::const_iterator itr = mapStats.begin(); itr != mapStats.end(); ++itr)
+        if (itr->second.count)
+            maps.push_back(*itr);
+
+    std::sort(maps.begin(), maps.end(), MapLatencySorter());
+    if (maps.size() > 10)
+        maps.resize(10);
+
+    PSendSysMessage("Slowest maps by p99 (ms):");
+    for (std::vector<std::pair<uint32, LatencySnapshot> >::const_iterator itr = maps.begin(); itr != maps.end(); ++itr)
+        PSendSysMessage("map %-4u %8u %8.2f %8.2f %8.2f %8.2f %8.2f", itr->first, uint32(itr->second.count),
+            itr->second.GetAverage() / 1000.0f, itr->second.GetPercentile(0.50f) / 1000.0f, itr->second.GetPercentile(0.95f) / 1000.0f,
+            itr->second.GetPercentile(0.99f) / 1000.0f, itr->second.max / 1000.0f);
+
+    return true;
+}
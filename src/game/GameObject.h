@@ -593,8 +593,6 @@ class GameObject : public WorldObject
 
         GameObject* LookupFishingHoleAround(float range);
 
-        GridReference<GameObject> &GetGridRef() { return m_gridRef; }
-
         void CastSpell(Unit *target, uint32 spell, uint64 originalCaster = 0);
         void SendCustomAnim(uint32 anim);
         bool IsInRange(float x, float y, float z, float radius) const;
@@ -638,7 +636,6 @@ class GameObject : public WorldObject
     private:
         GameObjectAI* m_AI;
         bool AIM_Initialize();
-        GridReference<GameObject> m_gridRef;
         
         void UpdateModel();                                 // updates model in case displayId were changed
 };
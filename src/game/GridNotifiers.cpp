@@ -35,10 +35,10 @@ VisibleChangesNotifier::Visit(PlayerMapType &m)
 {
     for(PlayerMapType::iterator iter=m.begin(); iter != m.end(); ++iter)
     {
-        if(iter->getSource() == &i_object)
+        if(*iter == &i_object)
             continue;
 
-        iter->getSource()->UpdateVisibilityOf(&i_object);
+        (*iter)->UpdateVisibilityOf(&i_object);
     }
 }
 
@@ -55,7 +55,7 @@ PlayerVisibilityNotifier::Notify()
             if(i_clientGUIDs.find((*itr)->GetGUID())!=i_clientGUIDs.end())
             {
                 (*itr)->UpdateVisibilityOf(&i_player);
-                i_player.UpdateVisibilityOf((*itr),i_data,i_visibleNow);
+                i_player.UpdateVisibilityOf(*itr,i_data,i_visibleNow);
                 i_clientGUIDs.erase((*itr)->GetGUID());
             }
         }
@@ -116,14 +116,14 @@ Deliverer::Visit(PlayerMapType &m)
 {
     for (PlayerMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        if (!i_dist || iter->getSource()->GetDistance(&i_source) <= i_dist)
+        if (!i_dist || (*iter)->GetDistance(&i_source) <= i_dist)
         {
             // Send packet to all who are sharing the player's vision
-            for (auto itr : iter->getSource()->GetSharedVisionList())
+            for (auto itr : (*iter)->GetSharedVisionList())
                 if(Player* p = ObjectAccessor::FindPlayer(itr))
                     SendPacket(p);
 
-            VisitObject(iter->getSource());
+            VisitObject(*iter);
         }
     }
 }
@@ -133,10 +133,10 @@ Deliverer::Visit(CreatureMapType &m)
 {
     for (CreatureMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        if (!i_dist || iter->getSource()->GetDistance(&i_source) <= i_dist)
+        if (!i_dist || (*iter)->GetDistance(&i_source) <= i_dist)
         {
             // Send packet to all who are sharing the creature's vision
-            for (auto itr : iter->getSource()->GetSharedVisionList())
+            for (auto itr : (*iter)->GetSharedVisionList())
                 if(Player* p = ObjectAccessor::FindPlayer(itr))
                     SendPacket(p);
         }
@@ -148,13 +148,13 @@ Deliverer::Visit(DynamicObjectMapType &m)
 {
     for (DynamicObjectMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        if (IS_PLAYER_GUID(iter->getSource()->GetCasterGUID()))
+        if (IS_PLAYER_GUID((*iter)->GetCasterGUID()))
         {
             // Send packet back to the caster if the caster has vision of dynamic object
-            Unit* caster_unit = iter->getSource()->GetCaster();
+            Unit* caster_unit = (*iter)->GetCaster();
             Player* caster = caster_unit ? caster_unit->ToPlayer() : NULL;
-            if (caster && caster->GetUInt64Value(PLAYER_FARSIGHT) == iter->getSource()->GetGUID() &&
-                (!i_dist || iter->getSource()->GetDistance(&i_source) <= i_dist))
+            if (caster && caster->GetUInt64Value(PLAYER_FARSIGHT) == (*iter)->GetGUID() &&
+                (!i_dist || (*iter)->GetDistance(&i_source) <= i_dist))
                 SendPacket(caster);
         }
     }
@@ -195,12 +195,12 @@ MessageDistDeliverer::VisitObject(Player* plr)
 }
 
 template<class T> void
-ObjectUpdater::Visit(GridRefManager<T> &m)
+ObjectUpdater::Visit(GridObjectList<T> &m)
 {
-    for(typename GridRefManager<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
+    for(typename GridObjectList<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        if(iter->getSource()->IsInWorld())
-            iter->getSource()->Update(i_timeDiff);
+        if((*iter)->IsInWorld())
+            (*iter)->Update(i_timeDiff);
     }
 }
 
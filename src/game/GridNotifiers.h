@@ -47,7 +47,7 @@ namespace Trinity
 
         PlayerVisibilityNotifier(Player &player) : i_player(player),i_clientGUIDs(player.m_clientGUIDs) {}
 
-        template<class T> inline void Visit(GridRefManager<T> &);
+        template<class T> inline void Visit(GridObjectList<T> &);
 
         void Notify(void);
     };
@@ -55,7 +55,7 @@ namespace Trinity
     struct PlayerRelocationNotifier : public PlayerVisibilityNotifier
     {
         PlayerRelocationNotifier(Player &player) : PlayerVisibilityNotifier(player) {}
-        template<class T> inline void Visit(GridRefManager<T> &m) { PlayerVisibilityNotifier::Visit(m); }
+        template<class T> inline void Visit(GridObjectList<T> &m) { PlayerVisibilityNotifier::Visit(m); }
         #ifdef WIN32
         template<> inline void Visit(PlayerMapType &);
         template<> inline void Visit(CreatureMapType &);
@@ -66,7 +66,7 @@ namespace Trinity
     {
         Creature &i_creature;
         CreatureRelocationNotifier(Creature &c) : i_creature(c) {}
-        template<class T> void Visit(GridRefManager<T> &) {}
+        template<class T> void Visit(GridObjectList<T> &) {}
         #ifdef WIN32
         template<> inline void Visit(PlayerMapType &);
         template<> inline void Visit(CreatureMapType &);
@@ -78,7 +78,7 @@ namespace Trinity
         WorldObject &i_object;
 
         explicit VisibleChangesNotifier(WorldObject &object) : i_object(object) {}
-        template<class T> void Visit(GridRefManager<T> &) {}
+        template<class T> void Visit(GridObjectList<T> &) {}
         void Visit(PlayerMapType &);
     };
 
@@ -88,10 +88,10 @@ namespace Trinity
         uint32 i_timeDiff;
         GridUpdater(GridType &grid, uint32 diff) : i_grid(grid), i_timeDiff(diff) {}
 
-        template<class T> void updateObjects(GridRefManager<T> &m)
+        template<class T> void updateObjects(GridObjectList<T> &m)
         {
-            for(typename GridRefManager<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
-                iter->getSource()->Update(i_timeDiff);
+            for(typename GridObjectList<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
+                (*iter)->Update(i_timeDiff);
         }
 
         void Visit(PlayerMapType &m) { updateObjects<Player>(m); }
@@ -115,7 +115,7 @@ namespace Trinity
         void Visit(DynamicObjectMapType &m);
         virtual void VisitObject(Player* plr) = 0;
         void SendPacket(Player* plr);
-        template<class SKIP> void Visit(GridRefManager<SKIP> &) {}
+        template<class SKIP> void Visit(GridObjectList<SKIP> &) {}
     };
 
     struct MessageDeliverer : public Deliverer
@@ -146,8 +146,10 @@ namespace Trinity
     struct ObjectUpdater
     {
         uint32 i_timeDiff;
-        explicit ObjectUpdater(const uint32 &diff) : i_timeDiff(diff) {}
-        template<class T> void Visit(GridRefManager<T> &m);
+        uint32 i_tick;
+        uint32 i_interval;                                  // creatures not needing full rate are updated every i_interval ticks
+        explicit ObjectUpdater(const uint32 &diff, uint32 tick = 0) : i_timeDiff(diff), i_tick(tick), i_interval(1) {}
+        template<class T> void Visit(GridObjectList<T> &m);
         void Visit(PlayerMapType &) {}
         void Visit(CorpseMapType &) {}
         void Visit(CreatureMapType &);
@@ -165,7 +167,7 @@ namespace Trinity
                 i_check = owner;
         }
 
-        template<class T> inline void Visit(GridRefManager<T>  &) {}
+        template<class T> inline void Visit(GridObjectList<T>  &) {}
         #ifdef WIN32
         template<> inline void Visit<Player>(PlayerMapType &);
         template<> inline void Visit<Creature>(CreatureMapType &);
@@ -192,7 +194,7 @@ namespace Trinity
         void Visit(CorpseMapType &m);
         void Visit(DynamicObjectMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     template<class Check>
@@ -209,7 +211,7 @@ namespace Trinity
         void Visit(GameObjectMapType &m);
         void Visit(DynamicObjectMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     template<class Do>
@@ -222,33 +224,33 @@ namespace Trinity
         void Visit(GameObjectMapType &m)
         {
             for(GameObjectMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-                i_do(itr->getSource());
+                i_do(*itr);
         }
 
         void Visit(PlayerMapType &m)
         {
             for(PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-                i_do(itr->getSource());
+                i_do(*itr);
         }
         void Visit(CreatureMapType &m)
         {
             for(CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-                i_do(itr->getSource());
+                i_do(*itr);
         }
 
         void Visit(CorpseMapType &m)
         {
             for(CorpseMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-                i_do(itr->getSource());
+                i_do(*itr);
         }
 
         void Visit(DynamicObjectMapType &m)
         {
             for(DynamicObjectMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-                i_do(itr->getSource());
+                i_do(*itr);
         }
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     // Gameobject searchers
@@ -263,7 +265,7 @@ namespace Trinity
 
         void Visit(GameObjectMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     // Last accepted by Check GO if any (Check can change requirements at each call)
@@ -277,7 +279,7 @@ namespace Trinity
 
         void Visit(GameObjectMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     template<class Check>
@@ -290,7 +292,7 @@ namespace Trinity
 
         void Visit(GameObjectMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     // Unit searchers
@@ -307,7 +309,7 @@ namespace Trinity
         void Visit(CreatureMapType &m);
         void Visit(PlayerMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     // Last accepted by Check Unit if any (Check can change requirements at each call)
@@ -322,7 +324,7 @@ namespace Trinity
         void Visit(CreatureMapType &m);
         void Visit(PlayerMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     // All accepted by Check units if any
@@ -337,7 +339,7 @@ namespace Trinity
         void Visit(PlayerMapType &m);
         void Visit(CreatureMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
     
     template<class Check>
@@ -350,7 +352,7 @@ namespace Trinity
         
         void Visit(PlayerMapType &m);
         
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     // Creature searchers
@@ -365,7 +367,7 @@ namespace Trinity
 
         void Visit(CreatureMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     // Last accepted by Check Creature if any (Check can change requirements at each call)
@@ -379,7 +381,7 @@ namespace Trinity
 
         void Visit(CreatureMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     template<class Check>
@@ -392,7 +394,7 @@ namespace Trinity
 
         void Visit(CreatureMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     // Player searchers
@@ -407,7 +409,7 @@ namespace Trinity
 
         void Visit(PlayerMapType &m);
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     template<class Do>
@@ -420,10 +422,10 @@ namespace Trinity
         void Visit(PlayerMapType &m)
         {
             for(PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-                i_do(itr->getSource());
+                i_do(*itr);
         }
 
-        template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
+        template<class NOT_INTERESTED> void Visit(GridObjectList<NOT_INTERESTED> &) {}
     };
 
     // CHECKS && DO classes
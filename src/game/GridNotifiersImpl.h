@@ -34,8 +34,15 @@ inline void
 Trinity::ObjectUpdater::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator iter=m.begin(); iter != m.end(); ++iter)
-        if(iter->getSource()->IsInWorld() && !iter->getSource()->isSpiritService())
-            iter->getSource()->Update(i_timeDiff);
+    {
+        Creature* creature = *iter;
+        if(!creature->IsInWorld() || creature->isSpiritService())
+            continue;
+
+        uint32 diff = i_timeDiff;
+        if(!creature->DelayUpdate(diff, i_tick, i_interval))
+            creature->Update(diff);
+    }
 }
 
 inline void PlayerCreatureRelocationWorker(Player* pl, Creature* c)
@@ -87,12 +94,12 @@ inline void CreatureCreatureRelocationWorker(Creature* c1, Creature* c2)
 
 template<class T>
 inline void
-Trinity::PlayerVisibilityNotifier::Visit(GridRefManager<T> &m)
+Trinity::PlayerVisibilityNotifier::Visit(GridObjectList<T> &m)
 {
-    for(typename GridRefManager<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
+    for(typename GridObjectList<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        i_player.UpdateVisibilityOf(iter->getSource(),i_data,i_visibleNow);
-        i_clientGUIDs.erase(iter->getSource()->GetGUID());
+        i_player.UpdateVisibilityOf(*iter,i_data,i_visibleNow);
+        i_clientGUIDs.erase((*iter)->GetGUID());
     }
 }
 
@@ -102,21 +109,21 @@ Trinity::PlayerRelocationNotifier::Visit(PlayerMapType &m)
 {
     for(PlayerMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        i_clientGUIDs.erase(iter->getSource()->GetGUID()); //remaining guids are marked for deletion later, so erasing here means we're going to keep these at client
+        i_clientGUIDs.erase((*iter)->GetGUID()); //remaining guids are marked for deletion later, so erasing here means we're going to keep these at client
 
-        if(iter->getSource()->m_Notified) //self is also skipped in this check
+        if((*iter)->m_Notified) //self is also skipped in this check
             continue;
 
-        i_player.UpdateVisibilityOf(iter->getSource(),i_data,i_visibleNow);
-        iter->getSource()->UpdateVisibilityOf(&i_player);
+        i_player.UpdateVisibilityOf(*iter,i_data,i_visibleNow);
+        (*iter)->UpdateVisibilityOf(&i_player);
 
         for (auto it : i_player.GetSharedVisionList())
             if(Player* p = i_player.GetPlayer(it))
-                p->UpdateVisibilityOf(iter->getSource());
+                p->UpdateVisibilityOf(*iter);
 
         // Cancel Trade
-        if(i_player.GetTrader()==iter->getSource())
-            if(!i_player.IsWithinDistInMap(iter->getSource(), 5)) // iteraction distance
+        if(i_player.GetTrader()==(*iter))
+            if(!i_player.IsWithinDistInMap(*iter, 5)) // iteraction distance
                 i_player.GetSession()->SendCancelTrade();   // will clode both side trade windows
     }
 }
@@ -127,18 +134,18 @@ Trinity::PlayerRelocationNotifier::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        i_clientGUIDs.erase(iter->getSource()->GetGUID()); //remaining guids are marked for deletion later, so erasing here means we're going to keep these at client
+        i_clientGUIDs.erase((*iter)->GetGUID()); //remaining guids are marked for deletion later, so erasing here means we're going to keep these at client
 
-        if(iter->getSource()->m_Notified)
+        if((*iter)->m_Notified)
             continue;
 
-        i_player.UpdateVisibilityOf(iter->getSource(),i_data,i_visibleNow);
+        i_player.UpdateVisibilityOf(*iter,i_data,i_visibleNow);
 
         for (auto it : i_player.GetSharedVisionList())
             if(Player* p = i_player.GetPlayer(it))
-                p->UpdateVisibilityOf(iter->getSource());
+                p->UpdateVisibilityOf(*iter);
 
-        PlayerCreatureRelocationWorker(&i_player, iter->getSource());
+        PlayerCreatureRelocationWorker(&i_player, *iter);
     }
 }
 
@@ -148,16 +155,16 @@ Trinity::CreatureRelocationNotifier::Visit(PlayerMapType &m)
 {
     for(PlayerMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        if(iter->getSource()->m_Notified)
+        if((*iter)->m_Notified)
             continue;
 
-        iter->getSource()->UpdateVisibilityOf(&i_creature);
+        (*iter)->UpdateVisibilityOf(&i_creature);
 
         for (auto it : i_creature.GetSharedVisionList())
             if(Player* p = i_creature.GetPlayer(it))
-                p->UpdateVisibilityOf(iter->getSource());
+                p->UpdateVisibilityOf(*iter);
         
-        PlayerCreatureRelocationWorker(iter->getSource(), &i_creature);
+        PlayerCreatureRelocationWorker(*iter, &i_creature);
     }
 }
 
@@ -170,17 +177,17 @@ Trinity::CreatureRelocationNotifier::Visit(CreatureMapType &m)
 
     for(CreatureMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        if(iter->getSource()->m_Notified)
+        if((*iter)->m_Notified)
             continue;
         
-        if(!iter->getSource()->IsAlive())
+        if(!(*iter)->IsAlive())
             continue;
 
         for (auto it : i_creature.GetSharedVisionList())
             if(Player* p = i_creature.GetPlayer(it))
-                p->UpdateVisibilityOf(iter->getSource());
+                p->UpdateVisibilityOf(*iter);
 
-        CreatureCreatureRelocationWorker(iter->getSource(), &i_creature);
+        CreatureCreatureRelocationWorker(*iter, &i_creature);
     }
 }
 
@@ -262,7 +269,7 @@ inline void
 Trinity::DynamicObjectUpdater::Visit(CreatureMapType  &m)
 {
     for(CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        VisitHelper(itr->getSource());
+        VisitHelper(*itr);
 }
 
 template<>
@@ -270,7 +277,7 @@ inline void
 Trinity::DynamicObjectUpdater::Visit(PlayerMapType  &m)
 {
     for(PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        VisitHelper(itr->getSource());
+        VisitHelper(*itr);
 }
 
 // SEARCHERS & LIST SEARCHERS & WORKERS
@@ -286,9 +293,9 @@ void Trinity::WorldObjectSearcher<Check>::Visit(GameObjectMapType &m)
 
     for(GameObjectMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
+        if(i_check(*itr))
         {
-            i_object = itr->getSource();
+            i_object = *itr;
             return;
         }
     }
@@ -303,9 +310,9 @@ void Trinity::WorldObjectSearcher<Check>::Visit(PlayerMapType &m)
 
     for(PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
+        if(i_check(*itr))
         {
-            i_object = itr->getSource();
+            i_object = *itr;
             return;
         }
     }
@@ -320,9 +327,9 @@ void Trinity::WorldObjectSearcher<Check>::Visit(CreatureMapType &m)
 
     for(CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
+        if(i_check(*itr))
         {
-            i_object = itr->getSource();
+            i_object = *itr;
             return;
         }
     }
@@ -337,9 +344,9 @@ void Trinity::WorldObjectSearcher<Check>::Visit(CorpseMapType &m)
 
     for(CorpseMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
+        if(i_check(*itr))
         {
-            i_object = itr->getSource();
+            i_object = *itr;
             return;
         }
     }
@@ -354,9 +361,9 @@ void Trinity::WorldObjectSearcher<Check>::Visit(DynamicObjectMapType &m)
 
     for(DynamicObjectMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
+        if(i_check(*itr))
         {
-            i_object = itr->getSource();
+            i_object = *itr;
             return;
         }
     }
@@ -366,40 +373,40 @@ template<class Check>
 void Trinity::WorldObjectListSearcher<Check>::Visit(PlayerMapType &m)
 {
     for(PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        if(i_check(itr->getSource()))
-            i_objects.push_back(itr->getSource());
+        if(i_check(*itr))
+            i_objects.push_back(*itr);
 }
 
 template<class Check>
 void Trinity::WorldObjectListSearcher<Check>::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        if(i_check(itr->getSource()))
-            i_objects.push_back(itr->getSource());
+        if(i_check(*itr))
+            i_objects.push_back(*itr);
 }
 
 template<class Check>
 void Trinity::WorldObjectListSearcher<Check>::Visit(CorpseMapType &m)
 {
     for(CorpseMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        if(i_check(itr->getSource()))
-            i_objects.push_back(itr->getSource());
+        if(i_check(*itr))
+            i_objects.push_back(*itr);
 }
 
 template<class Check>
 void Trinity::WorldObjectListSearcher<Check>::Visit(GameObjectMapType &m)
 {
     for(GameObjectMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        if(i_check(itr->getSource()))
-            i_objects.push_back(itr->getSource());
+        if(i_check(*itr))
+            i_objects.push_back(*itr);
 }
 
 template<class Check>
 void Trinity::WorldObjectListSearcher<Check>::Visit(DynamicObjectMapType &m)
 {
     for(DynamicObjectMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        if(i_check(itr->getSource()))
-            i_objects.push_back(itr->getSource());
+        if(i_check(*itr))
+            i_objects.push_back(*itr);
 }
 
 // Gameobject searchers
@@ -413,9 +420,9 @@ void Trinity::GameObjectSearcher<Check>::Visit(GameObjectMapType &m)
 
     for(GameObjectMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
+        if(i_check(*itr))
         {
-            i_object = itr->getSource();
+            i_object = *itr;
             return;
         }
     }
@@ -426,8 +433,8 @@ void Trinity::GameObjectLastSearcher<Check>::Visit(GameObjectMapType &m)
 {
     for(GameObjectMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
-            i_object = itr->getSource();
+        if(i_check(*itr))
+            i_object = *itr;
     }
 }
 
@@ -435,8 +442,8 @@ template<class Check>
 void Trinity::GameObjectListSearcher<Check>::Visit(GameObjectMapType &m)
 {
     for(GameObjectMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        if(i_check(itr->getSource()))
-            i_objects.push_back(itr->getSource());
+        if(i_check(*itr))
+            i_objects.push_back(*itr);
 }
 
 // Unit searchers
@@ -450,9 +457,9 @@ void Trinity::UnitSearcher<Check>::Visit(CreatureMapType &m)
 
     for(CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
+        if(i_check(*itr))
         {
-            i_object = itr->getSource();
+            i_object = *itr;
             return;
         }
     }
@@ -467,9 +474,9 @@ void Trinity::UnitSearcher<Check>::Visit(PlayerMapType &m)
 
     for(PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
+        if(i_check(*itr))
         {
-            i_object = itr->getSource();
+            i_object = *itr;
             return;
         }
     }
@@ -480,8 +487,8 @@ void Trinity::UnitLastSearcher<Check>::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
-            i_object = itr->getSource();
+        if(i_check(*itr))
+            i_object = *itr;
     }
 }
 
@@ -490,8 +497,8 @@ void Trinity::UnitLastSearcher<Check>::Visit(PlayerMapType &m)
 {
     for(PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
-            i_object = itr->getSource();
+        if(i_check(*itr))
+            i_object = *itr;
     }
 }
 
@@ -499,24 +506,24 @@ template<class Check>
 void Trinity::UnitListSearcher<Check>::Visit(PlayerMapType &m)
 {
     for(PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        if(i_check(itr->getSource()))
-            i_objects.push_back(itr->getSource());
+        if(i_check(*itr))
+            i_objects.push_back(*itr);
 }
 
 template<class Check>
 void Trinity::UnitListSearcher<Check>::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        if(i_check(itr->getSource()))
-            i_objects.push_back(itr->getSource());
+        if(i_check(*itr))
+            i_objects.push_back(*itr);
 }
 
 template<class Check>
 void Trinity::PlayerListSearcher<Check>::Visit(PlayerMapType &m)
 {
     for(PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        if(i_check(itr->getSource()))
-            i_objects.push_back(itr->getSource());
+        if(i_check(*itr))
+            i_objects.push_back(*itr);
 }
 
 // Creature searchers
@@ -530,9 +537,9 @@ void Trinity::CreatureSearcher<Check>::Visit(CreatureMapType &m)
 
     for(CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
+        if(i_check(*itr))
         {
-            i_object = itr->getSource();
+            i_object = *itr;
             return;
         }
     }
@@ -543,8 +550,8 @@ void Trinity::CreatureLastSearcher<Check>::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
-            i_object = itr->getSource();
+        if(i_check(*itr))
+            i_object = *itr;
     }
 }
 
@@ -552,8 +559,8 @@ template<class Check>
 void Trinity::CreatureListSearcher<Check>::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-        if(i_check(itr->getSource()))
-            i_objects.push_back(itr->getSource());
+        if(i_check(*itr))
+            i_objects.push_back(*itr);
 }
 
 template<class Check>
@@ -565,9 +572,9 @@ void Trinity::PlayerSearcher<Check>::Visit(PlayerMapType &m)
 
     for(PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
     {
-        if(i_check(itr->getSource()))
+        if(i_check(*itr))
         {
-            i_object = itr->getSource();
+            i_object = *itr;
             return;
         }
     }
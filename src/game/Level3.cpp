@@ -61,6 +61,7 @@
 #include "GameEvent.h"
 
 #include "MoveMap.h"                                        // for mmap manager
+#include "ByteBufferAllocator.h"                            // for server memory command
 #include "PathFinder.h"                                     // for mmap commands                                
 
 //reload commands
@@ -455,6 +456,7 @@ bool ChatHandler::HandleReloadSpellAffectCommand(const char*)
 {
     sLog.outString( "Re-Loading SpellAffect definitions..." );
     spellmgr.LoadSpellAffects();
+    spellmgr.LoadSpellMetadata();
     SendGlobalGMSysMessage("DB table `spell_affect` (spell mods apply requirements) reloaded.");
     return true;
 }
@@ -471,6 +473,7 @@ bool ChatHandler::HandleReloadSpellElixirCommand(const char*)
 {
     sLog.outString( "Re-Loading Spell Elixir types..." );
     spellmgr.LoadSpellElixirs();
+    spellmgr.LoadSpellMetadata();
     SendGlobalGMSysMessage("DB table `spell_elixir` (spell elixir types) reloaded.");
     return true;
 }
@@ -487,6 +490,7 @@ bool ChatHandler::HandleReloadSpellLinkedSpellCommand(const char*)
 {
     sLog.outString( "Re-Loading Spell Linked Spells..." );
     spellmgr.LoadSpellLinked();
+    spellmgr.LoadSpellMetadata();
     SendGlobalGMSysMessage("DB table `spell_linked_spell` reloaded.");
     return true;
 }
@@ -495,6 +499,7 @@ bool ChatHandler::HandleReloadSpellProcEventCommand(const char*)
 {
     sLog.outString( "Re-Loading Spell Proc Event conditions..." );
     spellmgr.LoadSpellProcEvents();
+    spellmgr.LoadSpellMetadata();
     SendGlobalGMSysMessage("DB table `spell_proc_event` (spell proc trigger requirements) reloaded.");
     return true;
 }
@@ -6705,6 +6710,28 @@ bool ChatHandler::HandleServerSetMotdCommand(const char* args)
     return true;
 }
 
+/// Display the ByteBuffer storage pool statistics
+bool ChatHandler::HandleServerMemoryCommand(const char* /*args*/)
+{
+    ByteBufferSizeClassStats stats[BYTEBUFFER_SIZE_CLASS_COUNT];
+    uint64 largeAllocations;
+    ByteBufferPool::GetStats(stats, largeAllocations);
+
+    PSendSysMessage("ByteBuffer storage by size class:");
+    for (uint32 i = 0; i < BYTEBUFFER_SIZE_CLASS_COUNT; ++i)
+    {
+        if (!stats[i].blocks)
+            continue;
+
+        uint64 inUse = stats[i].allocations - stats[i].deallocations;
+        uint64 blocks = stats[i].blocks - stats[i].freedBlocks;
+        PSendSysMessage("  %5u bytes: " UI64FMTD " allocations, " UI64FMTD " in use, " UI64FMTD " cached, " UI64FMTD " KB held",
+            uint32(stats[i].blockSize), stats[i].allocations, inUse, blocks - inUse, blocks * stats[i].blockSize / 1024);
+    }
+    PSendSysMessage("  larger than 64K: " UI64FMTD " heap allocations", largeAllocations);
+    return true;
+}
+
 bool ChatHandler::HandleServerSetConfigCommand(const char* args)
 {
     if(!*args)
@@ -7994,6 +8021,7 @@ bool ChatHandler::HandleReloadSpellTemplates(const char* args)
     sLog.outString("Re-loading spell templates...");
     objmgr.LoadSpellTemplates();
     spellmgr.LoadSpellCustomAttr(); //re apply custom attr
+    spellmgr.LoadSpellMetadata();
     SendGlobalGMSysMessage("DB table `spell_template` (spell definitions) reloaded.");
     return true;
 }
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef TRINITY_LOOTALIASTABLE_H
+#define TRINITY_LOOTALIASTABLE_H
+
+#include "Platform/Define.h"
+
+#include <algorithm>
+#include <vector>
+
+/*
+ * Walker alias table: picks one of n weighted outcomes with one roll, a NULL outcome is an empty drop.
+ * A column gives its item with its chance, else its alias.
+ */
+template<class T>
+class LootAliasTable
+{
+    public:
+        // weights sum to 100
+        void Build(std::vector<T const*> const& outcomes, std::vector<double> const& weights)
+        {
+            m_columns.clear();
+
+            uint32 size = outcomes.size();
+            if (!size)
+                return;
+
+            // Vose's construction: columns below the average are topped up by one above it
+            m_columns.resize(size);
+            std::vector<double> scaled(size);
+            std::vector<uint32> small, large;
+            for (uint32 i = 0; i < size; ++i)
+            {
+                m_columns[i].chance = 1.0f;
+                m_columns[i].item = outcomes[i];
+                m_columns[i].alias = outcomes[i];
+                scaled[i] = weights[i] * size / 100.0;
+                if (scaled[i] < 1.0)
+                    small.push_back(i);
+                else
+                    large.push_back(i);
+            }
+
+            while (!small.empty() && !large.empty())
+            {
+                uint32 less = small.back();
+                uint32 more = large.back();
+                small.pop_back();
+
+                m_columns[less].chance = float(scaled[less]);
+                m_columns[less].alias = outcomes[more];
+
+                scaled[more] -= 1.0 - scaled[less];
+                if (scaled[more] < 1.0)
+                {
+                    large.pop_back();
+                    small.push_back(more);
+                }
+            }
+            // what is left is 1.0 up to rounding errors, the columns keep their own outcome
+        }
+
+        // norm in [0, 1)
+        T const* Roll(double norm) const
+        {
+            if (m_columns.empty())
+                return NULL;
+
+            // one roll gives the column and the chance inside of it
+            double roll = norm * m_columns.size();
+            uint32 column = std::min(uint32(roll), uint32(m_columns.size() - 1));
+
+            Column const& entry = m_columns[column];
+            return roll - column < entry.chance ? entry.item : entry.alias;
+        }
+
+    private:
+        struct Column
+        {
+            float chance;
+            T const* item;
+            T const* alias;
+        };
+        std::vector<Column> m_columns;
+};
+
+// Builds the table of a loot group, the outcomes keep the chances of the former roll:
+// explicitly chanced entries are checked in order on one roll of 100 (an entry of 100% or more
+// takes all what is left), when all of them miss one of the equal chanced entries is taken
+template<class T, class List>
+void BuildLootGroupTable(LootAliasTable<T>& table, List const& explicitlyChanced, List const& equalChanced)
+{
+    std::vector<T const*> outcomes;
+    std::vector<double> weights;
+    double total = 0.0;
+    for (typename List::const_iterator i = explicitlyChanced.begin(); i != explicitlyChanced.end() && total < 100.0; ++i)
+    {
+        double chance = std::min(double(i->chance), 100.0 - total);
+        outcomes.push_back(&*i);
+        weights.push_back(chance);
+        total += chance;
+    }
+
+    double missed = 100.0 - std::min(total, 100.0);
+    if (missed > 0.0)
+    {
+        if (equalChanced.empty())
+        {
+            outcomes.push_back(NULL);
+            weights.push_back(missed);
+        }
+        else
+        {
+            for (typename List::const_iterator i = equalChanced.begin(); i != equalChanced.end(); ++i)
+            {
+                outcomes.push_back(&*i);
+                weights.push_back(missed / equalChanced.size());
+            }
+        }
+    }
+
+    table.Build(outcomes, weights);
+}
+
+#endif
@@ -19,6 +19,7 @@
  */
 
 #include "LootMgr.h"
+#include "LootAliasTable.h"
 #include "Log.h"
 #include "ObjectMgr.h"
 #include "World.h"
@@ -61,10 +62,13 @@ class LootTemplate::LootGroup                               // A set of loot def
         void Verify(LootStore const& lootstore, uint32 id, uint32 group_id) const;
         void CollectLootIds(LootIdSet& set) const;
         void CheckLootRefs(LootTemplateMap const& store, LootIdSet* ref_set) const;
+        void Compile();                                     // Builds the alias table used by Roll()
     private:
         LootStoreItemList ExplicitlyChanced;                // Entries with chances defined in DB
         LootStoreItemList EqualChanced;                     // Zero chances - every entry takes the same chance
 
+        LootAliasTable<LootStoreItem> Columns;              // Alias table over all outcomes of the group
+
         LootStoreItem const * Roll() const;                 // Rolls an item from the group, returns NULL if all miss their chances
 };
 
@@ -84,6 +88,13 @@ void LootStore::Verify() const
         i->second->Verify(*this, i->first);
 }
 
+// Prepares the templates for loot generation, references to missing templates are dropped
+void LootStore::Compile()
+{
+    for (LootTemplateMap::const_iterator i = m_LootTemplates.begin(); i != m_LootTemplates.end(); ++i )
+        i->second->Compile();
+}
+
 // Loads a *_loot_template DB table into loot store
 // All checks of the loaded template are called from here, no error reports at loot generation required
 void LootStore::LoadLootTable()
@@ -153,6 +164,7 @@ void LootStore::LoadLootTable()
         delete result;
 
         Verify();                                           // Checks validity of the loot store
+        Compile();                                          // References are resolved again when reference templates are loaded
 
         sLog.outString();
         sLog.outString( ">> Loaded %u loot definitions (%d templates)", count, m_LootTemplates.size());
@@ -771,28 +783,16 @@ void LootTemplate::LootGroup::AddEntry(LootStoreItem& item)
         EqualChanced.push_back(item);
 }
 
+// Builds the alias table of the group
+void LootTemplate::LootGroup::Compile()
+{
+    BuildLootGroupTable(Columns, ExplicitlyChanced, EqualChanced);
+}
+
 // Rolls an item from the group, returns NULL if all miss their chances
 LootStoreItem const * LootTemplate::LootGroup::Roll() const
 {
-    if (!ExplicitlyChanced.empty())                         // First explicitly chanced entries are checked
-    {
-        float Roll = rand_chance();
-
-        for (uint32 i=0; i<ExplicitlyChanced.size(); ++i)    //check each explicitly chanced entry in the template and modify its chance based on quality.
-        {
-            if(ExplicitlyChanced[i].chance>=100.f)
-                return &ExplicitlyChanced[i];
-
-            ItemPrototype const *pProto = objmgr.GetItemPrototype(ExplicitlyChanced[i].itemid);
-            Roll -= ExplicitlyChanced[i].chance;
-            if (Roll < 0)
-                return &ExplicitlyChanced[i];
-        }
-    }
-    if (!EqualChanced.empty())                              // If nothing selected yet - an item is taken from equal-chanced part
-        return &EqualChanced[irand(0, EqualChanced.size()-1)];
-
-    return NULL;                                            // Empty drop from the group
+    return Columns.Roll(rand_norm());
 }
 
 // True if group includes at least 1 quest drop entry
@@ -918,24 +918,19 @@ void LootTemplate::Process(Loot& loot, LootStore const& store, uint8 groupId) co
         return;
     }
 
-    // Rolling non-grouped items
-    for (LootStoreItemList::const_iterator i = Entries.begin() ; i != Entries.end() ; ++i )
+    // Rolling non-grouped items, same as LootStoreItem::Roll() with the rate resolved at load
+    for (std::vector<CompiledEntry>::const_iterator i = CompiledEntries.begin() ; i != CompiledEntries.end() ; ++i )
     {
-        if ( !i->Roll() )
+        if (i->chance < 100.f && !roll_chance_f(i->chance * (i->rate < MAX_RATES ? sWorld.getRate(Rates(i->rate)) : 1.0f)))
             continue;                                       // Bad luck for the entry
 
-        if (i->mincountOrRef < 0)                           // References processing
+        if (i->reference)                                   // References processing
         {
-            LootTemplate const* Referenced = LootTemplates_Reference.GetLootFor(-i->mincountOrRef);
-
-            if(!Referenced)
-                continue;                                   // Error message already printed at loading stage
-
-            for (uint32 loop=0; loop < i->maxcount; ++loop )// Ref multiplicator
-                Referenced->Process(loot, store, i->group); // Ref processing
+            for (uint32 loop=0; loop < i->item->maxcount; ++loop )// Ref multiplicator
+                i->reference->Process(loot, store, i->item->group); // Ref processing
         }
         else                                                // Plain entries (not a reference, not grouped)
-            loot.AddItem(*i);                               // Chance is already checked, just add
+            loot.AddItem(*i->item);                         // Chance is already checked, just add
     }
 
     // Now processing groups
@@ -1035,6 +1030,37 @@ void LootTemplate::CheckLootRefs(LootTemplateMap const& store, LootIdSet* ref_se
         grItr->CheckLootRefs(store,ref_set);
 }
 
+// Resolves the references and the drop rates of the entries and builds the group tables
+void LootTemplate::Compile()
+{
+    CompiledEntries.clear();
+    CompiledEntries.reserve(Entries.size());
+
+    for (LootStoreItemList::const_iterator i = Entries.begin(); i != Entries.end(); ++i)
+    {
+        CompiledEntry entry;
+        entry.chance = i->chance;
+        entry.item = &*i;
+        entry.reference = NULL;
+        entry.rate = MAX_RATES;
+
+        if (i->mincountOrRef < 0)
+        {
+            entry.reference = LootTemplates_Reference.GetLootFor(-i->mincountOrRef);
+            if (!entry.reference)
+                continue;                                   // Error message already printed at loading stage
+            entry.rate = RATE_DROP_ITEM_REFERENCED;
+        }
+        else if (ItemPrototype const* pProto = objmgr.GetItemPrototype(i->itemid))
+            entry.rate = qualityToRate[pProto->Quality];
+
+        CompiledEntries.push_back(entry);
+    }
+
+    for (LootGroups::iterator i = Groups.begin(); i != Groups.end(); ++i)
+        i->Compile();
+}
+
 void LoadLootTemplates_Creature()
 {
     LootIdSet ids_set, ids_setUsed;
@@ -1243,6 +1269,17 @@ void LoadLootTemplates_Reference()
     LootTemplates_QuestMail.CheckLootRefs(&ids_set);
     LootTemplates_Reference.CheckLootRefs(&ids_set);
 
+    // the other stores still point to the former reference templates
+    LootTemplates_Creature.Compile();
+    LootTemplates_Fishing.Compile();
+    LootTemplates_Gameobject.Compile();
+    LootTemplates_Item.Compile();
+    LootTemplates_Pickpocketing.Compile();
+    LootTemplates_Skinning.Compile();
+    LootTemplates_Disenchant.Compile();
+    LootTemplates_Prospecting.Compile();
+    LootTemplates_QuestMail.Compile();
+
     // output error for any still listed ids (not referenced from any loot table)
     LootTemplates_Reference.ReportUnusedIds(ids_set);
 }
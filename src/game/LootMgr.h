@@ -145,6 +145,10 @@ class LootStore
 
         LootTemplate const* GetLootFor(uint32 loot_id) const;
 
+        // Builds the roll tables of all templates and resolves their references,
+        // redone for every store when the reference templates are reloaded
+        void Compile();
+
         char const* GetName() const { return m_name; }
         char const* GetEntryName() const { return m_entryName; }
     protected:
@@ -175,10 +179,21 @@ class LootTemplate
         // Checks integrity of the template
         void Verify(LootStore const& store, uint32 Id) const;
         void CheckLootRefs(LootTemplateMap const& store, LootIdSet* ref_set) const;
+        // Builds the group alias tables and resolves the references (after loading, see LootStore::Compile)
+        void Compile();
         
     private:
+        struct CompiledEntry                                // non-grouped entry prepared for Process()
+        {
+            float chance;                                   // copy of item->chance, entries are rolled without touching the item
+            uint32 rate;                                    // Rates applied to the chance, MAX_RATES if none
+            LootTemplate const* reference;                  // referenced template, NULL for plain items and missing references
+            LootStoreItem const* item;
+        };
+
         LootStoreItemList Entries;                          // not grouped only
         LootGroups        Groups;                           // groups have own (optimised) processing, grouped entries go there
+        std::vector<CompiledEntry> CompiledEntries;         // Entries in the same order, built by Compile()
 };
 
 //=====================================================
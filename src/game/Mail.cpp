@@ -797,6 +797,14 @@ void WorldSession::HandleMsgQueryNextMailtime(WorldPacket & /*recv_data*/ )
 }
 
 void WorldSession::SendMailTo(Player* receiver, uint8 messageType, uint8 stationery, uint32 sender_guidlow_or_entry, uint32 receiver_guidlow, std::string subject, uint32 itemTextId, MailItemsInfo* mi, uint32 money, uint32 COD, uint32 checked, uint32 deliver_delay, uint16 mailTemplateId)
+{
+    SQLTransaction trans = CharacterDatabase.BeginTransaction();
+    SendMailTo(trans, receiver, messageType, stationery, sender_guidlow_or_entry, receiver_guidlow, subject, itemTextId, mi, money, COD, checked, deliver_delay, mailTemplateId);
+    if (trans->GetSize())
+        CharacterDatabase.CommitTransaction(trans);
+}
+
+void WorldSession::SendMailTo(SQLTransaction& trans, Player* receiver, uint8 messageType, uint8 stationery, uint32 sender_guidlow_or_entry, uint32 receiver_guidlow, std::string subject, uint32 itemTextId, MailItemsInfo* mi, uint32 money, uint32 COD, uint32 checked, uint32 deliver_delay, uint16 mailTemplateId)
 {
     if (receiver_guidlow == 0)
     {
@@ -870,7 +878,6 @@ void WorldSession::SendMailTo(Player* receiver, uint8 messageType, uint8 station
             mi->deleteIncludedItems();
     }
 
-    SQLTransaction trans = CharacterDatabase.BeginTransaction();
     CharacterDatabase.escape_string(subject);
     trans->PAppend("INSERT INTO mail (id,messageType,stationery,mailTemplateId,sender,receiver,subject,itemTextId,has_items,expire_time,deliver_time,money,cod,checked) "
         "VALUES ('%u', '%u', '%u', '%u', '%u', '%u', '%s', '%u', '%u', '" I64FMTD "','" I64FMTD "', '%u', '%u', '%d')",
@@ -886,7 +893,6 @@ void WorldSession::SendMailTo(Player* receiver, uint8 messageType, uint8 station
             LogsDatabase.PExecute("INSERT INTO item_mail (senderguid,receiverguid,itemguid,itementry,itemcount,time) VALUES (%u,%u,%u,%u,%u,%u);", messageType == MAIL_NORMAL ? sender_guidlow_or_entry : 0,receiver_guidlow,mailItem.item_guidlow,mailItem.item_template,mailItem.item ? mailItem.item->GetCount() : 0,time(NULL));
         }
     }
-    CharacterDatabase.CommitTransaction(trans);
 
     //receiver is not online, delete item from memory for now
     if(mi && !receiver)
@@ -182,6 +182,24 @@ void Map::LoadMapAndVMap(uint32 mapid, uint32 instanceid, int x,int y)
     }
 }
 
+// distance in yards from a position in cell units to the borders of a cell, cell x covers [x, x + 1)
+static float GetCellDistance(float cell_x, float cell_y, uint32 x, uint32 y)
+{
+    float dx = std::max(0.0f, std::max(float(x) - cell_x, cell_x - float(x + 1)));
+    float dy = std::max(0.0f, std::max(float(y) - cell_y, cell_y - float(y + 1)));
+    return sqrt(dx*dx + dy*dy) * SIZE_OF_GRID_CELL;
+}
+
+// map updates between two updates of idle creatures at this distance from the nearest player
+static uint32 GetCreatureUpdateInterval(float distance)
+{
+    if(distance < sWorld.getConfig(CONFIG_CREATURE_LOD_NEAR_DISTANCE))
+        return 1;
+    if(distance < sWorld.getConfig(CONFIG_CREATURE_LOD_FAR_DISTANCE))
+        return sWorld.getConfig(CONFIG_CREATURE_LOD_MID_INTERVAL);
+    return sWorld.getConfig(CONFIG_CREATURE_LOD_FAR_INTERVAL);
+}
+
 void Map::InitStateMachine()
 {
     si_GridStates[GRID_STATE_INVALID] = new InvalidState;
@@ -200,8 +218,8 @@ void Map::DeleteStateMachine()
 
 Map::Map(uint32 id, time_t expiry, uint32 InstanceId, uint8 SpawnMode)
    : i_mapEntry (sMapStore.LookupEntry(id)), i_spawnMode(SpawnMode),
-   i_id(id), i_InstanceId(InstanceId), m_unloadTimer(0), i_gridExpiry(expiry),
-   m_VisibleDistance(DEFAULT_VISIBILITY_DISTANCE),
+   i_id(id), i_InstanceId(InstanceId), m_unloadTimer(0), i_updateTick(0), i_gridExpiry(expiry),
+   m_VisibleDistance(DEFAULT_VISIBILITY_DISTANCE), m_updateStats(NULL),
    m_activeNonPlayersIter(m_activeNonPlayers.end())
    , i_lock(true)
 {
@@ -680,6 +698,8 @@ void Map::AddUnitToNotify(Unit* u)
 
 void Map::Update(const uint32 &t_diff)
 {
+    PROFILE;
+
     i_lock = false;
     
     _dynamicTree.update(t_diff);
@@ -699,7 +719,7 @@ void Map::Update(const uint32 &t_diff)
 
     resetMarkedCells();
 
-    Trinity::ObjectUpdater updater(t_diff);
+    Trinity::ObjectUpdater updater(t_diff, ++i_updateTick);
     // for creature
     TypeContainerVisitor<Trinity::ObjectUpdater, GridTypeMapContainer  > grid_object_update(updater);
     // for pets
@@ -726,27 +746,47 @@ void Map::Update(const uint32 &t_diff)
         CellArea area = Cell::CalculateCellArea(*plr, GetVisibilityDistance());
         area.ResizeBorders(begin_cell, end_cell);
 
+        // position of the player in cell units
+        float cell_x = (plr->GetPositionX() - CENTER_GRID_CELL_OFFSET) / SIZE_OF_GRID_CELL + CENTER_GRID_CELL_ID + 0.5f;
+        float cell_y = (plr->GetPositionY() - CENTER_GRID_CELL_OFFSET) / SIZE_OF_GRID_CELL + CENTER_GRID_CELL_ID + 0.5f;
+
         for(uint32 x = begin_cell.x_coord; x <= end_cell.x_coord; ++x)
         {
             for(uint32 y = begin_cell.y_coord; y <= end_cell.y_coord; ++y)
             {
-                // marked cells are those that have been visited
-                // don't visit the same cell twice
-                uint32 cell_id = (y * TOTAL_NUMBER_OF_CELLS_PER_MAP) + x;
-                if(!isCellMarked(cell_id))
-                {
-                    markCell(cell_id);
-                    CellPair pair(x,y);
-                    Cell cell(pair);
-                    cell.data.Part.reserved = CENTER_DISTRICT;
-                    //cell.SetNoCreate();
-                    cell.Visit(pair, grid_object_update,  *this);
-                    cell.Visit(pair, world_object_update, *this);
-                }
+                UpdateCell updateCell;
+                updateCell.cellId = (y * TOTAL_NUMBER_OF_CELLS_PER_MAP) + x;
+                updateCell.distance = GetCellDistance(cell_x, cell_y, x, y);
+                i_updateCells.push_back(updateCell);
             }
         }
     }
 
+    // a cell around several players comes first with the distance of the nearest one
+    std::sort(i_updateCells.begin(), i_updateCells.end());
+
+    for(std::vector<UpdateCell>::const_iterator itr = i_updateCells.begin(); itr != i_updateCells.end(); ++itr)
+    {
+        // marked cells are those that have been visited
+        // don't visit the same cell twice
+        if(isCellMarked(itr->cellId))
+            continue;
+
+        markCell(itr->cellId);
+        updater.i_interval = GetCreatureUpdateInterval(itr->distance);
+
+        CellPair pair(itr->cellId % TOTAL_NUMBER_OF_CELLS_PER_MAP, itr->cellId / TOTAL_NUMBER_OF_CELLS_PER_MAP);
+        Cell cell(pair);
+        cell.data.Part.reserved = CENTER_DISTRICT;
+        //cell.SetNoCreate();
+        cell.Visit(pair, grid_object_update,  *this);
+        cell.Visit(pair, world_object_update, *this);
+    }
+    i_updateCells.clear();
+
+    // cells around active objects only are updated at full rate
+    updater.i_interval = 1;
+
     //must be done before creatures update
     for (auto itr : CreatureGroupHolder)
     {
@@ -841,6 +881,11 @@ void Map::Update(const uint32 &t_diff)
     RelocationNotify();
     RemoveAllObjectsInRemoveList();
 
+    // hand the packets built during this update to the sockets
+    for(MapRefManager::iterator itr = m_mapRefManager.begin(); itr != m_mapRefManager.end(); ++itr)
+        if(Player* plr = itr->getSource())
+            plr->GetSession()->FlushPackets();
+
     // Don't unload grids if it's battleground, since we may have manually added GOs,creatures, those doesn't load from DB at grid re-load !
     // This isn't really bother us, since as soon as we have instanced BG-s, the whole map unloads as the BG gets ended
     if (IsBattleGroundOrArena())
@@ -48,6 +48,7 @@ class InstanceSave;
 class WorldObject;
 class CreatureGroup;
 class BattleGround;
+class LatencyHistogram;
 
 namespace ZThread
 {
@@ -368,6 +369,10 @@ class Map : public GridRefManager<NGridType>, public Trinity::ObjectLevelLockabl
         bool IsDungeon() const { return i_mapEntry && i_mapEntry->IsDungeon(); }
         bool IsRaid() const { return i_mapEntry && i_mapEntry->IsRaid(); }
         bool IsCommon() const { return i_mapEntry && i_mapEntry->IsCommon(); }
+
+        // update time of a base map and its instances, set by MapManager when it creates the base map
+        LatencyHistogram* GetUpdateStats() const { return m_updateStats; }
+        void SetUpdateStats(LatencyHistogram* stats) { m_updateStats = stats; }
         bool IsHeroic() const { return i_spawnMode == DIFFICULTY_HEROIC; }
         bool IsBattleGround() const { return i_mapEntry && i_mapEntry->IsBattleGround(); }
         bool IsBattleArena() const { return i_mapEntry && i_mapEntry->IsBattleArena(); }
@@ -505,6 +510,7 @@ class Map : public GridRefManager<NGridType>, public Trinity::ObjectLevelLockabl
         uint32 i_InstanceId;
         uint32 m_unloadTimer;
         float m_VisibleDistance;
+        LatencyHistogram* m_updateStats;
         DynamicMapTree _dynamicTree;
 
         MapRefManager m_mapRefManager;
@@ -520,6 +526,20 @@ class Map : public GridRefManager<NGridType>, public Trinity::ObjectLevelLockabl
         GridMap *GridMaps[MAX_NUMBER_OF_GRIDS][MAX_NUMBER_OF_GRIDS];
         std::bitset<TOTAL_NUMBER_OF_CELLS_PER_MAP*TOTAL_NUMBER_OF_CELLS_PER_MAP> marked_cells;
 
+        // cells updated around the players, with the distance of their borders to the player
+        struct UpdateCell
+        {
+            uint32 cellId;
+            float distance;
+
+            bool operator<(UpdateCell const& right) const
+            {
+                return cellId < right.cellId || (cellId == right.cellId && distance < right.distance);
+            }
+        };
+        std::vector<UpdateCell> i_updateCells;
+        uint32 i_updateTick;
+
         time_t i_gridExpiry;
 
         bool i_lock;
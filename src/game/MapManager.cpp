@@ -127,6 +127,7 @@ MapManager::_GetBaseMap(uint32 id)
         {
             m = new Map(id, i_gridCleanUpDelay, 0, 0);
         }
+        m->SetUpdateStats(sWorld.CreateMapUpdateStats(id));
         i_maps[id] = m;
     }
 
@@ -245,13 +246,15 @@ void MapManager::RemoveBonesFromMap(uint32 mapid, uint64 guid, float x, float y)
 void
 MapManager::Update(time_t diff)
 {
+    PROFILE;
+
     i_timer.Update(diff);
     if( !i_timer.Passed() )
         return;
 
-    sWorld.RecordTimeDiff(NULL);
+    uint64 phaseStart = getNSTime();
     ObjectAccessor::Instance().UpdatePlayers(i_timer.GetCurrent());
-    sWorld.RecordTimeDiff("UpdatePlayers");
+    phaseStart = sWorld.RecordPhaseTime(TICK_PHASE_PLAYERS, phaseStart);
 
     uint32 i=0;
     MapMapType::iterator iter;
@@ -268,16 +271,19 @@ MapManager::Update(time_t diff)
     for(int32 i = 0; i < i_maps.size(); ++i)
     {
         //checkAndCorrectGridStatesArray();                   // debugging code, should be deleted some day
+        uint64 mapStart = getNSTime();
         update_queue[i]->Update(i_timer.GetCurrent());
-        sWorld.RecordTimeDiff("UpdateMap %u", update_queue[i]->GetId());
+        sWorld.RecordMapUpdateTime(update_queue[i], mapStart);
     //  sLog.outError("This is thread %d out of %d threads,updating map %u",omp_get_thread_num(),omp_get_num_threads(),iter->second->GetId());
     }
 
+    phaseStart = sWorld.RecordPhaseTime(TICK_PHASE_MAPS, phaseStart);
+
     ObjectAccessor::Instance().Update(i_timer.GetCurrent());
-    sWorld.RecordTimeDiff("UpdateObjectAccessor");
+    phaseStart = sWorld.RecordPhaseTime(TICK_PHASE_OBJECTACCESSOR, phaseStart);
     for (TransportSet::iterator iter = m_Transports.begin(); iter != m_Transports.end(); ++iter)
         (*iter)->Update(i_timer.GetCurrent());
-    sWorld.RecordTimeDiff("UpdateTransports");
+    sWorld.RecordPhaseTime(TICK_PHASE_TRANSPORTS, phaseStart);
 
     i_timer.SetCurrent(0);
 }
@@ -396,3 +402,21 @@ uint32 MapManager::GetNumPlayersInMap(uint32 mapId)
 
     return ret;
 }
+
+void MapManager::GetPlayerCountsByMap(std::map<uint32, uint32>& counts)
+{
+    for (MapMapType::iterator itr = i_maps.begin(); itr != i_maps.end(); ++itr)
+    {
+        Map* map = itr->second;
+        uint32& count = counts[map->GetId()];
+
+        if (!map->Instanceable())
+            count += map->GetPlayers().getSize();
+        else
+        {
+            MapInstanced::InstancedMaps& maps = ((MapInstanced *)map)->GetInstancedMaps();
+            for (MapInstanced::InstancedMaps::iterator mitr = maps.begin(); mitr != maps.end(); ++mitr)
+                count += ((InstanceMap *)mitr->second)->GetPlayers().getSize();
+        }
+    }
+}
@@ -121,6 +121,8 @@ class MapManager : public Trinity::Singleton<MapManager, Trinity::ClassLevelLock
         uint32 GetNumInstances();
         uint32 GetNumPlayersInInstances();
         uint32 GetNumPlayersInMap(uint32 mapId);
+        // player count of every loaded map id, instances summed, in one pass
+        void GetPlayerCountsByMap(std::map<uint32, uint32>& counts);
 
     private:
         // debugging code, should be deleted some day
@@ -852,6 +852,10 @@ void Object::SetFloatValue( uint16 index, float value )
     {
         m_floatValues[ index ] = value;
 
+        // units are mirrored in their cell with their size for the spell target searches
+        if(index == UNIT_FIELD_COMBATREACH && isType(TYPEMASK_UNIT))
+            static_cast<WorldObject*>(this)->GetGridPosition().SetSize(value);
+
         if(m_inWorld)
         {
             if(!m_objectUpdated)
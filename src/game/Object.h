@@ -26,6 +26,7 @@
 #include "UpdateFields.h"
 #include "UpdateData.h"
 #include "GameSystem/GridReference.h"
+#include "GameSystem/GridPositions.h"
 #include "ObjectDefines.h"
 #include "GridDefines.h"
 #include "CreatureAI.h"
@@ -482,6 +483,20 @@ class WorldObject : public Object, public WorldLocation
 
         void _Create( uint32 guidlow, HighGuid guidhigh, uint32 mapid );
 
+        // Position::Relocate hidden to keep the position mirror of the grid cell up to date
+        void Relocate(float x, float y)
+            { Position::Relocate(x, y); m_gridPosition.Relocate(m_positionX, m_positionY, m_positionZ); }
+        void Relocate(float x, float y, float z)
+            { Position::Relocate(x, y, z); m_gridPosition.Relocate(m_positionX, m_positionY, m_positionZ); }
+        void Relocate(float x, float y, float z, float orientation)
+            { Position::Relocate(x, y, z, orientation); m_gridPosition.Relocate(m_positionX, m_positionY, m_positionZ); }
+        void Relocate(const Position &pos)
+            { Position::Relocate(pos); m_gridPosition.Relocate(m_positionX, m_positionY, m_positionZ); }
+        void Relocate(const Position *pos)
+            { Position::Relocate(pos); m_gridPosition.Relocate(m_positionX, m_positionY, m_positionZ); }
+
+        GridPositionSlot& GetGridPosition() { return m_gridPosition; }
+
         void GetNearPoint2D( float &x, float &y, float distance, float absAngle) const;
         void GetNearPoint( WorldObject const* searcher, float &x, float &y, float &z, float searcher_size, float distance2d,float absAngle) const;
         void GetClosePoint(float &x, float &y, float &z, float size, float distance2d = 0, float angle = 0) const
@@ -615,6 +630,8 @@ class WorldObject : public Object, public WorldLocation
         Map* _findMap();
 
         bool mSemaphoreTeleport;
+
+        GridPositionSlot m_gridPosition;
 };
 
 namespace Trinity
@@ -59,13 +59,13 @@ namespace Trinity
         {
             for(PlayerMapType::iterator iter=m.begin(); iter != m.end(); ++iter)
             {
-                if( iter->getSource() == &i_player )
+                if( *iter == &i_player )
                     continue;
 
-                UpdateDataMapType::iterator iter2 = i_updatePlayers.find(iter->getSource());
+                UpdateDataMapType::iterator iter2 = i_updatePlayers.find(*iter);
                 if( iter2 == i_updatePlayers.end() )
                 {
-                    std::pair<UpdateDataMapType::iterator, bool> p = i_updatePlayers.insert( ObjectAccessor::UpdateDataValueType(iter->getSource(), UpdateData()) );
+                    std::pair<UpdateDataMapType::iterator, bool> p = i_updatePlayers.insert( ObjectAccessor::UpdateDataValueType(*iter, UpdateData()) );
                     assert(p.second);
                     iter2 = p.first;
                 }
@@ -74,7 +74,7 @@ namespace Trinity
             }
         }
 
-        template<class SKIP> void Visit(GridRefManager<SKIP> &) {}
+        template<class SKIP> void Visit(GridObjectList<SKIP> &) {}
     };
 }
 
@@ -506,6 +506,8 @@ ObjectAccessor::ConvertCorpseForPlayer(uint64 player_guid, bool insignia)
 void
 ObjectAccessor::Update(uint32 diff)
 {
+    PROFILE;
+
     UpdateDataMapType update_players;
     {
         Guard guard(i_updateGuard);
@@ -520,7 +522,7 @@ ObjectAccessor::Update(uint32 diff)
         }
     }
 
-    WorldPacket packet;                                     // here we allocate a std::vector with a size of 0x10000
+    WorldPacket packet;                                     // storage is reused for every player, clear() keeps the capacity
     for(UpdateDataMapType::iterator iter = update_players.begin(); iter != update_players.end(); ++iter)
     {
         iter->second.BuildPacket(&packet);
@@ -532,6 +534,8 @@ ObjectAccessor::Update(uint32 diff)
 void
 ObjectAccessor::UpdatePlayers(uint32 diff)
 {
+    PROFILE;
+
     HashMapHolder<Player>::MapType playerMap = HashMapHolder<Player>::GetContainer();
     for(HashMapHolder<Player>::MapType::iterator iter = playerMap.begin(); iter != playerMap.end(); ++iter)
         if(iter->second->IsInWorld())
@@ -545,10 +549,10 @@ ObjectAccessor::WorldObjectChangeAccumulator::Visit(PlayerMapType &m)
 {
     for(PlayerMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        BuildPacket(iter->getSource());
-        if (!iter->getSource()->GetSharedVisionList().empty())
+        BuildPacket(*iter);
+        if (!(*iter)->GetSharedVisionList().empty())
         {
-            for (auto itr : iter->getSource()->GetSharedVisionList())
+            for (auto itr : (*iter)->GetSharedVisionList())
             {
                 if(Player* p = FindPlayer(itr))
                     BuildPacket(p);
@@ -562,10 +566,10 @@ ObjectAccessor::WorldObjectChangeAccumulator::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        if (!iter->getSource()->GetSharedVisionList().empty())
+        if (!(*iter)->GetSharedVisionList().empty())
         {
-            SharedVisionList::const_iterator it = iter->getSource()->GetSharedVisionList().begin();
-            for (auto itr : iter->getSource()->GetSharedVisionList())
+            SharedVisionList::const_iterator it = (*iter)->GetSharedVisionList().begin();
+            for (auto itr : (*iter)->GetSharedVisionList())
             {
                 if(Player* p = FindPlayer(itr))
                     BuildPacket(p);
@@ -579,10 +583,10 @@ ObjectAccessor::WorldObjectChangeAccumulator::Visit(DynamicObjectMapType &m)
 {
     for(DynamicObjectMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        if (IS_PLAYER_GUID(iter->getSource()->GetCasterGUID()))
+        if (IS_PLAYER_GUID((*iter)->GetCasterGUID()))
         {
-            Player* caster = iter->getSource()->GetCaster()->ToPlayer();
-            if (caster->GetUInt64Value(PLAYER_FARSIGHT) == iter->getSource()->GetGUID())
+            Player* caster = (*iter)->GetCaster()->ToPlayer();
+            if (caster->GetUInt64Value(PLAYER_FARSIGHT) == (*iter)->GetGUID())
                 BuildPacket(caster);
         }
     }
@@ -223,7 +223,7 @@ class ObjectAccessor : public Trinity::Singleton<ObjectAccessor, Trinity::ClassL
             void Visit(CreatureMapType &);
             void Visit(DynamicObjectMapType &);
             void BuildPacket(Player* plr);
-            template<class SKIP> void Visit(GridRefManager<SKIP> &) {}
+            template<class SKIP> void Visit(GridObjectList<SKIP> &) {}
         };
 
         friend struct WorldObjectChangeAccumulator;
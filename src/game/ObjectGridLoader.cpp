@@ -36,7 +36,7 @@ class ObjectGridRespawnMover
 
         void Move(GridType &grid);
 
-        template<class T> void Visit(GridRefManager<T> &) {}
+        template<class T> void Visit(GridObjectList<T> &) {}
         void Visit(CreatureMapType &m);
 };
 
@@ -55,7 +55,7 @@ ObjectGridRespawnMover::Visit(CreatureMapType &m)
     // move to respawn point to prevent this case. For player view in respawn grid this will be normal respawn.
     for(CreatureMapType::iterator iter = m.begin(); iter != m.end();)
     {
-        Creature * c = iter->getSource();
+        Creature * c = *iter;
         ++iter;
 
         assert(!c->IsPet() && "ObjectGridRespawnMover don't must be called for pets");
@@ -85,7 +85,7 @@ class ObjectWorldLoader
 
         void Visit(CorpseMapType &m);
 
-        template<class T> void Visit(GridRefManager<T>&) { }
+        template<class T> void Visit(GridObjectList<T>&) { }
 
     private:
         Cell i_cell;
@@ -109,7 +109,7 @@ template<> void addUnitState(Creature *obj, CellPair const& cell_pair)
 }
 
 template <class T>
-void LoadHelper(CellGuidSet const& guid_set, CellPair &cell, GridRefManager<T> &m, uint32 &count, Map* map)
+void LoadHelper(CellGuidSet const& guid_set, CellPair &cell, GridObjectList<T> &m, uint32 &count, Map* map)
 {
     for(CellGuidSet::const_iterator i_guid = guid_set.begin(); i_guid != guid_set.end(); ++i_guid)
     {
@@ -122,7 +122,7 @@ void LoadHelper(CellGuidSet const& guid_set, CellPair &cell, GridRefManager<T> &
             continue;
         }
 
-        obj->GetGridRef().link(&m, obj);
+        m.insert(obj);
 
         addUnitState(obj,cell);
         obj->AddToWorld();
@@ -150,7 +150,7 @@ void LoadHelper(CellCorpseSet const& cell_corpses, CellPair &cell, CorpseMapType
         if(!obj)
             continue;
 
-        obj->GetGridRef().link(&m, obj);
+        m.insert(obj);
 
         addUnitState(obj,cell);
         obj->AddToWorld();
@@ -253,15 +253,16 @@ ObjectGridUnloader::Unload(GridType &grid)
 
 template<class T>
 void
-ObjectGridUnloader::Visit(GridRefManager<T> &m)
+ObjectGridUnloader::Visit(GridObjectList<T> &m)
 {
-    while(!m.isEmpty())
+    for(typename GridObjectList<T>::iterator iter = m.begin(); iter != m.end();)
     {
-        T *obj = m.getFirst()->getSource();
+        T *obj = *iter;
+        ++iter;
         // if option set then object already saved at this moment
         if(!sWorld.getConfig(CONFIG_SAVE_RESPAWN_TIME_IMMEDIATELY))
             obj->SaveRespawnTime();
-        ///- object will get delinked from the manager when deleted
+        ///- object will get delinked from the list when deleted
         delete obj;
     }
 }
@@ -279,14 +280,14 @@ ObjectGridStoper::Visit(CreatureMapType &m)
     // stop any fights at grid de-activation and remove dynobjects created at cast by creatures
     for(CreatureMapType::iterator iter=m.begin(); iter != m.end(); ++iter)
     {
-        iter->getSource()->RemoveAllDynObjects();
-        if(iter->getSource()->IsInCombat())
+        (*iter)->RemoveAllDynObjects();
+        if((*iter)->IsInCombat())
         {
-            iter->getSource()->CombatStop();
-            iter->getSource()->DeleteThreatList();
-            iter->getSource()->AI()->EnterEvadeMode();
-            if (iter->getSource()->getAI())
-                iter->getSource()->getAI()->evade();
+            (*iter)->CombatStop();
+            (*iter)->DeleteThreatList();
+            (*iter)->AI()->EnterEvadeMode();
+            if ((*iter)->getAI())
+                (*iter)->getAI()->evade();
         }
     }
 }
@@ -302,15 +303,15 @@ void
 ObjectGridCleaner::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator iter=m.begin(); iter != m.end(); ++iter)
-        iter->getSource()->CleanupsBeforeDelete();
+        (*iter)->CleanupsBeforeDelete();
 }
 
 template<class T>
 void
-ObjectGridCleaner::Visit(GridRefManager<T> &m)
+ObjectGridCleaner::Visit(GridObjectList<T> &m)
 {
-    for(typename GridRefManager<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
-        iter->getSource()->RemoveFromWorld();
+    for(typename GridObjectList<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
+        (*iter)->RemoveFromWorld();
 }
 
 template void ObjectGridUnloader::Visit(CreatureMapType &);
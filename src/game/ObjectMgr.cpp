@@ -132,6 +132,9 @@ ObjectMgr::ObjectMgr()
     m_arenaTeamId       = 1;
     m_auctionid         = 1;
 
+    m_mailExpiryRunning = false;
+    m_mailExpiryCursor  = 0;
+
     mGuildBankTabPrice.resize(GUILD_BANK_MAX_TABS);
     mGuildBankTabPrice[0] = 100;
     mGuildBankTabPrice[1] = 250;
@@ -4155,91 +4158,176 @@ void ObjectMgr::LoadNpcTextLocales()
     sLog.outString();
 }
 
-//not very fast function but it is called only once a day, or on starting-up
+// one chunk of expired mails with one row per attached item, mails without items come with a NULL item
+//                          0    1             2        3          4            5           6         7
+#define OLD_MAILS_QUERY "SELECT m.id,m.messageType,m.sender,m.receiver,m.itemTextId,m.has_items,m.checked,mi.item_guid " \
+    "FROM (SELECT id,messageType,sender,receiver,itemTextId,has_items,checked FROM mail " \
+    "WHERE expire_time < '" I64FMTD "' AND id > '%u' ORDER BY id LIMIT %u) m " \
+    "LEFT JOIN mail_items mi ON mi.mail_id = m.id ORDER BY m.id"
+
+static void AppendIdList(std::ostringstream& ss, std::vector<uint32> const& ids)
+{
+    for (std::vector<uint32>::const_iterator itr = ids.begin(); itr != ids.end(); ++itr)
+        ss << (itr == ids.begin() ? "" : ",") << *itr;
+}
+
+// called once a day and on starting-up, expired mails are handled in chunks of Mail.ExpiryChunk mails
+// with a few set based statements per chunk. While the server is up the chunks are queried asynchronously and
+// applied from the world thread result queue, so the world update never waits for them
 void ObjectMgr::ReturnOrDeleteOldMails(bool serverUp)
 {
     time_t basetime = time(NULL);
-    //delete all old mails without item and without body immediately, if starting server
+
     if (!serverUp)
+    {
+        //delete all old mails without item and without body immediately, if starting server
         CharacterDatabase.PExecute("DELETE FROM mail WHERE expire_time < '" I64FMTD "' AND has_items = '0' AND itemTextId = 0", (uint64)basetime);
-    //                                                     0  1           2      3        4          5         6           7   8       9
-    QueryResult* result = CharacterDatabase.PQuery("SELECT id,messageType,sender,receiver,itemTextId,has_items,expire_time,cod,checked,mailTemplateId FROM mail WHERE expire_time < '" I64FMTD "'", (uint64)basetime);
-    if ( !result )
-        return;                                             // any mails need to be returned or deleted
-    Field *fields;
-    //std::ostringstream delitems, delmails; //will be here for optimization
-    //bool deletemail = false, deleteitem = false;
-    //delitems << "DELETE FROM item_instance WHERE guid IN ( ";
-    //delmails << "DELETE FROM mail WHERE id IN ( "
-    do
+
+        uint32 lastId = 0;
+        while (_ReturnOrDeleteOldMailsChunk(CharacterDatabase.PQuery(OLD_MAILS_QUERY, (uint64)basetime, lastId, _GetMailExpiryChunk()), basetime, false, lastId) == _GetMailExpiryChunk())
+            ;
+        return;
+    }
+
+    // previous run still busy (big backlog), it will reach the mails expired since then next time
+    if (m_mailExpiryRunning)
+        return;
+
+    m_mailExpiryRunning = true;
+    m_mailExpiryCursor = 0;
+    CharacterDatabase.AsyncPQuery(this, &ObjectMgr::_ReturnOrDeleteOldMailsCallback, (uint64)basetime, OLD_MAILS_QUERY, (uint64)basetime, m_mailExpiryCursor, _GetMailExpiryChunk());
+}
+
+void ObjectMgr::_ReturnOrDeleteOldMailsCallback(QueryResult* result, uint64 basetime)
+{
+    uint32 lastId = m_mailExpiryCursor;
+    if (_ReturnOrDeleteOldMailsChunk(result, time_t(basetime), true, lastId) < _GetMailExpiryChunk())
     {
-        fields = result->Fetch();
-        Mail *m = new Mail;
-        m->messageID = fields[0].GetUInt32();
-        m->messageType = fields[1].GetUInt8();
-        m->sender = fields[2].GetUInt32();
-        m->receiver = fields[3].GetUInt32();
-        m->itemTextId = fields[4].GetUInt32();
-        bool has_items = fields[5].GetBool();
-        m->expire_time = (time_t)fields[6].GetUInt64();
-        m->deliver_time = 0;
-        m->COD = fields[7].GetUInt32();
-        m->checked = fields[8].GetUInt32();
-        m->mailTemplateId = fields[9].GetInt16();
-
-        Player *pl = 0;
-        if (serverUp)
-            pl = GetPlayer((uint64)m->receiver);
-        if (pl && pl->m_mailsLoaded)
-        {                                                   //this code will run very improbably (the time is between 4 and 5 am, in game is online a player, who has old mail
-            //his in mailbox and he has already listed his mails )
-            delete m;
-            continue;
-        }
-        //delete or return mail:
-        if (has_items)
-        {
-            QueryResult *resultItems = CharacterDatabase.PQuery("SELECT item_guid,item_template FROM mail_items WHERE mail_id='%u'", m->messageID);
-            if(resultItems)
-            {
-                do
-                {
-                    Field *fields2 = resultItems->Fetch();
+        m_mailExpiryRunning = false;
+        return;
+    }
 
-                    uint32 item_guid_low = fields2[0].GetUInt32();
-                    uint32 item_template = fields2[1].GetUInt32();
+    // full chunk, more expired mails may follow
+    m_mailExpiryCursor = lastId;
+    CharacterDatabase.AsyncPQuery(this, &ObjectMgr::_ReturnOrDeleteOldMailsCallback, basetime, OLD_MAILS_QUERY, basetime, m_mailExpiryCursor, _GetMailExpiryChunk());
+}
 
-                    m->AddItem(item_guid_low, item_template);
-                }
-                while (resultItems->NextRow());
+uint32 ObjectMgr::_GetMailExpiryChunk() const
+{
+    uint32 chunk = sWorld.getConfig(CONFIG_MAIL_EXPIRY_CHUNK);
+    return chunk ? chunk : 0xFFFFFFFF;
+}
 
-                delete resultItems;
+uint32 ObjectMgr::_ReturnOrDeleteOldMailsChunk(QueryResult* result, time_t basetime, bool serverUp, uint32& lastId)
+{
+    if (!result)
+        return 0;                                           // any mails need to be returned or deleted
+
+    std::vector<uint32> delMails, delItemMails, delItems, delTexts, retMails;
+    std::ostringstream retSenders, retReceivers;
+    enum { MAIL_KEEP, MAIL_RETURN, MAIL_DELETE } action = MAIL_KEEP;
+    uint32 count = 0;
+
+    do
+    {
+        Field* fields = result->Fetch();
+        uint32 mailId = fields[0].GetUInt32();
+
+        // rows of one mail are consecutive, the first one decides what happens to the mail
+        if (!count || mailId != lastId)
+        {
+            lastId = mailId;
+            ++count;
+
+            uint8 messageType = fields[1].GetUInt8();
+            uint32 sender = fields[2].GetUInt32();
+            uint32 receiver = fields[3].GetUInt32();
+            uint32 itemTextId = fields[4].GetUInt32();
+            bool has_items = fields[5].GetBool();
+            uint32 checked = fields[6].GetUInt32();
+
+            Player* pl = serverUp ? GetPlayer((uint64)receiver) : NULL;
+            if (pl && pl->m_mailsLoaded)
+            {                                               //this code will run very improbably (the time is between 4 and 5 am, in game is online a player, who has old mail
+                //his in mailbox and he has already listed his mails )
+                action = MAIL_KEEP;
+                continue;
             }
+
             //if it is mail from AH, it shouldn't be returned, but deleted
-            if (m->messageType != MAIL_NORMAL || (m->checked & (MAIL_CHECK_MASK_AUCTION | MAIL_CHECK_MASK_COD_PAYMENT | MAIL_CHECK_MASK_RETURNED)))
-            {
-                // mail open and then not returned
-                for(std::vector<MailItemInfo>::iterator itr2 = m->items.begin(); itr2 != m->items.end(); ++itr2)
-                    CharacterDatabase.PExecute("DELETE FROM item_instance WHERE guid = '%u'", itr2->item_guid);
-            }
-            else
+            if (has_items && messageType == MAIL_NORMAL && !(checked & (MAIL_CHECK_MASK_AUCTION | MAIL_CHECK_MASK_COD_PAYMENT | MAIL_CHECK_MASK_RETURNED)))
             {
                 //mail will be returned:
-                CharacterDatabase.PExecute("UPDATE mail SET sender = '%u', receiver = '%u', expire_time = '" I64FMTD "', deliver_time = '" I64FMTD "',cod = '0', checked = '%u' WHERE id = '%u'", m->receiver, m->sender, (uint64)(basetime + 30*DAY), (uint64)basetime, MAIL_CHECK_MASK_RETURNED, m->messageID);
-                delete m;
+                action = MAIL_RETURN;
+                retMails.push_back(mailId);
+                retSenders << " WHEN " << mailId << " THEN " << receiver;
+                retReceivers << " WHEN " << mailId << " THEN " << sender;
                 continue;
             }
-        }
 
-        if (m->itemTextId)
-            CharacterDatabase.PExecute("DELETE FROM item_text WHERE id = '%u'", m->itemTextId);
+            action = MAIL_DELETE;
+            delMails.push_back(mailId);
+            if (has_items)
+                delItemMails.push_back(mailId);
+            if (itemTextId)
+                delTexts.push_back(itemTextId);
+        }
 
-        //deletemail = true;
-        //delmails << m->messageID << ", ";
-        CharacterDatabase.PExecute("DELETE FROM mail WHERE id = '%u'", m->messageID);
-        delete m;
+        // mail open and then not returned
+        if (action == MAIL_DELETE)
+            if (uint32 itemGuid = fields[7].GetUInt32())
+                delItems.push_back(itemGuid);
     } while (result->NextRow());
     delete result;
+
+    // id lists may go beyond the PAppend buffer
+    SQLTransaction trans = CharacterDatabase.BeginTransaction();
+    if (!delItems.empty())
+    {
+        std::ostringstream ss;
+        ss << "DELETE FROM item_instance WHERE guid IN (";
+        AppendIdList(ss, delItems);
+        ss << ")";
+        trans->Append(ss.str().c_str());
+    }
+    if (!delTexts.empty())
+    {
+        std::ostringstream ss;
+        ss << "DELETE FROM item_text WHERE id IN (";
+        AppendIdList(ss, delTexts);
+        ss << ")";
+        trans->Append(ss.str().c_str());
+    }
+    if (!delItemMails.empty())
+    {
+        std::ostringstream ss;
+        ss << "DELETE FROM mail_items WHERE mail_id IN (";
+        AppendIdList(ss, delItemMails);
+        ss << ")";
+        trans->Append(ss.str().c_str());
+    }
+    if (!delMails.empty())
+    {
+        std::ostringstream ss;
+        ss << "DELETE FROM mail WHERE id IN (";
+        AppendIdList(ss, delMails);
+        ss << ")";
+        trans->Append(ss.str().c_str());
+    }
+    if (!retMails.empty())
+    {
+        std::ostringstream ss;
+        ss << "UPDATE mail SET sender = CASE id" << retSenders.str() << " END, receiver = CASE id" << retReceivers.str() << " END"
+            << ", expire_time = '" << uint64(basetime + 30*DAY) << "', deliver_time = '" << uint64(basetime) << "', cod = '0'"
+            << ", checked = '" << uint32(MAIL_CHECK_MASK_RETURNED) << "' WHERE id IN (";
+        AppendIdList(ss, retMails);
+        ss << ")";
+        trans->Append(ss.str().c_str());
+    }
+    if (trans->GetSize())
+        CharacterDatabase.CommitTransaction(trans);
+
+    return count;
 }
 
 void ObjectMgr::LoadQuestAreaTriggers()
@@ -994,6 +994,13 @@ class ObjectMgr
         void ConvertCreatureAddonAuras(CreatureDataAddon* addon, char const* table, char const* guidEntryStr);
         void LoadQuestRelationsHelper(QuestRelations& map,char const* table);
 
+        // old mails expiry, see ReturnOrDeleteOldMails
+        void _ReturnOrDeleteOldMailsCallback(QueryResult* result, uint64 basetime);
+        uint32 _ReturnOrDeleteOldMailsChunk(QueryResult* result, time_t basetime, bool serverUp, uint32& lastId);
+        uint32 _GetMailExpiryChunk() const;
+        bool m_mailExpiryRunning;                           // async chunks of a run still in flight
+        uint32 m_mailExpiryCursor;                          // last mail id handled by the running run
+
         typedef std::map<uint32,PetLevelInfo*> PetLevelInfoMap;
         // PetLevelInfoMap[creature_id][level]
         PetLevelInfoMap petInfo;                            // [creature_id][level]
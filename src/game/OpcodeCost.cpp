@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+/** \file
+    \ingroup u2w
+*/
+
+#include "OpcodeCost.h"
+#include "Opcodes.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "LatencyHistogram.h"
+#include "Policies/SingletonImp.h"
+#include "Config/ConfigEnv.h"
+
+#define CLASS_LOCK Trinity::ClassLevelLockable<OpcodeCostMgr, ZThread::FastMutex>
+INSTANTIATE_SINGLETON_2(OpcodeCostMgr, CLASS_LOCK);
+INSTANTIATE_CLASS_MUTEX(OpcodeCostMgr, ZThread::FastMutex);
+
+static char const* const s_deferReasonNames[MAX_OPCODE_DEFER_REASON] = { "budget", "rate_limit" };
+
+OpcodeCostMgr::OpcodeCostMgr() : i_histograms(new std::atomic<LatencyHistogram*>[NUM_MSG_TYPES]),
+    i_rateLimits(new RateLimitTable(NUM_MSG_TYPES)), i_sessionBudget(0)
+{
+    for (uint32 i = 0; i < NUM_MSG_TYPES; ++i)
+        i_histograms[i].store(NULL, std::memory_order_relaxed);
+
+    for (uint32 i = 0; i < MAX_OPCODE_DEFER_REASON; ++i)
+    {
+        std::ostringstream labels;
+        labels << "reason=\"" << s_deferReasonNames[i] << '"';
+        i_deferred[i] = sMetrics.GetCounter("wr_opcode_deferred_total", "Client packets left in the receive queue for the next session update", labels.str());
+    }
+}
+
+/// Parse "OPCODE:rate[:burst] OPCODE:rate[:burst] ..." (spaces or commas between entries)
+void OpcodeCostMgr::LoadConfig()
+{
+    i_sessionBudget.store(uint64(sConfig.GetIntDefault("Network.SessionBudget", 10000)) * 1000, std::memory_order_relaxed);
+
+    RateLimitTable* rateLimits = new RateLimitTable(NUM_MSG_TYPES);
+
+    std::string list = sConfig.GetStringDefault("Network.OpcodeRateLimits", "");
+    for (std::string::size_type pos = 0; pos < list.size();)
+    {
+        std::string::size_type end = list.find_first_of(" ,", pos);
+        if (end == std::string::npos)
+            end = list.size();
+
+        std::string entry = list.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (entry.empty())
+            continue;
+
+        std::string::size_type sep = entry.find(':');
+        if (sep == std::string::npos)
+        {
+            sLog.outError("Network.OpcodeRateLimits: entry '%s' has no rate, skipped", entry.c_str());
+            continue;
+        }
+
+        std::string name = entry.substr(0, sep);
+        uint32 opcode = 0;
+        for (; opcode < NUM_MSG_TYPES; ++opcode)
+            if (name == opcodeTable[opcode].name)
+                break;
+
+        if (opcode == NUM_MSG_TYPES)
+        {
+            sLog.outError("Network.OpcodeRateLimits: unknown opcode '%s', skipped", name.c_str());
+            continue;
+        }
+
+        OpcodeRateLimit& limit = (*rateLimits)[opcode];
+        limit.rate = float(atof(entry.c_str() + sep + 1));
+
+        std::string::size_type burstSep = entry.find(':', sep + 1);
+        limit.burst = burstSep != std::string::npos ? float(atof(entry.c_str() + burstSep + 1)) : limit.rate;
+
+        if (limit.rate <= 0.0f)
+            limit.rate = limit.burst = 0.0f;
+        else if (limit.burst < 1.0f)
+            limit.burst = 1.0f;
+    }
+
+    // sessions of the map threads read the limits meanwhile, they see either table as a whole
+    RateLimitTable const* retired = i_rateLimits.exchange(rateLimits, std::memory_order_acq_rel);
+
+    ACE_Guard<ACE_Thread_Mutex> guard(i_retiredLock);
+    i_retiredRateLimits.push_back(retired);
+}
+
+void OpcodeCostMgr::Update()
+{
+    // no session update runs between two world ticks, nothing refers to the retired tables any more
+    ACE_Guard<ACE_Thread_Mutex> guard(i_retiredLock);
+    for (std::vector<RateLimitTable const*>::const_iterator itr = i_retiredRateLimits.begin(); itr != i_retiredRateLimits.end(); ++itr)
+        delete *itr;
+    i_retiredRateLimits.clear();
+}
+
+void OpcodeCostMgr::RecordHandler(uint16 opcode, uint64 elapsedNs)
+{
+    if (opcode >= NUM_MSG_TYPES)
+        return;
+
+    _GetHistogram(opcode)->Record(elapsedNs / 1000);
+}
+
+void OpcodeCostMgr::RecordDeferred(OpcodeDeferReason reason)
+{
+    i_deferred[reason]->Add();
+}
+
+LatencyHistogram* OpcodeCostMgr::_GetHistogram(uint16 opcode)
+{
+    LatencyHistogram* histogram = i_histograms[opcode].load(std::memory_order_acquire);
+    if (histogram)
+        return histogram;
+
+    // first call of this opcode, map threads may race here, one histogram wins
+    LatencyHistogram* created = new LatencyHistogram();
+    if (!i_histograms[opcode].compare_exchange_strong(histogram, created, std::memory_order_acq_rel))
+    {
+        delete created;
+        return histogram;
+    }
+
+    std::ostringstream labels;
+    labels << "opcode=\"" << opcodeTable[opcode].name << '"';
+    sMetrics.RegisterHistogram("wr_opcode_handler_seconds", "Duration of the client packet handlers", labels.str(), created);
+    return created;
+}
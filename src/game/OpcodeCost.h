@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+/// \addtogroup u2w
+/// @{
+/// \file
+
+#ifndef TRINITY_OPCODECOST_H
+#define TRINITY_OPCODECOST_H
+
+#include "Common.h"
+#include "Policies/Singleton.h"
+#include <atomic>
+#include <vector>
+
+class LatencyHistogram;
+class MetricCounter;
+
+enum OpcodeDeferReason
+{
+    OPCODE_DEFER_BUDGET     = 0,                        // session spent its handler time of the update
+    OPCODE_DEFER_RATE_LIMIT = 1,                        // opcode sent faster than its rate limit
+    MAX_OPCODE_DEFER_REASON
+};
+
+/// Allowed rate of one opcode, per session
+struct OpcodeRateLimit
+{
+    OpcodeRateLimit() : rate(0.0f), burst(0.0f) {}
+
+    float rate;                                         // packets per second, 0 = unlimited
+    float burst;                                        // packets accepted back to back
+};
+
+/// Token bucket of a rate limited opcode in a session
+struct OpcodeRateBucket
+{
+    OpcodeRateBucket() : tokens(0.0f), lastRefill(0) {}
+
+    float tokens;
+    uint32 lastRefill;                                  // getMSTime()
+};
+
+/**
+ * Cost accounting of the opcode handlers.
+ *
+ * Every handler call is timed by WorldSession::Update and recorded in a
+ * latency histogram of its opcode, exported by the metrics listener as
+ * wr_opcode_handler_seconds{opcode="..."}. Histograms are created on the
+ * first call of an opcode, most opcodes are never seen.
+ *
+ * Also holds the limits applied by WorldSession::Update: the handler time
+ * a session may spend per update (Network.SessionBudget) and the per
+ * opcode rate limits (Network.OpcodeRateLimits). Packets over a limit stay
+ * in the receive queue for the next update, a client flooding long enough
+ * fills its queue and is disconnected.
+ */
+class OpcodeCostMgr : public Trinity::Singleton<OpcodeCostMgr, Trinity::ClassLevelLockable<OpcodeCostMgr, ZThread::FastMutex> >
+{
+    friend class Trinity::OperatorNew<OpcodeCostMgr>;
+    OpcodeCostMgr();
+    OpcodeCostMgr(const OpcodeCostMgr &);
+    OpcodeCostMgr& operator=(const OpcodeCostMgr &);
+
+    public:
+        /// Read the limits from the configuration, done at startup and on config reload
+        void LoadConfig();
+        /// Free the limits swapped out by LoadConfig, called by the world thread between two ticks
+        void Update();
+
+        /// Handler time of one session per update in nanoseconds, 0 if unlimited
+        uint64 GetSessionBudget() const { return i_sessionBudget.load(std::memory_order_relaxed); }
+        OpcodeRateLimit const& GetRateLimit(uint16 opcode) const { return (*i_rateLimits.load(std::memory_order_acquire))[opcode]; }
+
+        /// Record one handler call, may be called from any thread, takes no lock
+        void RecordHandler(uint16 opcode, uint64 elapsedNs);
+        /// Record a packet left in the queue for the next update
+        void RecordDeferred(OpcodeDeferReason reason);
+
+    private:
+        LatencyHistogram* _GetHistogram(uint16 opcode);
+
+        std::atomic<LatencyHistogram*>* i_histograms;       // NUM_MSG_TYPES, never freed, the metrics registry points to them
+        MetricCounter* i_deferred[MAX_OPCODE_DEFER_REASON];
+        typedef std::vector<OpcodeRateLimit> RateLimitTable;
+
+        std::atomic<RateLimitTable const*> i_rateLimits;    // NUM_MSG_TYPES, swapped as a whole at reload
+        std::vector<RateLimitTable const*> i_retiredRateLimits;    // sessions may still hold a limit of them until the tick ends
+        ACE_Thread_Mutex i_retiredLock;
+        std::atomic<uint64> i_sessionBudget;
+};
+
+#define sOpcodeCost OpcodeCostMgr::Instance()
+#endif
+/// @}
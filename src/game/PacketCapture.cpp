@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+/** \file
+    \ingroup u2w
+*/
+
+#include "PacketCapture.h"
+#include "WorldPacket.h"
+#include "Timer.h"
+#include "Policies/SingletonImp.h"
+#include "Config/ConfigEnv.h"
+
+#define CLASS_LOCK Trinity::ClassLevelLockable<PacketCapture, ZThread::FastMutex>
+INSTANTIATE_SINGLETON_2(PacketCapture, CLASS_LOCK);
+INSTANTIATE_CLASS_MUTEX(PacketCapture, ZThread::FastMutex);
+
+/// Client build written in the file header
+#define PACKET_CAPTURE_CLIENT_BUILD 8606
+
+/// Open the capture file (if specified so in the configuration file)
+void PacketCapture::Initialize()
+{
+    std::string logsDir = sConfig.GetStringDefault("LogsDir","");
+
+    if(!logsDir.empty())
+    {
+        if((logsDir.at(logsDir.length()-1)!='/') && (logsDir.at(logsDir.length()-1)!='\\'))
+            logsDir.append("/");
+    }
+
+    std::string filename = sConfig.GetStringDefault("PacketCaptureFile", "");
+    if(filename.empty())
+        return;
+
+    i_file = fopen((logsDir+filename).c_str(), "wb");
+    if(!i_file)
+        return;
+
+    // records are small, let stdio batch the writes
+    setvbuf(i_file, NULL, _IOFBF, 256*1024);
+
+    PacketCaptureFileHeader header;
+    header.magic = PACKET_CAPTURE_MAGIC;
+    header.version = PACKET_CAPTURE_VERSION;
+    header.build = PACKET_CAPTURE_CLIENT_BUILD;
+    header.startTime = uint64(time(NULL));
+    fwrite(&header, sizeof(header), 1, i_file);
+
+    i_startTime = getMSTime();
+}
+
+uint32 PacketCapture::OpenSession(uint32 accountId, std::string const& account)
+{
+    if(!IsActive())
+        return 0;
+
+    std::vector<uint8> payload(4 + account.size());
+    memcpy(&payload[0], &accountId, 4);
+    if(!account.empty())
+        memcpy(&payload[4], account.c_str(), account.size());
+
+    Guard guard(*this);
+    uint32 session = ++i_nextSession;
+    WriteRecord(CAPTURE_SESSION_OPEN, session, 0, &payload[0], payload.size());
+    return session;
+}
+
+void PacketCapture::CapturePacket(uint32 session, WorldPacket const& packet)
+{
+    if(!IsActive() || !session)
+        return;
+
+    Guard guard(*this);
+    WriteRecord(CAPTURE_CLIENT_PACKET, session, packet.GetOpcode(), packet.size() ? packet.contents() : NULL, packet.size());
+}
+
+void PacketCapture::CloseSession(uint32 session)
+{
+    if(!IsActive() || !session)
+        return;
+
+    Guard guard(*this);
+    WriteRecord(CAPTURE_SESSION_CLOSE, session, 0, NULL, 0);
+    // a closed session is a good point for the file to be replayable
+    fflush(i_file);
+}
+
+/// Write one record, the lock must be held
+void PacketCapture::WriteRecord(uint8 type, uint32 session, uint16 opcode, uint8 const* data, uint32 size)
+{
+    PacketCaptureRecordHeader header;
+    header.type = type;
+    header.session = session;
+    header.time = GetMSTimeDiffToNow(i_startTime);
+    header.opcode = opcode;
+    header.size = size;
+
+    fwrite(&header, sizeof(header), 1, i_file);
+    if(size)
+        fwrite(data, size, 1, i_file);
+}
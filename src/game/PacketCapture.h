@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+/// \addtogroup u2w
+/// @{
+/// \file
+
+#ifndef TRINITY_PACKETCAPTURE_H
+#define TRINITY_PACKETCAPTURE_H
+
+#include "Common.h"
+#include "Policies/Singleton.h"
+#include "PacketCaptureDefines.h"
+
+class WorldPacket;
+
+/// Binary capture of the client packets, for replaying sessions (see PacketCaptureDefines.h)
+class PacketCapture : public Trinity::Singleton<PacketCapture, Trinity::ClassLevelLockable<PacketCapture, ZThread::FastMutex> >
+{
+    friend class Trinity::OperatorNew<PacketCapture>;
+    PacketCapture() : i_file(NULL), i_startTime(0), i_nextSession(0) { Initialize(); }
+    PacketCapture(const PacketCapture &);
+    PacketCapture& operator=(const PacketCapture &);
+    typedef Trinity::ClassLevelLockable<PacketCapture, ZThread::FastMutex>::Lock Guard;
+
+    /// Close the file in destructor
+    ~PacketCapture()
+    {
+        if( i_file != NULL )
+            fclose(i_file);
+        i_file = NULL;
+    }
+
+    public:
+        void Initialize();
+        /// Is the capture active?
+        inline bool IsActive(void) const { return (i_file != NULL); }
+
+        /// Start capturing an authenticated connection, returns its capture id (0 if the capture is not active)
+        uint32 OpenSession(uint32 accountId, std::string const& account);
+        /// Record a client packet of a captured connection
+        void CapturePacket(uint32 session, WorldPacket const& packet);
+        /// End of a captured connection
+        void CloseSession(uint32 session);
+
+    private:
+        void WriteRecord(uint8 type, uint32 session, uint16 opcode, uint8 const* data, uint32 size);
+
+        FILE *i_file;
+        uint32 i_startTime;                                 // getMSTime() at the capture start
+        uint32 i_nextSession;
+};
+
+#define sPacketCapture PacketCapture::Instance()
+#endif
+/// @}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/// \addtogroup u2w
+/// @{
+/// \file
+
+#ifndef TRINITY_PACKETCAPTUREDEFINES_H
+#define TRINITY_PACKETCAPTUREDEFINES_H
+
+#include "Platform/Define.h"
+
+/*
+ * Binary packet capture, written by the worldserver (PacketCaptureFile)
+ * and read by the replay tool (contrib/packetreplay).
+ *
+ * The file starts with a PacketCaptureFileHeader followed by records,
+ * each one a PacketCaptureRecordHeader and size bytes of payload.
+ * All values are little endian. Only decrypted client packets of
+ * authenticated sessions are captured, CMSG_AUTH_SESSION is not.
+ *
+ * CAPTURE_SESSION_OPEN  payload: uint32 account id, account name (size - 4 bytes, no terminator)
+ * CAPTURE_CLIENT_PACKET payload: packet body, opcode in the record header
+ * CAPTURE_SESSION_CLOSE payload: none
+ */
+
+#define PACKET_CAPTURE_MAGIC    0x43505257              // "WRPC"
+#define PACKET_CAPTURE_VERSION  1
+
+enum PacketCaptureRecordType
+{
+    CAPTURE_SESSION_OPEN    = 1,
+    CAPTURE_CLIENT_PACKET   = 2,
+    CAPTURE_SESSION_CLOSE   = 3
+};
+
+#if defined( __GNUC__ )
+#pragma pack(1)
+#else
+#pragma pack(push,1)
+#endif
+
+struct PacketCaptureFileHeader
+{
+    uint32 magic;
+    uint32 version;
+    uint32 build;                                           // client build of the captured sessions
+    uint64 startTime;                                       // unix time of the capture start
+};
+
+struct PacketCaptureRecordHeader
+{
+    uint8  type;                                            // PacketCaptureRecordType
+    uint32 session;                                         // capture id of the connection
+    uint32 time;                                            // ms since the capture start
+    uint16 opcode;
+    uint32 size;                                            // payload bytes following the header
+};
+
+#if defined( __GNUC__ )
+#pragma pack()
+#else
+#pragma pack(pop)
+#endif
+
+#endif
+/// @}
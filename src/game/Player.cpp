@@ -1207,6 +1207,8 @@ void Player::SetDrunkValue(uint16 newDrunkenValue, uint32 itemId)
 
 void Player::Update( uint32 p_time )
 {
+    PROFILE;
+
     if(!IsInWorld())
         return;
 
@@ -15519,8 +15521,6 @@ void Player::_LoadIntoDataField(const char* data, uint32 startOffset, uint32 cou
 void Player::_LoadAuras(QueryResult *result, uint32 timediff)
 {
     m_Auras.clear();
-    for (int i = 0; i < TOTAL_AURAS; i++)
-        m_modAuras[i].clear();
 
     // all aura related fields
     for(int i = UNIT_FIELD_AURA; i <= UNIT_FIELD_AURASTATE; ++i)
@@ -16789,51 +16789,39 @@ void Player::_SaveAuras(SQLTransaction trans)
     if (auras.empty())
         return;
 
-    spellEffectPair lastEffectPair = auras.begin()->first;
-    uint32 stackCounter = 1;
-
-    for(AuraMap::const_iterator itr = auras.begin(); ; ++itr)
+    // only the last applied aura of each spell effect is saved
+    std::set<spellEffectPair> savedEffects;
+    for (AuraMap::const_iterator itr = auras.begin(); itr != auras.end(); ++itr)
     {
-        if(itr == auras.end() || lastEffectPair != itr->first)
-        {
-            AuraMap::const_iterator itr2 = itr;
-            // save previous spellEffectPair to db
-            itr2--;
-            SpellEntry const *spellInfo = itr2->second->GetSpellProto();
+        if (!savedEffects.insert(itr->first).second)
+            continue;
 
-            //skip all auras from spells that are passive or need a shapeshift
-            if (!(itr2->second->IsPassive() || itr2->second->IsRemovedOnShapeLost()))
-            {
-                //do not save single target auras (unless they were cast by the player)
-                if (!(itr2->second->GetCasterGUID() != GetGUID() && IsSingleTargetSpell(spellInfo)))
-                {
-                    uint8 i;
-                    // or apply at cast SPELL_AURA_MOD_SHAPESHIFT or SPELL_AURA_MOD_STEALTH auras
-                    for (i = 0; i < 3; i++)
-                        if (spellInfo->EffectApplyAuraName[i] == SPELL_AURA_MOD_SHAPESHIFT ||
-                        spellInfo->EffectApplyAuraName[i] == SPELL_AURA_MOD_STEALTH)
-                            break;
+        Aura* aura = NULL;
+        for (AuraMap::const_iterator itr2 = auras.lower_bound(itr->first); itr2 != auras.end(); ++itr2)
+            aura = itr2->second;
 
-                    if (i == 3)
-                    {
-                        trans->PAppend("INSERT INTO character_aura (guid,caster_guid,spell,effect_index,stackcount,amount,maxduration,remaintime,remaincharges) "
-                            "VALUES ('%u', '" I64FMTD "' ,'%u', '%u', '%u', '%d', '%d', '%d', '%d')",
-                            GetGUIDLow(), itr2->second->GetCasterGUID(), (uint32)itr2->second->GetId(), (uint32)itr2->second->GetEffIndex(), (uint32)itr2->second->GetStackAmount(), itr2->second->GetModifier()->m_amount,int(itr2->second->GetAuraMaxDuration()),int(itr2->second->GetAuraDuration()),int(itr2->second->m_procCharges));
-                    }
-                }
-            }
+        SpellEntry const *spellInfo = aura->GetSpellProto();
+
+        //skip all auras from spells that are passive or need a shapeshift
+        if (aura->IsPassive() || aura->IsRemovedOnShapeLost())
+            continue;
 
-            if(itr == auras.end())
+        //do not save single target auras (unless they were cast by the player)
+        if (aura->GetCasterGUID() != GetGUID() && IsSingleTargetSpell(spellInfo))
+            continue;
+
+        uint8 i;
+        // or apply at cast SPELL_AURA_MOD_SHAPESHIFT or SPELL_AURA_MOD_STEALTH auras
+        for (i = 0; i < 3; i++)
+            if (spellInfo->EffectApplyAuraName[i] == SPELL_AURA_MOD_SHAPESHIFT ||
+            spellInfo->EffectApplyAuraName[i] == SPELL_AURA_MOD_STEALTH)
                 break;
-        }
 
-        //TODO: if need delete this
-        if (lastEffectPair == itr->first)
-            stackCounter++;
-        else
+        if (i == 3)
         {
-            lastEffectPair = itr->first;
-            stackCounter = 1;
+            trans->PAppend("INSERT INTO character_aura (guid,caster_guid,spell,effect_index,stackcount,amount,maxduration,remaintime,remaincharges) "
+                "VALUES ('%u', '" I64FMTD "' ,'%u', '%u', '%u', '%d', '%d', '%d', '%d')",
+                GetGUIDLow(), aura->GetCasterGUID(), (uint32)aura->GetId(), (uint32)aura->GetEffIndex(), (uint32)aura->GetStackAmount(), aura->GetModifier()->m_amount,int(aura->GetAuraMaxDuration()),int(aura->GetAuraDuration()),int(aura->m_procCharges));
         }
     }
 }
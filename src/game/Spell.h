@@ -633,33 +633,63 @@ namespace Trinity
         Unit* i_caster;
         uint32 i_entry;
         float i_x, i_y, i_z;
+        bool i_casterReach;                                 // distance checked from the caster, sizes included
+        float i_reach;
+        std::vector<uint32> i_candidates;
 
         SpellNotifierCreatureAndPlayer(Spell &spell, std::list<Unit*> &data, float radius, const uint32 &type,
             SpellTargets TargetType = SPELL_TARGETS_ENEMY, uint32 entry = 0, float x = 0, float y = 0, float z = 0)
             : i_data(&data), i_spell(spell), i_push_type(type), i_radius(radius), i_radiusSq(radius*radius)
-            , i_TargetType(TargetType), i_entry(entry), i_x(x), i_y(y), i_z(z)
+            , i_TargetType(TargetType), i_entry(entry), i_x(x), i_y(y), i_z(z), i_casterReach(false), i_reach(radius)
         {
             i_caster = spell.GetCaster();
+
+            if(!i_caster)
+                return;
+
+            switch(i_push_type)
+            {
+                case PUSH_IN_FRONT:
+                case PUSH_IN_BACK:
+                case PUSH_IN_LINE:
+                case PUSH_IN_FRONT_180:
+                    i_casterReach = true;
+                    break;
+                default:
+                    i_casterReach = i_TargetType != SPELL_TARGETS_ENTRY && i_push_type == PUSH_SRC_CENTER;
+                    break;
+            }
+
+            if(i_casterReach)
+                i_reach = i_radius + i_caster->GetObjectSize();
         }
 
-        template<class T> inline void Visit(GridRefManager<T>  &m)
+        template<class T> inline void Visit(GridObjectList<T>  &m)
         {
             assert(i_data);
 
             if(!i_caster)
                 return;
 
-            for(typename GridRefManager<T>::iterator itr = m.begin(); itr != m.end(); ++itr)
+            // range prefilter over the position arrays of the cell, only the candidates are checked
+            if(i_casterReach)
+                m.FilterInReach(i_caster->GetPositionX(), i_caster->GetPositionY(), i_caster->GetPositionZ(), i_reach, i_candidates);
+            else
+                m.FilterInRange(i_x, i_y, i_z, i_radius, i_candidates);
+
+            for(std::vector<uint32>::const_iterator itr = i_candidates.begin(); itr != i_candidates.end(); ++itr)
             {
-                if(!itr->getSource()->IsAlive())
+                T* target = m.template getObject<T>(*itr);
+
+                if(!target->IsAlive())
                     continue;
 
-                if (itr->getSource()->GetTypeId() == TYPEID_PLAYER)
+                if (target->GetTypeId() == TYPEID_PLAYER)
                 {
-                    if ((itr->getSource()->ToPlayer())->isInFlight())
+                    if ((target->ToPlayer())->isInFlight())
                         continue;
 
-                    if ((itr->getSource()->ToPlayer())->isSpectator())
+                    if ((target->ToPlayer())->isSpectator())
                         continue;
                 } else {
                     if(i_spell.m_spellInfo->AttributesEx3 & SPELL_ATTR_EX3_PLAYERS_ONLY)
@@ -669,38 +699,38 @@ namespace Trinity
                 switch (i_TargetType)
                 {
                     case SPELL_TARGETS_ALLY:
-                        if(!itr->getSource()->isAttackableByAOE())
+                        if(!target->isAttackableByAOE())
                             continue;
 
-                        if(!i_caster->IsFriendlyTo( itr->getSource()))
+                        if(!i_caster->IsFriendlyTo( target))
                             continue;
 
-                        if((spellmgr.GetSpellCustomAttr(i_spell.m_spellInfo->Id) & SPELL_ATTR_CU_AOE_CANT_TARGET_SELF) && i_caster == itr->getSource() )
+                        if((spellmgr.GetSpellCustomAttr(i_spell.m_spellInfo->Id) & SPELL_ATTR_CU_AOE_CANT_TARGET_SELF) && i_caster == target )
                             continue;
 
                         break;
                     case SPELL_TARGETS_ENEMY:
                     {
-                        if(!itr->getSource()->isAttackableByAOE())
+                        if(!target->isAttackableByAOE())
                             continue;
 
                         Unit* check = i_caster->GetCharmerOrOwnerOrSelf();
 
                         if( check->GetTypeId()==TYPEID_PLAYER )
                         {
-                            if (check->IsFriendlyTo( itr->getSource() ))
+                            if (check->IsFriendlyTo( target ))
                                 continue;
                         }
                         else
                         {
-                            if (!check->IsHostileTo( itr->getSource() ))
+                            if (!check->IsHostileTo( target ))
                                 continue;
                         }
                         break;
                     }
                     case SPELL_TARGETS_ENTRY:
                     {
-                        if(itr->getSource()->GetEntry()!= i_entry)
+                        if(target->GetEntry()!= i_entry)
                             continue;
                         break;
                     }
@@ -711,43 +741,43 @@ namespace Trinity
                 switch(i_push_type)
                 {
                     case PUSH_IN_FRONT:
-                        if(i_caster->IsWithinDistInMap( itr->getSource(), i_radius))
+                        if(i_caster->IsWithinDistInMap( target, i_radius))
                         {
-                            if(i_caster->isInFront((Unit*)(itr->getSource()), M_PI/3 ))
-                                i_data->push_back(itr->getSource());
+                            if(i_caster->isInFront(target, M_PI/3 ))
+                                i_data->push_back(target);
                         }
                         break;
                     case PUSH_IN_BACK:
-                        if(i_caster->IsWithinDistInMap( itr->getSource(), i_radius))
+                        if(i_caster->IsWithinDistInMap( target, i_radius))
                         {
-                            if(i_caster->isInBack((Unit*)(itr->getSource()), M_PI/3 ))
-                                i_data->push_back(itr->getSource());
+                            if(i_caster->isInBack(target, M_PI/3 ))
+                                i_data->push_back(target);
                         }
                         break;
                     case PUSH_IN_LINE:
-                        if(i_caster->IsWithinDistInMap( itr->getSource(), i_radius))
+                        if(i_caster->IsWithinDistInMap( target, i_radius))
                         {
-                            if(i_caster->HasInLine(itr->getSource(), i_caster->GetObjectSize()))
-                                i_data->push_back(itr->getSource());
+                            if(i_caster->HasInLine(target, i_caster->GetObjectSize()))
+                                i_data->push_back(target);
                         }
                         break;
                     case PUSH_IN_FRONT_180:
-                        if(i_caster->IsWithinDistInMap( itr->getSource(), i_radius))
+                        if(i_caster->IsWithinDistInMap( target, i_radius))
                         {
-                            if(i_caster->isInFront((Unit*)(itr->getSource()), M_PI ))
-                                i_data->push_back(itr->getSource());
+                            if(i_caster->isInFront(target, M_PI ))
+                                i_data->push_back(target);
                         }
                         break;
                     default:
                         if(i_TargetType != SPELL_TARGETS_ENTRY && i_push_type == PUSH_SRC_CENTER && i_caster) // if caster then check distance from caster to target (because of model collision)
                         {
-                            if(i_caster->IsWithinDistInMap( itr->getSource(), i_radius, true) )
-                                i_data->push_back(itr->getSource());
+                            if(i_caster->IsWithinDistInMap( target, i_radius, true) )
+                                i_data->push_back(target);
                         }
                         else
                         {
-                            if((itr->getSource()->GetDistanceSq(i_x, i_y, i_z) < i_radiusSq))
-                                i_data->push_back(itr->getSource());
+                            if((target->GetDistanceSq(i_x, i_y, i_z) < i_radiusSq))
+                                i_data->push_back(target);
                         }
                         break;
                 }
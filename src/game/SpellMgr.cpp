@@ -29,7 +29,7 @@
 
 bool IsAreaEffectTarget[TOTAL_SPELL_TARGETS];
 
-SpellMgr::SpellMgr()
+SpellMgr::SpellMgr() : mSpellMetadataReady(false)
 {
     for(int i = 0; i < TOTAL_SPELL_EFFECTS; ++i)
     {
@@ -295,6 +295,9 @@ uint32 GetSpellCastTime(SpellEntry const* spellInfo, Spell const* spell)
 
 bool IsPassiveSpell(uint32 spellId)
 {
+    if(SpellMetadata const* meta = spellmgr.GetSpellMetadata(spellId))
+        return meta->flags & SPELL_META_PASSIVE;
+
     SpellEntry const *spellInfo = spellmgr.LookupSpell(spellId);
     if (!spellInfo)
         return false;
@@ -567,7 +570,7 @@ bool IsPositiveTarget(uint32 targetA, uint32 targetB)
     return true;
 }
 
-bool IsPositiveEffect(uint32 spellId, uint32 effIndex, bool hostileTarget)
+static bool ComputePositiveEffect(uint32 spellId, uint32 effIndex, bool hostileTarget)
 {
     SpellEntry const *spellproto = spellmgr.LookupSpell(spellId);
     if (!spellproto)
@@ -827,7 +830,16 @@ bool IsPositiveEffect(uint32 spellId, uint32 effIndex, bool hostileTarget)
     return true;
 }
 
-bool IsPositiveSpell(uint32 spellId, bool hostileTarget)
+bool IsPositiveEffect(uint32 spellId, uint32 effIndex, bool hostileTarget)
+{
+    if(effIndex < 3)
+        if(SpellMetadata const* meta = spellmgr.GetSpellMetadata(spellId))
+            return meta->positiveEffects & (hostileTarget ? SPELL_META_POSITIVE_EFFECT(effIndex) : SPELL_META_POSITIVE_FRIENDLY_EFFECT(effIndex));
+
+    return ComputePositiveEffect(spellId, effIndex, hostileTarget);
+}
+
+static bool ComputePositiveSpell(uint32 spellId, bool hostileTarget)
 {
     SpellEntry const *spellproto = spellmgr.LookupSpell(spellId);
     if (!spellproto) return false;
@@ -844,6 +856,14 @@ bool IsPositiveSpell(uint32 spellId, bool hostileTarget)
     return true;
 }
 
+bool IsPositiveSpell(uint32 spellId, bool hostileTarget)
+{
+    if(SpellMetadata const* meta = spellmgr.GetSpellMetadata(spellId))
+        return meta->flags & (hostileTarget ? SPELL_META_POSITIVE : SPELL_META_POSITIVE_FRIENDLY);
+
+    return ComputePositiveSpell(spellId, hostileTarget);
+}
+
 bool IsSingleTargetSpell(SpellEntry const *spellInfo)
 {
     // all other single target spells have if it has AttributesEx5
@@ -1025,6 +1045,7 @@ void SpellMgr::LoadSpellTargetPositions()
 
 void SpellMgr::LoadSpellAffects()
 {
+    mSpellMetadataReady = false;
     mSpellAffectMap.clear();                                // need for reload case
 
     uint32 count = 0;
@@ -1157,6 +1178,7 @@ bool SpellMgr::IsAffectedBySpell(SpellEntry const *spellInfo, uint32 spellId, ui
 
 void SpellMgr::LoadSpellProcEvents()
 {
+    mSpellMetadataReady = false;                            // points in the map, rebuilt by LoadSpellMetadata
     mSpellProcEventMap.clear();                             // need for reload case
 
     uint32 count = 0;
@@ -1366,6 +1388,7 @@ bool SpellMgr::IsSpellProcEventCanTriggeredBy(SpellProcEventEntry const * spellP
 
 void SpellMgr::LoadSpellElixirs()
 {
+    mSpellMetadataReady = false;
     mSpellElixirs.clear();                                  // need for reload case
 
     uint32 count = 0;
@@ -2336,6 +2359,7 @@ void SpellMgr::OverrideSpellItemEnchantment()
 // set data in core for now
 void SpellMgr::LoadSpellCustomAttr()
 {
+    mSpellMetadataReady = false;
     mSpellCustomAttr.resize(objmgr.GetMaxSpellId() + 1);
 
     SpellEntry* spellInfo;
@@ -3337,6 +3361,7 @@ void SpellMgr::LoadSpellCustomAttr()
 
 void SpellMgr::LoadSpellLinked()
 {
+    mSpellMetadataReady = false;
     mSpellLinkedMap.clear();    // need for reload case
     uint32 count = 0;
 
@@ -3874,9 +3899,101 @@ DiminishingReturnsType GetDiminishingReturnsGroupType(DiminishingGroup group)
 
 SpellEntry* SpellMgr::LookupSpell(uint32 id)
 {
+    if(SpellMetadata const* meta = GetSpellMetadata(id))
+        return meta->entry;
+
     return objmgr.GetSpellTemplate(id);
 }
 
+void SpellMgr::LoadSpellMetadata()
+{
+    // entries are refilled in place at reload, the array never moves once built
+    mSpellMetadataReady = false;
+    if(mSpellMetadata.size() != objmgr.GetMaxSpellId() + 1)
+        mSpellMetadata.resize(objmgr.GetMaxSpellId() + 1);
+
+    uint32 count = 0;
+    for(uint32 i = 0; i < mSpellMetadata.size(); ++i)
+    {
+        SpellMetadata& meta = mSpellMetadata[i];
+        memset(&meta, 0, sizeof(meta));
+
+        SpellEntry* spellInfo = objmgr.GetSpellTemplate(i);
+        if(!spellInfo)
+            continue;
+
+        meta.entry = spellInfo;
+        meta.elixirMask = GetSpellElixirMask(i);
+        meta.procEvent = GetSpellProcEvent(i);
+        meta.linked = GetSpellLinked(i);
+        if(SpellChainNode const* node = GetSpellChainNode(i))
+            meta.chain = *node;
+
+        if(spellInfo->Attributes & SPELL_ATTR_PASSIVE)
+            meta.flags |= SPELL_META_PASSIVE;
+        if(ComputePositiveSpell(i, true))
+            meta.flags |= SPELL_META_POSITIVE;
+        if(ComputePositiveSpell(i, false))
+            meta.flags |= SPELL_META_POSITIVE_FRIENDLY;
+        if(IsAreaOfEffectSpell(spellInfo))
+            meta.flags |= SPELL_META_AREA_OF_EFFECT;
+        if(IsChanneledSpell(spellInfo))
+            meta.flags |= SPELL_META_CHANNELED;
+
+        for(uint8 eff = 0; eff < 3; ++eff)
+        {
+            if(ComputePositiveEffect(i, eff, true))
+                meta.positiveEffects |= SPELL_META_POSITIVE_EFFECT(eff);
+            if(ComputePositiveEffect(i, eff, false))
+                meta.positiveEffects |= SPELL_META_POSITIVE_FRIENDLY_EFFECT(eff);
+
+            meta.mechanicMask |= GetSpellMechanicMask(spellInfo, eff);
+            meta.affectMask[eff] = GetSpellAffectMask(i, eff);
+        }
+
+        ++count;
+    }
+
+    // spells cast by the effects and auras of other spells
+    for(uint32 i = 0; i < mSpellMetadata.size(); ++i)
+    {
+        SpellEntry const* spellInfo = mSpellMetadata[i].entry;
+        if(!spellInfo)
+            continue;
+
+        for(uint8 eff = 0; eff < 3; ++eff)
+        {
+            uint32 triggered = spellInfo->EffectTriggerSpell[eff];
+            if(!triggered || triggered == i || triggered >= mSpellMetadata.size())
+                continue;
+
+            switch(spellInfo->Effect[eff])
+            {
+                case SPELL_EFFECT_TRIGGER_MISSILE:
+                case SPELL_EFFECT_TRIGGER_SPELL:
+                case SPELL_EFFECT_TRIGGER_SPELL_WITH_VALUE:
+                case SPELL_EFFECT_TRIGGER_SPELL_2:
+                    break;
+                case SPELL_EFFECT_APPLY_AURA:
+                    if(spellInfo->EffectApplyAuraName[eff] == SPELL_AURA_PERIODIC_TRIGGER_SPELL
+                        || spellInfo->EffectApplyAuraName[eff] == SPELL_AURA_PERIODIC_TRIGGER_SPELL_WITH_VALUE
+                        || spellInfo->EffectApplyAuraName[eff] == SPELL_AURA_PROC_TRIGGER_SPELL)
+                        break;
+                    continue;
+                default:
+                    continue;
+            }
+
+            mSpellMetadata[triggered].flags |= SPELL_META_TRIGGERED;
+        }
+    }
+
+    mSpellMetadataReady = true;
+
+    sLog.outString();
+    sLog.outString( ">> Built metadata of %u spells", count );
+}
+
 float SpellMgr::GetSpellThreatModPercent(SpellEntry const* spellInfo) const
 {
     if(spellInfo)
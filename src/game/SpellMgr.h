@@ -789,6 +789,36 @@ inline bool IsProfessionOrRidingSkill(uint32 skill)
 
 typedef std::vector<uint32> SpellCustomAttribute;
 
+// SpellMetadata flags
+enum SpellMetadataFlags
+{
+    SPELL_META_PASSIVE              = 0x00000001,
+    SPELL_META_POSITIVE             = 0x00000002,           // IsPositiveSpell on hostile target
+    SPELL_META_POSITIVE_FRIENDLY    = 0x00000004,           // IsPositiveSpell on friendly target
+    SPELL_META_AREA_OF_EFFECT       = 0x00000008,
+    SPELL_META_CHANNELED            = 0x00000010,
+    SPELL_META_TRIGGERED            = 0x00000020,           // triggered by an effect or an aura of another spell
+};
+
+// SpellMetadata::positiveEffects bits
+#define SPELL_META_POSITIVE_EFFECT(i)           (1 << (i))
+#define SPELL_META_POSITIVE_FRIENDLY_EFFECT(i)  (1 << ((i) + 4))
+
+// What the core looks up per spell, precomputed from the spell and the spell tables,
+// one entry per spell id (see SpellMgr::LoadSpellMetadata)
+struct SpellMetadata
+{
+    SpellEntry* entry;                                      // NULL if no spell has this id
+    uint32 flags;                                           // SpellMetadataFlags
+    uint32 mechanicMask;                                    // mechanic of the spell and of its effects
+    uint32 elixirMask;
+    uint8 positiveEffects;
+    SpellChainNode chain;                                   // rank 0 if the spell has no chain
+    uint64 affectMask[3];
+    SpellProcEventEntry const* procEvent;
+    std::vector<int32> const* linked;
+};
+
 typedef std::map<int32, std::vector<int32> > SpellLinkedMap;
 
 class SpellMgr
@@ -803,6 +833,9 @@ class SpellMgr
         // Spell affects
         uint64 GetSpellAffectMask(uint16 spellId, uint8 effectId) const
         {
+            if(SpellMetadata const* meta = GetSpellMetadata(spellId))
+                return meta->affectMask[effectId];
+
             SpellAffectMap::const_iterator itr = mSpellAffectMap.find((spellId<<8) + effectId);
             if( itr != mSpellAffectMap.end( ) )
                 return itr->second;
@@ -829,6 +862,9 @@ class SpellMgr
 
         uint32 GetSpellElixirMask(uint32 spellid) const
         {
+            if(SpellMetadata const* meta = GetSpellMetadata(spellid))
+                return meta->elixirMask;
+
             SpellElixirMap::const_iterator itr = mSpellElixirs.find(spellid);
             if(itr==mSpellElixirs.end())
                 return 0x0;
@@ -854,6 +890,9 @@ class SpellMgr
         // Spell proc events
         SpellProcEventEntry const* GetSpellProcEvent(uint32 spellId) const
         {
+            if(SpellMetadata const* meta = GetSpellMetadata(spellId))
+                return meta->procEvent;
+
             SpellProcEventMap::const_iterator itr = mSpellProcEventMap.find(spellId);
             if( itr != mSpellProcEventMap.end( ) )
                 return &itr->second;
@@ -882,6 +921,9 @@ class SpellMgr
         // Spell ranks chains
         SpellChainNode const* GetSpellChainNode(uint32 spell_id) const
         {
+            if(SpellMetadata const* meta = GetSpellMetadata(spell_id))
+                return meta->chain.rank ? &meta->chain : NULL;
+
             SpellChainMap::const_iterator itr = mSpellChains.find(spell_id);
             if(itr == mSpellChains.end())
                 return NULL;
@@ -1047,10 +1089,23 @@ class SpellMgr
 
         const std::vector<int32> *GetSpellLinked(int32 spell_id) const
         {
+            if(spell_id > 0)
+                if(SpellMetadata const* meta = GetSpellMetadata(spell_id))
+                    return meta->linked;
+
             SpellLinkedMap::const_iterator itr = mSpellLinkedMap.find(spell_id);
             return itr != mSpellLinkedMap.end() ? &(itr->second) : NULL;
         }
 
+        // NULL until LoadSpellMetadata is done and for ids above the highest spell id
+        SpellMetadata const* GetSpellMetadata(uint32 spell_id) const
+        {
+            if(!mSpellMetadataReady || spell_id >= mSpellMetadata.size())
+                return NULL;
+
+            return &mSpellMetadata[spell_id];
+        }
+
         SpellEffectTargetTypes EffectTargetType[TOTAL_SPELL_EFFECTS];
         SpellSelectTargetTypes SpellTargetType[TOTAL_SPELL_TARGETS];
 
@@ -1081,6 +1136,7 @@ class SpellMgr
         void OverrideSpellItemEnchantment();
         void LoadSpellLinked();
         void LoadSpellEnchantProcData();
+        void LoadSpellMetadata();                           // must be after all other spell tables
         SpellEntry* LookupSpell(uint32 id);
 
     private:
@@ -1099,6 +1155,8 @@ class SpellMgr
         SpellCustomAttribute  mSpellCustomAttr;
         SpellLinkedMap      mSpellLinkedMap;
         SpellEnchantProcEventMap     mSpellEnchantProcEventMap;
+        std::vector<SpellMetadata> mSpellMetadata;
+        bool mSpellMetadataReady;                           // false while the tables it is built from are loaded
 };
 
 #define spellmgr SpellMgr::Instance()
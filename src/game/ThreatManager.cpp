@@ -65,6 +65,8 @@ HostilReference::HostilReference(Unit* pUnit, ThreatManager *pThreatManager, flo
     iUnitGuid = pUnit->GetGUID();
     iOnline = true;
     iAccessible = true;
+    iHeapIndex = 0;
+    iSequence = 0;
 }
 
 //============================================================
@@ -202,30 +204,40 @@ Unit* HostilReference::getSourceUnit()
 
 void ThreatContainer::clearReferences()
 {
-    for(std::list<HostilReference*>::iterator i = iThreatList.begin(); i != iThreatList.end(); ++i)
+    for(std::list<HostilReference*>::const_iterator i = iReferences.list().begin(); i != iReferences.list().end(); ++i)
     {
         (*i)->unlink();
         delete (*i);
     }
-    iThreatList.clear();
+    iReferences.clear();
+}
+
+//============================================================
+
+void ThreatContainer::addReference(HostilReference* pHostilReference)
+{
+    iReferences.add(pHostilReference);
+}
+
+//============================================================
+
+void ThreatContainer::remove(HostilReference* pRef)
+{
+    iReferences.remove(pRef);                               // nothing if not in this container
+}
+
+//============================================================
+
+void ThreatContainer::threatChanged(HostilReference* pRef)
+{
+    iReferences.update(pRef);
 }
 
 //============================================================
 // Return the HostilReference of NULL, if not found
 HostilReference* ThreatContainer::getReferenceByTarget(Unit* pVictim)
 {
-    HostilReference* result = NULL;
-    uint64 guid = pVictim->GetGUID();
-    for(std::list<HostilReference*>::iterator i = iThreatList.begin(); i != iThreatList.end(); ++i)
-    {
-        if((*i)->getUnitGuid() == guid)
-        {
-            result = (*i);
-            break;
-        }
-    }
-
-    return result;
+    return iReferences.find(pVictim->GetGUID());
 }
 
 //============================================================
@@ -257,22 +269,11 @@ void ThreatContainer::modifyThreatPercent(Unit *pVictim, int32 pPercent)
 
 //============================================================
 
-bool HostilReferenceSortPredicate(const HostilReference* lhs, const HostilReference* rhs)
-{
-    // std::list::sort ordering predicate must be: (Pred(x,y)&&Pred(y,x))==false
-    return lhs->getThreat() > rhs->getThreat();             // reverse sorting
-}
+// Sort the list if the threat changed since it was last sorted
 
-//============================================================
-// Check if the list is dirty and sort if necessary
-
-void ThreatContainer::update()
+std::list<HostilReference*>& ThreatContainer::getThreatList()
 {
-    if(iDirty && iThreatList.size() >1)
-    {
-        iThreatList.sort(HostilReferenceSortPredicate);
-    }
-    iDirty = false;
+    return iReferences.getSorted();
 }
 
 //============================================================
@@ -285,12 +286,13 @@ HostilReference* ThreatContainer::selectNextVictim(Creature* pAttacker, HostilRe
     HostilReference* fallback = NULL;
     bool found = false;
 
-    std::list<HostilReference*>::iterator lastRef = iThreatList.end();
-    lastRef--;
+    // references in threat order, usually only the first few are looked at
+    ReferenceSet::Walker walker(iReferences.heap());
+    uint32 remaining = iReferences.size();
 
-    for(std::list<HostilReference*>::iterator iter = iThreatList.begin(); iter != iThreatList.end() && !found; ++iter)
+    while(!found && (currentRef = walker.Next()))
     {
-        currentRef = (*iter);
+        bool lastRef = --remaining == 0;
 
         Unit* target = currentRef->getTarget();
         assert(target);                                     // if the ref has status online the target must be there !
@@ -299,7 +301,7 @@ HostilReference* ThreatContainer::selectNextVictim(Creature* pAttacker, HostilRe
             fallback = currentRef;
 
         // some units are preferred in comparison to others
-        if(iter != lastRef && (target->IsImmunedToDamage(pAttacker->GetMeleeDamageSchoolMask(), false) ||
+        if(!lastRef && (target->IsImmunedToDamage(pAttacker->GetMeleeDamageSchoolMask(), false) ||
                 target->HasUnitState(UNIT_STAT_CONFUSED) || (pAttacker->isWorldBoss() && target->HasAura(30300))
                 ) )
         {
@@ -450,7 +452,6 @@ void ThreatManager::modifyThreatPercent(Unit *pVictim, int32 pPercent)
 
 Unit* ThreatManager::getHostilTarget()
 {
-    iThreatContainer.update();
     HostilReference* nextVictim = iThreatContainer.selectNextVictim(getOwner()->ToCreature(), getCurrentVictim());
     setCurrentVictim(nextVictim);
     return getCurrentVictim() != NULL ? getCurrentVictim()->getTarget() : NULL;
@@ -537,35 +538,29 @@ bool ThreatManager::processThreatEvent(const UnitBaseEvent* pUnitBaseEvent)
     switch(pUnitBaseEvent->getType())
     {
         case UEV_THREAT_REF_THREAT_CHANGE:
-            if((getCurrentVictim() == hostilReference && threatRefStatusChangeEvent->getFValue()<0.0f) ||
-                (getCurrentVictim() != hostilReference && threatRefStatusChangeEvent->getFValue()>0.0f))
-                setDirty(true);                             // the order in the threat list might have changed
+            // the order in the threat list might have changed
+            if(hostilReference->isOnline())
+                iThreatContainer.threatChanged(hostilReference);
+            else
+                iThreatOfflineContainer.threatChanged(hostilReference);
             break;
         case UEV_THREAT_REF_ONLINE_STATUS:
             if(!hostilReference->isOnline())
             {
                 if (hostilReference == getCurrentVictim())
-                {
                     setCurrentVictim(NULL);
-                    setDirty(true);
-                }
                 iThreatContainer.remove(hostilReference);
                 iThreatOfflineContainer.addReference(hostilReference);
             }
             else
             {
-                if(getCurrentVictim() && hostilReference->getThreat() > (1.1f * getCurrentVictim()->getThreat()))
-                    setDirty(true);
-                iThreatContainer.addReference(hostilReference);
                 iThreatOfflineContainer.remove(hostilReference);
+                iThreatContainer.addReference(hostilReference);
             }
             break;
         case UEV_THREAT_REF_REMOVE_FROM_LIST:
             if (hostilReference == getCurrentVictim())
-            {
                 setCurrentVictim(NULL);
-                setDirty(true);
-            }
             if(hostilReference->isOnline())
                 iThreatContainer.remove(hostilReference);
             else
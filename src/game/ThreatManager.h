@@ -25,6 +25,7 @@
 #include "SharedDefines.h"
 #include "Utilities/LinkedReference/Reference.h"
 #include "UnitEvents.h"
+#include "ThreatReferenceSet.h"
 
 #include <list>
 
@@ -49,11 +50,19 @@ class ThreatCalcHelper
 class HostilReference : public Reference<Unit, ThreatManager>
 {
     private:
+        friend class ThreatContainer;
+        friend struct HostilReferenceHeapTraits;
+
         float iThreat;
         float iTempThreatModifyer;                          // used for taunt
         uint64 iUnitGuid;
         bool iOnline;
         bool iAccessible;
+
+        // position in the container holding the reference
+        uint32 iHeapIndex;
+        uint32 iSequence;                                   // order of insertion, breaks threat ties
+        std::list<HostilReference*>::iterator iListPos;
     private:
         // Inform the source, that the status of that reference was changed
         void fireStatusChanged(const ThreatRefStatusChangeEvent& pThreatRefStatusChangeEvent);
@@ -127,24 +136,46 @@ class HostilReference : public Reference<Unit, ThreatManager>
         void sourceObjectDestroyLink();
 };
 
+//==============================================================
+// Highest threat first, on equal threat the first added
+
+struct HostilReferenceHeapTraits
+{
+    static bool Less(HostilReference const* lhs, HostilReference const* rhs)
+    {
+        if (lhs->iThreat != rhs->iThreat)
+            return lhs->iThreat < rhs->iThreat;
+        return lhs->iSequence > rhs->iSequence;
+    }
+
+    static uint32& Index(HostilReference* ref) { return ref->iHeapIndex; }
+    static uint32& Sequence(HostilReference* ref) { return ref->iSequence; }
+    static uint64 Guid(HostilReference const* ref) { return ref->iUnitGuid; }
+    static std::list<HostilReference*>::iterator& ListPos(HostilReference* ref) { return ref->iListPos; }
+};
+
 //==============================================================
 class ThreatManager;
 
+// References are kept in a heap on threat, threat changes move one reference in O(log n) and
+// victim selection walks the references in threat order from the heap. The list given to the
+// scripts holds the same references and is only sorted when it is asked for.
 class ThreatContainer
 {
     private:
-        std::list<HostilReference*> iThreatList;
-        bool iDirty;
+        typedef ThreatReferenceSet<HostilReference, HostilReferenceHeapTraits> ReferenceSet;
+
+        ReferenceSet iReferences;
     protected:
         friend class ThreatManager;
 
-        void remove(HostilReference* pRef) { iThreatList.remove(pRef); }
-        void addReference(HostilReference* pHostilReference) { iThreatList.push_back(pHostilReference); }
+        void remove(HostilReference* pRef);
+        void addReference(HostilReference* pHostilReference);
         void clearReferences();
-        // Sort the list if necessary
-        void update();
+        // the threat of pRef changed, restore the order
+        void threatChanged(HostilReference* pRef);
     public:
-        ThreatContainer() { iDirty = false; }
+        ThreatContainer() {}
         ~ThreatContainer() { clearReferences(); }
 
         HostilReference* addThreat(Unit* pVictim, float pThreat);
@@ -153,17 +184,14 @@ class ThreatContainer
 
         HostilReference* selectNextVictim(Creature* pAttacker, HostilReference* pCurrentVictim);
 
-        void setDirty(bool pDirty) { iDirty = pDirty; }
-
-        bool isDirty() { return iDirty; }
+        bool empty() { return(iReferences.empty()); }
 
-        bool empty() { return(iThreatList.empty()); }
-
-        HostilReference* getMostHated() { return iThreatList.empty() ? NULL : iThreatList.front(); }
+        HostilReference* getMostHated() { return iReferences.top(); }
 
         HostilReference* getReferenceByTarget(Unit* pVictim);
 
-        std::list<HostilReference*>& getThreatList() { return iThreatList; }
+        // sorted by threat, sorting keeps the list nodes so iterators stay valid
+        std::list<HostilReference*>& getThreatList();
 };
 
 //=================================================
@@ -208,8 +236,6 @@ class ThreatManager
 
         void setCurrentVictim(HostilReference* pHostilReference);
 
-        void setDirty(bool pDirty) { iThreatContainer.setDirty(pDirty); }
-
         // methods to access the lists from the outside to do sume dirty manipulation (scriping and such)
         // I hope they are used as little as possible.
         inline std::list<HostilReference*>& getThreatList() { return iThreatContainer.getThreatList(); }
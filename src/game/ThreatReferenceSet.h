@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef _THREATREFERENCESET_H
+#define _THREATREFERENCESET_H
+
+#include "Platform/Define.h"
+#include "Utilities/IndexedHeap.h"
+#include "Utilities/UnorderedMap.h"
+
+#include <list>
+
+/*
+ * References of one threat container: an indexed heap ordered on threat for the victim selection,
+ * a guid map for the lookups and the list handed to scripts, sorted only when it is requested after
+ * a change. std::list::sort keeps the nodes, so iterators of the list stay valid.
+ * Traits provides, besides Less and Index of the heap:
+ *   static uint32& Sequence(T* ref)                      - order of insertion, breaks threat ties in Less
+ *   static uint64 Guid(T const* ref)                     - key of the map
+ *   static typename std::list<T*>::iterator& ListPos(T* ref) - position in the list
+ */
+template<class T, class Traits>
+class ThreatReferenceSet
+{
+    public:
+        typedef IndexedHeap<T, Traits> Heap;
+        typedef typename Heap::OrderedWalker Walker;       // threat order, without touching the set
+
+        ThreatReferenceSet() : m_sequence(0), m_sorted(true) {}
+
+        bool empty() const { return m_list.empty(); }
+        uint32 size() const { return m_heap.size(); }
+        T* top() const { return m_heap.top(); }
+        Heap const& heap() const { return m_heap; }
+
+        void add(T* ref)
+        {
+            Traits::Sequence(ref) = m_sequence++;
+            Traits::ListPos(ref) = m_list.insert(m_list.end(), ref);
+            m_heap.push(ref);
+            m_refs[Traits::Guid(ref)] = ref;
+            m_sorted = false;
+        }
+
+        // false if the reference is not in this set
+        bool remove(T* ref)
+        {
+            if (!m_heap.remove(ref))
+                return false;
+
+            m_list.erase(Traits::ListPos(ref));
+            m_refs.erase(Traits::Guid(ref));
+            return true;
+        }
+
+        // the threat of ref changed, restore the order
+        void update(T* ref)
+        {
+            m_heap.update(ref);
+            m_sorted = false;
+        }
+
+        T* find(uint64 guid) const
+        {
+            typename UNORDERED_MAP<uint64, T*>::const_iterator itr = m_refs.find(guid);
+            return itr != m_refs.end() ? itr->second : NULL;
+        }
+
+        // unsorted, for walks that do not care about the order
+        std::list<T*> const& list() const { return m_list; }
+
+        std::list<T*>& getSorted()
+        {
+            if (!m_sorted)
+            {
+                m_list.sort(SortPredicate);
+                m_sorted = true;
+            }
+            return m_list;
+        }
+
+        void clear()
+        {
+            m_list.clear();
+            m_heap.clear();
+            m_refs.clear();
+            m_sorted = true;
+        }
+
+    private:
+        static bool SortPredicate(T const* lhs, T const* rhs) { return Traits::Less(rhs, lhs); }   // reverse sorting
+
+        std::list<T*> m_list;
+        Heap m_heap;
+        UNORDERED_MAP<uint64, T*> m_refs;
+        uint32 m_sequence;
+        bool m_sorted;
+};
+
+#endif
@@ -177,7 +177,6 @@ Unit::Unit()
     //m_removeAuraTimer = 4;
     //tmpAura = NULL;
 
-    m_AurasUpdateIterator = m_Auras.end();
     m_Visibility = VISIBILITY_ON;
 
     m_interruptMask = 0;
@@ -285,24 +284,12 @@ Unit::~Unit()
     assert(!m_attacking);
     assert(m_attackers.empty());
     assert(m_sharedVision.empty());
-
-#ifdef WITH_UNIT_CRASHFIX
-    for (unsigned int i = 0; i < TOTAL_AURAS; i++) {
-        if (m_modAuras[i]._M_impl._M_node._M_prev == NULL) {
-            sLog.outError("AURA:Corrupted m_modAuras _M_prev (%p) at index %d (higuid %d loguid %d)", m_modAuras, i, GetGUIDHigh(), GetGUIDLow());
-            m_modAuras[i]._M_impl._M_node._M_prev = m_modAuras[i]._M_impl._M_node._M_next;
-        }
-
-        if (m_modAuras[i]._M_impl._M_node._M_next == NULL) {
-            sLog.outError("AURA:Corrupted m_modAuras _M_next (%p) at index %d (higuid %d loguid %d)", m_modAuras, i, GetGUIDHigh(), GetGUIDLow());
-            m_modAuras[i]._M_impl._M_node._M_next = m_modAuras[i]._M_impl._M_node._M_prev;
-        }
-    }
-#endif
 }
 
 void Unit::Update( uint32 p_time )
 {
+    PROFILE;
+
     /*if(p_time > m_AurasCheck)
     {
     m_AurasCheck = 2000;
@@ -685,40 +672,20 @@ void Unit::RemoveMovementImpairingAuras()
 void Unit::RemoveSpellsCausingAura(AuraType auraType)
 {
     if (auraType >= TOTAL_AURAS) return;
-    AuraList::iterator iter, next;
-    for (iter = m_modAuras[auraType].begin(); iter != m_modAuras[auraType].end(); iter = next)
-    {
-        next = iter;
-        ++next;
 
-        if (*iter)
-        {
-            RemoveAurasDueToSpell((*iter)->GetId());
-            if (!m_modAuras[auraType].empty())
-                next = m_modAuras[auraType].begin();
-            else
-                return;
-        }
-    }
+    // removed entries are skipped, iteration can continue after nested removals
+    AuraList const& auras = GetAurasByType(auraType);
+    for (AuraList::const_iterator iter = auras.begin(); iter != auras.end(); ++iter)
+        RemoveAurasDueToSpell((*iter)->GetId());
 }
 
 void Unit::RemoveAuraTypeByCaster(AuraType auraType, uint64 casterGUID)
 {
     if (auraType >= TOTAL_AURAS) return;
 
-    for(AuraList::iterator iter = m_modAuras[auraType].begin(); iter != m_modAuras[auraType].end(); )
-    {
-        Aura *aur = *iter;
-        ++iter;
-
-        if (aur)
-        {
-            uint32 removedAuras = m_removedAurasCount;
-            RemoveAurasByCasterSpell(aur->GetId(), casterGUID);
-            if (m_removedAurasCount > removedAuras + 1)
-                iter = m_modAuras[auraType].begin();
-        }
-    }
+    AuraList const& auras = GetAurasByType(auraType);
+    for (AuraList::const_iterator iter = auras.begin(); iter != auras.end(); ++iter)
+        RemoveAurasByCasterSpell((*iter)->GetId(), casterGUID);
 }
 
 void Unit::RemoveAurasWithInterruptFlags(uint32 flag, uint32 except, bool withChanneled)
@@ -793,7 +760,7 @@ uint32 Unit::GetAuraCount(uint32 spellId) const
 
 bool Unit::HasAuraType(AuraType auraType) const
 {
-    return (!m_modAuras[auraType].empty());
+    return (!GetAurasByType(auraType).empty());
 }
 
 bool Unit::HasAuraTypeWithFamilyFlags(AuraType auraType, uint32 familyName  ,uint64 familyFlags) const
@@ -3230,11 +3197,15 @@ uint32 Unit::GetWeaponSkillValue (WeaponAttackType attType, Unit const* target)
 
 void Unit::_DeleteAuras()
 {
-    while(!m_removedAuras.empty())
-    {
-        delete m_removedAuras.front();
-        m_removedAuras.pop_front();
-    }
+    // no aura iteration in progress here, drop the removed entries before freeing the auras
+    m_Auras.Compact();
+    m_scAuras.Compact();
+    m_interruptableAuras.Compact();
+    m_ccAuras.Compact();
+
+    for (std::vector<Aura*>::const_iterator itr = m_removedAuras.begin(); itr != m_removedAuras.end(); ++itr)
+        delete *itr;
+    m_removedAuras.clear();
 }
 
 void Unit::_UpdateSpells( uint32 time )
@@ -3252,15 +3223,9 @@ void Unit::_UpdateSpells( uint32 time )
         }
     }
 
-    // update auras
-    // m_AurasUpdateIterator can be updated in inderect called code at aura remove to skip next planned to update but removed auras
-    for (m_AurasUpdateIterator = m_Auras.begin(); m_AurasUpdateIterator != m_Auras.end(); )
-    {
-        Aura* i_aura = m_AurasUpdateIterator->second;
-        ++m_AurasUpdateIterator;                            // need shift to next for allow update if need into aura update
-        if (i_aura)
-            i_aura->Update(time);
-    }
+    // update auras, auras removed meanwhile are skipped by the iterator
+    for (AuraMap::iterator i = m_Auras.begin(); i != m_Auras.end(); ++i)
+        i->second->Update(time);
 
     // remove expired auras
     for (AuraMap::iterator i = m_Auras.begin(); i != m_Auras.end(); )
@@ -3951,10 +3916,9 @@ bool Unit::AddAura(Aura *Aur)
 
     // add aura, register in lists and arrays
     Aur->_AddAura(!(doubleMongoose && Aur->GetEffIndex() == 0));    // We should change slot only while processing the first effect of double mongoose
-    m_Auras.insert(AuraMap::value_type(spellEffectPair(Aur->GetId(), Aur->GetEffIndex()), Aur));
+    m_Auras.insert(AuraMap::value_type(spellEffectPair(Aur->GetId(), Aur->GetEffIndex()), Aur), Aur->GetModifier()->m_auraname, GetAuraProcTriggerFlags(Aur));
     if (Aur->GetModifier()->m_auraname < TOTAL_AURAS)
     {
-        m_modAuras[Aur->GetModifier()->m_auraname].push_back(Aur);
         if(Aur->GetSpellProto()->AuraInterruptFlags)
         {
             m_interruptableAuras.push_back(Aur);
@@ -4480,13 +4444,15 @@ void Unit::RemoveAura(AuraMap::iterator &i, AuraRemoveMode mode)
 {
     Aura* Aur = i->second;
 
-    // if unit currently update aura list then make safe update iterator shift to next
-    if (m_AurasUpdateIterator == i)
-        ++m_AurasUpdateIterator;
+    // already removed by a nested call while the caller kept its iterator
+    if (!m_Auras.erase(i))
+    {
+        ++i;
+        return;
+    }
 
     // some ShapeshiftBoosts at remove trigger removing other auras including parent Shapeshift aura
-    // remove aura from list before to prevent deleting it before
-    m_Auras.erase(i);
+    // aura is flagged removed above (also in its aura type list) before to prevent deleting it before
     ++m_removedAurasCount;
 
     SpellEntry const* AurSpellInfo = Aur->GetSpellProto();
@@ -4496,8 +4462,6 @@ void Unit::RemoveAura(AuraMap::iterator &i, AuraRemoveMode mode)
     // remove from list before mods removing (prevent cyclic calls, mods added before including to aura list - use reverse order)
     if (Aur->GetModifier()->m_auraname < TOTAL_AURAS)
     {
-        m_modAuras[Aur->GetModifier()->m_auraname].remove(Aur);
-
         if(Aur->GetSpellProto()->AuraInterruptFlags)
         {
             m_interruptableAuras.remove(Aur);
@@ -4614,7 +4578,8 @@ void Unit::RemoveAura(AuraMap::iterator &i, AuraRemoveMode mode)
     if(statue)
         statue->UnSummon();
 
-    i = m_Auras.begin();
+    // removed record is kept until _DeleteAuras, moving to the next one is safe
+    ++i;
 }
 
 void Unit::RemoveAllAuras()
@@ -4624,8 +4589,6 @@ void Unit::RemoveAllAuras()
         AuraMap::iterator iter = m_Auras.begin();
         RemoveAura(iter);
     }
-
-    m_Auras.clear();
 }
 
 void Unit::RemoveAllAurasExcept(uint32 spellId)
@@ -10590,15 +10553,6 @@ void Unit::ApplyMaxPowerMod(Powers power, uint32 val, bool apply)
     }
 }
 
-void Unit::ApplyAuraProcTriggerDamage( Aura* aura, bool apply )
-{
-    AuraList& tAuraProcTriggerDamage = m_modAuras[SPELL_AURA_PROC_TRIGGER_DAMAGE];
-    if(apply)
-        tAuraProcTriggerDamage.push_back(aura);
-    else
-        tAuraProcTriggerDamage.remove(aura);
-}
-
 uint32 Unit::GetCreatePowers( Powers power ) const
 {
     // POWER_FOCUS and POWER_HAPPINESS only have hunter pet
@@ -10956,6 +10910,24 @@ void InitTriggerAuraData()
     isNonTriggerAura[SPELL_AURA_RESIST_PUSHBACK]=true;
 }
 
+// Proc flags the aura can trigger on, same static checks as the start of IsTriggeredAtSpellProcEvent
+uint32 Unit::GetAuraProcTriggerFlags(Aura* aura)
+{
+    uint32 auraName = aura->GetModifier()->m_auraname;
+    if (auraName >= TOTAL_AURAS || isNonTriggerAura[auraName])
+        return 0;
+
+    SpellEntry const* spellProto = aura->GetSpellProto();
+    SpellProcEventEntry const* spellProcEvent = spellmgr.GetSpellProcEvent(spellProto->Id);
+    if (!isTriggerAura[auraName] && spellProcEvent == NULL)
+        return 0;
+
+    if (spellProcEvent && spellProcEvent->procFlags)
+        return spellProcEvent->procFlags;
+
+    return spellProto->procFlags;
+}
+
 uint32 createProcExtendMask(SpellNonMeleeDamage *damageInfo, SpellMissInfo missCondition)
 {
     uint32 procEx = PROC_EX_NONE;
@@ -10997,7 +10969,7 @@ uint32 createProcExtendMask(SpellNonMeleeDamage *damageInfo, SpellMissInfo missC
 void Unit::ProcDamageAndSpellFor( bool isVictim, Unit * pTarget, uint32 procFlag, uint32 procExtra, WeaponAttackType attType, SpellEntry const * procSpell, uint32 damage )
 {
     ++m_procDeep;
-    if (m_procDeep > 5)
+    if (m_procDeep > MAX_PROC_DEPTH)
     {
         sLog.outError("Prevent possible stack owerflow in Unit::ProcDamageAndSpellFor");
         if (procSpell)
@@ -11085,18 +11057,22 @@ void Unit::ProcDamageAndSpellFor( bool isVictim, Unit * pTarget, uint32 procFlag
 
     RemoveSpellList removedSpells;
     ProcTriggeredList procTriggered;
-    // Fill procTriggered list
-    
-    for(AuraMap::const_iterator itr = GetAuras().begin(); itr!= GetAuras().end(); ++itr)
+    // Fill procTriggered list, only auras registered for one of the event proc flags can trigger
+    // the buffer of this depth keeps its capacity, procs handled below nest into the next one
+    std::vector<Aura*>& procCandidates = m_procCandidates[m_procDeep - 1];
+    procCandidates.clear();
+    m_Auras.GetProcCandidates(procFlag, procCandidates);
+
+    for(std::vector<Aura*>::const_iterator itr = procCandidates.begin(); itr != procCandidates.end(); ++itr)
     {
         SpellProcEventEntry const* spellProcEvent = NULL;
-        //sLog.outString("IsTriggeredAtSpellProcEvent: %u %u %x %x %u %s %s", itr->second->GetId(), procSpell ? procSpell->Id : 0, procFlag, procExtra, attType, isVictim ? "victim" : "attacker", (damage > 0) ? "damage > 0" : "damage < 0");
-        if(!IsTriggeredAtSpellProcEvent(itr->second, procSpell, procFlag, procExtra, attType, isVictim, (damage > 0), spellProcEvent)) {
+        //sLog.outString("IsTriggeredAtSpellProcEvent: %u %u %x %x %u %s %s", (*itr)->GetId(), procSpell ? procSpell->Id : 0, procFlag, procExtra, attType, isVictim ? "victim" : "attacker", (damage > 0) ? "damage > 0" : "damage < 0");
+        if(!IsTriggeredAtSpellProcEvent(*itr, procSpell, procFlag, procExtra, attType, isVictim, (damage > 0), spellProcEvent)) {
             //sLog.outString("No.");
             continue;
         }
 
-        procTriggered.push_back( ProcTriggeredData(spellProcEvent, itr->second) );
+        procTriggered.push_back( ProcTriggeredData(spellProcEvent, *itr) );
     }
     // Handle effects proceed this time
     for(ProcTriggeredList::iterator i = procTriggered.begin(); i != procTriggered.end(); ++i)
@@ -12980,18 +12956,16 @@ void Unit::RestoreDisplayId()
     Unit::AuraList const& transforms = GetAurasByType(SPELL_AURA_TRANSFORM);
     if (!transforms.empty())
     {
-        // iterate over already applied transform auras - from newest to oldest
-        for (Unit::AuraList::const_reverse_iterator i = transforms.rbegin(); i != transforms.rend(); ++i)
+        // use the newest transform aura, prefer negative auras
+        Aura* negativeAura = NULL;
+        for (Unit::AuraList::const_iterator i = transforms.begin(); i != transforms.end(); ++i)
         {
-            if (!handledAura)
-                handledAura = (*i);
-            // prefer negative auras
+            handledAura = (*i);
             if(!IsPositiveSpell((*i)->GetSpellProto()->Id))
-            {
-                handledAura = (*i);
-                break;
-            }
+                negativeAura = (*i);
         }
+        if (negativeAura)
+            handledAura = negativeAura;
     }
     
     // transform aura was found
@@ -26,6 +26,7 @@
 #include "Opcodes.h"
 #include "Mthread.h"
 #include "SpellAuraDefines.h"
+#include "AuraStorage.h"
 #include "UpdateFields.h"
 #include "SharedDefines.h"
 #include "ThreatManager.h"
@@ -153,6 +154,8 @@ enum SpellFacingFlags
 
 #define MAX_AGGRO_RESET_TIME 10 // in seconds
 
+#define MAX_PROC_DEPTH 5                                    // nested ProcDamageAndSpellFor calls
+
 // byte value (UNIT_FIELD_BYTES_1,0)
 enum UnitStandStateType
 {
@@ -886,9 +889,9 @@ class Unit : public WorldObject
 {
     public:
         typedef std::set<Unit*> AttackerSet;
-        typedef std::pair<uint32, uint8> spellEffectPair;
-        typedef std::multimap< spellEffectPair, Aura*> AuraMap;
-        typedef std::list<Aura *> AuraList;
+        typedef AuraStorage::key_type spellEffectPair;
+        typedef AuraStorage AuraMap;
+        typedef ::AuraList AuraList;
         typedef std::list<DiminishingReturn> Diminishing;
         typedef std::set<AuraType> AuraTypeSet;
         typedef std::set<uint32> ComboPointHolderSet;
@@ -1460,8 +1463,7 @@ class Unit : public WorldObject
         Aura* GetAura(uint32 spellId, uint32 effindex);
         AuraMap      & GetAuras()       { return m_Auras; }
         AuraMap const& GetAuras() const { return m_Auras; }
-        AuraList const& GetAurasByType(AuraType type) const { return m_modAuras[type]; }
-        void ApplyAuraProcTriggerDamage(Aura* aura, bool apply);
+        AuraList const& GetAurasByType(AuraType type) const { return m_Auras.GetAurasByType(type); }
 
         int32 GetTotalAuraModifier(AuraType auratype) const;
         float GetTotalAuraMultiplier(AuraType auratype) const;
@@ -1708,7 +1710,6 @@ class Unit : public WorldObject
         DeathState m_deathState;
 
         AuraMap m_Auras;
-        AuraMap::iterator m_AurasUpdateIterator;
         uint32 m_removedAurasCount;
 
         typedef std::list<uint64> DynObjectGUIDs;
@@ -1717,9 +1718,8 @@ class Unit : public WorldObject
         std::list<GameObject*> m_gameObj;
         bool m_isSorted;
         uint32 m_transform;
-        AuraList m_removedAuras;
+        std::vector<Aura*> m_removedAuras;                 // deleted by _DeleteAuras
 
-        AuraList m_modAuras[TOTAL_AURAS];
         AuraList m_scAuras;                        // casted singlecast auras
         AuraList m_interruptableAuras;
         AuraList m_ccAuras;
@@ -1760,6 +1760,7 @@ class Unit : public WorldObject
         //void SendAttackStart(Unit* pVictim);                // only from Unit::AttackStart(Unit*)
 
         bool IsTriggeredAtSpellProcEvent( Aura* aura, SpellEntry const* procSpell, uint32 procFlag, uint32 procExtra, WeaponAttackType attType, bool isVictim, bool active, SpellProcEventEntry const*& spellProcEvent );
+        static uint32 GetAuraProcTriggerFlags(Aura* aura);
         bool HandleDummyAuraProc(   Unit *pVictim, uint32 damage, Aura* triggredByAura, SpellEntry const *procSpell, uint32 procFlag, uint32 procEx, uint32 cooldown);
         bool HandleHasteAuraProc(   Unit *pVictim, uint32 damage, Aura* triggredByAura, SpellEntry const *procSpell, uint32 procFlag, uint32 procEx, uint32 cooldown);
         bool HandleProcTriggerSpell(Unit *pVictim, uint32 damage, Aura* triggredByAura, SpellEntry const *procSpell, uint32 procFlag, uint32 procEx, uint32 cooldown);
@@ -1794,6 +1795,7 @@ class Unit : public WorldObject
         bool m_attackVictimOnEnd;
 
         uint32 m_procDeep;
+        std::vector<Aura*> m_procCandidates[MAX_PROC_DEPTH];    // per depth, reused between proc events
         
         Spell const* _focusSpell;
         bool _targetLocked; // locks the target during spell cast for proper facing
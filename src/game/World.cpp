@@ -70,6 +70,9 @@
 #include "SmartAI.h"
 #include "WardenDataStorage.h"
 #include "ArenaTeam.h"
+#include "ProfilerMgr.h"
+#include "Metrics.h"
+#include "OpcodeCost.h"
 
 INSTANTIATE_SINGLETON_1( World );
 
@@ -158,6 +161,9 @@ World::~World()
 
     if(m_resultQueue) delete m_resultQueue;
 
+    for (MapLatencyMap::iterator itr = m_mapUpdateStats.begin(); itr != m_mapUpdateStats.end(); ++itr)
+        delete itr->second;
+
     //TODO free addSessQueue
 }
 
@@ -863,6 +869,10 @@ void World::LoadConfigSettings(bool reload)
 
     m_configs[CONFIG_MAIL_DELIVERY_DELAY] = sConfig.GetIntDefault("MailDeliveryDelay",HOUR);
 
+    m_configs[CONFIG_AUCTION_EXPIRY_BATCH] = sConfig.GetIntDefault("AuctionHouse.ExpiryBatch", 200);
+
+    m_configs[CONFIG_MAIL_EXPIRY_CHUNK] = sConfig.GetIntDefault("Mail.ExpiryChunk", 500);
+
     m_configs[CONFIG_UPTIME_UPDATE] = sConfig.GetIntDefault("UpdateUptimeInterval", 10);
     if(m_configs[CONFIG_UPTIME_UPDATE]<=0)
     {
@@ -998,6 +1008,21 @@ void World::LoadConfigSettings(bool reload)
     
     m_configs[CONFIG_GROUPLEADER_RECONNECT_PERIOD] = sConfig.GetIntDefault("GroupLeaderReconnectPeriod", 180);
 
+    m_configs[CONFIG_CREATURE_LOD_NEAR_DISTANCE] = sConfig.GetIntDefault("Creature.UpdateLOD.NearDistance", 40);
+    m_configs[CONFIG_CREATURE_LOD_FAR_DISTANCE] = sConfig.GetIntDefault("Creature.UpdateLOD.FarDistance", 70);
+    if(m_configs[CONFIG_CREATURE_LOD_FAR_DISTANCE] < m_configs[CONFIG_CREATURE_LOD_NEAR_DISTANCE])
+    {
+        sLog.outError("Creature.UpdateLOD.FarDistance (%u) can't be less than Creature.UpdateLOD.NearDistance (%u), set to %u.",
+            m_configs[CONFIG_CREATURE_LOD_FAR_DISTANCE], m_configs[CONFIG_CREATURE_LOD_NEAR_DISTANCE], m_configs[CONFIG_CREATURE_LOD_NEAR_DISTANCE]);
+        m_configs[CONFIG_CREATURE_LOD_FAR_DISTANCE] = m_configs[CONFIG_CREATURE_LOD_NEAR_DISTANCE];
+    }
+    m_configs[CONFIG_CREATURE_LOD_MID_INTERVAL] = sConfig.GetIntDefault("Creature.UpdateLOD.MidInterval", 2);
+    if(m_configs[CONFIG_CREATURE_LOD_MID_INTERVAL] < 1)
+        m_configs[CONFIG_CREATURE_LOD_MID_INTERVAL] = 1;
+    m_configs[CONFIG_CREATURE_LOD_FAR_INTERVAL] = sConfig.GetIntDefault("Creature.UpdateLOD.FarInterval", 4);
+    if(m_configs[CONFIG_CREATURE_LOD_FAR_INTERVAL] < m_configs[CONFIG_CREATURE_LOD_MID_INTERVAL])
+        m_configs[CONFIG_CREATURE_LOD_FAR_INTERVAL] = m_configs[CONFIG_CREATURE_LOD_MID_INTERVAL];
+
     m_VisibleUnitGreyDistance = sConfig.GetFloatDefault("Visibility.Distance.Grey.Unit", 1);
     if(m_VisibleUnitGreyDistance >  MAX_VISIBILITY_DISTANCE)
     {
@@ -1132,6 +1157,10 @@ void World::LoadConfigSettings(bool reload)
     m_configs[CONFIG_MONITORING_ENABLED] = sConfig.GetBoolDefault("Monitor.enabled", true);
     m_configs[CONFIG_MONITORING_UPDATE] = sConfig.GetIntDefault("Monitor.update", 10000);
 
+    Profiler::SetEnabled(sConfig.GetBoolDefault("Profiler.Enable", true));
+    sMetrics.SetSummaryRange(sConfig.GetIntDefault("Metrics.SummaryRange", 60));
+    sOpcodeCost.LoadConfig();
+
     std::string forbiddenmaps = sConfig.GetStringDefault("ForbiddenMaps", "");
     char * forbiddenMaps = new char[forbiddenmaps.length() + 1];
     forbiddenMaps[forbiddenmaps.length()] = 0;
@@ -1439,6 +1468,9 @@ void World::SetInitialWorldSettings()
     sLog.outString( "Loading linked spells..." );
     spellmgr.LoadSpellLinked();
 
+    sLog.outString( "Building spell metadata..." );
+    spellmgr.LoadSpellMetadata();                           // must be after all spell tables
+
     sLog.outString( "Loading player Create Info & Level Stats..." );
     objmgr.LoadPlayerInfo();
 
@@ -1643,9 +1675,9 @@ void World::SetInitialWorldSettings()
     sLog.outString("Loading automatic announces...");
     LoadAutoAnnounce();
 
+    InitMetrics();
+
     sLog.outString("Cleaning up old logs...");
-    if(m_configs[CONFIG_MONITORING_ENABLED])
-        CleanupOldMonitorLogs(); 
     CleanupOldLogs();
 
     uint32 serverStartedTime = GetMSTimeDiffToNow(serverStartingTime);
@@ -1695,30 +1727,74 @@ void World::DetectDBCLang()
     sLog.outString("Using %s DBC Locale as default. All available DBC locales: %s",localeNames[m_defaultDbcLocale],availableLocalsStr.empty() ? "<none>" : availableLocalsStr.c_str());
 }
 
-void World::RecordTimeDiff(const char *text, ...)
+char const* World::GetTickPhaseName(TickPhase phase)
 {
-    if(m_updateTimeCount != 1)
-        return;
-    if(!text)
+    switch (phase)
     {
-        m_currentTime = getMSTime();
-        return;
+        case TICK_PHASE_WORLD:          return "World";
+        case TICK_PHASE_AUCTIONS:       return "UpdateAuctions";
+        case TICK_PHASE_SESSIONS:       return "UpdateSessions";
+        case TICK_PHASE_GROUPS:         return "UpdateGroups";
+        case TICK_PHASE_PLAYERS:        return "UpdatePlayers";
+        case TICK_PHASE_MAPS:           return "UpdateMaps";
+        case TICK_PHASE_OBJECTACCESSOR: return "UpdateObjectAccessor";
+        case TICK_PHASE_TRANSPORTS:     return "UpdateTransports";
+        case TICK_PHASE_SCRIPTS:        return "UpdateScriptsProcess";
+        case TICK_PHASE_BATTLEGROUNDS:  return "UpdateBattleGroundMgr";
+        case TICK_PHASE_OUTDOORPVP:     return "UpdateOutdoorPvPMgr";
+        case TICK_PHASE_RESULTQUEUE:    return "UpdateResultQueue";
+        default:                        return "Unknown";
     }
+}
 
-    uint32 thisTime = getMSTime();
-    uint32 diff = GetMSTimeDiff(m_currentTime, thisTime);
+uint64 World::RecordPhaseTime(TickPhase phase, uint64 startNs)
+{
+    uint64 now = getNSTime();
+    uint64 us = (now - startNs) / 1000;
+    m_phaseStats[phase].Record(us);
 
-    if(diff > m_configs[CONFIG_MIN_LOG_UPDATE])
-    {
-        va_list ap;
-        char str [256];
-        va_start(ap, text);
-        vsnprintf(str,256,text, ap );
-        va_end(ap);
-        sLog.outString("Difftime %s: %u.", str, diff);
-    }
+    // keep the old behaviour: log slow phases once per RecordUpdateTimeDiffInterval
+    if (m_updateTimeCount == 1 && phase != TICK_PHASE_WORLD && us / 1000 > m_configs[CONFIG_MIN_LOG_UPDATE])
+        sLog.outString("Difftime %s: %u.", GetTickPhaseName(phase), uint32(us / 1000));
 
-    m_currentTime = thisTime;
+    return now;
+}
+
+LatencyHistogram* World::CreateMapUpdateStats(uint32 mapId)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(m_mapUpdateStatsLock);
+    MapLatencyMap::iterator itr = m_mapUpdateStats.find(mapId);
+    if (itr != m_mapUpdateStats.end())
+        return itr->second;
+
+    itr = m_mapUpdateStats.insert(MapLatencyMap::value_type(mapId, new LatencyHistogram())).first;
+
+    std::ostringstream labels;
+    labels << "map=\"" << mapId << '"';
+    sMetrics.RegisterHistogram("wr_map_update_seconds", "Duration of one map update, instances included", labels.str(), itr->second);
+    return itr->second;
+}
+
+uint64 World::RecordMapUpdateTime(Map const* map, uint64 startNs)
+{
+    uint64 now = getNSTime();
+    uint64 us = (now - startNs) / 1000;
+
+    // base maps only, the histogram was created with the map and Record() takes no lock
+    if (LatencyHistogram* histogram = map->GetUpdateStats())
+        histogram->Record(us);
+
+    if (m_updateTimeCount == 1 && us / 1000 > m_configs[CONFIG_MIN_LOG_UPDATE])
+        sLog.outString("Difftime UpdateMap %u: %u.", map->GetId(), uint32(us / 1000));
+
+    return now;
+}
+
+void World::GetMapUpdateStats(std::map<uint32, LatencySnapshot>& stats, uint32 seconds)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(m_mapUpdateStatsLock);
+    for (MapLatencyMap::const_iterator itr = m_mapUpdateStats.begin(); itr != m_mapUpdateStats.end(); ++itr)
+        stats[itr->first] = itr->second->GetSnapshot(seconds);
 }
 
 uint32 World::GetCurrentQuestForPool(uint32 poolId)
@@ -1781,8 +1857,13 @@ void World::LoadQuestPoolsData()
 /// Update the World !
 void World::Update(time_t diff)
 {
+    PROFILE;
+
+    uint64 tickStart = getNSTime();
     m_updateTime = uint32(diff);
 
+    sOpcodeCost.Update();
+
     if(m_configs[CONFIG_MONITORING_ENABLED])
     {
         if (m_configs[CONFIG_MONITORING_UPDATE])
@@ -1856,6 +1937,7 @@ void World::Update(time_t diff)
     if (m_timers[WUPDATE_AUCTIONS].Passed())
     {
         m_timers[WUPDATE_AUCTIONS].Reset();
+        uint64 phaseStart = getNSTime();
 
         ///- Update mails (return old mails with item, or delete them)
         //(tested... works on win)
@@ -1866,6 +1948,14 @@ void World::Update(time_t diff)
         }
         ///-Handle expired auctions
         sAHMgr.Update();
+        RecordPhaseTime(TICK_PHASE_AUCTIONS, phaseStart);
+    }
+    ///- Expired auctions left by the last update, one more batch per tick
+    else if (sAHMgr.HasExpiryBacklog())
+    {
+        uint64 phaseStart = getNSTime();
+        sAHMgr.Update();
+        RecordPhaseTime(TICK_PHASE_AUCTIONS, phaseStart);
     }
 
     /// <li> Handle session updates when the timer has passed
@@ -1873,15 +1963,14 @@ void World::Update(time_t diff)
     {
         m_timers[WUPDATE_SESSIONS].Reset();
 
-        RecordTimeDiff(NULL);
+        uint64 phaseStart = getNSTime();
         UpdateSessions(diff);
-        RecordTimeDiff("UpdateSessions");
+        phaseStart = RecordPhaseTime(TICK_PHASE_SESSIONS, phaseStart);
 
         // Update groups
-        RecordTimeDiff(NULL);
         for (ObjectMgr::GroupSet::iterator itr = objmgr.GetGroupSetBegin(); itr != objmgr.GetGroupSetEnd(); ++itr)
             (*itr)->Update(diff);
-        RecordTimeDiff("UpdateGroups");
+        RecordPhaseTime(TICK_PHASE_GROUPS, phaseStart);
     }
 
     /// <li> Handle weather updates when the timer has passed
@@ -1922,25 +2011,23 @@ void World::Update(time_t diff)
         ///- Update objects when the timer has passed (maps, transport, creatures,...)
         MapManager::Instance().Update(diff);                // As interval = 0
 
-        RecordTimeDiff(NULL);
+        uint64 phaseStart = getNSTime();
         ///- Process necessary scripts
         if (!m_scriptSchedule.empty())
             ScriptsProcess();
-        RecordTimeDiff("UpdateScriptsProcess");
+        phaseStart = RecordPhaseTime(TICK_PHASE_SCRIPTS, phaseStart);
 
         sBattleGroundMgr.Update(diff);
-        RecordTimeDiff("UpdateBattleGroundMgr");
-
+        phaseStart = RecordPhaseTime(TICK_PHASE_BATTLEGROUNDS, phaseStart);
 
         sOutdoorPvPMgr.Update(diff);
-        RecordTimeDiff("UpdateOutdoorPvPMgr");
-
+        RecordPhaseTime(TICK_PHASE_OUTDOORPVP, phaseStart);
     }
 
-    RecordTimeDiff(NULL);
+    uint64 phaseStart = getNSTime();
     // execute callbacks from sql queries that were queued recently
     UpdateResultQueue();
-    RecordTimeDiff("UpdateResultQueue");
+    RecordPhaseTime(TICK_PHASE_RESULTQUEUE, phaseStart);
 
     ///- Erase corpses once every 20 minutes
     if (m_timers[WUPDATE_CORPSES].Passed())
@@ -1991,6 +2078,13 @@ void World::Update(time_t diff)
 
     // And last, but not least handle the issued cli commands
     ProcessCliCommands();
+
+    // send what was not sent at the end of a map update (character screen, world thread packets)
+    for (SessionMap::const_iterator itr = m_sessions.begin(); itr != m_sessions.end(); ++itr)
+        if (itr->second)
+            itr->second->FlushPackets();
+
+    RecordPhaseTime(TICK_PHASE_WORLD, tickStart);
 }
 
 void World::ForceGameEventUpdate()
@@ -2061,6 +2155,8 @@ void World::ScriptCommandStart(ScriptInfo const& script, uint32 delay, Object* s
 /// Process queued scripts
 void World::ScriptsProcess()
 {
+    PROFILE;
+
     if (m_scriptSchedule.empty())
         return;
 
@@ -3156,6 +3252,7 @@ void World::_UpdateGameTime()
     time_t thisTime = time(NULL);
     uint32 elapsed = uint32(thisTime - m_gameTime);
     m_gameTime = thisTime;
+    LatencyHistogram::SetClock(thisTime);
 
     ///- if there is a shutdown timer
     if(!m_stopEvent && m_ShutdownTimer > 0 && elapsed > 0)
@@ -3272,6 +3369,8 @@ void World::SendServerMessage(uint32 type, const char *text, Player* player)
 
 void World::UpdateSessions( time_t diff )
 {
+    PROFILE;
+
     ///- Add new sessions
     while(!addSessQueue.empty())
     {
@@ -3387,6 +3486,8 @@ void World::InitResultQueue()
 
 void World::UpdateResultQueue()
 {
+    PROFILE;
+
     m_resultQueue->Update();
 }
 
@@ -3485,22 +3586,6 @@ void World::ResetDailyQuests()
     }
 }
 
-void World::CleanupOldMonitorLogs()
-{
-    sLog.outDetail("Cleaning old logs from monitoring system. ( > 1 month old)");
-    
-    time_t now = time(NULL);
-    time_t limit = now - (1 * MONTH);
-    
-    SQLTransaction trans = LogsDatabase.BeginTransaction();
-    trans->PAppend("DELETE FROM mon_players WHERE time < %u", limit);
-    trans->PAppend("DELETE FROM mon_timediff WHERE time < %u", limit);
-    trans->PAppend("DELETE FROM mon_maps WHERE time < %u", limit);
-    trans->PAppend("DELETE FROM mon_races WHERE time < %u", limit);
-    trans->PAppend("DELETE FROM mon_classes WHERE time < %u", limit);
-    LogsDatabase.CommitTransaction(trans);
-}
-
 void World::CleanupOldLogs()
 {
     sLog.outDetail("Cleaning old logs for deleted chars and items. ( > 1 month old)");
@@ -3685,167 +3770,111 @@ void World::LoadMotdAndTwitter()
     delete motdRes;
 }
 
+void World::InitMetrics()
+{
+    for (uint32 i = 0; i < TICK_PHASE_COUNT; ++i)
+    {
+        std::ostringstream labels;
+        labels << "phase=\"" << GetTickPhaseName(TickPhase(i)) << '"';
+        sMetrics.RegisterHistogram("wr_tick_phase_seconds", "Duration of the world tick phases", labels.str(), &m_phaseStats[i]);
+    }
+
+    m_metrics.activeSessions = sMetrics.GetGauge("wr_sessions_active", "Sessions in world or at character screen");
+    m_metrics.queuedSessions = sMetrics.GetGauge("wr_sessions_queued", "Sessions waiting in the login queue");
+    m_metrics.averageDiff = sMetrics.GetGauge("wr_tick_average_milliseconds", "Smoothed world update diff");
+    m_metrics.maxCreatureGuid = sMetrics.GetGauge("wr_creature_guid_max", "Highest creature guid in use");
+    m_metrics.worldDbQueue = sMetrics.GetGauge("wr_db_queue_size", "Async operations waiting for a database worker", "db=\"world\"");
+    m_metrics.characterDbQueue = sMetrics.GetGauge("wr_db_queue_size", "Async operations waiting for a database worker", "db=\"characters\"");
+    m_metrics.loginDbQueue = sMetrics.GetGauge("wr_db_queue_size", "Async operations waiting for a database worker", "db=\"realmd\"");
+    m_metrics.logsDbQueue = sMetrics.GetGauge("wr_db_queue_size", "Async operations waiting for a database worker", "db=\"logs\"");
+    m_metrics.sendBacklog = sMetrics.GetGauge("wr_send_backlog_bytes", "Bytes sent to sessions and not yet written to the network");
+    m_metrics.sendBacklogMax = sMetrics.GetGauge("wr_send_backlog_max_bytes", "Largest send backlog of a single session");
+}
+
+MetricGauge* World::_GetLabeledGauge(MetricGaugeMap& gauges, uint32 key, char const* name, char const* help, char const* label)
+{
+    MetricGaugeMap::iterator itr = gauges.find(key);
+    if (itr != gauges.end())
+        return itr->second;
+
+    std::ostringstream labels;
+    labels << label << "=\"" << key << '"';
+    MetricGauge* gauge = sMetrics.GetGauge(name, help, labels.str());
+    gauges[key] = gauge;
+    return gauge;
+}
+
+// Refresh the gauges exported by the metrics listener, no file or database access here
 void World::UpdateMonitoring(uint32 diff)
 {
-    FILE *fp;
-    std::string monpath;
-    std::string filename;
-    char data[64];
-    time_t now = time(NULL);
+    m_metrics.activeSessions->Set(GetActiveSessionCount());
+    m_metrics.queuedSessions->Set(GetQueuedSessionCount());
+    m_metrics.averageDiff->Set(fastTd);
+    m_metrics.maxCreatureGuid->Set(objmgr.GetMaxCreatureGUID());
 
-    monpath = sConfig.GetStringDefault("Monitor.path", "");
-    monpath += "/";
-    
-    SQLTransaction trans = LogsDatabase.BeginTransaction();
+    m_metrics.worldDbQueue->Set(WorldDatabase.QueueSize());
+    m_metrics.characterDbQueue->Set(CharacterDatabase.QueueSize());
+    m_metrics.loginDbQueue->Set(LoginDatabase.QueueSize());
+    m_metrics.logsDbQueue->Set(LogsDatabase.QueueSize());
 
-    /* players */
+    /* send backlog, the socket output waiting for the network */
 
-    filename = monpath;
-    filename += sConfig.GetStringDefault("Monitor.players", "players");
-    if ((fp = fopen(filename.c_str(), "w")) == NULL)
-        return;
-    sprintf(data, "%lu %lu", GetActiveSessionCount(), GetQueuedSessionCount());
-    trans->PAppend("INSERT INTO mon_players (time, active, queued) VALUES (%u, %u, %u)", (uint32)now, GetActiveSessionCount(), GetQueuedSessionCount());
-    fputs(data, fp);
-    fclose(fp);
+    uint64 sendBacklog = 0;
+    uint32 sendBacklogMax = 0;
+    for (SessionMap::const_iterator itr = m_sessions.begin(); itr != m_sessions.end(); ++itr)
+    {
+        if (!itr->second)
+            continue;
 
-    /* time diff */
+        uint32 backlog = itr->second->GetSendBacklog();
+        sendBacklog += backlog;
+        if (backlog > sendBacklogMax)
+            sendBacklogMax = backlog;
+    }
 
-    filename = monpath;
-    filename += sConfig.GetStringDefault("Monitor.timediff", "timediff");
-    if ((fp = fopen(filename.c_str(), "w")) == NULL)
-        return;
-    sprintf(data, "%lu", fastTd);
-    trans->PAppend("INSERT INTO mon_timediff (time, diff) VALUES (%u, %u)", (uint32)now, fastTd);
-    fputs(data, fp);
-    fclose(fp);
-
-    /* maps */
-
-    std::string maps = "eastern kalimdor outland karazhan hyjal ssc blacktemple tempestkeep zulaman warsong arathi eye alterac arenas sunwell";
-    std::stringstream cnts;
-    int arena_cnt = 0;
-    arena_cnt += MapManager::Instance().GetNumPlayersInMap(559); /* nagrand */
-    arena_cnt += MapManager::Instance().GetNumPlayersInMap(562); /* blade's edge */
-    arena_cnt += MapManager::Instance().GetNumPlayersInMap(572); /* lordaeron */
-
-    cnts << MapManager::Instance().GetNumPlayersInMap(0) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(1) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(530) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(532) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(534) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(548) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(564) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(550) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(568) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(489) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(529) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(566) << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(30) << " ";
-    cnts << arena_cnt << " ";
-    cnts << MapManager::Instance().GetNumPlayersInMap(580);
-    
-    int mapIds[14] = { 0, 1, 530, 532, 534, 548, 564, 550, 568, 489, 529, 566, 30, 580 };
-    for (int i = 0; i < 14; i++)
-        trans->PAppend("INSERT INTO mon_maps (time, map, players) VALUES (%u, %u, %u)", (uint32)now, mapIds[i], MapManager::Instance().GetNumPlayersInMap(mapIds[i]));
-    // arenas
-    trans->PAppend("INSERT INTO mon_maps (time, map, players) VALUES (%u, 559, %u)", (uint32)now, arena_cnt); // Nagrand!
-
-    filename = monpath;
-    filename += sConfig.GetStringDefault("Monitor.maps", "maps");
-    if ((fp = fopen(filename.c_str(), "w")) == NULL)
-        return;
-    fputs(maps.c_str(), fp);
-    fputs("\n", fp);
-    fputs(cnts.str().c_str(), fp);
-    fclose(fp);
+    m_metrics.sendBacklog->Set(sendBacklog);
+    m_metrics.sendBacklogMax->Set(sendBacklogMax);
 
-    /* battleground queue time */
+    /* maps, maps emptied since last update are reset to 0 */
 
-    std::string bgs = "alterac warsong arathi eye 2v2 3v3 5v5";
-    std::stringstream bgs_wait;
+    std::map<uint32, uint32> players;
+    MapManager::Instance().GetPlayerCountsByMap(players);
 
-    bgs_wait << sBattleGroundMgr.m_BattleGroundQueues[BATTLEGROUND_QUEUE_AV].GetAvgTime() << " ";
-    bgs_wait << sBattleGroundMgr.m_BattleGroundQueues[BATTLEGROUND_QUEUE_WS].GetAvgTime() << " ";
-    bgs_wait << sBattleGroundMgr.m_BattleGroundQueues[BATTLEGROUND_QUEUE_AB].GetAvgTime() << " ";
-    bgs_wait << sBattleGroundMgr.m_BattleGroundQueues[BATTLEGROUND_QUEUE_EY].GetAvgTime() << " ";
-    bgs_wait << sBattleGroundMgr.m_BattleGroundQueues[BATTLEGROUND_QUEUE_2v2].GetAvgTime() << " ";
-    bgs_wait << sBattleGroundMgr.m_BattleGroundQueues[BATTLEGROUND_QUEUE_3v3].GetAvgTime() << " ";
-    bgs_wait << sBattleGroundMgr.m_BattleGroundQueues[BATTLEGROUND_QUEUE_5v5].GetAvgTime();
+    for (MetricGaugeMap::iterator itr = m_metrics.mapPlayers.begin(); itr != m_metrics.mapPlayers.end(); ++itr)
+        if (players.find(itr->first) == players.end())
+            itr->second->Set(0);
 
-    filename = monpath;
-    filename += sConfig.GetStringDefault("Monitor.bgwait", "bgwait");
-    if ((fp = fopen(filename.c_str(), "w")) == NULL)
-        return;
-    fputs(bgs.c_str(), fp);
-    fputs("\n", fp);
-    fputs(bgs_wait.str().c_str(), fp);
-    fclose(fp);
+    for (std::map<uint32, uint32>::const_iterator itr = players.begin(); itr != players.end(); ++itr)
+        _GetLabeledGauge(m_metrics.mapPlayers, itr->first, "wr_map_players", "Players in map, instances summed", "map")->Set(itr->second);
 
-    /* max creature guid */
+    /* battleground queue time */
+
+    for (uint32 i = 0; i < MAX_BATTLEGROUND_QUEUE_TYPES; ++i)
+        _GetLabeledGauge(m_metrics.bgQueueWait, i, "wr_bg_queue_wait_milliseconds", "Average battleground queue wait time", "queue")->Set(sBattleGroundMgr.m_BattleGroundQueues[i].GetAvgTime());
 
-    filename = monpath;
-    filename += sConfig.GetStringDefault("Monitor.creatureguid", "creatureguid");
-    if ((fp = fopen(filename.c_str(), "w")) == NULL)
-        return;
-    sprintf(data, "%lu", objmgr.GetMaxCreatureGUID());
-    fputs(data, fp);
-    fclose(fp);
-    
     /* races && classes */
 
-    std::string races = "human orc dwarf nightelf undead tauren gnome troll bloodelf draenei";
-    std::stringstream ssraces;
-    
-    std::string classes = "warrior paladin hunter rogue priest shaman mage warlock druid";
-    std::stringstream ssclasses;
-    
-    uint32 racesCount[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-    uint32 classesCount[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    uint32 racesCount[MAX_RACES];
+    uint32 classesCount[MAX_CLASSES];
+    memset(racesCount, 0, sizeof(racesCount));
+    memset(classesCount, 0, sizeof(classesCount));
+
     HashMapHolder<Player>::MapType& m = ObjectAccessor::Instance().GetPlayers();
-    for (HashMapHolder<Player>::MapType::iterator itr = m.begin(); itr != m.end(); ++itr) {
-        racesCount[itr->second->getRace()]++;
-        classesCount[itr->second->getClass()]++;
-    }
-    
-    ssraces << racesCount[1] << " " << racesCount[2] << " " << racesCount[3] << " ";
-    ssraces << racesCount[4] << " " << racesCount[5] << " " << racesCount[6] << " ";
-    ssraces << racesCount[7] << " " << racesCount[8] << " " << racesCount[10] << " ";
-    ssraces << racesCount[11];
-    
-    ssclasses << classesCount[1] << " " << classesCount[2] << " " << classesCount[3] << " ";
-    ssclasses << classesCount[4] << " " << classesCount[5] << " " << classesCount[7] << " ";
-    ssclasses << classesCount[8] << " " << classesCount[9] << " " << classesCount[11] << " ";
-    
-    for (int i = 1; i < 12; i++) {
-        if (i != 9) 
-            trans->PAppend("INSERT INTO mon_races (time, race, players) VALUES (%u, %u, %u)", (uint32)now, i, racesCount[i]);
-    }
-    
-    for (int i = 1; i < 12; i++) {
-        if (i != 6 && i != 10)
-            trans->PAppend("INSERT INTO mon_classes (time, `class`, players) VALUES (%u, %u, %u)", (uint32)now, i, classesCount[i]);
+    for (HashMapHolder<Player>::MapType::iterator itr = m.begin(); itr != m.end(); ++itr)
+    {
+        if (itr->second->getRace() < MAX_RACES)
+            racesCount[itr->second->getRace()]++;
+        if (itr->second->getClass() < MAX_CLASSES)
+            classesCount[itr->second->getClass()]++;
     }
-    
-    filename = monpath;
-    filename += sConfig.GetStringDefault("Monitor.races", "races");
-    if ((fp = fopen(filename.c_str(), "w")) == NULL)
-        return;
-    fputs(races.c_str(), fp);
-    fputs("\n", fp);
-    fputs(ssraces.str().c_str(), fp);
-    fclose(fp);
-    
-    filename = monpath;
-    filename += sConfig.GetStringDefault("Monitor.classes", "classes");
-    if ((fp = fopen(filename.c_str(), "w")) == NULL)
-        return;
-    fputs(classes.c_str(), fp);
-    fputs("\n", fp);
-    fputs(ssclasses.str().c_str(), fp);
-    fclose(fp);
-    
-    LogsDatabase.CommitTransaction(trans); // TODO: drop records from more than 8 days ago in a method like daily quests reinit
+
+    for (uint32 i = 1; i < MAX_RACES; ++i)
+        if ((1 << (i - 1)) & RACEMASK_ALL_PLAYABLE)
+            _GetLabeledGauge(m_metrics.racePlayers, i, "wr_race_players", "Players online by race", "race")->Set(racesCount[i]);
+
+    for (uint32 i = 1; i < MAX_CLASSES; ++i)
+        if ((1 << (i - 1)) & CLASSMASK_ALL_PLAYABLE)
+            _GetLabeledGauge(m_metrics.classPlayers, i, "wr_class_players", "Players online by class", "class")->Set(classesCount[i]);
 }
 
 void World::LoadAutoAnnounce()
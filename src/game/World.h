@@ -27,6 +27,7 @@
 
 #include "Common.h"
 #include "Timer.h"
+#include "LatencyHistogram.h"
 #include "Policies/Singleton.h"
 #include "SharedDefines.h"
 
@@ -38,11 +39,13 @@ class Object;
 class WorldPacket;
 class WorldSession;
 class Player;
+class Map;
 struct Gladiator;
 class Weather;
 struct ScriptAction;
 struct ScriptInfo;
 class SQLResultQueue;
+class MetricGauge;
 class QueryResult;
 class WorldSocket;
 class ArenaTeam;
@@ -79,6 +82,25 @@ enum WorldTimers
     WUPDATE_COUNT          = 9
 };
 
+/// Phases of a world tick with their own latency histogram
+enum TickPhase
+{
+    TICK_PHASE_WORLD            = 0,                        // whole World::Update
+    TICK_PHASE_AUCTIONS         = 1,                        // mails and auctions expiration
+    TICK_PHASE_SESSIONS         = 2,
+    TICK_PHASE_GROUPS           = 3,
+    TICK_PHASE_PLAYERS          = 4,                        // ObjectAccessor::UpdatePlayers
+    TICK_PHASE_MAPS             = 5,                        // parallel map update, see RecordMapUpdateTime for a single map
+    TICK_PHASE_OBJECTACCESSOR   = 6,
+    TICK_PHASE_TRANSPORTS       = 7,
+    TICK_PHASE_SCRIPTS          = 8,
+    TICK_PHASE_BATTLEGROUNDS    = 9,
+    TICK_PHASE_OUTDOORPVP       = 10,
+    TICK_PHASE_RESULTQUEUE      = 11,
+
+    TICK_PHASE_COUNT            = 12
+};
+
 /// Configuration elements
 enum WorldConfigs
 {
@@ -147,6 +169,8 @@ enum WorldConfigs
     CONFIG_ALLOW_GM_FRIEND,
     CONFIG_GROUP_VISIBILITY,
     CONFIG_MAIL_DELIVERY_DELAY,
+    CONFIG_AUCTION_EXPIRY_BATCH,
+    CONFIG_MAIL_EXPIRY_CHUNK,
     CONFIG_UPTIME_UPDATE,
     CONFIG_SKILL_CHANCE_ORANGE,
     CONFIG_SKILL_CHANCE_YELLOW,
@@ -192,6 +216,10 @@ enum WorldConfigs
     CONFIG_THREAT_RADIUS,
     CONFIG_INSTANT_LOGOUT,
     CONFIG_GROUPLEADER_RECONNECT_PERIOD,
+    CONFIG_CREATURE_LOD_NEAR_DISTANCE,
+    CONFIG_CREATURE_LOD_FAR_DISTANCE,
+    CONFIG_CREATURE_LOD_MID_INTERVAL,
+    CONFIG_CREATURE_LOD_FAR_INTERVAL,
     CONFIG_DISABLE_BREATHING,
     CONFIG_ALL_TAXI_PATHS,
     CONFIG_DECLINED_NAMES_USED,
@@ -684,7 +712,15 @@ class World
         void SetScriptsVersion(char const* version) { m_ScriptsVersion = version ? version : "unknown scripting library"; }
         char const* GetScriptsVersion() { return m_ScriptsVersion.c_str(); }
 
-        void RecordTimeDiff(const char * text, ...);
+        /// Record duration of a tick phase started at startNs (getNSTime), returns current time
+        uint64 RecordPhaseTime(TickPhase phase, uint64 startNs);
+        /// Same for one map update, can be called from the map update threads
+        uint64 RecordMapUpdateTime(Map const* map, uint64 startNs);
+        /// Histogram of a base map, created with the map so recording needs no lookup
+        LatencyHistogram* CreateMapUpdateStats(uint32 mapId);
+        LatencySnapshot GetPhaseStats(TickPhase phase, uint32 seconds) const { return m_phaseStats[phase].GetSnapshot(seconds); }
+        void GetMapUpdateStats(std::map<uint32, LatencySnapshot>& stats, uint32 seconds);
+        static char const* GetTickPhaseName(TickPhase phase);
 
         uint32 GetCurrentQuestForPool(uint32 poolId);
         bool IsQuestInAPool(uint32 questId);
@@ -692,7 +728,6 @@ class World
         bool IsPhishing(std::string msg);
         void LogPhishing(uint32 src, uint32 dst, std::string msg);
         void ResetDailyQuests();
-        void CleanupOldMonitorLogs();
         void CleanupOldLogs();
         void LoadAutoAnnounce();
         
@@ -716,6 +751,7 @@ class World
         void InitDailyQuestResetTime();
         void InitNewDataForQuestPools();
         void LoadQuestPoolsData();
+        void InitMetrics();
         void UpdateMonitoring(uint32 diff);
 
     private:
@@ -735,9 +771,32 @@ class World
         uint32 mail_timer_expires;
         uint32 m_updateTime, m_updateTimeSum;
         uint32 m_updateTimeCount;
-        uint32 m_currentTime;
+        LatencyHistogram m_phaseStats[TICK_PHASE_COUNT];
+        typedef std::map<uint32, LatencyHistogram*> MapLatencyMap;
+        MapLatencyMap m_mapUpdateStats;
+        ACE_Thread_Mutex m_mapUpdateStatsLock;             // creation and listing only
         uint32 m_updateTimeMon;
 
+        typedef std::map<uint32, MetricGauge*> MetricGaugeMap;
+        MetricGauge* _GetLabeledGauge(MetricGaugeMap& gauges, uint32 key, char const* name, char const* help, char const* label);
+        struct WorldMetrics
+        {
+            MetricGauge* activeSessions;
+            MetricGauge* queuedSessions;
+            MetricGauge* averageDiff;
+            MetricGauge* maxCreatureGuid;
+            MetricGauge* worldDbQueue;
+            MetricGauge* characterDbQueue;
+            MetricGauge* loginDbQueue;
+            MetricGauge* logsDbQueue;
+            MetricGauge* sendBacklog;
+            MetricGauge* sendBacklogMax;
+            MetricGaugeMap mapPlayers;
+            MetricGaugeMap bgQueueWait;
+            MetricGaugeMap racePlayers;
+            MetricGaugeMap classPlayers;
+        } m_metrics;
+
         typedef UNORDERED_MAP<uint32, Weather*> WeatherMap;
         WeatherMap m_weathers;
         SessionMap m_sessions;
@@ -28,6 +28,7 @@
 #include "Log.h"
 #include "Opcodes.h"
 #include "WorldPacket.h"
+#include "WorldPacketPool.h"
 #include "WorldSession.h"
 #include "Player.h"
 #include "ObjectMgr.h"
@@ -47,6 +48,11 @@
 #include "IRCMgr.h"
 #include "WardenWin.h"
 #include "WardenMac.h"
+#include "OpcodeCost.h"
+#include "Timer.h"
+
+// Received packets waiting for the session update, a client filling the queue is flooding and gets disconnected
+#define RECV_QUEUE_SIZE 2048
 
 bool MapSessionFilter::Process(WorldPacket * packet)
 {
@@ -89,12 +95,39 @@ bool WorldSessionFilter::Process(WorldPacket* packet)
     return (plr->IsInWorld() == false);
 }
 
+/// Filter of an update restricted to the opcodes within their rate limit, the first refused packet stops the update
+class OpcodeRateFilter
+{
+public:
+    OpcodeRateFilter(WorldSession* pSession, PacketFilter& filter) : m_pSession(pSession), m_filter(filter), m_rateLimited(false) {}
+
+    bool Process(WorldPacket* packet)
+    {
+        if (!m_filter.Process(packet))
+            return false;
+
+        if (m_pSession->ConsumeOpcodeRate(packet->GetOpcode()))
+            return true;
+
+        m_rateLimited = true;
+        return false;
+    }
+
+    bool IsRateLimited() const { return m_rateLimited; }
+
+private:
+    WorldSession* const m_pSession;
+    PacketFilter& m_filter;
+    bool m_rateLimited;
+};
+
 /// WorldSession constructor
 WorldSession::WorldSession(uint32 id, WorldSocket *sock, uint32 sec, uint8 expansion, time_t mute_time, LocaleConstant locale, uint32 gid, bool mailChange) :
 LookingForGroup_auto_join(false), LookingForGroup_auto_add(false), m_muteTime(mute_time),
 _player(NULL), m_Socket(sock),_security(sec), _groupid(gid), _accountId(id), m_expansion(expansion),
 m_sessionDbcLocale(sWorld.GetAvailableDbcLocale(locale)), m_sessionDbLocaleIndex(objmgr.GetIndexForLocale(locale)),
-_logoutTime(0), m_inQueue(false), m_playerLoading(false), m_playerLogout(false), m_playerRecentlyLogout(false), m_latency(0), m_mailChange(mailChange), m_Warden(NULL), lastCheatWarn(time(NULL))
+_logoutTime(0), m_inQueue(false), m_playerLoading(false), m_playerLogout(false), m_playerRecentlyLogout(false), m_latency(0), m_mailChange(mailChange), m_Warden(NULL), lastCheatWarn(time(NULL)),
+_recvQueue(RECV_QUEUE_SIZE)
 {
     if (sock)
     {
@@ -123,11 +156,9 @@ WorldSession::~WorldSession()
         delete m_Warden;
 
     ///- empty incoming packet queue
-    while(!_recvQueue.empty())
-    {
-        WorldPacket *packet = _recvQueue.next ();
-        delete packet;
-    }
+    WorldPacket *packet;
+    while (_recvQueue.next(packet))
+        WorldPacketPool::Release(packet);
     LoginDatabase.PExecute("UPDATE account SET online = 0 WHERE id = %u;", GetAccountId());
     CharacterDatabase.PExecute("UPDATE characters SET online = 0 WHERE account = %u;", GetAccountId());
 }
@@ -186,14 +217,63 @@ void WorldSession::SendPacket(WorldPacket const* packet)
 
     #endif                                                  // !MANGOS_DEBUG
 
-    if (m_Socket->SendPacket (*packet) == -1)
+    if (m_Socket->BufferPacket (*packet) == -1)
+        m_Socket->CloseSocket ();
+}
+
+void WorldSession::FlushPackets()
+{
+    if (!m_Socket)
+        return;
+
+    if (m_Socket->FlushBufferedPackets () == -1)
         m_Socket->CloseSocket ();
 }
 
+uint32 WorldSession::GetSendBacklog() const
+{
+    return m_Socket ? uint32(m_Socket->GetSendBacklog ()) : 0;
+}
+
+uint32 WorldSession::GetSendBacklogPeak() const
+{
+    return m_Socket ? uint32(m_Socket->GetSendBacklogPeak ()) : 0;
+}
+
 /// Add an incoming packet to the queue
-void WorldSession::QueuePacket(WorldPacket* new_packet)
+bool WorldSession::QueuePacket(WorldPacket* new_packet)
+{
+    return _recvQueue.add(new_packet);
+}
+
+bool WorldSession::ConsumeOpcodeRate(uint16 opcode)
 {
-    _recvQueue.add(new_packet);
+    if (opcode >= NUM_MSG_TYPES)
+        return true;
+
+    OpcodeRateLimit const& limit = sOpcodeCost.GetRateLimit(opcode);
+    if (limit.rate <= 0.0f)
+        return true;
+
+    uint32 now = getMSTime();
+    std::map<uint16, OpcodeRateBucket>::iterator itr = m_opcodeRateBuckets.find(opcode);
+    if (itr == m_opcodeRateBuckets.end())
+    {
+        // first packet of this opcode, the whole burst is available
+        itr = m_opcodeRateBuckets.insert(std::make_pair(opcode, OpcodeRateBucket())).first;
+        itr->second.tokens = limit.burst;
+    }
+    else
+        itr->second.tokens = std::min(limit.burst, itr->second.tokens + GetMSTimeDiff(itr->second.lastRefill, now) * limit.rate / 1000.0f);
+
+    OpcodeRateBucket& bucket = itr->second;
+    bucket.lastRefill = now;
+
+    if (bucket.tokens < 1.0f)
+        return false;
+
+    bucket.tokens -= 1.0f;
+    return true;
 }
 
 /// Logging helper for unexpected opcodes
@@ -208,10 +288,16 @@ void WorldSession::logUnexpectedOpcode(WorldPacket* packet, const char *reason)
 /// Update the WorldSession (triggered by World update)
 bool WorldSession::Update(uint32 diff, PacketFilter& updater)
 {
+    PROFILE;
+
     ///- Retrieve packets from the receive queue and call the appropriate handlers
     /// not process packets if socket already closed
+    /// packets over the handler time budget or the opcode rate limits wait for the next update
+    uint64 budget = sOpcodeCost.GetSessionBudget();
+    uint64 spent = 0;
+    OpcodeRateFilter filter(this, updater);
     WorldPacket *packet;
-    while (!_recvQueue.empty() && m_Socket && !m_Socket->IsClosed () && _recvQueue.next(packet, updater))
+    while (!_recvQueue.empty() && m_Socket && !m_Socket->IsClosed () && _recvQueue.next(packet, filter))
     {
         #if 0
         sLog.outString( "MOEP: %s (0x%.4X)",
@@ -228,6 +314,7 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
         else
         {
             OpcodeHandler& opHandle = opcodeTable[packet->GetOpcode()];
+            uint64 start = getNSTime();
             switch (opHandle.status)
             {
                 case STATUS_LOGGEDIN:
@@ -267,11 +354,26 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
                         packet->GetOpcode());
                     break; */
             }
+
+            uint64 elapsed = getNSTime() - start;
+            sOpcodeCost.RecordHandler(packet->GetOpcode(), elapsed);
+            spent += elapsed;
         }
 
-        delete packet;
+        WorldPacketPool::Release(packet);
+
+        // at least one packet per update, even an expensive one
+        if (budget && spent >= budget)
+        {
+            if (!_recvQueue.empty())
+                sOpcodeCost.RecordDeferred(OPCODE_DEFER_BUDGET);
+            break;
+        }
     }
 
+    if (filter.IsRateLimited())
+        sOpcodeCost.RecordDeferred(OPCODE_DEFER_RATE_LIMIT);
+
     ///- Cleanup socket pointer if need
     if (m_Socket && m_Socket->IsClosed ())
     {
@@ -477,6 +579,7 @@ void WorldSession::LogoutPlayer(bool Save)
         ///- Send the 'logout complete' packet to the client
         WorldPacket data( SMSG_LOGOUT_COMPLETE, 0 );
         SendPacket( &data );
+        FlushPackets();                                     // the session may be deleted before the next flush
 
         ///- Since each account can only have one online character at any given time, ensure all characters for active account are marked as offline
         //No SQL injection as AccountId is uint32
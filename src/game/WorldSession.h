@@ -29,7 +29,10 @@
 #include "WardenBase.h"
 #include "WorldPacket.h"
 #include "ProfilerMgr.h"
+#include "Threading/ProducerConsumerQueue.h"
 #include "Profiler.h"
+#include "OpcodeCost.h"
+#include "Transaction.h"
 
 class MailItemsInfo;
 struct ItemPrototype;
@@ -136,6 +139,11 @@ class WorldSession
         void ReadMovementInfo(WorldPacket &data, MovementInfo *mi, uint32* flags);
 
         void SendPacket(WorldPacket const* packet);
+        // send the packets buffered by SendPacket, done at the end of map and world updates
+        void FlushPackets();
+        // bytes sent but not yet written to the network, and the highest value seen
+        uint32 GetSendBacklog() const;
+        uint32 GetSendBacklogPeak() const;
         void SendNotification(const char *format,...) ATTR_PRINTF(2,3);
         void SendNotification(int32 string_id,...);
         void SendPetNameInvalid(uint32 error, const std::string& name, DeclinedName *declinedName);
@@ -178,7 +186,10 @@ class WorldSession
         void LogoutPlayer(bool Save);
         void KickPlayer();
 
-        void QueuePacket(WorldPacket* new_packet);
+        // called by the network thread of the socket only, false if the queue is full
+        bool QueuePacket(WorldPacket* new_packet);
+        // takes a token of a rate limited opcode, false if the client sends it faster than allowed
+        bool ConsumeOpcodeRate(uint16 opcode);
         
         bool Update(uint32 diff, PacketFilter& updater);
 
@@ -217,6 +228,8 @@ class WorldSession
         bool SendItemInfo( uint32 itemid, WorldPacket data );
         static void SendReturnToSender(uint8 messageType, uint32 sender_acc, uint32 sender_guid, uint32 receiver_guid, const std::string& subject, uint32 itemTextId, MailItemsInfo *mi, uint32 money, uint16 mailTemplateId = 0);
         static void SendMailTo(Player* receiver, uint8 messageType, uint8 stationery, uint32 sender_guidlow_or_entry, uint32 received_guidlow, std::string subject, uint32 itemTextId, MailItemsInfo* mi, uint32 money, uint32 COD, uint32 checked, uint32 deliver_delay = 0, uint16 mailTemplateId = 0);
+        // same, the mail is saved in the transaction of the caller
+        static void SendMailTo(SQLTransaction& trans, Player* receiver, uint8 messageType, uint8 stationery, uint32 sender_guidlow_or_entry, uint32 received_guidlow, std::string subject, uint32 itemTextId, MailItemsInfo* mi, uint32 money, uint32 COD, uint32 checked, uint32 deliver_delay = 0, uint16 mailTemplateId = 0);
 
         //auction
         void SendAuctionHello( uint64 guid, Creature * unit );
@@ -722,7 +735,10 @@ class WorldSession
         int m_sessionDbLocaleIndex;
         uint32 m_latency;
 
-        ZThread::LockedQueue<WorldPacket*,ZThread::FastMutex> _recvQueue;
+        // filled by the network thread, emptied by the world thread or the map thread of the player
+        ACE_Based::ProducerConsumerQueue<WorldPacket*> _recvQueue;
+        // rate limited opcodes received by the session
+        std::map<uint16, OpcodeRateBucket> m_opcodeRateBuckets;
 };
 #endif
 /// @}
@@ -26,8 +26,9 @@
 #include <ace/os_include/sys/os_types.h>
 #include <ace/os_include/sys/os_socket.h>
 #include <ace/OS_NS_string.h>
+#include <ace/OS_NS_sys_socket.h>
+#include <ace/OS_NS_sys_uio.h>
 #include <ace/Reactor.h>
-#include <ace/Auto_Ptr.h>
 
 #include "WorldSocket.h"
 #include "Common.h"
@@ -35,6 +36,7 @@
 #include "Util.h"
 #include "World.h"
 #include "WorldPacket.h"
+#include "WorldPacketPool.h"
 #include "SharedDefines.h"
 #include "ByteBuffer.h"
 #include "AddonHandler.h"
@@ -45,6 +47,8 @@
 #include "WorldSocketMgr.h"
 #include "Log.h"
 #include "WorldLog.h"
+#include "PacketCapture.h"
+#include "Metrics.h"
 
 #if defined( __GNUC__ )
 #pragma pack(1)
@@ -70,16 +74,46 @@ struct ClientPktHeader
 #pragma pack(pop)
 #endif
 
+/// Most blocks of the output chain written by one handle_output call.
+#define WORLDSOCKET_MAX_IOV 64
+
+/// Initial size of the batch buffer, it grows as needed.
+#define WORLDSOCKET_BATCH_SIZE 4096
+
+/// Batch size handed over to the output chain without waiting for the end of the tick.
+#define WORLDSOCKET_BATCH_FLUSH 65536
+
+/// Largest payload the 16 bit size of ServerPktHeader can describe, the size counts the opcode too.
+#define WORLDSOCKET_MAX_PACKET_SIZE 0xFFFD
+
+static MetricCounter* s_PacketsReceived = NULL;
+static MetricCounter* s_BytesReceived = NULL;
+static MetricCounter* s_PacketsSent = NULL;
+static MetricCounter* s_BytesSent = NULL;
+
+void WorldSocket::InitMetrics (void)
+{
+    s_PacketsReceived = sMetrics.GetCounter ("wr_packets_received_total", "World packets received from clients");
+    s_BytesReceived = sMetrics.GetCounter ("wr_packet_bytes_received_total", "World packet payload bytes received from clients");
+    s_PacketsSent = sMetrics.GetCounter ("wr_packets_sent_total", "World packets sent to clients");
+    s_BytesSent = sMetrics.GetCounter ("wr_packet_bytes_sent_total", "World packet payload bytes sent to clients");
+}
+
 WorldSocket::WorldSocket (void) :
 WorldHandler (),
 m_Session (0),
-m_RecvWPct (0),
-m_RecvPct (),
+m_RecvBuffer (0),
+m_RecvBufferSize (32768),
 m_Header (sizeof (ClientPktHeader)),
 m_OutBuffer (0),
+m_OutTail (0),
 m_OutBufferSize (65536),
+m_OutPending (0),
+m_OutPendingPeak (0),
+m_Batch (0),
 m_OutActive (false),
 m_Seed (static_cast<uint32> (rand32 ())),
+m_CaptureId (0),
 m_OverSpeedPings (0),
 m_LastPingTime (ACE_Time_Value::zero)
 {
@@ -88,19 +122,19 @@ m_LastPingTime (ACE_Time_Value::zero)
 
 WorldSocket::~WorldSocket (void)
 {
-    if (m_RecvWPct)
-        delete m_RecvWPct;
+    if (m_RecvBuffer)
+        m_RecvBuffer->release ();
 
+    // releases the whole chain
     if (m_OutBuffer)
         m_OutBuffer->release ();
 
+    if (m_Batch)
+        m_Batch->release ();
+
     closing_ = true;
 
     peer ().close ();
-
-    WorldPacket* pct;
-    while (m_PacketQueue.dequeue_head (pct) == 0)
-        delete pct;
 }
 
 bool WorldSocket::IsClosed (void) const
@@ -110,12 +144,19 @@ bool WorldSocket::IsClosed (void) const
 
 void WorldSocket::CloseSocket (void)
 {
+    // the last packets of the session (kick reason, logout complete) are still in the batch
+    FlushBufferedPackets ();
+
     {
         ACE_GUARD (LockType, Guard, m_OutBufferLock);
 
         if (closing_)
             return;
 
+        // best effort, what the peer does not take now is dropped with the socket
+        if (m_OutPending)
+            iWriteOutput ();
+
         closing_ = true;
         peer ().close_writer ();
     }
@@ -132,12 +173,15 @@ const std::string& WorldSocket::GetRemoteAddress (void) const
     return m_Address;
 }
 
-int WorldSocket::SendPacket (const WorldPacket& pct)
+void WorldSocket::LogOutgoing (const WorldPacket& pct)
 {
-    ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, -1);
+    WorldPacket::LearnSize (pct.GetOpcode (), pct.size ());
 
-    if (closing_)
-        return -1;
+    if (s_PacketsSent)
+    {
+        s_PacketsSent->Add ();
+        s_BytesSent->Add (pct.size ());
+    }
 
     // Dump outgoing packet.
     if (sWorldLog.LogWorld ())
@@ -159,26 +203,136 @@ int WorldSocket::SendPacket (const WorldPacket& pct)
 
         sWorldLog.Log ("\n\n");
     }
+}
+
+int WorldSocket::SendPacket (const WorldPacket& pct)
+{
+    ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, -1);
 
-    if (iSendPacket (pct) == -1)
+    if (closing_)
+        return -1;
+
+    LogOutgoing (pct);
+
+    return iSendPacket (pct);
+}
+
+int WorldSocket::BufferPacket (const WorldPacket& pct)
+{
+    ACE_GUARD_RETURN (LockType, Guard, m_BatchLock, -1);
+
+    if (closing_)
+        return -1;
+
+    // the size would be truncated and iFlushBatch would walk the batch out of step with the headers
+    if (pct.size () > WORLDSOCKET_MAX_PACKET_SIZE)
     {
-        WorldPacket* npct;
+        sLog.outError ("WorldSocket::BufferPacket: dropped packet %s (0x%.4X) of %u bytes, too large for the header",
+                       LookupOpcodeName (pct.GetOpcode ()), pct.GetOpcode (), uint32 (pct.size ()));
+        return 0;
+    }
 
-        ACE_NEW_RETURN (npct, WorldPacket (pct), -1);
+    LogOutgoing (pct);
 
-        // NOTE maybe check of the size of the queue can be good ?
-        // to make it bounded instead of unbounded
-        if (m_PacketQueue.enqueue_tail (npct) == -1)
-        {
-            delete npct;
-            sLog.outError ("WorldSocket::SendPacket: m_PacketQueue.enqueue_tail failed");
+    const size_t len = sizeof (ServerPktHeader) + pct.size ();
+
+    if (m_Batch->space () < len)
+        if (m_Batch->size (m_Batch->size () * 2 + len) == -1)
             return -1;
-        }
+
+    // header is encrypted on flush, the crypt has to follow the order of the output chain
+    ServerPktHeader header;
+
+    header.cmd = pct.GetOpcode ();
+    header.size = (uint16) pct.size () + 2;
+
+    m_Batch->copy ((char*) & header, sizeof (header));
+
+    if (!pct.empty ())
+        m_Batch->copy ((char*) pct.contents (), pct.size ());
+
+    // do not let a burst (login, zone change) grow the batch until the end of the tick
+    if (m_Batch->length () >= WORLDSOCKET_BATCH_FLUSH)
+        return iFlushBatch ();
+
+    return 0;
+}
+
+int WorldSocket::FlushBufferedPackets (void)
+{
+    ACE_GUARD_RETURN (LockType, BatchGuard, m_BatchLock, -1);
+
+    return iFlushBatch ();
+}
+
+int WorldSocket::iFlushBatch (void)
+{
+    // NULL if the socket is closed before it was opened
+    const size_t len = m_Batch ? m_Batch->length () : 0;
+
+    if (len == 0)
+        return 0;
+
+    ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, -1);
+
+    if (closing_)
+        return -1;
+
+    for (char* p = m_Batch->rd_ptr (); p < m_Batch->wr_ptr ();)
+    {
+        ServerPktHeader& header = *((ServerPktHeader*) p);
+
+        p += sizeof (ServerPktHeader) + header.size - 2;
+
+        EndianConvert(header.cmd);
+        EndianConvertReverse(header.size);
+
+        m_Crypt.EncryptSend ((uint8*) & header, sizeof (header));
     }
 
+    if (m_OutTail->space () >= len)
+    {
+        m_OutTail->copy (m_Batch->rd_ptr (), len);
+        m_Batch->reset ();
+    }
+    else
+    {
+        // large batch, chain the block itself and start a new one
+        ACE_Message_Block* batch;
+        ACE_NEW_RETURN (batch, ACE_Message_Block (WORLDSOCKET_BATCH_SIZE), -1);
+
+        m_OutTail->cont (m_Batch);
+        m_OutTail = m_Batch;
+        m_Batch = batch;
+    }
+
+    m_OutPending += len;
+
+    if (m_OutPending > m_OutPendingPeak)
+        m_OutPendingPeak = m_OutPending;
+
     return 0;
 }
 
+size_t WorldSocket::GetSendBacklog (void)
+{
+    size_t backlog;
+
+    {
+        ACE_GUARD_RETURN (LockType, Guard, m_BatchLock, 0);
+        backlog = m_Batch ? m_Batch->length () : 0;
+    }
+
+    ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, 0);
+    return backlog + m_OutPending;
+}
+
+size_t WorldSocket::GetSendBacklogPeak (void)
+{
+    ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, 0);
+    return m_OutPendingPeak;
+}
+
 long WorldSocket::AddReference (void)
 {
     return static_cast<long> (add_reference ());
@@ -205,8 +359,11 @@ int WorldSocket::open (void *a)
     if (sWorldSocketMgr->OnSocketOpen (this) == -1)
         return -1;
 
-    // Allocate the buffer.
+    // Allocate the buffers.
     ACE_NEW_RETURN (m_OutBuffer, ACE_Message_Block (m_OutBufferSize), -1);
+    ACE_NEW_RETURN (m_Batch, ACE_Message_Block (WORLDSOCKET_BATCH_SIZE), -1);
+    ACE_NEW_RETURN (m_RecvBuffer, ACE_Message_Block (m_RecvBufferSize), -1);
+    m_OutTail = m_OutBuffer;
 
     // Store peer address.
     ACE_INET_Addr remote_addr;
@@ -293,16 +450,10 @@ int WorldSocket::handle_output (ACE_HANDLE)
     if (closing_)
         return -1;
 
-    const size_t send_len = m_OutBuffer->length ();
-
-    if (send_len == 0)
+    if (m_OutPending == 0)
         return cancel_wakeup_output (Guard);
 
-#ifdef MSG_NOSIGNAL
-    ssize_t n = peer ().send (m_OutBuffer->rd_ptr (), send_len, MSG_NOSIGNAL);
-#else
-    ssize_t n = peer ().send (m_OutBuffer->rd_ptr (), send_len);
-#endif // MSG_NOSIGNAL
+    const ssize_t n = iWriteOutput ();
 
     if (n == 0)
         return -1;
@@ -313,26 +464,70 @@ int WorldSocket::handle_output (ACE_HANDLE)
 
         return -1;
     }
-    else if (n < send_len) //now n > 0
-    {
-        m_OutBuffer->rd_ptr (static_cast<size_t> (n));
 
-        // move the data to the base of the buffer
-        m_OutBuffer->crunch ();
+    if (m_OutPending == 0)
+        return cancel_wakeup_output (Guard);
+
+    return schedule_wakeup_output (Guard);
+}
+
+ssize_t WorldSocket::iWriteOutput (void)
+{
+    iovec iov[WORLDSOCKET_MAX_IOV];
+    int iovcnt = 0;
+
+    for (ACE_Message_Block* mb = m_OutBuffer; mb && iovcnt < WORLDSOCKET_MAX_IOV; mb = mb->cont ())
+    {
+        if (mb->length () == 0)
+            continue;
 
-        return schedule_wakeup_output (Guard);
+        iov[iovcnt].iov_base = mb->rd_ptr ();
+        iov[iovcnt].iov_len = mb->length ();
+        ++iovcnt;
     }
-    else //now n == send_len
+
+#ifdef MSG_NOSIGNAL
+    msghdr msg;
+    ACE_OS::memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+
+    ssize_t n = ACE_OS::sendmsg (get_handle (), &msg, MSG_NOSIGNAL);
+#else
+    ssize_t n = peer ().sendv (iov, iovcnt);
+#endif // MSG_NOSIGNAL
+
+    if (n <= 0)
+        return n;
+
+    m_OutPending -= static_cast<size_t> (n);
+
+    // consume the sent data, fully sent blocks are released except the last one
+    size_t left = static_cast<size_t> (n);
+
+    for (;;)
     {
-        m_OutBuffer->reset ();
+        const size_t len = std::min (m_OutBuffer->length (), left);
+        m_OutBuffer->rd_ptr (len);
+        left -= len;
 
-        if (!iFlushPacketQueue ())
-            return cancel_wakeup_output (Guard);
-        else
-            return schedule_wakeup_output (Guard);
+        if (m_OutBuffer->length () > 0 || m_OutBuffer == m_OutTail)
+            break;
+
+        ACE_Message_Block* next = m_OutBuffer->cont ();
+        m_OutBuffer->cont (0);
+        m_OutBuffer->release ();
+        m_OutBuffer = next;
     }
 
-    ACE_NOTREACHED (return 0);
+    ACE_ASSERT (left == 0);
+
+    if (m_OutPending == 0)
+        m_OutBuffer->reset ();
+    else if (m_OutBuffer == m_OutTail)
+        m_OutBuffer->crunch ();                             // move the data to the base of the buffer
+
+    return n;
 }
 
 int WorldSocket::handle_close (ACE_HANDLE h, ACE_Reactor_Mask)
@@ -354,6 +549,9 @@ int WorldSocket::handle_close (ACE_HANDLE h, ACE_Reactor_Mask)
         m_Session = NULL;
     }
 
+    sPacketCapture.CloseSession (m_CaptureId);
+    m_CaptureId = 0;
+
     reactor()->remove_handler(this, ACE_Event_Handler::DONT_CALL | ACE_Event_Handler::ALL_EVENTS_MASK);
 
     return 0;
@@ -364,7 +562,7 @@ int WorldSocket::Update (void)
     if (closing_)
         return -1;
 
-    if (m_OutActive || m_OutBuffer->length () == 0)
+    if (m_OutActive || m_OutPending == 0)
         return 0;
 
     return handle_output (get_handle ());
@@ -372,8 +570,6 @@ int WorldSocket::Update (void)
 
 int WorldSocket::handle_input_header (void)
 {
-    ACE_ASSERT (m_RecvWPct == NULL);
-
     ACE_ASSERT (m_Header.length () == sizeof (ClientPktHeader));
 
     m_Crypt.DecryptRecv ((ACE_UINT8*) m_Header.rd_ptr (), sizeof (ClientPktHeader));
@@ -393,40 +589,35 @@ int WorldSocket::handle_input_header (void)
         return -1;
     }
 
+    // from now on the header holds the payload size
     header.size -= 4;
 
-    ACE_NEW_RETURN (m_RecvWPct, WorldPacket ((uint16) header.cmd, header.size), -1);
-
-    if(header.size > 0)
-    {
-        m_RecvWPct->resize (header.size);
-        m_RecvPct.base ((char*) m_RecvWPct->contents (), m_RecvWPct->size ());
-    }
-    else
-    {
-        ACE_ASSERT(m_RecvPct.space() == 0);
-    }
-
     return 0;
 }
 
 int WorldSocket::handle_input_payload (void)
 {
     // set errno properly here on error !!!
-    // now have a header and payload
+    // now have a header and the whole payload in m_RecvBuffer
 
-    ACE_ASSERT (m_RecvPct.space () == 0);
     ACE_ASSERT (m_Header.space () == 0);
-    ACE_ASSERT (m_RecvWPct != NULL);
 
-    const int ret = ProcessIncoming (m_RecvWPct);
+    const ClientPktHeader& header = *((const ClientPktHeader*) m_Header.rd_ptr ());
 
-    m_RecvPct.base (NULL, 0);
-    m_RecvPct.reset ();
-    m_RecvWPct = NULL;
+    ACE_ASSERT (m_RecvBuffer->length () >= header.size);
+
+    WorldPacket* new_pct = WorldPacketPool::Acquire ((uint16) header.cmd, header.size);
+
+    if (header.size > 0)
+    {
+        new_pct->append ((const uint8*) m_RecvBuffer->rd_ptr (), header.size);
+        m_RecvBuffer->rd_ptr (header.size);
+    }
 
     m_Header.reset ();
 
+    const int ret = ProcessIncoming (new_pct);
+
     if (ret == -1)
         errno = EINVAL;
 
@@ -435,48 +626,32 @@ int WorldSocket::handle_input_payload (void)
 
 int WorldSocket::handle_input_missing_data (void)
 {
-    char buf [1024];
-
-    ACE_Data_Block db ( sizeof (buf),
-                        ACE_Message_Block::MB_DATA,
-                        buf,
-                        0,
-                        0,
-                        ACE_Message_Block::DONT_DELETE,
-                        0);
+    // Move the unparsed tail (start of the next packet) to the front of the buffer,
+    // the buffer is larger than the biggest packet so there is always space left.
+    m_RecvBuffer->crunch ();
 
-    ACE_Message_Block message_block(&db,
-                                    ACE_Message_Block::DONT_DELETE,
-                                    0);
+    const size_t recv_size = m_RecvBuffer->space ();
 
-    const size_t recv_size = message_block.space ();
-
-    const ssize_t n = peer ().recv (message_block.wr_ptr (),
+    const ssize_t n = peer ().recv (m_RecvBuffer->wr_ptr (),
                                           recv_size);
 
     if (n <= 0)
         return n;
 
-    message_block.wr_ptr (n);
+    m_RecvBuffer->wr_ptr (n);
 
-    while (message_block.length () > 0)
+    // Handle every complete packet we have, an incomplete one stays in the buffer.
+    for (;;)
     {
         if (m_Header.space () > 0)
         {
-            //need to receive the header
-            const size_t to_header = (message_block.length () > m_Header.space () ? m_Header.space () : message_block.length ());
-            m_Header.copy (message_block.rd_ptr (), to_header);
-            message_block.rd_ptr (to_header);
+            if (m_RecvBuffer->length () < sizeof (ClientPktHeader))
+                break;
 
-            if (m_Header.space () > 0)
-            {
-                // Couldn't receive the whole header this time.
-                ACE_ASSERT (message_block.length () == 0);
-                errno = EWOULDBLOCK;
-                return -1;
-            }
+            // header is decrypted once, it is kept until its payload is complete
+            m_Header.copy (m_RecvBuffer->rd_ptr (), sizeof (ClientPktHeader));
+            m_RecvBuffer->rd_ptr (sizeof (ClientPktHeader));
 
-            // We just received nice new header
             if (handle_input_header () == -1)
             {
                 ACE_ASSERT ((errno != EWOULDBLOCK) && (errno != EAGAIN));
@@ -484,34 +659,11 @@ int WorldSocket::handle_input_missing_data (void)
             }
         }
 
-        // Its possible on some error situations that this happens
-        // for example on closing when epoll receives more chunked data and stuff
-        // hope this is not hack ,as proper m_RecvWPct is asserted around
-        if (!m_RecvWPct)
-        {
-            sLog.outError ("Forcing close on input m_RecvWPct = NULL");
-            errno = EINVAL;
-            return -1;
-        }
-
-        // We have full read header, now check the data payload
-        if (m_RecvPct.space () > 0)
-        {
-            //need more data in the payload
-            const size_t to_data = (message_block.length () > m_RecvPct.space () ? m_RecvPct.space () : message_block.length ());
-            m_RecvPct.copy (message_block.rd_ptr (), to_data);
-            message_block.rd_ptr (to_data);
+        const ClientPktHeader& header = *((const ClientPktHeader*) m_Header.rd_ptr ());
 
-            if (m_RecvPct.space () > 0)
-            {
-                // Couldn't receive the whole data this time.
-                ACE_ASSERT (message_block.length () == 0);
-                errno = EWOULDBLOCK;
-                return -1;
-            }
-        }
+        if (m_RecvBuffer->length () < header.size)
+            break;
 
-        //just received fresh new payload
         if (handle_input_payload () == -1)
         {
             ACE_ASSERT ((errno != EWOULDBLOCK) && (errno != EAGAIN));
@@ -519,7 +671,8 @@ int WorldSocket::handle_input_missing_data (void)
         }
     }
 
-    return n == recv_size ? 1 : 2;
+    // A full buffer means there may be more data waiting in the kernel.
+    return size_t (n) == recv_size ? 1 : 2;
 }
 
 int WorldSocket::cancel_wakeup_output (GuardType& g)
@@ -566,13 +719,19 @@ int WorldSocket::ProcessIncoming (WorldPacket* new_pct)
     ACE_ASSERT (new_pct);
 
     // manage memory ;)
-    ACE_Auto_Ptr<WorldPacket> aptr (new_pct);
+    WorldPacketPoolPtr aptr (new_pct);
 
     const ACE_UINT16 opcode = new_pct->GetOpcode ();
 
     if (closing_)
         return -1;
 
+    if (s_PacketsReceived)
+    {
+        s_PacketsReceived->Add ();
+        s_BytesReceived->Add (new_pct->size ());
+    }
+
     // Dump received packet.
     if (sWorldLog.LogWorld ())
     {
@@ -592,6 +751,10 @@ int WorldSocket::ProcessIncoming (WorldPacket* new_pct)
         sWorldLog.Log ("\n\n");
     }
 
+    // Capture it for replay, only set once the session is authenticated.
+    if (m_CaptureId)
+        sPacketCapture.CapturePacket (m_CaptureId, *new_pct);
+
     // like one switch ;)
     if (opcode == CMSG_PING)
     {
@@ -619,11 +782,16 @@ int WorldSocket::ProcessIncoming (WorldPacket* new_pct)
 
         if (m_Session != NULL)
         {
-            // OK ,give the packet to WorldSession
-            aptr.release ();
             // WARNINIG here we call it with locks held.
             // Its possible to cause deadlock if QueuePacket calls back
-            m_Session->QueuePacket (new_pct);
+            if (!m_Session->QueuePacket (new_pct))
+            {
+                sLog.outError ("WorldSocket::ProcessIncoming: receive queue of account %u is full, closing connection", m_Session->GetAccountId ());
+                return -1;
+            }
+
+            // OK ,the packet belongs to WorldSession now
+            aptr.release ();
             return 0;
         }
         else
@@ -898,6 +1066,8 @@ int WorldSocket::HandleAuthSession (WorldPacket& recvPacket)
 
     sWorld.AddSession (m_Session);
 
+    m_CaptureId = sPacketCapture.OpenSession (id, account);
+
     // Create and send the Addon packet
     if (sAddOnHandler.BuildAddonPacket (&recvPacket, &SendAddonPacked))
         SendPacket (SendAddonPacked);
@@ -974,13 +1144,28 @@ int WorldSocket::HandlePing (WorldPacket& recvPacket)
     return SendPacket (packet);
 }
 
+ACE_Message_Block* WorldSocket::iGetOutBlock (size_t size)
+{
+    if (m_OutTail->space () >= size)
+        return m_OutTail;
+
+    ACE_Message_Block* mb;
+    ACE_NEW_RETURN (mb, ACE_Message_Block (std::max (size, m_OutBufferSize)), NULL);
+
+    m_OutTail->cont (mb);
+    m_OutTail = mb;
+
+    return mb;
+}
+
 int WorldSocket::iSendPacket (const WorldPacket& pct)
 {
-    if (m_OutBuffer->space () < pct.size () + sizeof (ServerPktHeader))
-    {
-        errno = ENOBUFS;
+    const size_t len = pct.size () + sizeof (ServerPktHeader);
+
+    ACE_Message_Block* mb = iGetOutBlock (len);
+
+    if (!mb)
         return -1;
-    }
 
     ServerPktHeader header;
 
@@ -992,41 +1177,17 @@ int WorldSocket::iSendPacket (const WorldPacket& pct)
 
     m_Crypt.EncryptSend ((uint8*) & header, sizeof (header));
 
-    if (m_OutBuffer->copy ((char*) & header, sizeof (header)) == -1)
+    if (mb->copy ((char*) & header, sizeof (header)) == -1)
         ACE_ASSERT (false);
 
     if (!pct.empty ())
-        if (m_OutBuffer->copy ((char*) pct.contents (), pct.size ()) == -1)
+        if (mb->copy ((char*) pct.contents (), pct.size ()) == -1)
             ACE_ASSERT (false);
 
-    return 0;
-}
+    m_OutPending += len;
 
-bool WorldSocket::iFlushPacketQueue ()
-{
-    WorldPacket *pct;
-    bool haveone = false;
+    if (m_OutPending > m_OutPendingPeak)
+        m_OutPendingPeak = m_OutPending;
 
-    while (m_PacketQueue.dequeue_head (pct) == 0)
-    {
-        if (iSendPacket (*pct) == -1)
-        {
-            if (m_PacketQueue.enqueue_head (pct) == -1)
-            {
-                delete pct;
-                sLog.outError ("WorldSocket::iFlushPacketQueue m_PacketQueue->enqueue_head");
-                return false;
-            }
-
-            break;
-        }
-        else
-        {
-            haveone = true;
-            delete pct;
-        }
-    }
-
-    return haveone;
+    return 0;
 }
-
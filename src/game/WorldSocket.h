@@ -60,26 +60,36 @@ typedef ACE_Svc_Handler<ACE_SOCK_STREAM, ACE_NULL_SYNCH> WorldHandler;
  * Most methods return -1 on failure.
  * The class uses reference counting.
  *
- * For output the class uses one buffer (64K usually) and
- * a queue where it stores packet if there is no place on
- * the queue. The reason this is done, is because the server
- * does really a lot of small-size writes to it, and it doesn't
- * scale well to allocate memory for every. When something is
- * written to the output buffer the socket is not immediately
- * activated for output (again for the same reason), there
- * is 10ms celling (thats why there is Update() method).
- * This concept is similar to TCP_CORK, but TCP_CORK
- * uses 200ms celling. As result overhead generated by
- * sending packets from "producer" threads is minimal,
- * and doing a lot of writes with small size is tolerated.
+ * For output the class uses a chain of buffers (64K usually),
+ * a new block is chained only when the last one is full.
+ * The whole chain is written with one writev() call.
+ *
+ * Packets sent by the session are not put in the chain directly.
+ * They are appended to a batch buffer (BufferPacket) with its own
+ * lock, so producer threads never wait on the network thread.
+ * The session hands the batch over once per tick (FlushBufferedPackets).
+ * The headers are then encrypted and the batch joins the chain under
+ * a single m_OutBufferLock acquisition.
+ * A batch reaching WORLDSOCKET_BATCH_FLUSH bytes is handed over at once.
+ * CloseSocket flushes the batch and writes what the peer takes,
+ * so kick and logout messages are not lost.
+ * Packets too large for the 16 bit size of the header are dropped.
+ * Packets sent by the socket itself (auth, pong) go straight to the
+ * chain with SendPacket.
+ * When something is written to the output chain the socket is not
+ * immediately activated for output, there is 10ms celling (thats
+ * why there is Update() method). This concept is similar to TCP_CORK,
+ * but TCP_CORK uses 200ms celling.
  *
  * The calls to Update () method are managed by WorldSocketMgr
  * and ReactorRunnable.
  *
- * For input ,the class uses one 1024 bytes buffer on stack
- * to which it does recv() calls. And then received data is
- * distributed where its needed. 1024 matches pretty well the
- * traffic generated by client for now.
+ * For input the class uses one buffer (32K usually), larger
+ * than the biggest client packet, to which it does recv() calls.
+ * Every complete packet in the buffer is handled after a single
+ * recv() and the payload is copied once, straight into its
+ * WorldPacket. An incomplete packet stays in the buffer and is
+ * moved to its front before the next recv().
  *
  * The input/output do speculative reads/writes (AKA it tryes
  * to read all data available in the kernel buffer or tryes to
@@ -103,9 +113,6 @@ class WorldSocket : protected WorldHandler
         typedef ACE_Thread_Mutex LockType;
         typedef ACE_Guard<LockType> GuardType;
 
-        /// Queue for storing packets for which there is no space.
-        typedef ACE_Unbounded_Queue< WorldPacket* > PacketQueueT;
-
         /// Check if socket is closed.
         bool IsClosed (void) const;
 
@@ -120,12 +127,27 @@ class WorldSocket : protected WorldHandler
         /// @return -1 of failure
         int SendPacket (const WorldPacket& pct);
 
+        /// Append a packet to the batch sent on next FlushBufferedPackets, this function is reentrant.
+        /// @return -1 of failure
+        int BufferPacket (const WorldPacket& pct);
+
+        /// Move the batch of buffered packets to the output chain.
+        /// @return -1 of failure
+        int FlushBufferedPackets (void);
+
+        /// Bytes buffered or waiting in the output chain, and the highest value seen.
+        size_t GetSendBacklog (void);
+        size_t GetSendBacklogPeak (void);
+
         /// Add reference to this object.
         long AddReference (void);
 
         /// Remove reference to this object.
         long RemoveReference (void);
 
+        /// Register the packet counters, must be called before the network threads start.
+        static void InitMetrics (void);
+
     protected:
         /// things called by ACE framework.
         WorldSocket (void);
@@ -171,15 +193,25 @@ class WorldSocket : protected WorldHandler
         /// Called by ProcessIncoming() on CMSG_PING.
         int HandlePing (WorldPacket& recvPacket);
 
-        /// Try to write WorldPacket to m_OutBuffer ,return -1 if no space
+        /// Write WorldPacket to the output chain.
         /// Need to be called with m_OutBufferLock lock held
         int iSendPacket (const WorldPacket& pct);
 
-        /// Flush m_PacketQueue if there are packets in it
+        /// Move the batch to the output chain.
+        /// Need to be called with m_BatchLock lock held
+        int iFlushBatch (void);
+
+        /// Write as much of the output chain as the socket takes without blocking.
+        /// Need to be called with m_OutBufferLock lock held
+        /// @return bytes written, -1 with errno set on failure
+        ssize_t iWriteOutput (void);
+
+        /// Get the last block of the output chain, chaining a new one if it has less than size bytes free.
         /// Need to be called with m_OutBufferLock lock held
-        /// @return true if it wrote to the buffer ( AKA you need
-        /// to mark the socket for output ).
-        bool iFlushPacketQueue ();
+        ACE_Message_Block* iGetOutBlock (size_t size);
+
+        /// Update packet counters and size hints and dump the packet to the world log.
+        void LogOutgoing (const WorldPacket& pct);
 
     private:
         /// Time in which the last ping was received
@@ -200,34 +232,45 @@ class WorldSocket : protected WorldHandler
         /// Session to which received packets are routed
         WorldSession* m_Session;
 
-        /// here are stored the fragments of the received data
-        WorldPacket* m_RecvWPct;
+        /// Buffer used for reading input.
+        ACE_Message_Block *m_RecvBuffer;
 
-        /// This block actually refers to m_RecvWPct contents,
-        /// which allows easy and safe writing to it.
-        /// It wont free memory when its deleted. m_RecvWPct takes care of freeing.
-        ACE_Message_Block m_RecvPct;
+        /// Size of the m_RecvBuffer.
+        size_t m_RecvBufferSize;
 
-        /// Fragment of the received header.
+        /// Decrypted header of the packet being received,
+        /// full (no space) while waiting for the rest of its payload.
         ACE_Message_Block m_Header;
 
         /// Mutex for protecting output related data.
         LockType m_OutBufferLock;
 
-        /// Buffer used for writing output.
+        /// First block of the output chain, the one being sent.
         ACE_Message_Block *m_OutBuffer;
 
-        /// Size of the m_OutBuffer.
+        /// Last block of the output chain, the one being written.
+        ACE_Message_Block *m_OutTail;
+
+        /// Size of the output blocks.
         size_t m_OutBufferSize;
 
-        /// Here are stored packets for which there was no space on m_OutBuffer,
-        /// this allows not-to kick player if its buffer is overflowed.
-        PacketQueueT m_PacketQueue;
+        /// Bytes in the output chain not sent yet, and the highest value seen.
+        size_t m_OutPending;
+        size_t m_OutPendingPeak;
+
+        /// Mutex for protecting m_Batch, taken before m_OutBufferLock.
+        LockType m_BatchLock;
+
+        /// Packets buffered since the last flush, headers are not encrypted yet.
+        ACE_Message_Block *m_Batch;
 
         /// True if the socket is registered with the reactor for output
         bool m_OutActive;
 
         uint32 m_Seed;
+
+        /// Id of the connection in the packet capture, 0 if not captured
+        uint32 m_CaptureId;
 };
 
 #endif  /* _WORLDSOCKET_H */
@@ -302,6 +302,8 @@ WorldSocketMgr::StartNetwork (ACE_UINT16 port, const char* address)
     if (!sLog.IsOutDebug ())
         ACE_Log_Msg::instance ()->priority_mask (LM_ERROR, ACE_Log_Msg::PROCESS);
 
+    WorldSocket::InitMetrics ();
+
     if (StartReactiveIO (port, address) == -1)
         return -1;
 
@@ -22,6 +22,20 @@
 #include <openssl/bn.h>
 #include <algorithm>
 
+// BN_CTX only holds temporaries, one per thread is reused instead of one per operation
+static BN_CTX* GetThreadContext()
+{
+    struct ThreadContext
+    {
+        ThreadContext() : ctx(BN_CTX_new()) {}
+        ~ThreadContext() { BN_CTX_free(ctx); }
+        BN_CTX* ctx;
+    };
+
+    static thread_local ThreadContext context;
+    return context.ctx;
+}
+
 BigNumber::BigNumber()
 {
     _bn = BN_new();
@@ -76,53 +90,41 @@ void BigNumber::SetRand(int numbits)
     BN_rand(_bn, numbits, 0, 1);
 }
 
-BigNumber BigNumber::operator=(const BigNumber &bn)
+BigNumber& BigNumber::operator=(const BigNumber &bn)
 {
     BN_copy(_bn, bn._bn);
     return *this;
 }
 
-BigNumber BigNumber::operator+=(const BigNumber &bn)
+BigNumber& BigNumber::operator+=(const BigNumber &bn)
 {
     BN_add(_bn, _bn, bn._bn);
     return *this;
 }
 
-BigNumber BigNumber::operator-=(const BigNumber &bn)
+BigNumber& BigNumber::operator-=(const BigNumber &bn)
 {
     BN_sub(_bn, _bn, bn._bn);
     return *this;
 }
 
-BigNumber BigNumber::operator*=(const BigNumber &bn)
+BigNumber& BigNumber::operator*=(const BigNumber &bn)
 {
-    BN_CTX *bnctx;
-
-    bnctx = BN_CTX_new();
-    BN_mul(_bn, _bn, bn._bn, bnctx);
-    BN_CTX_free(bnctx);
+    BN_mul(_bn, _bn, bn._bn, GetThreadContext());
 
     return *this;
 }
 
-BigNumber BigNumber::operator/=(const BigNumber &bn)
+BigNumber& BigNumber::operator/=(const BigNumber &bn)
 {
-    BN_CTX *bnctx;
-
-    bnctx = BN_CTX_new();
-    BN_div(_bn, NULL, _bn, bn._bn, bnctx);
-    BN_CTX_free(bnctx);
+    BN_div(_bn, NULL, _bn, bn._bn, GetThreadContext());
 
     return *this;
 }
 
-BigNumber BigNumber::operator%=(const BigNumber &bn)
+BigNumber& BigNumber::operator%=(const BigNumber &bn)
 {
-    BN_CTX *bnctx;
-
-    bnctx = BN_CTX_new();
-    BN_mod(_bn, _bn, bn._bn, bnctx);
-    BN_CTX_free(bnctx);
+    BN_mod(_bn, _bn, bn._bn, GetThreadContext());
 
     return *this;
 }
@@ -130,11 +132,7 @@ BigNumber BigNumber::operator%=(const BigNumber &bn)
 BigNumber BigNumber::Exp(const BigNumber &bn)
 {
     BigNumber ret;
-    BN_CTX *bnctx;
-
-    bnctx = BN_CTX_new();
-    BN_exp(ret._bn, _bn, bn._bn, bnctx);
-    BN_CTX_free(bnctx);
+    BN_exp(ret._bn, _bn, bn._bn, GetThreadContext());
 
     return ret;
 }
@@ -142,12 +140,26 @@ BigNumber BigNumber::Exp(const BigNumber &bn)
 BigNumber BigNumber::ModExp(const BigNumber &bn1, const BigNumber &bn2)
 {
     BigNumber ret;
-    BN_CTX *bnctx;
+    BN_mod_exp(ret._bn, _bn, bn1._bn, bn2._bn, GetThreadContext());
 
-    bnctx = BN_CTX_new();
-    BN_mod_exp(ret._bn, _bn, bn1._bn, bn2._bn, bnctx);
-    BN_CTX_free(bnctx);
+    return ret;
+}
 
+BigNumberModulus::BigNumberModulus(const BigNumber &modulus) : _modulus(modulus)
+{
+    _mont = BN_MONT_CTX_new();
+    BN_MONT_CTX_set(_mont, _modulus._bn, GetThreadContext());
+}
+
+BigNumberModulus::~BigNumberModulus()
+{
+    BN_MONT_CTX_free(_mont);
+}
+
+BigNumber BigNumberModulus::ModExp(const BigNumber &base, const BigNumber &exp) const
+{
+    BigNumber ret;
+    BN_mod_exp_mont(ret._bn, base._bn, exp._bn, _modulus._bn, GetThreadContext(), _mont);
     return ret;
 }
 
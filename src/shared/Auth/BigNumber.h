@@ -26,9 +26,12 @@
 #include <ace/Mutex.h>
 
 struct bignum_st;
+struct bn_mont_ctx_st;
 
 class BigNumber
 {
+    friend class BigNumberModulus;
+
     public:
         BigNumber();
         BigNumber(const BigNumber &bn);
@@ -42,33 +45,33 @@ class BigNumber
 
         void SetRand(int numbits);
 
-        BigNumber operator=(const BigNumber &bn);
+        BigNumber& operator=(const BigNumber &bn);
 
-        BigNumber operator+=(const BigNumber &bn);
+        BigNumber& operator+=(const BigNumber &bn);
         BigNumber operator+(const BigNumber &bn)
         {
             BigNumber t(*this);
             return t += bn;
         }
-        BigNumber operator-=(const BigNumber &bn);
+        BigNumber& operator-=(const BigNumber &bn);
         BigNumber operator-(const BigNumber &bn)
         {
             BigNumber t(*this);
             return t -= bn;
         }
-        BigNumber operator*=(const BigNumber &bn);
+        BigNumber& operator*=(const BigNumber &bn);
         BigNumber operator*(const BigNumber &bn)
         {
             BigNumber t(*this);
             return t *= bn;
         }
-        BigNumber operator/=(const BigNumber &bn);
+        BigNumber& operator/=(const BigNumber &bn);
         BigNumber operator/(const BigNumber &bn)
         {
             BigNumber t(*this);
             return t /= bn;
         }
-        BigNumber operator%=(const BigNumber &bn);
+        BigNumber& operator%=(const BigNumber &bn);
         BigNumber operator%(const BigNumber &bn)
         {
             BigNumber t(*this);
@@ -97,5 +100,24 @@ class BigNumber
         // This mutex only controls thread-safe access to AsByteArray() and should be replaced with a thread-safe implementation of BigNumber
         ACE_Mutex _lock;
 };
+
+/// Fixed odd modulus kept in Montgomery form, for repeated ModExp with the same modulus.
+/// Read only once built, may be shared by threads.
+class BigNumberModulus
+{
+    public:
+        explicit BigNumberModulus(const BigNumber &modulus);
+        ~BigNumberModulus();
+
+        /// base^exp mod modulus
+        BigNumber ModExp(const BigNumber &base, const BigNumber &exp) const;
+
+    private:
+        BigNumberModulus(const BigNumberModulus&);
+        BigNumberModulus& operator=(const BigNumberModulus&);
+
+        BigNumber _modulus;
+        struct bn_mont_ctx_st *_mont;
+};
 #endif
 
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "Auth/SRP6.h"
+#include "Auth/Sha1.h"
+#include <algorithm>
+
+BigNumber SRP6::MakeModulus()
+{
+    BigNumber n;
+    n.SetHexStr("894B645E89E1535BBDAD5B8B290650530801B18EBFBF5E8FAB3C82872A3E9BB7");
+    return n;
+}
+
+SRP6::SRP6() : N(MakeModulus()), g(7), _modN(N)
+{
+    // H(N) xor H(g), part of the client proof
+    Sha1Hash sha;
+    sha.UpdateBigNumbers(&N, NULL);
+    sha.Finalize();
+    memcpy(NgHash, sha.GetDigest(), SHA_DIGEST_LENGTH);
+    sha.Initialize();
+    sha.UpdateBigNumbers(&g, NULL);
+    sha.Finalize();
+    for (int i = 0; i < SHA_DIGEST_LENGTH; ++i)
+        NgHash[i] ^= sha.GetDigest()[i];
+}
+
+BigNumber SRP6::ComputeVerifier(BigNumber& s, const std::string& shaPassHash) const
+{
+    BigNumber I;
+    I.SetHexStr(shaPassHash.c_str());
+
+    //In case of leading zeroes in the rI hash, restore them
+    uint8 mDigest[SHA_DIGEST_LENGTH];
+    memset(mDigest,0,SHA_DIGEST_LENGTH);
+    if (I.GetNumBytes() <= SHA_DIGEST_LENGTH)
+        memcpy(mDigest,I.AsByteArray(),I.GetNumBytes());
+
+    std::reverse(mDigest,mDigest+SHA_DIGEST_LENGTH);
+
+    Sha1Hash sha;
+    sha.UpdateData(s.AsByteArray(), s.GetNumBytes());
+    sha.UpdateData(mDigest, SHA_DIGEST_LENGTH);
+    sha.Finalize();
+    BigNumber x;
+    x.SetBinary(sha.GetDigest(), sha.GetLength());
+    return ModExpN(g, x);
+}
+
+BigNumber SRP6::ComputeB(BigNumber& v, const BigNumber& b) const
+{
+    BigNumber gmod = ModExpN(g, b);
+    ASSERT(gmod.GetNumBytes() <= 32);
+    return ((v * SRP6_K) + gmod) % N;
+}
+
+BigNumber SRP6::ComputeSessionKey(BigNumber& A, BigNumber& B, BigNumber& v, const BigNumber& b) const
+{
+    Sha1Hash sha;
+    sha.UpdateBigNumbers(&A, &B, NULL);
+    sha.Finalize();
+    BigNumber u;
+    u.SetBinary(sha.GetDigest(), 20);
+    BigNumber S = ModExpN(A * ModExpN(v, u), b);
+
+    // S is little endian on 32 bytes for the client, padded with zeroes when shorter
+    uint8 t[32];
+    uint8 t1[16];
+    uint8 vK[40];
+    memset(t, 0, 32);
+    memcpy(t, S.AsByteArray(), std::min(S.GetNumBytes(), 32));
+    for (int i = 0; i < 16; i++)
+    {
+        t1[i] = t[i*2];
+    }
+    sha.Initialize();
+    sha.UpdateData(t1, 16);
+    sha.Finalize();
+    for (int i = 0; i < 20; i++)
+    {
+        vK[i*2] = sha.GetDigest()[i];
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        t1[i] = t[i*2+1];
+    }
+    sha.Initialize();
+    sha.UpdateData(t1, 16);
+    sha.Finalize();
+    for (int i = 0; i < 20; i++)
+    {
+        vK[i*2+1] = sha.GetDigest()[i];
+    }
+
+    BigNumber K;
+    K.SetBinary(vK, 40);
+    return K;
+}
+
+BigNumber SRP6::ComputeClientProof(const std::string& login, BigNumber& s, BigNumber& A, BigNumber& B, BigNumber& K) const
+{
+    BigNumber t3;
+    t3.SetBinary(NgHash, SHA_DIGEST_LENGTH);
+
+    Sha1Hash sha;
+    sha.UpdateData(login);
+    sha.Finalize();
+    uint8 t4[SHA_DIGEST_LENGTH];
+    memcpy(t4, sha.GetDigest(), SHA_DIGEST_LENGTH);
+
+    sha.Initialize();
+    sha.UpdateBigNumbers(&t3, NULL);
+    sha.UpdateData(t4, SHA_DIGEST_LENGTH);
+    sha.UpdateBigNumbers(&s, &A, &B, &K, NULL);
+    sha.Finalize();
+    BigNumber M;
+    M.SetBinary(sha.GetDigest(), 20);
+    return M;
+}
+
+void SRP6::ComputeServerProof(BigNumber& A, BigNumber& M, BigNumber& K, uint8* digest) const
+{
+    Sha1Hash sha;
+    sha.UpdateBigNumbers(&A, &M, &K, NULL);
+    sha.Finalize();
+    memcpy(digest, sha.GetDigest(), SHA_DIGEST_LENGTH);
+}
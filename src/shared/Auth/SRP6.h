@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef _AUTH_SRP6_H
+#define _AUTH_SRP6_H
+
+#include "Common.h"
+#include "Auth/BigNumber.h"
+#include <openssl/sha.h>
+
+// SRP6 multiplier, k = 3 for the legacy SRP6 used by the client
+#define SRP6_K 3
+
+/// Server side of the SRP6 login of the client.
+/// N, g, the Montgomery form of N and H(N) xor H(g) are computed once, an instance
+/// is read only afterwards and may be shared by all connections and threads.
+class SRP6
+{
+    public:
+        SRP6();
+
+        /// base^exp mod N
+        BigNumber ModExpN(const BigNumber& base, const BigNumber& exp) const { return _modN.ModExp(base, exp); }
+
+        /// v = g^x, x = H(s, P) with P the sha_pass_hash of the account (hex string)
+        BigNumber ComputeVerifier(BigNumber& s, const std::string& shaPassHash) const;
+        /// public ephemeral B = k * v + g^b
+        BigNumber ComputeB(BigNumber& v, const BigNumber& b) const;
+        /// session key K from the client public ephemeral A
+        BigNumber ComputeSessionKey(BigNumber& A, BigNumber& B, BigNumber& v, const BigNumber& b) const;
+        /// client proof M1 the client must have sent
+        BigNumber ComputeClientProof(const std::string& login, BigNumber& s, BigNumber& A, BigNumber& B, BigNumber& K) const;
+        /// server proof M2 sent back on success
+        void ComputeServerProof(BigNumber& A, BigNumber& M, BigNumber& K, uint8* digest) const;
+
+        BigNumber N, g;
+        uint8 NgHash[SHA_DIGEST_LENGTH];
+
+    private:
+        SRP6(const SRP6&);
+        SRP6& operator=(const SRP6&);
+
+        static BigNumber MakeModulus();
+
+        BigNumberModulus _modN;
+};
+#endif
@@ -25,12 +25,20 @@
 #include "Errors.h"
 #include "Log.h"
 #include "Utilities/ByteConverter.h"
+#include "ByteBufferAllocator.h"
 
 class ByteBuffer
 {
     public:
         const static size_t DEFAULT_SIZE = 0x1000;
 
+        // storage allocator, build with BYTEBUFFER_SYSTEM_ALLOCATOR to use the heap directly
+#ifdef BYTEBUFFER_SYSTEM_ALLOCATOR
+        typedef std::vector<uint8> StorageType;
+#else
+        typedef std::vector<uint8, ByteBufferAllocator<uint8> > StorageType;
+#endif
+
         // constructor
         ByteBuffer(): _rpos(0), _wpos(0)
         {
@@ -43,6 +51,21 @@ class ByteBuffer
         }
         // copy constructor
         ByteBuffer(const ByteBuffer &buf): _rpos(buf._rpos), _wpos(buf._wpos), _storage(buf._storage) { }
+        // move constructor, takes the storage of buf which is left empty
+        ByteBuffer(ByteBuffer &&buf): _rpos(buf._rpos), _wpos(buf._wpos), _storage(std::move(buf._storage))
+        {
+            buf._rpos = buf._wpos = 0;
+        }
+
+        ByteBuffer& operator=(const ByteBuffer &buf) = default;
+        ByteBuffer& operator=(ByteBuffer &&buf)
+        {
+            _rpos = buf._rpos;
+            _wpos = buf._wpos;
+            _storage = std::move(buf._storage);
+            buf._rpos = buf._wpos = 0;
+            return *this;
+        }
 
         void clear()
         {
@@ -287,6 +310,7 @@ class ByteBuffer
         const uint8 *contents() const { return &_storage[0]; }
 
         size_t size() const { return _storage.size(); }
+        size_t capacity() const { return _storage.capacity(); }
         bool empty() const { return _storage.empty(); }
 
         void resize(size_t newsize)
@@ -454,7 +478,7 @@ class ByteBuffer
         }
 
         size_t _rpos, _wpos;
-        std::vector<uint8> _storage;
+        StorageType _storage;
 };
 
 template <typename T> ByteBuffer &operator<<(ByteBuffer &b, std::vector<T> v)
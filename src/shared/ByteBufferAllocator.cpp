@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "ByteBufferAllocator.h"
+
+#include <ace/Guard_T.h>
+#include <ace/Thread_Mutex.h>
+#include <atomic>
+#include <new>
+
+namespace
+{
+    const size_t MIN_BLOCK_SIZE     = 32;
+    const size_t MAX_BLOCK_SIZE     = MIN_BLOCK_SIZE << (BYTEBUFFER_SIZE_CLASS_COUNT - 1);   // 64K
+    const size_t SLAB_SIZE          = 0x10000;
+    const size_t MAX_SLAB_BLOCK     = 0x1000;               // bigger classes are not carved from slabs
+    const size_t THREAD_CACHE_BYTES = 0x40000;              // per size class, above that half goes to the depot
+    const size_t DEPOT_BYTES        = 0x400000;             // per size class, above that big blocks are freed
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    // only used with static or thread storage, zero initialized
+    struct FreeList
+    {
+        void Push(FreeBlock* block)
+        {
+            block->next = head;
+            head = block;
+            ++count;
+        }
+
+        FreeBlock* Pop()
+        {
+            FreeBlock* block = head;
+            head = block->next;
+            --count;
+            return block;
+        }
+
+        FreeBlock* head;
+        size_t count;
+    };
+
+    // allocations and deallocations of the threads which exited or had no cache,
+    // the live threads count theirs in their cache
+    struct SizeClassCounters
+    {
+        std::atomic<uint64> allocations;
+        std::atomic<uint64> deallocations;
+        std::atomic<uint64> blocks;
+        std::atomic<uint64> freedBlocks;
+    };
+
+    struct ThreadCache;
+
+    SizeClassCounters s_counters[BYTEBUFFER_SIZE_CLASS_COUNT];
+    std::atomic<uint64> s_largeAllocations;
+    FreeList s_depot[BYTEBUFFER_SIZE_CLASS_COUNT];
+    ThreadCache* s_caches;                                  // live thread caches, under DepotLock
+
+    // never destroyed, buffers of static objects may be freed after the other statics
+    ACE_Thread_Mutex& DepotLock()
+    {
+        static ACE_Thread_Mutex* lock = new ACE_Thread_Mutex();
+        return *lock;
+    }
+
+    inline size_t BlockSize(uint32 sizeClass) { return MIN_BLOCK_SIZE << sizeClass; }
+
+    inline uint32 SizeClassOf(size_t size)
+    {
+        uint32 sizeClass = 0;
+        while (BlockSize(sizeClass) < size)
+            ++sizeClass;
+        return sizeClass;
+    }
+
+    inline size_t MaxBlocks(size_t bytes, uint32 sizeClass)
+    {
+        size_t count = bytes / BlockSize(sizeClass);
+        return count < 4 ? 4 : count;
+    }
+
+    // moves count blocks (or all) from list to the depot
+    void MoveToDepot(FreeList& list, uint32 sizeClass, size_t count)
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard(DepotLock());
+
+        FreeList& depot = s_depot[sizeClass];
+        size_t maxDepot = MaxBlocks(DEPOT_BYTES, sizeClass);
+
+        for (; count > 0 && list.head; --count)
+        {
+            FreeBlock* block = list.Pop();
+            if (BlockSize(sizeClass) > MAX_SLAB_BLOCK && depot.count >= maxDepot)
+            {
+                ::operator delete(block);
+                ++s_counters[sizeClass].freedBlocks;
+            }
+            else
+                depot.Push(block);
+        }
+    }
+
+    void TakeFromDepot(FreeList& list, uint32 sizeClass)
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard(DepotLock());
+
+        FreeList& depot = s_depot[sizeClass];
+        for (size_t count = MaxBlocks(THREAD_CACHE_BYTES, sizeClass) / 2; count > 0 && depot.head; --count)
+            list.Push(depot.Pop());
+    }
+
+    void Refill(FreeList& list, uint32 sizeClass)
+    {
+        TakeFromDepot(list, sizeClass);
+        if (list.head)
+            return;
+
+        size_t blockSize = BlockSize(sizeClass);
+        if (blockSize > MAX_SLAB_BLOCK)
+        {
+            list.Push(static_cast<FreeBlock*>(::operator new(blockSize)));
+            ++s_counters[sizeClass].blocks;
+            return;
+        }
+
+        // slabs are never given back: their blocks end up spread over all the caches. What a class
+        // holds is bounded by the peak of its blocks in use and cached, see the blocks counter
+        char* slab = static_cast<char*>(::operator new(SLAB_SIZE));
+        for (size_t offset = 0; offset < SLAB_SIZE; offset += blockSize)
+            list.Push(reinterpret_cast<FreeBlock*>(slab + offset));
+        s_counters[sizeClass].blocks += SLAB_SIZE / blockSize;
+    }
+
+    // only written by the owning thread, no locked instruction on the allocation path
+    inline void Increment(std::atomic<uint64>& counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    thread_local ThreadCache* t_cache;
+    thread_local bool t_exited;
+
+    struct ThreadCache
+    {
+        ThreadCache() : prev(NULL)
+        {
+            for (uint32 i = 0; i < BYTEBUFFER_SIZE_CLASS_COUNT; ++i)
+            {
+                lists[i] = FreeList();
+                allocations[i].store(0, std::memory_order_relaxed);
+                deallocations[i].store(0, std::memory_order_relaxed);
+            }
+
+            ACE_Guard<ACE_Thread_Mutex> guard(DepotLock());
+            next = s_caches;
+            if (next)
+                next->prev = this;
+            s_caches = this;
+        }
+
+        // blocks of an exiting thread stay usable by the others, its counts are kept
+        ~ThreadCache()
+        {
+            for (uint32 i = 0; i < BYTEBUFFER_SIZE_CLASS_COUNT; ++i)
+                MoveToDepot(lists[i], i, lists[i].count);
+
+            {
+                ACE_Guard<ACE_Thread_Mutex> guard(DepotLock());
+                for (uint32 i = 0; i < BYTEBUFFER_SIZE_CLASS_COUNT; ++i)
+                {
+                    s_counters[i].allocations += allocations[i].load(std::memory_order_relaxed);
+                    s_counters[i].deallocations += deallocations[i].load(std::memory_order_relaxed);
+                }
+
+                (prev ? prev->next : s_caches) = next;
+                if (next)
+                    next->prev = prev;
+            }
+
+            t_cache = NULL;
+            t_exited = true;
+        }
+
+        FreeList lists[BYTEBUFFER_SIZE_CLASS_COUNT];
+        std::atomic<uint64> allocations[BYTEBUFFER_SIZE_CLASS_COUNT];
+        std::atomic<uint64> deallocations[BYTEBUFFER_SIZE_CLASS_COUNT];
+        ThreadCache* prev;
+        ThreadCache* next;
+    };
+
+    // NULL once the thread cache is destroyed, the depot is then used directly
+    inline ThreadCache* GetThreadCache()
+    {
+        if (!t_cache && !t_exited)
+        {
+            static thread_local ThreadCache cache;
+            t_cache = &cache;
+        }
+
+        return t_cache;
+    }
+}
+
+void* ByteBufferPool::Allocate(size_t size)
+{
+    if (size > MAX_BLOCK_SIZE)
+    {
+        ++s_largeAllocations;
+        return ::operator new(size);
+    }
+
+    uint32 sizeClass = SizeClassOf(size);
+
+    ThreadCache* cache = GetThreadCache();
+    if (!cache)
+    {
+        s_counters[sizeClass].allocations.fetch_add(1, std::memory_order_relaxed);
+
+        FreeList list = FreeList();
+        Refill(list, sizeClass);
+        void* ptr = list.Pop();
+        MoveToDepot(list, sizeClass, list.count);
+        return ptr;
+    }
+
+    Increment(cache->allocations[sizeClass]);
+
+    FreeList& list = cache->lists[sizeClass];
+    if (!list.head)
+        Refill(list, sizeClass);
+
+    return list.Pop();
+}
+
+void ByteBufferPool::Deallocate(void* ptr, size_t size)
+{
+    if (size > MAX_BLOCK_SIZE)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+
+    uint32 sizeClass = SizeClassOf(size);
+
+    ThreadCache* cache = GetThreadCache();
+    if (!cache)
+    {
+        s_counters[sizeClass].deallocations.fetch_add(1, std::memory_order_relaxed);
+
+        FreeList list = FreeList();
+        list.Push(static_cast<FreeBlock*>(ptr));
+        MoveToDepot(list, sizeClass, 1);
+        return;
+    }
+
+    Increment(cache->deallocations[sizeClass]);
+
+    FreeList& list = cache->lists[sizeClass];
+    list.Push(static_cast<FreeBlock*>(ptr));
+
+    size_t maxCached = MaxBlocks(THREAD_CACHE_BYTES, sizeClass);
+    if (list.count > maxCached)
+        MoveToDepot(list, sizeClass, maxCached / 2);
+}
+
+void ByteBufferPool::GetStats(ByteBufferSizeClassStats (&stats)[BYTEBUFFER_SIZE_CLASS_COUNT], uint64& largeAllocations)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(DepotLock());
+
+    for (uint32 i = 0; i < BYTEBUFFER_SIZE_CLASS_COUNT; ++i)
+    {
+        stats[i].blockSize = BlockSize(i);
+        stats[i].allocations = s_counters[i].allocations.load(std::memory_order_relaxed);
+        stats[i].deallocations = s_counters[i].deallocations.load(std::memory_order_relaxed);
+        stats[i].blocks = s_counters[i].blocks.load(std::memory_order_relaxed);
+        stats[i].freedBlocks = s_counters[i].freedBlocks.load(std::memory_order_relaxed);
+
+        for (ThreadCache* cache = s_caches; cache; cache = cache->next)
+        {
+            stats[i].allocations += cache->allocations[i].load(std::memory_order_relaxed);
+            stats[i].deallocations += cache->deallocations[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    largeAllocations = s_largeAllocations.load(std::memory_order_relaxed);
+}
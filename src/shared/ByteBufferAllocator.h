@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TRINITYCORE_BYTEBUFFERALLOCATOR_H
+#define TRINITYCORE_BYTEBUFFERALLOCATOR_H
+
+#include "Platform/Define.h"
+#include <cstddef>
+
+#define BYTEBUFFER_SIZE_CLASS_COUNT 12
+
+struct ByteBufferSizeClassStats
+{
+    size_t blockSize;
+    uint64 allocations;
+    uint64 deallocations;
+    uint64 blocks;                                          // blocks created, carved from slabs or allocated alone
+    uint64 freedBlocks;                                     // blocks given back to the system
+};
+
+/*
+ * Size class pool behind ByteBuffer storage. Blocks from 32 bytes to 64K are rounded
+ * up to a power of two size class. Freed blocks go to a free list of the calling thread,
+ * thread caches exchange blocks in batches through a locked depot so buffers can be
+ * freed by another thread than the one which allocated them. Classes up to 4K are
+ * carved from 64K slabs which are kept for the process lifetime: the memory of these
+ * classes stays at the peak of their blocks in use and cached, reported by the stats
+ * as blocks * blockSize. Bigger classes are allocated alone and freed when the depot
+ * is full. Larger requests use the heap.
+ * Each thread counts its own allocations, GetStats sums them.
+ */
+class ByteBufferPool
+{
+    public:
+        static void* Allocate(size_t size);
+        static void Deallocate(void* ptr, size_t size);
+
+        static void GetStats(ByteBufferSizeClassStats (&stats)[BYTEBUFFER_SIZE_CLASS_COUNT], uint64& largeAllocations);
+};
+
+// std::allocator replacement for std::vector<uint8> in ByteBuffer
+template <class T>
+class ByteBufferAllocator
+{
+    public:
+        typedef T value_type;
+
+        ByteBufferAllocator() {}
+        template <class U> ByteBufferAllocator(ByteBufferAllocator<U> const&) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(ByteBufferPool::Allocate(n * sizeof(T))); }
+        void deallocate(T* ptr, size_t n) { ByteBufferPool::Deallocate(ptr, n * sizeof(T)); }
+};
+
+template <class T, class U>
+inline bool operator==(ByteBufferAllocator<T> const&, ByteBufferAllocator<U> const&) { return true; }
+
+template <class T, class U>
+inline bool operator!=(ByteBufferAllocator<T> const&, ByteBufferAllocator<U> const&) { return false; }
+
+#endif
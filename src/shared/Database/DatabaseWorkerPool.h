@@ -122,6 +122,9 @@ class DatabaseWorkerPool
         SQLTransaction BeginTransaction();
         void CommitTransaction(SQLTransaction transaction);
 
+        //! Number of async operations waiting for a worker thread
+        uint32 QueueSize() const { return uint32(m_queue->method_count()); }
+
         void escape_string(std::string& str)
         {
             if (str.empty())
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "LatencyHistogram.h"
+
+#define LATENCY_WINDOW_CLEARING (~uint64(0))
+
+static std::atomic<uint64> s_clock(0);
+
+uint64 LatencySnapshot::GetPercentile(float percentile) const
+{
+    if (!count)
+        return 0;
+
+    uint64 wanted = uint64(ceil(count * percentile));
+    uint64 seen = 0;
+    for (uint32 b = 0; b < LATENCY_BUCKETS - 1; ++b)
+    {
+        seen += buckets[b];
+        if (seen >= wanted)
+            return std::min(LatencyBucketLimit(b), max);
+    }
+
+    return max;                                             // the last bucket has no upper bound
+}
+
+LatencyHistogram::LatencyHistogram(uint32 windowSeconds, uint32 windowCount) : _windowCount(windowCount ? windowCount : 1),
+    _windowSeconds(windowSeconds ? windowSeconds : 1), _totalCount(0), _totalSum(0)
+{
+    _windows = new Window[_windowCount];
+    for (uint32 i = 0; i < _windowCount; ++i)
+    {
+        Window& window = _windows[i];
+        window.epoch.store(0, std::memory_order_relaxed);
+        window.count.store(0, std::memory_order_relaxed);
+        window.sum.store(0, std::memory_order_relaxed);
+        window.max.store(0, std::memory_order_relaxed);
+        for (uint32 b = 0; b < LATENCY_BUCKETS; ++b)
+            window.buckets[b].store(0, std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram::~LatencyHistogram()
+{
+    delete[] _windows;
+}
+
+void LatencyHistogram::SetClock(time_t now)
+{
+    s_clock.store(uint64(now), std::memory_order_relaxed);
+}
+
+uint64 LatencyHistogram::_Now()
+{
+    uint64 now = s_clock.load(std::memory_order_relaxed);
+    return now ? now : uint64(time(NULL));
+}
+
+// NULL while another thread clears the window
+LatencyHistogram::Window* LatencyHistogram::_GetWindow(uint64 epoch)
+{
+    Window& window = _windows[epoch % _windowCount];
+    uint64 current = window.epoch.load(std::memory_order_acquire);
+    if (current == epoch)
+        return &window;
+
+    // never clear a newer window for a late sample
+    if (current == LATENCY_WINDOW_CLEARING || current > epoch)
+        return NULL;
+
+    if (!window.epoch.compare_exchange_strong(current, LATENCY_WINDOW_CLEARING, std::memory_order_acq_rel))
+        return current == epoch ? &window : NULL;
+
+    window.count.store(0, std::memory_order_relaxed);
+    window.sum.store(0, std::memory_order_relaxed);
+    window.max.store(0, std::memory_order_relaxed);
+    for (uint32 b = 0; b < LATENCY_BUCKETS; ++b)
+        window.buckets[b].store(0, std::memory_order_relaxed);
+
+    window.epoch.store(epoch, std::memory_order_release);
+    return &window;
+}
+
+void LatencyHistogram::Record(uint64 us)
+{
+    _totalCount.fetch_add(1, std::memory_order_relaxed);
+    _totalSum.fetch_add(us, std::memory_order_relaxed);
+
+    Window* window = _GetWindow(_Now() / _windowSeconds);
+    if (!window)
+        return;
+
+    window->count.fetch_add(1, std::memory_order_relaxed);
+    window->sum.fetch_add(us, std::memory_order_relaxed);
+    uint64 max = window->max.load(std::memory_order_relaxed);
+    while (us > max && !window->max.compare_exchange_weak(max, us, std::memory_order_relaxed))
+        ;
+    window->buckets[LatencyBucket(us)].fetch_add(1, std::memory_order_relaxed);
+}
+
+LatencySnapshot LatencyHistogram::GetSnapshot(uint32 seconds) const
+{
+    uint64 epoch = _Now() / _windowSeconds;
+    uint64 windows = std::min<uint64>((seconds + _windowSeconds - 1) / _windowSeconds, _windowCount);
+    if (!windows)
+        windows = 1;
+
+    LatencySnapshot snapshot;
+
+    for (uint32 i = 0; i < _windowCount; ++i)
+    {
+        Window const& window = _windows[i];
+        uint64 windowEpoch = window.epoch.load(std::memory_order_acquire);
+        if (windowEpoch > epoch || windowEpoch + windows <= epoch)
+            continue;                                       // out of range or being cleared
+
+        snapshot.count += window.count.load(std::memory_order_relaxed);
+        snapshot.sum += window.sum.load(std::memory_order_relaxed);
+        uint64 max = window.max.load(std::memory_order_relaxed);
+        if (max > snapshot.max)
+            snapshot.max = max;
+        for (uint32 b = 0; b < LATENCY_BUCKETS; ++b)
+            snapshot.buckets[b] += window.buckets[b].load(std::memory_order_relaxed);
+    }
+
+    return snapshot;
+}
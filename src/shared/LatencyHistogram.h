@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TRINITY_LATENCYHISTOGRAM_H
+#define TRINITY_LATENCYHISTOGRAM_H
+
+#include "Common.h"
+
+#include <atomic>
+
+#define LATENCY_BUCKETS 96
+
+/*
+ * Buckets are log-linear on microseconds: values below 4 get their own bucket,
+ * every power of two above is split in 4 sub-buckets. Last bucket holds everything >= ~29s,
+ * percentiles falling in it report the max.
+ */
+inline uint32 LatencyBucket(uint64 us)
+{
+    if (us < 4)
+        return uint32(us);
+
+#if COMPILER == COMPILER_GNU
+    uint32 msb = 63 - __builtin_clzll(us);
+#else
+    uint32 msb = 0;
+    for (uint64 v = us; v > 1; v >>= 1)
+        ++msb;
+#endif
+
+    uint32 bucket = 4 + (msb - 2) * 4 + uint32((us >> (msb - 2)) & 3);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+// Upper bound (in microseconds) of the values stored in a bucket
+inline uint64 LatencyBucketLimit(uint32 bucket)
+{
+    if (bucket < 4)
+        return bucket + 1;
+
+    uint32 msb = (bucket - 4) / 4 + 2;
+    uint32 sub = (bucket - 4) % 4;
+    return (uint64(4 + sub + 1) << (msb - 2));
+}
+
+struct LatencySnapshot
+{
+    LatencySnapshot() : count(0), sum(0), max(0) { memset(buckets, 0, sizeof(buckets)); }
+
+    uint64 GetPercentile(float percentile) const;
+    uint64 GetAverage() const { return count ? sum / count : 0; }
+
+    uint64 count;
+    uint64 sum;
+    uint64 max;
+    uint64 buckets[LATENCY_BUCKETS];
+};
+
+/*
+ * Latency distribution over a sliding time range, kept as a ring of fixed length windows.
+ * Record() may be called from any thread, it takes no lock: the counters are relaxed atomics
+ * and the first sample of a new window clears it. Samples recorded while a window is cleared
+ * are dropped, samples racing with the switch may land in the neighbouring window.
+ * The lifetime count and sum are kept apart from the windows and only ever grow.
+ */
+class LatencyHistogram
+{
+    public:
+        explicit LatencyHistogram(uint32 windowSeconds = 10, uint32 windowCount = 30);
+        ~LatencyHistogram();
+
+        void Record(uint64 us);
+
+        // merges the windows covering the last 'seconds' (at least the current window)
+        LatencySnapshot GetSnapshot(uint32 seconds) const;
+        uint32 GetRange() const { return _windowSeconds * _windowCount; }
+
+        // every sample since the histogram was created, dropped ones included
+        uint64 GetTotalCount() const { return _totalCount.load(std::memory_order_relaxed); }
+        uint64 GetTotalSum() const { return _totalSum.load(std::memory_order_relaxed); }
+
+        // coarse clock of all histograms, set once per world tick; time(NULL) until it is set
+        static void SetClock(time_t now);
+
+    private:
+        LatencyHistogram(LatencyHistogram const&);
+        LatencyHistogram& operator=(LatencyHistogram const&);
+
+        struct Window
+        {
+            std::atomic<uint64> epoch;                      // LATENCY_WINDOW_CLEARING while cleared
+            std::atomic<uint64> count;
+            std::atomic<uint64> sum;
+            std::atomic<uint64> max;
+            std::atomic<uint32> buckets[LATENCY_BUCKETS];
+        };
+
+        static uint64 _Now();
+        Window* _GetWindow(uint64 epoch);
+
+        Window* _windows;
+        uint32 _windowCount;
+        uint32 _windowSeconds;
+        std::atomic<uint64> _totalCount;
+        std::atomic<uint64> _totalSum;
+};
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "Metrics.h"
+#include "Policies/SingletonImp.h"
+
+#include <sstream>
+
+INSTANTIATE_SINGLETON_1(MetricsRegistry);
+
+MetricsRegistry::MetricsRegistry() : _summaryRange(60)
+{
+}
+
+MetricsRegistry::~MetricsRegistry()
+{
+    for (MetricFamilyMap::iterator itr = _families.begin(); itr != _families.end(); ++itr)
+    {
+        for (std::map<std::string, MetricCounter*>::iterator citr = itr->second.counters.begin(); citr != itr->second.counters.end(); ++citr)
+            delete citr->second;
+        for (std::map<std::string, MetricGauge*>::iterator gitr = itr->second.gauges.begin(); gitr != itr->second.gauges.end(); ++gitr)
+            delete gitr->second;
+    }
+}
+
+MetricsRegistry::MetricFamily& MetricsRegistry::_GetFamily(std::string const& name, std::string const& help, MetricType type)
+{
+    MetricFamilyMap::iterator itr = _families.find(name);
+    if (itr == _families.end())
+    {
+        itr = _families.insert(MetricFamilyMap::value_type(name, MetricFamily())).first;
+        itr->second.type = type;
+        itr->second.help = help;
+    }
+
+    return itr->second;
+}
+
+MetricCounter* MetricsRegistry::GetCounter(std::string const& name, std::string const& help, std::string const& labels)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(_lock);
+
+    MetricFamily& family = _GetFamily(name, help, METRIC_COUNTER);
+    MetricCounter*& counter = family.counters[labels];
+    if (!counter)
+        counter = new MetricCounter();
+    return counter;
+}
+
+MetricGauge* MetricsRegistry::GetGauge(std::string const& name, std::string const& help, std::string const& labels)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(_lock);
+
+    MetricFamily& family = _GetFamily(name, help, METRIC_GAUGE);
+    MetricGauge*& gauge = family.gauges[labels];
+    if (!gauge)
+        gauge = new MetricGauge();
+    return gauge;
+}
+
+void MetricsRegistry::RegisterHistogram(std::string const& name, std::string const& help, std::string const& labels, LatencyHistogram const* histogram)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(_lock);
+
+    _GetFamily(name, help, METRIC_SUMMARY).histograms[labels] = histogram;
+}
+
+static void AppendSample(std::ostringstream& out, std::string const& name, std::string const& labels, std::string const& extraLabel)
+{
+    out << name;
+    if (!labels.empty() || !extraLabel.empty())
+    {
+        out << '{' << labels;
+        if (!labels.empty() && !extraLabel.empty())
+            out << ',';
+        out << extraLabel << '}';
+    }
+    out << ' ';
+}
+
+std::string MetricsRegistry::Render()
+{
+    static const float quantiles[] = { 0.5f, 0.9f, 0.99f };
+
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(6);
+
+    ACE_Guard<ACE_Thread_Mutex> guard(_lock);
+
+    for (MetricFamilyMap::const_iterator itr = _families.begin(); itr != _families.end(); ++itr)
+    {
+        MetricFamily const& family = itr->second;
+        out << "# HELP " << itr->first << ' ' << family.help << '\n';
+        out << "# TYPE " << itr->first << ' ' << (family.type == METRIC_COUNTER ? "counter" : family.type == METRIC_GAUGE ? "gauge" : "summary") << '\n';
+
+        for (std::map<std::string, MetricCounter*>::const_iterator citr = family.counters.begin(); citr != family.counters.end(); ++citr)
+        {
+            AppendSample(out, itr->first, citr->first, "");
+            out << citr->second->Get() << '\n';
+        }
+
+        for (std::map<std::string, MetricGauge*>::const_iterator gitr = family.gauges.begin(); gitr != family.gauges.end(); ++gitr)
+        {
+            AppendSample(out, itr->first, gitr->first, "");
+            out << gitr->second->Get() << '\n';
+        }
+
+        for (std::map<std::string, LatencyHistogram const*>::const_iterator hitr = family.histograms.begin(); hitr != family.histograms.end(); ++hitr)
+        {
+            LatencySnapshot snapshot = hitr->second->GetSnapshot(_summaryRange);
+            for (uint32 i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); ++i)
+            {
+                std::ostringstream quantile;
+                quantile << "quantile=\"" << quantiles[i] << '"';
+                AppendSample(out, itr->first, hitr->first, quantile.str());
+                out << snapshot.GetPercentile(quantiles[i]) / 1000000.0 << '\n';
+            }
+
+            // _sum and _count are cumulative, only the quantiles use the window
+            AppendSample(out, itr->first + "_sum", hitr->first, "");
+            out << hitr->second->GetTotalSum() / 1000000.0 << '\n';
+            AppendSample(out, itr->first + "_count", hitr->first, "");
+            out << hitr->second->GetTotalCount() << '\n';
+        }
+    }
+
+    return out.str();
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TRINITY_METRICS_H
+#define TRINITY_METRICS_H
+
+#include "Common.h"
+#include "Policies/Singleton.h"
+#include "LatencyHistogram.h"
+#include <atomic>
+
+enum MetricType
+{
+    METRIC_COUNTER      = 0,
+    METRIC_GAUGE        = 1,
+    METRIC_SUMMARY      = 2
+};
+
+// Monotonic counter, Add() may be called from any thread
+class MetricCounter
+{
+    public:
+        MetricCounter() : _value(0) {}
+
+        void Add(uint64 value = 1) { _value.fetch_add(value, std::memory_order_relaxed); }
+        uint64 Get() const { return _value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64> _value;
+};
+
+// Last known value, Set() may be called from any thread
+class MetricGauge
+{
+    public:
+        MetricGauge() : _value(0) {}
+
+        void Set(int64 value) { _value.store(value, std::memory_order_relaxed); }
+        void Add(int64 value) { _value.fetch_add(value, std::memory_order_relaxed); }
+        int64 Get() const { return _value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<int64> _value;
+};
+
+/*
+ * Registry of every exported metric. Metrics live as long as the registry, so callers
+ * keep the returned pointer and update it without lock. Render() builds the plaintext
+ * exposition format (Prometheus 0.0.4) and is only called from the metrics listener thread.
+ */
+class MetricsRegistry
+{
+    friend class Trinity::Singleton<MetricsRegistry>;
+    friend class Trinity::OperatorNew<MetricsRegistry>;
+
+    public:
+        ~MetricsRegistry();
+
+        // labels is the raw label list without braces, e.g. map="530"
+        MetricCounter* GetCounter(std::string const& name, std::string const& help, std::string const& labels = "");
+        MetricGauge* GetGauge(std::string const& name, std::string const& help, std::string const& labels = "");
+        // exported as a summary in seconds, histogram must outlive the registry
+        // quantiles cover the last SummaryRange seconds, _sum and _count every sample since start
+        void RegisterHistogram(std::string const& name, std::string const& help, std::string const& labels, LatencyHistogram const* histogram);
+
+        void SetSummaryRange(uint32 seconds) { _summaryRange = seconds; }
+        std::string Render();
+
+    private:
+        MetricsRegistry();
+
+        struct MetricFamily
+        {
+            MetricType type;
+            std::string help;
+            std::map<std::string, MetricCounter*> counters;
+            std::map<std::string, MetricGauge*> gauges;
+            std::map<std::string, LatencyHistogram const*> histograms;
+        };
+
+        MetricFamily& _GetFamily(std::string const& name, std::string const& help, MetricType type);
+
+        typedef std::map<std::string, MetricFamily> MetricFamilyMap;
+        MetricFamilyMap _families;
+        ACE_Thread_Mutex _lock;
+        uint32 _summaryRange;
+};
+
+#define sMetrics Trinity::Singleton<MetricsRegistry>::Instance()
+
+#endif
@@ -19,23 +19,52 @@
 #include "Profiler.h"
 #include "ProfilerMgr.h"
 
-Profiler::Profiler(std::string name)
+std::atomic<bool> Profiler::s_enabled(false);
+thread_local ProfilerThreadData* Profiler::s_threadData = NULL;
+thread_local bool Profiler::s_threadFull = false;
+
+ProfileZone::ProfileZone(const char* name) : _name(name)
+{
+    _id = sProfilerMgr.RegisterZone(name);
+}
+
+ProfilerThreadData::ProfilerThreadData(uint32 index) : _index(index), _current(PROFILER_ROOT_NODE), _nodeCount(0)
+{
+    _AddNode(PROFILER_ROOT_ZONE, PROFILER_ROOT_NODE);
+}
+
+uint32 ProfilerThreadData::_AddNode(uint32 zone, uint32 parent)
 {
-    //printf("[TRACE] %s\n", name.c_str());
-#ifdef PROFILING
-    _start = ACE_OS::gettimeofday();
-    _fctName = name;
-#endif // _PROFILING
+    uint32 index = _nodeCount.load(std::memory_order_relaxed);
+    if (index >= PROFILER_MAX_NODES)
+        return PROFILER_INVALID_NODE;
+
+    ProfileNode& node = _nodes[index];
+    node.zone = zone;
+    node.parent = parent;
+    node.firstChild = PROFILER_INVALID_NODE;
+    node.nextSibling = PROFILER_INVALID_NODE;
+    node.count.store(0, std::memory_order_relaxed);
+    node.totalNs.store(0, std::memory_order_relaxed);
+    node.childNs.store(0, std::memory_order_relaxed);
+    for (uint32 i = 0; i < PROFILER_HISTOGRAM_BUCKETS; ++i)
+        node.histogram[i].store(0, std::memory_order_relaxed);
+
+    if (index != PROFILER_ROOT_NODE)
+    {
+        node.nextSibling = _nodes[parent].firstChild;
+        _nodes[parent].firstChild = index;
+    }
+
+    // publish the node only once fully initialized, ProfilerMgr may read it from another thread
+    _nodeCount.store(index + 1, std::memory_order_release);
+    return index;
 }
 
-Profiler::~Profiler()
+void Profiler::_RegisterThread()
 {
-#ifdef PROFILING
-    _end = ACE_OS::gettimeofday();
-    
-    long elapsed = _end.usec() - _start.usec();
-    if (elapsed >= 0)
-        sProfilerMgr.report(_fctName, elapsed);
-#endif // _PROFILING
+    s_threadData = sProfilerMgr.RegisterThread();
+    if (!s_threadData)
+        s_threadFull = true;
 }
 
@@ -20,22 +20,176 @@
 #define    PROFILER_H
 
 #include "Common.h"
-#include <ace/Time_Value.h>
+#include "Timer.h"
+#include "LatencyHistogram.h"
+#include <atomic>
 
+#define PROFILER_MAX_ZONES          512
+#define PROFILER_MAX_NODES          1024
+#define PROFILER_MAX_THREADS        64
+#define PROFILER_HISTOGRAM_BUCKETS  LATENCY_BUCKETS
+
+#define PROFILER_ROOT_ZONE          0
+#define PROFILER_ROOT_NODE          0
+#define PROFILER_INVALID_NODE       0xFFFFFFFF
+
+// Static description of an instrumented zone, one instance per PROFILE_ZONE call site
+class ProfileZone
+{
+public:
+
+    explicit ProfileZone(const char* name);
+
+    const char* GetName() const { return _name; }
+    uint32 GetId() const { return _id; }
+
+private:
+
+    const char* _name;
+    uint32 _id;
+};
+
+/*
+ * Call tree node of one thread. Counters are only written by the owner thread,
+ * ProfilerMgr reads them between ticks, hence relaxed atomics and no lock.
+ */
+struct ProfileNode
+{
+    uint32 zone;
+    uint32 parent;
+    uint32 firstChild;
+    uint32 nextSibling;
+
+    std::atomic<uint64> count;
+    std::atomic<uint64> totalNs;
+    std::atomic<uint64> childNs;
+    std::atomic<uint32> histogram[PROFILER_HISTOGRAM_BUCKETS];
+};
+
+class ProfilerThreadData
+{
+public:
+
+    explicit ProfilerThreadData(uint32 index);
+
+    uint32 Enter(uint32 zone)
+    {
+        uint32 child = _nodes[_current].firstChild;
+        while (child != PROFILER_INVALID_NODE && _nodes[child].zone != zone)
+            child = _nodes[child].nextSibling;
+
+        if (child == PROFILER_INVALID_NODE)
+        {
+            child = _AddNode(zone, _current);
+            if (child == PROFILER_INVALID_NODE)
+                return PROFILER_INVALID_NODE;
+        }
+
+        _current = child;
+        return child;
+    }
+
+    void Leave(uint32 node, uint64 elapsedNs)
+    {
+        if (node == PROFILER_INVALID_NODE)
+            return;
+
+        ProfileNode& n = _nodes[node];
+        _Add(n.count, 1);
+        _Add(n.totalNs, elapsedNs);
+        uint32 bucket = LatencyBucket(elapsedNs / 1000);
+        n.histogram[bucket].store(n.histogram[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        _Add(_nodes[n.parent].childNs, elapsedNs);
+        _current = n.parent;
+    }
+
+    uint32 GetIndex() const { return _index; }
+    uint32 GetNodeCount() const { return _nodeCount.load(std::memory_order_acquire); }
+    ProfileNode const& GetNode(uint32 node) const { return _nodes[node]; }
+
+private:
+
+    static void _Add(std::atomic<uint64>& counter, uint64 value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    uint32 _AddNode(uint32 zone, uint32 parent);
+
+    uint32 _index;
+    uint32 _current;
+    std::atomic<uint32> _nodeCount;
+    ProfileNode _nodes[PROFILER_MAX_NODES];
+};
+
+// RAII zone measurement, see PROFILE_ZONE
 class Profiler
 {
-    
 public:
-    
-    Profiler(std::string name);
-    ~Profiler();
-    
+
+    explicit Profiler(ProfileZone const& zone)
+    {
+        if (!s_enabled.load(std::memory_order_relaxed) || !(_data = GetThreadData()))
+        {
+            _data = NULL;
+            return;
+        }
+
+        _node = _data->Enter(zone.GetId());
+        _start = getNSTime();
+    }
+
+    ~Profiler()
+    {
+        if (_data)
+            _data->Leave(_node, getNSTime() - _start);
+    }
+
+    static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+
+    // Per thread buffer, registered to ProfilerMgr on first use. NULL when too many threads registered.
+    static ProfilerThreadData* GetThreadData()
+    {
+        if (!s_threadData && !s_threadFull)
+            _RegisterThread();
+        return s_threadData;
+    }
+
 private:
-    
-    ACE_Time_Value _start;
-    ACE_Time_Value _end;
-    std::string _fctName;
+
+    Profiler(Profiler const&);
+    Profiler& operator=(Profiler const&);
+
+    static void _RegisterThread();
+
+    ProfilerThreadData* _data;
+    uint32 _node;
+    uint64 _start;
+
+    static std::atomic<bool> s_enabled;
+    static thread_local ProfilerThreadData* s_threadData;
+    static thread_local bool s_threadFull;
 };
 
+#if COMPILER == COMPILER_GNU
+#  define PROFILER_FUNCTION __PRETTY_FUNCTION__
+#else
+#  define PROFILER_FUNCTION __FUNCTION__
+#endif
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+
+// Measures the enclosing scope under a static zone name, compiled out without PROFILING
+#if defined PROFILING
+#define PROFILE_ZONE(name) \
+    static ProfileZone PROFILER_CONCAT(_profileZone, __LINE__)(name); \
+    Profiler PROFILER_CONCAT(_profiler, __LINE__)(PROFILER_CONCAT(_profileZone, __LINE__))
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
+
 #endif    /* PROFILER_H */
 
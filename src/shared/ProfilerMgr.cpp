@@ -20,50 +20,304 @@
 
 INSTANTIATE_SINGLETON_1(ProfilerMgr);
 
-ProfilerMgr::ProfilerMgr()
+ProfilerMgr::ProfilerMgr() : _zoneCount(0), _ticks(0)
 {
-    _data.clear();
+    // never reallocated, RegisterThread may push while Update reads
+    _threads.reserve(PROFILER_MAX_THREADS);
+
+    _zoneNames[_zoneCount++] = "<root>";
+    memset(_zones, 0, sizeof(_zones));
+
+    ProfileTreeNode root;
+    memset(&root, 0, sizeof(root));
+    root.zone = PROFILER_ROOT_ZONE;
+    root.parent = PROFILER_ROOT_NODE;
+    _tree.push_back(root);
 }
 
 ProfilerMgr::~ProfilerMgr()
 {
+    for (std::vector<ThreadState>::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+        delete itr->data;
+}
+
+uint32 ProfilerMgr::RegisterZone(const char* name)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(_registryLock);
+
+    // call sites sharing a name share the zone
+    for (uint32 i = 1; i < _zoneCount; ++i)
+        if (!strcmp(_zoneNames[i], name))
+            return i;
+
+    if (_zoneCount >= PROFILER_MAX_ZONES)
+        return PROFILER_ROOT_ZONE;
+
+    _zoneNames[_zoneCount] = name;
+    return _zoneCount++;
+}
+
+ProfilerThreadData* ProfilerMgr::RegisterThread()
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(_registryLock);
+
+    if (_threads.size() >= PROFILER_MAX_THREADS)
+        return NULL;
+
+    ThreadState state;
+    state.data = new ProfilerThreadData(_threads.size());
+    _threads.push_back(state);
+    return state.data;
+}
+
+uint32 ProfilerMgr::_GetTreeNode(uint32 parent, uint32 zone)
+{
+    std::pair<uint32, uint32> key(parent, zone);
+    std::map<std::pair<uint32, uint32>, uint32>::const_iterator itr = _treeIndex.find(key);
+    if (itr != _treeIndex.end())
+        return itr->second;
+
+    ProfileTreeNode node;
+    memset(&node, 0, sizeof(node));
+    node.zone = zone;
+    node.parent = parent;
+    _tree.push_back(node);
+
+    uint32 index = _tree.size() - 1;
+    _treeIndex[key] = index;
+    return index;
 }
 
-void ProfilerMgr::report(std::string name, long time)
+void ProfilerMgr::Update()
 {
-    ProfileDataMap::iterator itr = _data.find(name);
-    if (itr != _data.end()) { // Profiling data already existing
-        if (time < itr->second.min)
-            itr->second.min = time;
-        
-        if (time > itr->second.max)
-            itr->second.max = time;
-        
-        itr->second.avg = ((itr->second.avg * itr->second.count) + time);
-        itr->second.count++;
-        itr->second.avg /= float(itr->second.count);
+    if (!Profiler::IsEnabled())
+        return;
+
+    uint32 threadCount;
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard(_registryLock);
+        threadCount = _threads.size();
+    }
+
+    ACE_Guard<ACE_Thread_Mutex> guard(_dataLock);
+
+    for (uint32 t = 0; t < threadCount; ++t)
+    {
+        ThreadState& state = _threads[t];
+        ProfilerThreadData const* data = state.data;
+
+        uint32 nodeCount = data->GetNodeCount();
+        if (state.snapshots.size() < nodeCount)
+        {
+            NodeSnapshot empty;
+            memset(&empty, 0, sizeof(empty));
+            state.snapshots.resize(nodeCount, empty);
+            state.treeNodes.resize(nodeCount, PROFILER_INVALID_NODE);
+        }
+
+        // nodes are always created after their parent, so parents are mapped first
+        for (uint32 n = 1; n < nodeCount; ++n)
+        {
+            ProfileNode const& node = data->GetNode(n);
+            NodeSnapshot& snapshot = state.snapshots[n];
+
+            // mapped even if idle: a zone still open (e.g. the world tick) has children to merge
+            if (state.treeNodes[n] == PROFILER_INVALID_NODE)
+            {
+                uint32 parent = node.parent == PROFILER_ROOT_NODE ? PROFILER_ROOT_NODE : state.treeNodes[node.parent];
+                state.treeNodes[n] = _GetTreeNode(parent, node.zone);
+            }
+
+            uint64 count = node.count.load(std::memory_order_relaxed);
+            if (count == snapshot.count)
+                continue;
+
+            uint64 totalNs = node.totalNs.load(std::memory_order_relaxed);
+            uint64 childNs = node.childNs.load(std::memory_order_relaxed);
+            uint64 deltaTotal = totalNs - snapshot.totalNs;
+            uint64 deltaChild = childNs - snapshot.childNs;
+            uint64 deltaSelf = deltaTotal > deltaChild ? deltaTotal - deltaChild : 0;
+
+            ProfileTreeNode& treeNode = _tree[state.treeNodes[n]];
+            treeNode.count += count - snapshot.count;
+            treeNode.totalNs += deltaTotal;
+            treeNode.selfNs += deltaSelf;
+            treeNode.tickNs += deltaTotal;
+
+            ProfileData& zone = _zones[node.zone];
+            zone.count += count - snapshot.count;
+            zone.totalNs += deltaTotal;
+            zone.selfNs += deltaSelf;
+            zone.tickNs += deltaTotal;
+
+            for (uint32 b = 0; b < PROFILER_HISTOGRAM_BUCKETS; ++b)
+            {
+                uint32 value = node.histogram[b].load(std::memory_order_relaxed);
+                zone.histogram[b] += uint32(value - snapshot.histogram[b]);
+                snapshot.histogram[b] = value;
+            }
+
+            snapshot.count = count;
+            snapshot.totalNs = totalNs;
+            snapshot.childNs = childNs;
+        }
+    }
+
+    for (std::vector<ProfileTreeNode>::iterator itr = _tree.begin(); itr != _tree.end(); ++itr)
+    {
+        if (itr->tickNs > itr->maxTickNs)
+            itr->maxTickNs = itr->tickNs;
+        itr->tickNs = 0;
+    }
+
+    for (uint32 i = 0; i < PROFILER_MAX_ZONES; ++i)
+    {
+        if (_zones[i].tickNs > _zones[i].maxTickNs)
+            _zones[i].maxTickNs = _zones[i].tickNs;
+        _zones[i].tickNs = 0;
     }
-    else { // New profiling data
-        ProfileData data;
-        data.count = 1;
-        data.min = time;
-        data.max = time;
-        data.avg = float(time);
-        
-        _data[name] = data;
+
+    ++_ticks;
+}
+
+uint64 ProfilerMgr::_Percentile(ProfileData const& data, float percentile)
+{
+    uint64 total = 0;
+    for (uint32 b = 0; b < PROFILER_HISTOGRAM_BUCKETS; ++b)
+        total += data.histogram[b];
+
+    if (!total)
+        return 0;
+
+    uint64 wanted = uint64(ceil(total * percentile));
+    uint64 seen = 0;
+    for (uint32 b = 0; b < PROFILER_HISTOGRAM_BUCKETS; ++b)
+    {
+        seen += data.histogram[b];
+        if (seen >= wanted)
+            return LatencyBucketLimit(b);
     }
+
+    return LatencyBucketLimit(PROFILER_HISTOGRAM_BUCKETS - 1);
 }
 
-std::string ProfilerMgr::dump()
+struct ProfileZoneSorter
+{
+    ProfileZoneSorter(std::vector<uint64> const& keys) : _keys(keys) {}
+    bool operator()(uint32 a, uint32 b) const { return _keys[a] > _keys[b]; }
+    std::vector<uint64> const& _keys;
+};
+
+std::string ProfilerMgr::dump(uint32 count, ProfileSortOrder order)
 {
     std::ostringstream out;
-    
-    out << "[PROFILING DATA]\n";
-    for (ProfileDataMap::iterator itr = _data.begin(); itr != _data.end(); ++itr) {
-        out << "\t" << itr->first << ": " << itr->second.count << " calls";
-        out << " - min: " << itr->second.min << " max: " << itr->second.max << " avg: " << itr->second.avg << " µs\n";
+    char line[512];
+
+    uint32 zoneCount;
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard(_registryLock);
+        zoneCount = _zoneCount;
+    }
+
+    ACE_Guard<ACE_Thread_Mutex> guard(_dataLock);
+
+    std::vector<uint64> keys(zoneCount, 0);
+    std::vector<uint32> zones;
+    for (uint32 i = 1; i < zoneCount; ++i)
+    {
+        if (!_zones[i].count)
+            continue;
+
+        keys[i] = order == PROFILE_SORT_P99 ? _Percentile(_zones[i], 0.99f) : _zones[i].totalNs;
+        zones.push_back(i);
+    }
+
+    std::sort(zones.begin(), zones.end(), ProfileZoneSorter(keys));
+    if (zones.size() > count)
+        zones.resize(count);
+
+    out << "[PROFILING DATA] " << _ticks << " ticks, sorted by " << (order == PROFILE_SORT_P99 ? "p99" : "total") << " time\n";
+    snprintf(line, sizeof(line), "%-60s %10s %8s %10s %10s %8s %8s %9s\n", "zone", "calls", "/tick", "total ms", "self ms", "avg us", "p99 us", "maxtick");
+    out << line;
+
+    uint64 ticks = _ticks ? _ticks : 1;
+    for (std::vector<uint32>::const_iterator itr = zones.begin(); itr != zones.end(); ++itr)
+    {
+        ProfileData const& data = _zones[*itr];
+        snprintf(line, sizeof(line), "%-60.60s %10llu %8.1f %10.1f %10.1f %8llu %8llu %9.2f\n", _zoneNames[*itr],
+            (unsigned long long)data.count, float(data.count) / ticks, data.totalNs / 1000000.0f, data.selfNs / 1000000.0f,
+            (unsigned long long)(data.totalNs / data.count / 1000), (unsigned long long)_Percentile(data, 0.99f), data.maxTickNs / 1000000.0f);
+        out << line;
     }
     out << "[/PROFILING DATA]";
-    
+
+    return out.str();
+}
+
+void ProfilerMgr::_DumpTreeNode(std::ostringstream& out, uint32 node, uint32 depth, uint32 maxDepth, std::vector<std::vector<uint32> > const& children)
+{
+    if (node != PROFILER_ROOT_NODE)
+    {
+        ProfileTreeNode const& data = _tree[node];
+        ProfileTreeNode const& parent = _tree[data.parent];
+        char line[512];
+
+        float share = parent.totalNs ? data.totalNs * 100.0f / parent.totalNs : 100.0f;
+        snprintf(line, sizeof(line), "%*s%s: %llu calls, total %.1f ms (%.1f%%), self %.1f ms, max tick %.2f ms\n", int(depth * 2), "", _zoneNames[data.zone],
+            (unsigned long long)data.count, data.totalNs / 1000000.0f, share, data.selfNs / 1000000.0f, data.maxTickNs / 1000000.0f);
+        out << line;
+    }
+
+    if (depth >= maxDepth)
+        return;
+
+    for (std::vector<uint32>::const_iterator itr = children[node].begin(); itr != children[node].end(); ++itr)
+        _DumpTreeNode(out, *itr, node == PROFILER_ROOT_NODE ? depth : depth + 1, maxDepth, children);
+}
+
+struct ProfileTreeSorter
+{
+    ProfileTreeSorter(std::vector<ProfileTreeNode> const& tree) : _tree(tree) {}
+    bool operator()(uint32 a, uint32 b) const { return _tree[a].totalNs > _tree[b].totalNs; }
+    std::vector<ProfileTreeNode> const& _tree;
+};
+
+std::string ProfilerMgr::dumpTree(uint32 maxDepth)
+{
+    std::ostringstream out;
+
+    ACE_Guard<ACE_Thread_Mutex> registryGuard(_registryLock);
+    ACE_Guard<ACE_Thread_Mutex> guard(_dataLock);
+
+    std::vector<std::vector<uint32> > children(_tree.size());
+    for (uint32 i = 1; i < _tree.size(); ++i)
+        if (_tree[i].count)
+            children[_tree[i].parent].push_back(i);
+
+    for (uint32 i = 0; i < children.size(); ++i)
+        std::sort(children[i].begin(), children[i].end(), ProfileTreeSorter(_tree));
+
+    out << "[PROFILING TREE] " << _ticks << " ticks\n";
+    _DumpTreeNode(out, PROFILER_ROOT_NODE, 0, maxDepth, children);
+    out << "[/PROFILING TREE]";
+
     return out.str();
-}
\ No newline at end of file
+}
+
+void ProfilerMgr::clear()
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(_dataLock);
+
+    // thread snapshots are kept, next Update only merges what happened since now
+    memset(_zones, 0, sizeof(_zones));
+    for (std::vector<ProfileTreeNode>::iterator itr = _tree.begin(); itr != _tree.end(); ++itr)
+    {
+        itr->count = 0;
+        itr->totalNs = 0;
+        itr->selfNs = 0;
+        itr->tickNs = 0;
+        itr->maxTickNs = 0;
+    }
+    _ticks = 0;
+}
+
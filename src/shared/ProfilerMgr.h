@@ -23,44 +23,94 @@
 #include "Policies/SingletonImp.h"
 #include "Profiler.h"
 
+enum ProfileSortOrder
+{
+    PROFILE_SORT_TOTAL  = 0,
+    PROFILE_SORT_P99    = 1
+};
+
+// Flat statistics of a zone, all call paths merged
 struct ProfileData
 {
-    uint32 count;
-    long min;
-    long max;
-    float avg;
+    uint64 count;
+    uint64 totalNs;
+    uint64 selfNs;
+    uint64 tickNs;          // accumulated during the tick being merged
+    uint64 maxTickNs;
+    uint64 histogram[PROFILER_HISTOGRAM_BUCKETS];
 };
 
-typedef std::map<std::string, ProfileData> ProfileDataMap;
+// Node of the call tree merged from all threads
+struct ProfileTreeNode
+{
+    uint32 zone;
+    uint32 parent;
+    uint64 count;
+    uint64 totalNs;
+    uint64 selfNs;
+    uint64 tickNs;
+    uint64 maxTickNs;
+};
 
 class ProfilerMgr
 {
-    
+
 public:
-    
+
     friend class Trinity::Singleton<ProfilerMgr>;
     friend class Trinity::OperatorNew<ProfilerMgr>;
-    
+
     ~ProfilerMgr();
-    
-    void report(std::string name, long time);
-    std::string dump();
-    void clear() { _data.clear(); };
-    
+
+    uint32 RegisterZone(const char* name);
+    ProfilerThreadData* RegisterThread();
+
+    // Merges every thread buffer into the global statistics, called once per world tick
+    void Update();
+
+    std::string dump(uint32 count = 20, ProfileSortOrder order = PROFILE_SORT_TOTAL);
+    std::string dumpTree(uint32 maxDepth = 6);
+    void clear();
+
+    uint64 GetTickCount() const { return _ticks; }
+
 private:
 
+    struct NodeSnapshot
+    {
+        uint64 count;
+        uint64 totalNs;
+        uint64 childNs;
+        uint32 histogram[PROFILER_HISTOGRAM_BUCKETS];
+    };
+
+    struct ThreadState
+    {
+        ProfilerThreadData* data;
+        std::vector<NodeSnapshot> snapshots;
+        std::vector<uint32> treeNodes;          // thread node -> index in _tree
+    };
+
     ProfilerMgr();
-    
-    ProfileDataMap _data;
+
+    uint32 _GetTreeNode(uint32 parent, uint32 zone);
+    void _DumpTreeNode(std::ostringstream& out, uint32 node, uint32 depth, uint32 maxDepth, std::vector<std::vector<uint32> > const& children);
+    static uint64 _Percentile(ProfileData const& data, float percentile);
+
+    ACE_Thread_Mutex _registryLock;             // zone and thread registration
+    ACE_Thread_Mutex _dataLock;                 // merged statistics
+
+    const char* _zoneNames[PROFILER_MAX_ZONES];
+    uint32 _zoneCount;
+    std::vector<ThreadState> _threads;
+
+    ProfileData _zones[PROFILER_MAX_ZONES];
+    std::vector<ProfileTreeNode> _tree;
+    std::map<std::pair<uint32, uint32>, uint32> _treeIndex;
+    uint64 _ticks;
 };
 
-#if defined PROFILING
-#define PROFILE { \
-    Profiler profiler(__PRETTY_FUNCTION__); \
-                }
-#else
-#define PROFILE NULL
-#endif
+#define PROFILE PROFILE_ZONE(PROFILER_FUNCTION)
 
 #define sProfilerMgr Trinity::Singleton<ProfilerMgr>::Instance()
 
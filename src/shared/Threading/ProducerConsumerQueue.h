@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2008-2011 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2008 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRODUCERCONSUMERQUEUE_H
+#define PRODUCERCONSUMERQUEUE_H
+
+#include <atomic>
+#include <vector>
+
+namespace ACE_Based
+{
+    /*
+     * Bounded lock-free queue for one producer thread and one consumer thread at a time.
+     * The consumer may change between threads (world thread, map threads) as long as
+     * the hand-over is synchronized by the caller, which the world update phases are.
+     */
+    template <class T>
+        class ProducerConsumerQueue
+    {
+        public:
+
+            //! Capacity is rounded up to a power of two.
+            explicit ProducerConsumerQueue(size_t capacity)
+                : _head(0), _tail(0)
+            {
+                size_t size = 1;
+                while (size < capacity)
+                    size <<= 1;
+
+                _buffer.resize(size);
+                _mask = size - 1;
+            }
+
+            //! Adds an item to the queue, called by the producer. False if the queue is full.
+            bool add(const T& item)
+            {
+                size_t tail = _tail.load(std::memory_order_relaxed);
+                if (tail - _head.load(std::memory_order_acquire) > _mask)
+                    return false;
+
+                _buffer[tail & _mask] = item;
+                _tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            //! Gets the next item in the queue, if any, called by the consumer.
+            bool next(T& result)
+            {
+                size_t head = _head.load(std::memory_order_relaxed);
+                if (head == _tail.load(std::memory_order_acquire))
+                    return false;
+
+                result = _buffer[head & _mask];
+                _head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            //! Gets the next item if the checker accepts it, called by the consumer.
+            template<class Checker>
+            bool next(T& result, Checker& check)
+            {
+                size_t head = _head.load(std::memory_order_relaxed);
+                if (head == _tail.load(std::memory_order_acquire))
+                    return false;
+
+                result = _buffer[head & _mask];
+                if (!check.Process(result))
+                    return false;
+
+                _head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            bool empty() const
+            {
+                return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+            }
+
+            size_t size() const
+            {
+                return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+            }
+
+        private:
+            std::vector<T> _buffer;
+            size_t _mask;
+
+            // producer and consumer indexes on their own cache lines
+            char _pad0[64];
+            std::atomic<size_t> _head;
+            char _pad1[64];
+            std::atomic<size_t> _tail;
+            char _pad2[64];
+    };
+}
+#endif
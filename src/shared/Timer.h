@@ -35,6 +35,8 @@
 #   include <sys/timeb.h>
 #endif
 
+#include <chrono>
+
 #if PLATFORM == PLATFORM_WINDOWS
 inline uint32 getMSTime() { return GetTickCount(); }
 #else
@@ -61,6 +63,12 @@ inline uint32 GetMSTimeDiffToNow(uint32 oldMSTime)
     return GetMSTimeDiff(oldMSTime, getMSTime());
 }
 
+// Monotonic clock in nanoseconds, only meaningful as a difference between two calls
+inline uint64 getNSTime()
+{
+    return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
 class IntervalTimer
 {
     public:
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "WorldPacket.h"
+
+#include <atomic>
+
+namespace
+{
+    // indexed by opcode, 0 while unknown
+    std::atomic<uint16> s_sizeHints[0x10000];
+}
+
+size_t WorldPacket::GetSizeHint(uint16 opcode)
+{
+    uint16 hint = s_sizeHints[opcode].load(std::memory_order_relaxed);
+    return hint ? hint : 200;
+}
+
+void WorldPacket::LearnSize(uint16 opcode, size_t size)
+{
+    if (size == 0)
+        return;
+
+    if (size > 0xFFFF)
+        size = 0xFFFF;
+
+    uint16 hint = s_sizeHints[opcode].load(std::memory_order_relaxed);
+    if (size > hint)
+        hint = uint16(size);
+    else if (hint - size >= 8)
+        hint -= uint16((hint - size) / 8);
+    else
+        return;
+
+    s_sizeHints[opcode].store(hint, std::memory_order_relaxed);
+}
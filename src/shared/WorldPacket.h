@@ -31,19 +31,39 @@ class WorldPacket : public ByteBuffer
         WorldPacket()                                       : ByteBuffer(0), m_opcode(0)
         {
         }
-        explicit WorldPacket(uint16 opcode, size_t res=200) : ByteBuffer(res), m_opcode(opcode) { }
+                                                            // res=0 is not an empty buffer: it reserves the learned size hint
+                                                            // of the opcode (GetSizeHint), pass a size to reserve exactly that
+        explicit WorldPacket(uint16 opcode, size_t res=0)   : ByteBuffer(res ? res : GetSizeHint(opcode)), m_opcode(opcode) { }
                                                             // copy constructor
         WorldPacket(const WorldPacket &packet)              : ByteBuffer(packet), m_opcode(packet.m_opcode)
         {
+        }
+                                                            // move constructor, packet is left empty
+        WorldPacket(WorldPacket &&packet)                   : ByteBuffer(std::move(packet)), m_opcode(packet.m_opcode)
+        {
+        }
+
+        WorldPacket& operator=(const WorldPacket &packet) = default;
+        WorldPacket& operator=(WorldPacket &&packet)
+        {
+            ByteBuffer::operator=(std::move(packet));
+            m_opcode = packet.m_opcode;
+            return *this;
         }
 
-        void Initialize(uint16 opcode, size_t newres=200)
+        // newres=0 reserves the learned size hint, as the constructor
+        void Initialize(uint16 opcode, size_t newres=0)
         {
             clear();
-            _storage.reserve(newres);
+            _storage.reserve(newres ? newres : GetSizeHint(opcode));
             m_opcode = opcode;
         }
 
+        // reserve size for a new packet of this opcode, 200 until a packet of it is sent
+        static size_t GetSizeHint(uint16 opcode);
+        // called for every sent packet, the hint follows the recent sizes, growing at once and shrinking slowly
+        static void LearnSize(uint16 opcode, size_t size);
+
         uint16 GetOpcode() const { return m_opcode; }
         void SetOpcode(uint16 opcode) { m_opcode = opcode; }
 
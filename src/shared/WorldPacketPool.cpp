@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "WorldPacketPool.h"
+#include "Metrics.h"
+
+#include <ace/Guard_T.h>
+#include <ace/Thread_Mutex.h>
+#include <vector>
+
+namespace
+{
+    // storage capacity of each size class, client packets are at most 10240 bytes
+    const size_t SizeClasses[] = { 64, 256, 1024, 4096, 16384 };
+    const uint32 SIZE_CLASS_COUNT = sizeof(SizeClasses) / sizeof(SizeClasses[0]);
+
+    const size_t THREAD_CACHE_MAX = 256;                    // per size class
+    const size_t TRANSFER_BATCH   = 64;                     // packets moved between a cache and the depot at once
+    const size_t DEPOT_MAX        = 4096;                   // per size class, more are freed
+
+    typedef std::vector<WorldPacket*> PacketList;
+
+    struct Depot
+    {
+        PacketList packets[SIZE_CLASS_COUNT];
+
+        ~Depot()
+        {
+            for (uint32 i = 0; i < SIZE_CLASS_COUNT; ++i)
+                for (PacketList::const_iterator itr = packets[i].begin(); itr != packets[i].end(); ++itr)
+                    delete *itr;
+        }
+    };
+
+    ACE_Thread_Mutex s_depotLock;
+    Depot s_depot;
+
+    MetricCounter* AllocationCounter()
+    {
+        static MetricCounter* counter = sMetrics.GetCounter("wr_packet_pool_allocations_total", "Received packets allocated because the pool was empty");
+        return counter;
+    }
+
+    MetricCounter* ReuseCounter()
+    {
+        static MetricCounter* counter = sMetrics.GetCounter("wr_packet_pool_reuses_total", "Received packets taken from the pool");
+        return counter;
+    }
+
+    void MoveToDepot(PacketList& cache, uint32 sizeClass, size_t count)
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard(s_depotLock);
+
+        PacketList& depot = s_depot.packets[sizeClass];
+        for (; count > 0 && !cache.empty(); --count)
+        {
+            if (depot.size() < DEPOT_MAX)
+                depot.push_back(cache.back());
+            else
+                delete cache.back();
+            cache.pop_back();
+        }
+    }
+
+    void TakeFromDepot(PacketList& cache, uint32 sizeClass)
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard(s_depotLock);
+
+        PacketList& depot = s_depot.packets[sizeClass];
+        for (size_t count = TRANSFER_BATCH; count > 0 && !depot.empty(); --count)
+        {
+            cache.push_back(depot.back());
+            depot.pop_back();
+        }
+    }
+
+    struct ThreadCache
+    {
+        PacketList packets[SIZE_CLASS_COUNT];
+
+        // give everything back when the thread exits
+        ~ThreadCache()
+        {
+            for (uint32 i = 0; i < SIZE_CLASS_COUNT; ++i)
+                MoveToDepot(packets[i], i, packets[i].size());
+        }
+    };
+
+    thread_local ThreadCache t_cache;
+}
+
+WorldPacket* WorldPacketPool::Acquire(uint16 opcode, size_t size)
+{
+    uint32 sizeClass = 0;
+    while (sizeClass < SIZE_CLASS_COUNT && SizeClasses[sizeClass] < size)
+        ++sizeClass;
+
+    if (sizeClass == SIZE_CLASS_COUNT)
+    {
+        AllocationCounter()->Add();
+        return new WorldPacket(opcode, size);
+    }
+
+    PacketList& cache = t_cache.packets[sizeClass];
+    if (cache.empty())
+        TakeFromDepot(cache, sizeClass);
+
+    if (cache.empty())
+    {
+        AllocationCounter()->Add();
+        return new WorldPacket(opcode, SizeClasses[sizeClass]);
+    }
+
+    ReuseCounter()->Add();
+
+    WorldPacket* packet = cache.back();
+    cache.pop_back();
+    packet->Initialize(opcode, size);
+    return packet;
+}
+
+void WorldPacketPool::Release(WorldPacket* packet)
+{
+    // the biggest size class the storage can serve
+    size_t capacity = packet->capacity();
+    if (capacity < SizeClasses[0] || capacity > 2 * SizeClasses[SIZE_CLASS_COUNT - 1])
+    {
+        delete packet;
+        return;
+    }
+
+    uint32 sizeClass = SIZE_CLASS_COUNT - 1;
+    while (SizeClasses[sizeClass] > capacity)
+        --sizeClass;
+
+    PacketList& cache = t_cache.packets[sizeClass];
+    cache.push_back(packet);
+
+    if (cache.size() > THREAD_CACHE_MAX)
+        MoveToDepot(cache, sizeClass, TRANSFER_BATCH);
+}
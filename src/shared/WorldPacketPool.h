@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TRINITYCORE_WORLDPACKETPOOL_H
+#define TRINITYCORE_WORLDPACKETPOOL_H
+
+#include "WorldPacket.h"
+
+/*
+ * Recycles received WorldPackets with their storage. Released packets are kept by
+ * storage size class in a cache of the releasing thread, the caches exchange packets
+ * in batches through a shared depot: packets are allocated by the network threads
+ * and released by the world and map threads.
+ */
+class WorldPacketPool
+{
+    public:
+        // empty packet with storage reserved for at least size bytes
+        static WorldPacket* Acquire(uint16 opcode, size_t size);
+        // packet must come from Acquire, it may be released by any thread
+        static void Release(WorldPacket* packet);
+};
+
+// Gives the packet back to the pool when going out of scope, unless released
+class WorldPacketPoolPtr
+{
+    public:
+        explicit WorldPacketPoolPtr(WorldPacket* packet) : _packet(packet) {}
+        ~WorldPacketPoolPtr() { if (_packet) WorldPacketPool::Release(_packet); }
+
+        WorldPacket* release() { WorldPacket* packet = _packet; _packet = NULL; return packet; }
+
+    private:
+        WorldPacketPoolPtr(WorldPacketPoolPtr const&);
+        WorldPacketPoolPtr& operator=(WorldPacketPoolPtr const&);
+
+        WorldPacket* _packet;
+};
+
+#endif
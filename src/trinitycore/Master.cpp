@@ -38,6 +38,7 @@
 #include "Database/DatabaseEnv.h"
 #include "CliRunnable.h"
 #include "RASocket.h"
+#include "MetricsSocket.h"
 #include "ScriptCalls.h"
 #include "Util.h"
 #include "IRCMgr.h"
@@ -168,11 +169,38 @@ public:
           }
       }
 
+    // Launch the metrics listener socket, served by the same select loop
+    ListenSocket<MetricsSocket> MetricsListenSocket (h);
+    bool usemetrics = sConfig.GetBoolDefault ("Metrics.Enable", false);
+
+    if (usemetrics)
+      {
+        port_t metricsport = sConfig.GetIntDefault ("Metrics.Port", 9401);
+        std::string stringip = sConfig.GetStringDefault ("Metrics.IP", "127.0.0.1");
+        ipaddr_t metricsip;
+        if (!Utility::u2ip (stringip, metricsip))
+          {
+            sLog.outError ("Trinity metrics can not bind to ip %s", stringip.c_str ());
+            usemetrics = false;
+          }
+        else if (MetricsListenSocket.Bind (metricsip, metricsport))
+          {
+            sLog.outError ("Trinity metrics can not bind to port %d on %s", metricsport, stringip.c_str ());
+            usemetrics = false;
+          }
+        else
+          {
+            h.Add (&MetricsListenSocket);
+
+            sLog.outString ("Starting metrics listener on port %d on %s", metricsport, stringip.c_str ());
+          }
+      }
+
     // Socket Selet time is in microseconds , not miliseconds!!
     uint32 socketSelecttime = sWorld.getConfig (CONFIG_SOCKET_SELECTTIME);
 
-    // if use ra spend time waiting for io, if not use ra ,just sleep
-    if (usera)
+    // if use ra or metrics spend time waiting for io, if not ,just sleep
+    if (usera || usemetrics)
       while (!World::IsStopped())
         {
           h.Select (0, socketSelecttime);
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** \file
+    \ingroup Trinityd
+*/
+
+#include "Common.h"
+#include "Log.h"
+#include "MetricsSocket.h"
+#include "Metrics.h"
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+/// Process memory is sampled here, on the listener thread, and not by the world thread
+static void UpdateMemoryMetrics()
+{
+#ifndef WIN32
+    static MetricGauge* residentBytes = sMetrics.GetGauge("wr_process_resident_memory_bytes", "Resident memory of the world server");
+    static MetricGauge* virtualBytes = sMetrics.GetGauge("wr_process_virtual_memory_bytes", "Virtual memory of the world server");
+
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (!fp)
+        return;
+
+    unsigned long size, resident;
+    if (fscanf(fp, "%lu %lu", &size, &resident) == 2)
+    {
+        long pageSize = sysconf(_SC_PAGESIZE);
+        virtualBytes->Set(int64(size) * pageSize);
+        residentBytes->Set(int64(resident) * pageSize);
+    }
+    fclose(fp);
+#endif
+}
+
+MetricsSocket::MetricsSocket(ISocketHandler &h): TcpSocket(h)
+{
+}
+
+/// Wait for the end of the request line, then send everything and close
+void MetricsSocket::OnRead()
+{
+    TcpSocket::OnRead();
+
+    unsigned int sz = ibuf.GetLength();
+    if (m_request.size() + sz > METRICS_REQUEST_SIZE)
+    {
+        SetCloseAndDelete();
+        return;
+    }
+
+    std::vector<char> inp(sz);
+    ibuf.Read(&inp[0], sz);
+    m_request.append(&inp[0], sz);
+
+    std::string::size_type eol = m_request.find('\n');
+    if (eol == std::string::npos)
+        return;
+
+    UpdateMemoryMetrics();
+    std::string body = sMetrics.Render();
+
+    // plain "\n" from netcat gets the bare text, anything else is treated as HTTP
+    if (eol > 1)
+    {
+        std::ostringstream header;
+        header << "HTTP/1.0 200 OK\r\n"
+               << "Content-Type: text/plain; version=0.0.4\r\n"
+               << "Content-Length: " << body.size() << "\r\n"
+               << "Connection: close\r\n\r\n";
+        SendBuf(header.str().c_str(), header.str().size());
+    }
+
+    SendBuf(body.c_str(), body.size());
+    SetCloseAndDelete();
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/// \addtogroup Trinityd
+/// @{
+/// \file
+
+#ifndef _METRICSSOCKET_H
+#define _METRICSSOCKET_H
+
+#include "Common.h"
+#include "sockets/TcpSocket.h"
+
+#define METRICS_REQUEST_SIZE 4096
+
+class ISocketHandler;
+
+/// Answers any HTTP request (or a bare newline) with the metrics registry in plaintext exposition format
+class MetricsSocket: public TcpSocket
+{
+    public:
+
+        MetricsSocket(ISocketHandler& h);
+
+        void OnRead();
+
+    private:
+
+        std::string m_request;
+};
+#endif
+/// @}
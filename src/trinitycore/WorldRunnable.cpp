@@ -30,6 +30,7 @@
 #include "ObjectAccessor.h"
 #include "MapManager.h"
 #include "BattleGroundMgr.h"
+#include "ProfilerMgr.h"
 
 #include "Database/DatabaseEnv.h"
 
@@ -80,6 +81,7 @@ void WorldRunnable::run()
         uint32 diff = GetMSTimeDiff(realPrevTime,realCurrTime);
 
         sWorld.Update( diff );
+        sProfilerMgr.Update();
         realPrevTime = realCurrTime;
 
         // diff (D0) include time of previous sleep (d0) + tick time (t0)
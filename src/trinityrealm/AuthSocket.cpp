@@ -24,6 +24,7 @@
 
 #include "Common.h"
 #include "Database/DatabaseEnv.h"
+#include "Database/AsyncDatabaseImpl.h"
 #include "ByteBuffer.h"
 #include "Config/ConfigEnv.h"
 #include "Log.h"
@@ -32,6 +33,7 @@
 #include "AuthCodes.h"
 #include <openssl/md5.h>
 #include "Auth/Sha1.h"
+#include "Auth/SRP6.h"
 //#include "Util.h" -- for commented utf8ToUpperOnlyLatin
 
 extern RealmList m_realmList;
@@ -222,12 +224,132 @@ const AuthHandler table[] =
 ///Holds the MD5 hash of client patches present on the server
 Patcher PatchesCache;
 
-/// Constructor - set the N and g values for SRP6
-AuthSocket::AuthSocket(ISocketHandler &h) : TcpSocket(h)
+/// Logon challenge lookups, run together by one login database worker
+enum AuthQueryIndex
+{
+    AUTH_QUERY_IP_BANNED        = 0,
+    AUTH_QUERY_ACCOUNT          = 1,
+    AUTH_QUERY_ACCOUNT_BANNED   = 2,
+    MAX_AUTH_QUERY
+};
+
+class AuthQueryHolder : public SQLQueryHolder
+{
+    private:
+        uint32 m_sessionId;
+    public:
+        AuthQueryHolder(uint32 sessionId) : m_sessionId(sessionId) { SetSize(MAX_AUTH_QUERY); }
+        uint32 GetSessionId() const { return m_sessionId; }
+};
+
+// don't keep the AuthSocket in the callbacks, it may get deleted before they
+// get executed, a session id is passed instead
+AuthSocket::SessionMap AuthSocket::s_sessions;
+uint32 AuthSocket::s_nextSessionId = 0;
+
+/// Dispatch the login database answers to the socket that asked for them
+class AuthQueryHandler
+{
+    public:
+        void HandleLogonChallengeCallback(QueryResult* /*dummy*/, SQLQueryHolder* holder)
+        {
+            AuthQueryHolder* authHolder = (AuthQueryHolder*)holder;
+            if (AuthSocket* socket = AuthSocket::FindSession(authHolder->GetSessionId()))
+                socket->_HandleLogonChallengeResult(holder);
+            else
+            {
+                for (size_t i = 0; i < MAX_AUTH_QUERY; ++i)
+                    delete holder->GetResult(i);
+            }
+
+            delete holder;
+        }
+
+        void HandleReconnectChallengeCallback(QueryResult* result, uint32 sessionId)
+        {
+            if (AuthSocket* socket = AuthSocket::FindSession(sessionId))
+                socket->_HandleReconnectChallengeResult(result);
+            else
+                delete result;
+        }
+
+        void HandleRealmListCallback(QueryResult* result, uint32 sessionId)
+        {
+            if (AuthSocket* socket = AuthSocket::FindSession(sessionId))
+                socket->_HandleRealmListResult(result);
+            else
+                delete result;
+        }
+
+        // does not need the socket, the account or IP is banned even if the client is gone
+        void HandleWrongPassCallback(QueryResult* result, std::string login, std::string address)
+        {
+            if (!result)
+                return;
+
+            Field* fields = result->Fetch();
+            uint32 acc_id = fields[0].GetUInt32();
+            uint32 failed_logins = fields[1].GetUInt32() + 1;
+            delete result;
+
+            //Increment number of failed logins by one and if it reaches the limit temporarily ban that account or IP
+            LoginDatabase.PExecute("UPDATE account SET failed_logins = failed_logins + 1 WHERE id = '%u'", acc_id);
+
+            uint32 MaxWrongPassCount = sConfig.GetIntDefault("WrongPass.MaxCount", 0);
+            if (failed_logins < MaxWrongPassCount)
+                return;
+
+            uint32 WrongPassBanTime = sConfig.GetIntDefault("WrongPass.BanTime", 600);
+            bool WrongPassBanType = sConfig.GetBoolDefault("WrongPass.BanType", false);
+
+            if(WrongPassBanType)
+            {
+                LoginDatabase.PExecute("INSERT INTO account_banned VALUES ('%u',UNIX_TIMESTAMP(),UNIX_TIMESTAMP()+'%u','Trinity realmd','Failed login autoban',1)",
+                    acc_id, WrongPassBanTime);
+                sLog.outBasic("[AuthChallenge] account %s got banned for '%u' seconds because it failed to authenticate '%u' times",
+                    login.c_str(), WrongPassBanTime, failed_logins);
+            }
+            else
+            {
+                LoginDatabase.escape_string(address);
+                LoginDatabase.PExecute("INSERT INTO ip_banned VALUES ('%s',UNIX_TIMESTAMP(),UNIX_TIMESTAMP()+'%u','Trinity realmd','Failed login autoban')",
+                    address.c_str(), WrongPassBanTime);
+                sLog.outBasic("[AuthChallenge] IP %s got banned for '%u' seconds because account %s failed to authenticate '%u' times",
+                    address.c_str(), WrongPassBanTime, login.c_str(), failed_logins);
+            }
+        }
+} authQueryHandler;
+
+/// SRP6 values shared by all connections, computed once
+static SRP6& GetSRP6()
+{
+    static SRP6 srp;
+    return srp;
+}
+
+/**
+ * Verifier of the last logins, only used by the main thread.
+ * Entries are keyed by account and checked against sha_pass_hash,
+ * a changed password makes the entry stale and it is recomputed.
+ */
+struct SRP6Verifier
+{
+    std::string shaPassHash;
+    BigNumber s, v;
+};
+
+typedef UNORDERED_MAP<uint32, SRP6Verifier> SRP6VerifierCache;
+static SRP6VerifierCache s_verifierCache;
+
+#define SRP6_VERIFIER_CACHE_SIZE 10000
+
+/// Constructor
+AuthSocket::AuthSocket()
 {
-    N.SetHexStr("894B645E89E1535BBDAD5B8B290650530801B18EBFBF5E8FAB3C82872A3E9BB7");
-    g.SetDword(7);
     _authed = false;
+    _queryPending = false;
+    _sessionId = 0;
+    _accountId = 0;
     pPatch = NULL;
 
     _accountSecurityLevel = SEC_PLAYER;
@@ -241,32 +363,50 @@ AuthSocket::~AuthSocket()
         fclose(pPatch);
 }
 
+/// Find an open connection by id
+AuthSocket* AuthSocket::FindSession(uint32 sessionId)
+{
+    SessionMap::const_iterator itr = s_sessions.find(sessionId);
+    return itr != s_sessions.end() ? itr->second : NULL;
+}
+
 /// Accept the connection and set the s random value for SRP6
 void AuthSocket::OnAccept()
 {
     sLog.outBasic("Accepting connection from '%s:%d'",
         GetRemoteAddress().c_str(), GetRemotePort());
 
+    _sessionId = ++s_nextSessionId;
+    s_sessions[_sessionId] = this;
+
     s.SetRand(s_BYTE_SIZE * 8);
 }
 
+/// Forget the connection, answers still in the login database queue are dropped
+void AuthSocket::OnClose()
+{
+    s_sessions.erase(_sessionId);
+}
+
 /// Read the packet from the client
 void AuthSocket::OnRead()
 {
-    ///- Read the packet
-    TcpSocket::OnRead();
     uint8 _cmd;
     while (1)
     {
-        if (!ibuf.GetLength())
+        ///- Keep the next commands in the buffer until the pending query is answered
+        if (_queryPending || IsClosed())
+            return;
+
+        if (!RecvLength())
             return;
 
         ///- Get the command out of it
-        ibuf.SoftRead((char *)&_cmd, 1);                    // UQ1: No longer exists in new net code ???
-        //ibuf.Read((char *)&_cmd, 1);
+        RecvSoft((char *)&_cmd, 1);                    // UQ1: No longer exists in new net code ???
+        //Recv((char *)&_cmd, 1);
         /*char *command = (char *)malloc(1);
 
-        ibuf.Read(command, 1);
+        Recv(command, 1);
 
         _cmd = (uint8)command;*/
         //      assert(0);
@@ -279,11 +419,11 @@ void AuthSocket::OnRead()
                 (table[i].status == STATUS_CONNECTED ||
                 (_authed && table[i].status == STATUS_AUTHED)))
             {
-                DEBUG_LOG("[Auth] got data for cmd %u ibuf length %u", (uint32)_cmd, ibuf.GetLength());
+                DEBUG_LOG("[Auth] got data for cmd %u ibuf length %u", (uint32)_cmd, RecvLength());
 
                 if (!(*this.*table[i].handler)())
                 {
-                    DEBUG_LOG("Command handler failed for cmd %u ibuf length %u", (uint32)_cmd, ibuf.GetLength());
+                    DEBUG_LOG("Command handler failed for cmd %u ibuf length %u", (uint32)_cmd, RecvLength());
                     return;
                 }
                 break;
@@ -302,24 +442,31 @@ void AuthSocket::OnRead()
 /// Make the SRP6 calculation from hash in dB
 void AuthSocket::_SetVSFields(const std::string& rI)
 {
-    BigNumber I;
-    I.SetHexStr(rI.c_str());
+    SRP6VerifierCache::const_iterator itr = s_verifierCache.find(_accountId);
+    if (itr != s_verifierCache.end() && itr->second.shaPassHash == rI)
+    {
+        s = itr->second.s;
+        v = itr->second.v;
+        _WriteVSFields();
+        return;
+    }
 
-    //In case of leading zeroes in the rI hash, restore them
-    uint8 mDigest[SHA_DIGEST_LENGTH];
-    memset(mDigest,0,SHA_DIGEST_LENGTH);
-    if (I.GetNumBytes() <= SHA_DIGEST_LENGTH)
-        memcpy(mDigest,I.AsByteArray(),I.GetNumBytes());
+    v = GetSRP6().ComputeVerifier(s, rI);
 
-    std::reverse(mDigest,mDigest+SHA_DIGEST_LENGTH);
+    if (s_verifierCache.size() >= SRP6_VERIFIER_CACHE_SIZE)
+        s_verifierCache.clear();
 
-    Sha1Hash sha;
-    sha.UpdateData(s.AsByteArray(), s.GetNumBytes());
-    sha.UpdateData(mDigest, SHA_DIGEST_LENGTH);
-    sha.Finalize();
-    BigNumber x;
-    x.SetBinary(sha.GetDigest(), sha.GetLength());
-    v = g.ModExp(x, N);
+    SRP6Verifier& entry = s_verifierCache[_accountId];
+    entry.shaPassHash = rI;
+    entry.s = s;
+    entry.v = v;
+
+    _WriteVSFields();
+}
+
+/// Store v and s in the account table, mangosd clears them after each login
+void AuthSocket::_WriteVSFields()
+{
     // No SQL injection (username escaped)
     const char *v_hex, *s_hex;
     v_hex = v.AsHexStr();
@@ -333,22 +480,25 @@ void AuthSocket::_SetVSFields(const std::string& rI)
 bool AuthSocket::_HandleLogonChallenge()
 {
     DEBUG_LOG("Entering _HandleLogonChallenge");
-    if (ibuf.GetLength() < sizeof(sAuthLogonChallenge_C))
+    if (RecvLength() < sizeof(sAuthLogonChallenge_C))
         return false;
 
-    ///- Read the first 4 bytes (header) to get the length of the remaining of the packet
+    ///- Peek the first 4 bytes (header) to get the length of the remaining of the packet,
+    ///- the header stays in the input buffer until the whole packet is there
     std::vector<uint8> buf;
     buf.resize(4);
 
-    ibuf.Read((char *)&buf[0], 4);
+    RecvSoft((char *)&buf[0], 4);
 
     EndianConvert(*((uint16*)(buf[0])));
     uint16 remaining = ((sAuthLogonChallenge_C *)&buf[0])->size;
     DEBUG_LOG("[AuthChallenge] got header, body is %#04x bytes", remaining);
 
-    if ((remaining < sizeof(sAuthLogonChallenge_C) - buf.size()) || (ibuf.GetLength() < remaining))
+    if ((remaining < sizeof(sAuthLogonChallenge_C) - buf.size()) || (RecvLength() < buf.size() + remaining))
         return false;
 
+    RecvSkip(buf.size());
+
     //No big fear of memory outage (size is int16, i.e. < 65536)
     buf.resize(remaining + buf.size() + 1);
     buf[buf.size() - 1] = 0;
@@ -365,12 +515,10 @@ bool AuthSocket::_HandleLogonChallenge()
     EndianConvert(ch->ip);
 
     ///- Read the remaining of the packet
-    ibuf.Read((char *)&buf[4], remaining);
+    Recv((char *)&buf[4], remaining);
     DEBUG_LOG("[AuthChallenge] got full packet, %#04x bytes", ch->size);
     DEBUG_LOG("[AuthChallenge] name(%d): '%s'", ch->I_len, ch->I);
 
-    ByteBuffer pkt;
-
     _login = (const char*)ch->I;
     _build = ch->build;
     
@@ -390,120 +538,139 @@ bool AuthSocket::_HandleLogonChallenge()
     _safelogin=_login;
     LoginDatabase.escape_string(_safelogin);
 
-    pkt << (uint8) AUTH_LOGON_CHALLENGE;
-    pkt << (uint8) 0x00;
-
-    ///- Verify that this IP is not in the ip_banned table
-    // No SQL injection possible (paste the IP address as passed by the socket)
-    LoginDatabase.Execute("DELETE FROM ip_banned WHERE unbandate<=UNIX_TIMESTAMP() AND unbandate<>bandate");
+    _localizationName.resize(4);
+    for(int i = 0; i <4; ++i)
+        _localizationName[i] = ch->country[4-i-1];
 
+    ///- Verify that this IP and the account are not banned and get the account details
+    // the queries run on a login database worker, the answer is sent by _HandleLogonChallengeResult
+    // expired bans are skipped here and cleaned up periodically by the main loop
+    // No SQL injection (escaped user name and IP address as passed by the socket)
     std::string address = GetRemoteAddress();
     LoginDatabase.escape_string(address);
-    QueryResult *result = LoginDatabase.PQuery(  "SELECT * FROM ip_banned WHERE ip = '%s'",address.c_str());
-    if(result)
+
+    AuthQueryHolder* holder = new AuthQueryHolder(_sessionId);
+    holder->SetPQuery(AUTH_QUERY_IP_BANNED, "SELECT unbandate FROM ip_banned WHERE ip = '%s' AND (unbandate > UNIX_TIMESTAMP() OR unbandate = bandate)", address.c_str());
+    holder->SetPQuery(AUTH_QUERY_ACCOUNT, "SELECT sha_pass_hash,id,locked,last_ip,gmlevel FROM account WHERE username = '%s'", _safelogin.c_str());
+    holder->SetPQuery(AUTH_QUERY_ACCOUNT_BANNED, "SELECT bandate,unbandate FROM account_banned WHERE id = (SELECT id FROM account WHERE username = '%s') AND active = 1 AND (unbandate > UNIX_TIMESTAMP() OR unbandate = bandate)", _safelogin.c_str());
+
+    if (!LoginDatabase.DelayQueryHolder(&authQueryHandler, &AuthQueryHandler::HandleLogonChallengeCallback, holder))
+    {
+        delete holder;
+        CloseSocket();
+        return false;
+    }
+
+    _queryPending = true;
+    return true;
+}
+
+/// Logon Challenge answer, once the ban and account lookups are done
+void AuthSocket::_HandleLogonChallengeResult(SQLQueryHolder* holder)
+{
+    _queryPending = false;
+
+    QueryResult *ipbanresult = holder->GetResult(AUTH_QUERY_IP_BANNED);
+    QueryResult *result = holder->GetResult(AUTH_QUERY_ACCOUNT);
+    QueryResult *banresult = holder->GetResult(AUTH_QUERY_ACCOUNT_BANNED);
+
+    ByteBuffer pkt;
+    pkt << (uint8) AUTH_LOGON_CHALLENGE;
+    pkt << (uint8) 0x00;
+
+    if(ipbanresult)
     {
         pkt << (uint8)REALM_AUTH_ACCOUNT_BANNED;
         sLog.outBasic("[AuthChallenge] Banned ip %s tries to login!",GetRemoteAddress().c_str ());
-        delete result;
     }
-    else
+    else if( result )
     {
-        ///- Get the account details from the account table
-        // No SQL injection (escaped user name)
-
-        result = LoginDatabase.PQuery("SELECT sha_pass_hash,id,locked,last_ip,gmlevel FROM account WHERE username = '%s'",_safelogin.c_str ());
-        if( result )
+        ///- If the IP is 'locked', check that the player comes indeed from the correct IP address
+        bool locked = false;
+        if((*result)[2].GetUInt8() == 1)            // if ip is locked
         {
-            ///- If the IP is 'locked', check that the player comes indeed from the correct IP address
-            bool locked = false;
-            if((*result)[2].GetUInt8() == 1)            // if ip is locked
+            DEBUG_LOG("[AuthChallenge] Account '%s' is locked to IP - '%s'", _login.c_str(), (*result)[3].GetString());
+            DEBUG_LOG("[AuthChallenge] Player address is '%s'", GetRemoteAddress().c_str());
+            if ( strcmp((*result)[3].GetString(),GetRemoteAddress().c_str()) )
             {
-                DEBUG_LOG("[AuthChallenge] Account '%s' is locked to IP - '%s'", _login.c_str(), (*result)[3].GetString());
-                DEBUG_LOG("[AuthChallenge] Player address is '%s'", GetRemoteAddress().c_str());
-                if ( strcmp((*result)[3].GetString(),GetRemoteAddress().c_str()) )
-                {
-                    DEBUG_LOG("[AuthChallenge] Account IP differs");
-                    pkt << (uint8) REALM_AUTH_ACCOUNT_LOCKED;
-                    locked=true;
-                }
-                else
-                {
-                    DEBUG_LOG("[AuthChallenge] Account IP matches");
-                }
+                DEBUG_LOG("[AuthChallenge] Account IP differs");
+                pkt << (uint8) REALM_AUTH_ACCOUNT_LOCKED;
+                locked=true;
             }
             else
             {
-                DEBUG_LOG("[AuthChallenge] Account '%s' is not locked to ip", _login.c_str());
+                DEBUG_LOG("[AuthChallenge] Account IP matches");
             }
+        }
+        else
+        {
+            DEBUG_LOG("[AuthChallenge] Account '%s' is not locked to ip", _login.c_str());
+        }
 
-            if (!locked)
+        if (!locked)
+        {
+            ///- If the account is banned, reject the logon attempt
+            if(banresult)
             {
-                //set expired bans to inactive
-                LoginDatabase.Execute("UPDATE account_banned SET active = 0 WHERE unbandate<=UNIX_TIMESTAMP() AND unbandate<>bandate");
-                ///- If the account is banned, reject the logon attempt
-                QueryResult *banresult = LoginDatabase.PQuery("SELECT bandate,unbandate FROM account_banned WHERE id = %u AND active = 1", (*result)[1].GetUInt32());
-                if(banresult)
+                if((*banresult)[0].GetUInt64() == (*banresult)[1].GetUInt64())
                 {
-                    if((*banresult)[0].GetUInt64() == (*banresult)[1].GetUInt64())
-                    {
-                        pkt << (uint8) REALM_AUTH_ACCOUNT_BANNED;
-                        sLog.outBasic("[AuthChallenge] Banned account %s tries to login!",_login.c_str ());
-                    }
-                    else
-                    {
-                        pkt << (uint8) REALM_AUTH_ACCOUNT_FREEZED;
-                        sLog.outBasic("[AuthChallenge] Temporarily banned account %s tries to login!",_login.c_str ());
-                    }
-
-                    delete banresult;
+                    pkt << (uint8) REALM_AUTH_ACCOUNT_BANNED;
+                    sLog.outBasic("[AuthChallenge] Banned account %s tries to login!",_login.c_str ());
                 }
                 else
                 {
-                    ///- Get the password from the account table, upper it, and make the SRP6 calculation
-                    std::string rI = (*result)[0].GetCppString();
-                    _SetVSFields(rI);
-
-                    b.SetRand(19 * 8);
-                    BigNumber gmod=g.ModExp(b, N);
-                    B = ((v * 3) + gmod) % N;
+                    pkt << (uint8) REALM_AUTH_ACCOUNT_FREEZED;
+                    sLog.outBasic("[AuthChallenge] Temporarily banned account %s tries to login!",_login.c_str ());
+                }
+            }
+            else
+            {
+                ///- Get the password from the account table, upper it, and make the SRP6 calculation
+                _shaPassHash = (*result)[0].GetCppString();
+                _accountId = (*result)[1].GetUInt32();
+                _SetVSFields(_shaPassHash);
 
-                    ASSERT(gmod.GetNumBytes() <= 32);
+                SRP6& srp = GetSRP6();
 
-                    BigNumber unk3;
-                    unk3.SetRand(16*8);
+                b.SetRand(19 * 8);
+                B = srp.ComputeB(v, b);
 
-                    ///- Fill the response packet with the result
-                    pkt << (uint8)REALM_AUTH_SUCCESS;
+                BigNumber unk3;
+                unk3.SetRand(16*8);
 
-                    // B may be calculated < 32B so we force minnimal length to 32B
-                    pkt.append(B.AsByteArray(32), 32);   // 32 bytes
-                    pkt << (uint8)1;
-                    pkt.append(g.AsByteArray(), 1);
-                    pkt << (uint8)32;
-                    pkt.append(N.AsByteArray(), 32);
-                    pkt.append(s.AsByteArray(), s.GetNumBytes());   // 32 bytes
-                    pkt.append(unk3.AsByteArray(), 16);
-                    pkt << (uint8)0;                    // Added in 1.12.x client branch
+                ///- Fill the response packet with the result
+                pkt << (uint8)REALM_AUTH_SUCCESS;
 
-                    uint8 secLevel = (*result)[4].GetUInt8();
-                    _accountSecurityLevel = secLevel <= SEC_GAMEMASTER3 ? AccountTypes(secLevel) : SEC_GAMEMASTER3;
+                // B may be calculated < 32B so we force minnimal length to 32B
+                pkt.append(B.AsByteArray(32), 32);   // 32 bytes
+                pkt << (uint8)1;
+                pkt.append(srp.g.AsByteArray(), 1);
+                pkt << (uint8)32;
+                pkt.append(srp.N.AsByteArray(), 32);
+                pkt.append(s.AsByteArray(), s.GetNumBytes());   // 32 bytes
+                pkt.append(unk3.AsByteArray(), 16);
+                pkt << (uint8)0;                    // Added in 1.12.x client branch
 
-                    _localizationName.resize(4);
-                    for(int i = 0; i <4; ++i)
-                        _localizationName[i] = ch->country[4-i-1];
+                uint8 secLevel = (*result)[4].GetUInt8();
+                _accountSecurityLevel = secLevel <= SEC_GAMEMASTER3 ? AccountTypes(secLevel) : SEC_GAMEMASTER3;
 
-                    sLog.outBasic("[AuthChallenge] account %s is using '%c%c%c%c' locale (%u)", _login.c_str (), ch->country[3],ch->country[2],ch->country[1],ch->country[0], GetLocaleByName(_localizationName));
-                }
+                sLog.outBasic("[AuthChallenge] account %s is using '%s' locale (%u)", _login.c_str (), _localizationName.c_str(), GetLocaleByName(_localizationName));
             }
-            delete result;
-        }
-        else                                            //no account
-        {
-            pkt<< (uint8) REALM_AUTH_NO_MATCH;
         }
     }
+    else                                            //no account
+    {
+        pkt<< (uint8) REALM_AUTH_NO_MATCH;
+    }
+
+    delete ipbanresult;
+    delete result;
+    delete banresult;
+
     SendBuf((char const*)pkt.contents(), pkt.size());
-    return true;
+
+    ///- Commands received meanwhile
+    OnRead();
 }
 
 /// Logon Proof command handler
@@ -511,10 +678,10 @@ bool AuthSocket::_HandleLogonProof()
 {
     DEBUG_LOG("Entering _HandleLogonProof");
     ///- Read the packet
-    if (ibuf.GetLength() < sizeof(sAuthLogonProof_C))
+    if (RecvLength() < sizeof(sAuthLogonProof_C))
         return false;
     sAuthLogonProof_C lp;
-    ibuf.Read((char *)&lp, sizeof(sAuthLogonProof_C));
+    Recv((char *)&lp, sizeof(sAuthLogonProof_C));
 
     ///- Check if the client has one of the expected version numbers
     bool valid_version=false;
@@ -587,73 +754,17 @@ bool AuthSocket::_HandleLogonProof()
     BigNumber A;
     A.SetBinary(lp.A, 32);
 
-    Sha1Hash sha;
-    sha.UpdateBigNumbers(&A, &B, NULL);
-    sha.Finalize();
-    BigNumber u;
-    u.SetBinary(sha.GetDigest(), 20);
-    BigNumber S = (A * (v.ModExp(u, N))).ModExp(b, N);
-
-    uint8 t[32];
-    uint8 t1[16];
-    uint8 vK[40];
-    memcpy(t, S.AsByteArray(), 32);
-    for (int i = 0; i < 16; i++)
-    {
-        t1[i] = t[i*2];
-    }
-    sha.Initialize();
-    sha.UpdateData(t1, 16);
-    sha.Finalize();
-    for (int i = 0; i < 20; i++)
-    {
-        vK[i*2] = sha.GetDigest()[i];
-    }
-    for (int i = 0; i < 16; i++)
-    {
-        t1[i] = t[i*2+1];
-    }
-    sha.Initialize();
-    sha.UpdateData(t1, 16);
-    sha.Finalize();
-    for (int i = 0; i < 20; i++)
-    {
-        vK[i*2+1] = sha.GetDigest()[i];
-    }
-    K.SetBinary(vK, 40);
-
-    uint8 hash[20];
-
-    sha.Initialize();
-    sha.UpdateBigNumbers(&N, NULL);
-    sha.Finalize();
-    memcpy(hash, sha.GetDigest(), 20);
-    sha.Initialize();
-    sha.UpdateBigNumbers(&g, NULL);
-    sha.Finalize();
-    for (int i = 0; i < 20; i++)
-    {
-        hash[i] ^= sha.GetDigest()[i];
-    }
-    BigNumber t3;
-    t3.SetBinary(hash, 20);
-
-    sha.Initialize();
-    sha.UpdateData(_login);
-    sha.Finalize();
-    uint8 t4[SHA_DIGEST_LENGTH];
-    memcpy(t4, sha.GetDigest(), SHA_DIGEST_LENGTH);
+    SRP6& srp = GetSRP6();
+    K = srp.ComputeSessionKey(A, B, v, b);
+    BigNumber M = srp.ComputeClientProof(_login, s, A, B, K);
 
-    sha.Initialize();
-    sha.UpdateBigNumbers(&t3, NULL);
-    sha.UpdateData(t4, SHA_DIGEST_LENGTH);
-    sha.UpdateBigNumbers(&s, &A, &B, &K, NULL);
-    sha.Finalize();
-    BigNumber M;
-    M.SetBinary(sha.GetDigest(), 20);
+    // M is shorter than 20 bytes when the digest ends with a zero byte
+    uint8 M1[SHA_DIGEST_LENGTH];
+    memset(M1, 0, SHA_DIGEST_LENGTH);
+    memcpy(M1, M.AsByteArray(), std::min(M.GetNumBytes(), SHA_DIGEST_LENGTH));
 
     ///- Check if SRP6 results match (password is correct), else send an error
-    if (!memcmp(M.AsByteArray(), lp.M1, 20))
+    if (!memcmp(M1, lp.M1, SHA_DIGEST_LENGTH))
     {
         sLog.outBasic("User '%s' successfully authenticated", _login.c_str());
 
@@ -664,12 +775,8 @@ bool AuthSocket::_HandleLogonProof()
         OPENSSL_free((void*)K_hex);
 
         ///- Finish SRP6 and send the final result to the client
-        sha.Initialize();
-        sha.UpdateBigNumbers(&A, &M, &K, NULL);
-        sha.Finalize();
-
         sAuthLogonProof_S proof;
-        memcpy(proof.M2, sha.GetDigest(), 20);
+        srp.ComputeServerProof(A, M, K, proof.M2);
         proof.cmd = AUTH_LOGON_PROOF;
         proof.error = 0;
         proof.unk1 = 0x00800000;
@@ -690,39 +797,9 @@ bool AuthSocket::_HandleLogonProof()
         uint32 MaxWrongPassCount = sConfig.GetIntDefault("WrongPass.MaxCount", 0);
         if(MaxWrongPassCount > 0)
         {
-            //Increment number of failed logins by one and if it reaches the limit temporarily ban that account or IP
-            LoginDatabase.PExecute("UPDATE account SET failed_logins = failed_logins + 1 WHERE username = '%s'",_safelogin.c_str());
-
-            if(QueryResult *loginfail = LoginDatabase.PQuery("SELECT id, failed_logins FROM account WHERE username = '%s'", _safelogin.c_str()))
-            {
-                Field* fields = loginfail->Fetch();
-                uint32 failed_logins = fields[1].GetUInt32();
-
-                if( failed_logins >= MaxWrongPassCount )
-                {
-                    uint32 WrongPassBanTime = sConfig.GetIntDefault("WrongPass.BanTime", 600);
-                    bool WrongPassBanType = sConfig.GetBoolDefault("WrongPass.BanType", false);
-
-                    if(WrongPassBanType)
-                    {
-                        uint32 acc_id = fields[0].GetUInt32();
-                        LoginDatabase.PExecute("INSERT INTO account_banned VALUES ('%u',UNIX_TIMESTAMP(),UNIX_TIMESTAMP()+'%u','Trinity realmd','Failed login autoban',1)",
-                            acc_id, WrongPassBanTime);
-                        sLog.outBasic("[AuthChallenge] account %s got banned for '%u' seconds because it failed to authenticate '%u' times",
-                            _login.c_str(), WrongPassBanTime, failed_logins);
-                    }
-                    else
-                    {
-                        std::string current_ip = GetRemoteAddress();
-                        LoginDatabase.escape_string(current_ip);
-                        LoginDatabase.PExecute("INSERT INTO ip_banned VALUES ('%s',UNIX_TIMESTAMP(),UNIX_TIMESTAMP()+'%u','Trinity realmd','Failed login autoban')",
-                            current_ip.c_str(), WrongPassBanTime);
-                        sLog.outBasic("[AuthChallenge] IP %s got banned for '%u' seconds because account %s failed to authenticate '%u' times",
-                            current_ip.c_str(), WrongPassBanTime, _login.c_str(), failed_logins);
-                    }
-                }
-                delete loginfail;
-            }
+            //Count the failed login and ban the account or IP once the limit is reached, see AuthQueryHandler
+            LoginDatabase.AsyncPQuery(&authQueryHandler, &AuthQueryHandler::HandleWrongPassCallback, _login, GetRemoteAddress(),
+                "SELECT id, failed_logins FROM account WHERE username = '%s'", _safelogin.c_str());
         }
     }
     return true;
@@ -732,34 +809,36 @@ bool AuthSocket::_HandleLogonProof()
 bool AuthSocket::_HandleReconnectChallenge()
 {
     DEBUG_LOG("Entering _HandleReconnectChallenge");
-    if (ibuf.GetLength() < sizeof(sAuthLogonChallenge_C))
+    if (RecvLength() < sizeof(sAuthLogonChallenge_C))
         return false;
 
-    ///- Read the first 4 bytes (header) to get the length of the remaining of the packet
+    ///- Peek the first 4 bytes (header) to get the length of the remaining of the packet,
+    ///- the header stays in the input buffer until the whole packet is there
     std::vector<uint8> buf;
     buf.resize(4);
 
-    ibuf.Read((char *)&buf[0], 4);
+    RecvSoft((char *)&buf[0], 4);
 
     EndianConvert(*((uint16*)(buf[0])));
     uint16 remaining = ((sAuthLogonChallenge_C *)&buf[0])->size;
     DEBUG_LOG("[ReconnectChallenge] got header, body is %#04x bytes", remaining);
 
-    if ((remaining < sizeof(sAuthLogonChallenge_C) - buf.size()) || (ibuf.GetLength() < remaining))
+    if ((remaining < sizeof(sAuthLogonChallenge_C) - buf.size()) || (RecvLength() < buf.size() + remaining))
         return false;
 
+    RecvSkip(buf.size());
+
     //No big fear of memory outage (size is int16, i.e. < 65536)
     buf.resize(remaining + buf.size() + 1);
     buf[buf.size() - 1] = 0;
     sAuthLogonChallenge_C *ch = (sAuthLogonChallenge_C*)&buf[0];
 
     ///- Read the remaining of the packet
-    ibuf.Read((char *)&buf[4], remaining);
+    Recv((char *)&buf[4], remaining);
     DEBUG_LOG("[ReconnectChallenge] got full packet, %#04x bytes", ch->size);
     DEBUG_LOG("[ReconnectChallenge] name(%d): '%s'", ch->I_len, ch->I);
 
     _login = (const char*)ch->I;
-    _safelogin = _login;
     
     _os = (const char*)ch->os;
 
@@ -769,18 +848,38 @@ bool AuthSocket::_HandleReconnectChallenge()
     // Restore string order as its byte order is reversed
     std::reverse(_os.begin(), _os.end());
 
-    QueryResult *result = LoginDatabase.PQuery ("SELECT sessionkey FROM account WHERE username = '%s'", _safelogin.c_str ());
+    ///- Get the session key, the answer is sent by _HandleReconnectChallengeResult
+    _safelogin = _login;
+    LoginDatabase.escape_string(_safelogin);
+
+    if (!LoginDatabase.AsyncPQuery(&authQueryHandler, &AuthQueryHandler::HandleReconnectChallengeCallback, _sessionId,
+        "SELECT sessionkey,id,sha_pass_hash FROM account WHERE username = '%s'", _safelogin.c_str ()))
+    {
+        CloseSocket();
+        return false;
+    }
+
+    _queryPending = true;
+    return true;
+}
+
+/// Reconnect Challenge answer, once the session key is loaded
+void AuthSocket::_HandleReconnectChallengeResult(QueryResult* result)
+{
+    _queryPending = false;
 
     // Stop if the account is not found
     if (!result)
     {
         sLog.outError("[ERROR] user %s tried to login and we cannot find his session key in the database.", _login.c_str());
-        SetCloseAndDelete();
-        return false;
+        CloseSocket();
+        return;
     }
 
     Field* fields = result->Fetch ();
     K.SetHexStr (fields[0].GetString ());
+    _accountId = fields[1].GetUInt32();
+    _shaPassHash = fields[2].GetCppString();
     delete result;
 
     ///- Sending response
@@ -791,7 +890,9 @@ bool AuthSocket::_HandleReconnectChallenge()
     pkt.append(_reconnectProof.AsByteBuffer());             // 16 bytes random
     pkt << (uint64) 0x00 << (uint64) 0x00;                  // 16 bytes zeros
     SendBuf((char const*)pkt.contents(), pkt.size());
-    return true;
+
+    ///- Commands received meanwhile
+    OnRead();
 }
 
 /// Reconnect Proof command handler
@@ -799,12 +900,12 @@ bool AuthSocket::_HandleReconnectProof()
 {
     DEBUG_LOG("Entering _HandleReconnectProof");
     ///- Read the packet
-    if (ibuf.GetLength() < sizeof(sAuthReconnectProof_C))
+    if (RecvLength() < sizeof(sAuthReconnectProof_C))
         return false;
     if (_login.empty() || !_reconnectProof.GetNumBytes() || !K.GetNumBytes())
         return false;
     sAuthReconnectProof_C lp;
-    ibuf.Read((char *)&lp, sizeof(sAuthReconnectProof_C));
+    Recv((char *)&lp, sizeof(sAuthReconnectProof_C));
 
     BigNumber t1;
     t1.SetBinary(lp.R1, 16);
@@ -832,7 +933,7 @@ bool AuthSocket::_HandleReconnectProof()
     else
     {
         sLog.outError("[ERROR] user %s tried to login, but session invalid.", _login.c_str());
-        SetCloseAndDelete();
+        CloseSocket();
         return false;
     }
 }
@@ -841,25 +942,41 @@ bool AuthSocket::_HandleReconnectProof()
 bool AuthSocket::_HandleRealmList()
 {
     DEBUG_LOG("Entering _HandleRealmList");
-    if (ibuf.GetLength() < 5)
+    if (RecvLength() < 5)
         return false;
 
-    ibuf.Remove(5);
-
-    ///- Get the user id (else close the connection)
-    // No SQL injection (escaped user name)
+    RecvSkip(5);
 
-    QueryResult *result = LoginDatabase.PQuery("SELECT id,sha_pass_hash FROM account WHERE username = '%s'",_safelogin.c_str());
-    if(!result)
+    ///- Get the number of characters of the account on each realm, the answer is sent by _HandleRealmListResult
+    // account id and password hash were loaded by the logon or reconnect challenge
+    if (!LoginDatabase.AsyncPQuery(&authQueryHandler, &AuthQueryHandler::HandleRealmListCallback, _sessionId,
+        "SELECT realmid,numchars FROM realmcharacters WHERE acctid = '%u'", _accountId))
     {
-        sLog.outError("[ERROR] user %s tried to login and we cannot find him in the database.",_login.c_str());
-        SetCloseAndDelete();
+        CloseSocket();
         return false;
     }
 
-    uint32 id = (*result)[0].GetUInt32();
-    std::string rI = (*result)[1].GetCppString();
-    delete result;
+    _queryPending = true;
+    return true;
+}
+
+/// %Realm List answer, once the character counts are loaded
+void AuthSocket::_HandleRealmListResult(QueryResult* result)
+{
+    _queryPending = false;
+
+    std::map<uint32, uint8> charactersByRealm;
+    if (result)
+    {
+        do
+        {
+            Field *fields = result->Fetch();
+            charactersByRealm[fields[0].GetUInt32()] = fields[1].GetUInt8();
+        }
+        while (result->NextRow());
+
+        delete result;
+    }
 
     ///- Update realm list if need
     m_realmList.UpdateIfNeed();
@@ -871,18 +988,8 @@ bool AuthSocket::_HandleRealmList()
     RealmList::RealmMap::const_iterator i;
     for( i = m_realmList.begin(); i != m_realmList.end(); i++ )
     {
-        uint8 AmountOfCharacters;
-
-        // No SQL injection. id of realm is controlled by the database.
-        result = LoginDatabase.PQuery( "SELECT numchars FROM realmcharacters WHERE realmid = '%d' AND acctid='%u'",i->second.m_ID,id);
-        if( result )
-        {
-            Field *fields = result->Fetch();
-            AmountOfCharacters = fields[0].GetUInt8();
-            delete result;
-        }
-        else
-            AmountOfCharacters = 0;
+        std::map<uint32, uint8>::const_iterator chars = charactersByRealm.find(i->second.m_ID);
+        uint8 AmountOfCharacters = chars != charactersByRealm.end() ? chars->second : 0;
 
         uint8 lock = (i->second.allowedSecurityLevel > _accountSecurityLevel) ? 1 : 0;
 
@@ -907,8 +1014,10 @@ bool AuthSocket::_HandleRealmList()
     SendBuf((char const*)hdr.contents(), hdr.size());
 
     // Set check field before possible relogin to realm
-    _SetVSFields(rI);
-    return true;
+    _SetVSFields(_shaPassHash);
+
+    ///- Commands received meanwhile
+    OnRead();
 }
 
 /// Resume patch transfer
@@ -916,7 +1025,7 @@ bool AuthSocket::_HandleXferResume()
 {
     DEBUG_LOG("Entering _HandleXferResume");
     ///- Check packet length and patch existence
-    if (ibuf.GetLength()<9 || !pPatch)
+    if (RecvLength()<9 || !pPatch)
     {
         sLog.outError("Error while resuming patch transfer (wrong packet)");
         return false;
@@ -924,8 +1033,8 @@ bool AuthSocket::_HandleXferResume()
 
     ///- Launch a PatcherRunnable thread starting at given patch file offset
     uint64 start;
-    ibuf.Remove(1);
-    ibuf.Read((char*)&start,sizeof(start));
+    RecvSkip(1);
+    Recv((char*)&start,sizeof(start));
     fseek(pPatch,start,0);
 
     ZThread::Thread u(new PatcherRunnable(this));
@@ -938,10 +1047,10 @@ bool AuthSocket::_HandleXferCancel()
     DEBUG_LOG("Entering _HandleXferCancel");
 
     ///- Close and delete the socket
-    ibuf.Remove(1);                                         //clear input buffer
+    RecvSkip(1);                                         //clear input buffer
 
     //ZThread::Thread::sleep(15);
-    SetCloseAndDelete();
+    CloseSocket();
 
     return true;
 }
@@ -959,7 +1068,7 @@ bool AuthSocket::_HandleXferAccept()
     }
 
     ///- Launch a PatcherRunnable thread, starting at the begining of the patch file
-    ibuf.Remove(1);                                         //clear input buffer
+    RecvSkip(1);                                         //clear input buffer
     fseek(pPatch,0,0);
 
     ZThread::Thread u(new PatcherRunnable(this));
@@ -970,7 +1079,8 @@ bool AuthSocket::_HandleXferAccept()
 /// Check if there is lag on the connection to the client
 bool AuthSocket::IsLag()
 {
-    return (TCP_BUFSIZE_READ-GetOutputLength()< 2*ChunkSize);
+    // keep a few chunks queued at most, the rest waits in the patch file
+    return GetOutputLength() > 4*ChunkSize;
 }
 
 PatcherRunnable::PatcherRunnable(class AuthSocket * as)
@@ -985,10 +1095,10 @@ void PatcherRunnable::run()
     XFER_DATA_STRUCT xfdata;
     xfdata.opcode = XFER_DATA;
 
-    while(!feof(mySocket->pPatch) && mySocket->Ready())
+    while(!feof(mySocket->pPatch) && !mySocket->IsClosed())
     {
         ///- Wait until output buffer is reasonably empty
-        while(mySocket->Ready() && mySocket->IsLag())
+        while(!mySocket->IsClosed() && mySocket->IsLag())
         {
             ZThread::Thread::sleep(1);
         }
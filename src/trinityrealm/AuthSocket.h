@@ -25,27 +25,37 @@
 #ifndef _AUTHSOCKET_H
 #define _AUTHSOCKET_H
 
+#include "RealmSocket.h"
 #include "Common.h"
 #include "Auth/BigNumber.h"
-#include "sockets/TcpSocket.h"
-#include "sockets/SocketHandler.h"
-#include "sockets/ListenSocket.h"
-#include "sockets/Utility.h"
-#include "sockets/Parse.h"
-#include "sockets/Socket.h"
+#include "Utilities/UnorderedMap.h"
 #include "zthread/Mutex.h"
 
-/// Handle login commands
-class AuthSocket: public TcpSocket
+class QueryResult;
+class SQLQueryHolder;
+
+/**
+ * Handle login commands.
+ * Commands needing the login database (logon and reconnect challenge, realm list)
+ * issue their queries asynchronously and return. Until the answer is sent from the
+ * query callback the following commands stay in the input buffer, so a slow query
+ * only delays its own connection. Callbacks find their socket with FindSession,
+ * a socket closed in between is simply not found anymore.
+ */
+class AuthSocket: public RealmSocket
 {
     public:
+        /// Declare the acceptor for this class
+        typedef ACE_Acceptor< AuthSocket, ACE_SOCK_ACCEPTOR > Acceptor;
+
         const static int s_BYTE_SIZE = 32;
 
-        AuthSocket(ISocketHandler& h);
+        AuthSocket();
         ~AuthSocket();
 
         void OnAccept();
         void OnRead();
+        void OnClose();
 
         bool _HandleLogonChallenge();
         bool _HandleLogonProof();
@@ -58,23 +68,41 @@ class AuthSocket: public TcpSocket
         bool _HandleXferCancel();
         bool _HandleXferAccept();
 
+        /// Login database answers, called from the result queue of the main thread
+        void _HandleLogonChallengeResult(SQLQueryHolder* holder);
+        void _HandleReconnectChallengeResult(QueryResult* result);
+        void _HandleRealmListResult(QueryResult* result);
+
         void _SetVSFields(const std::string& rI);
+        void _WriteVSFields();
 
         FILE *pPatch;
         ZThread::Mutex patcherLock;
         bool IsLag();
 
+        uint32 GetSessionId() const { return _sessionId; }
+        /// Open connection with this id, NULL once it is closed
+        static AuthSocket* FindSession(uint32 sessionId);
+
     private:
+        typedef UNORDERED_MAP<uint32, AuthSocket*> SessionMap;
+
+        static SessionMap s_sessions;                       // only used by the main thread
+        static uint32 s_nextSessionId;
 
-        BigNumber N, s, g, v;
+        BigNumber s, v;
         BigNumber b, B;
         BigNumber K;
         BigNumber _reconnectProof;
 
         bool _authed;
+        bool _queryPending;                                 // waiting for a login database answer
+        uint32 _sessionId;
 
         std::string _login;
         std::string _safelogin;
+        uint32 _accountId;
+        std::string _shaPassHash;
 
         // Since GetLocaleByName() is _NOT_ bijective, we have to store the locale as a string. Otherwise we can't differ
         // between enUS and enGB, which is important for the patch system
@@ -28,12 +28,17 @@
 
 #include "Config/ConfigEnv.h"
 #include "Log.h"
-#include "sockets/ListenSocket.h"
 #include "AuthSocket.h"
 #include "SystemConfig.h"
 #include "revision.h"
 #include "Util.h"
-#include <omp.h>
+#include "Timer.h"
+
+#include <ace/Reactor.h>
+#include <ace/Reactor_Impl.h>
+#include <ace/TP_Reactor.h>
+#include <ace/Dev_Poll_Reactor.h>
+#include <ace/INET_Addr.h>
 
 // Format is YYYYMMDDRR where RR is the change in the conf file
 // for that day.
@@ -45,6 +50,9 @@
 # define _TRINITY_REALM_CONFIG  "trinityrealm.conf"
 #endif //_TRINITY_REALM_CONFIG
 
+// interval of the expired ban cleanup, in milliseconds
+#define BAN_EXPIRY_INTERVAL     (MINUTE * IN_MILLISECONDS)
+
 bool StartDB(std::string &dbstring);
 void UnhookSignals();
 void HookSignals();
@@ -136,43 +144,71 @@ extern int main(int argc, char **argv)
         return 1;
     }
 
-    ///- Launch the listening network socket
-    port_t rmport = sConfig.GetIntDefault("RealmServerPort", DEFAULT_REALMSERVER_PORT);
+    ///- Answers of the asynchronous login queries are handled by the main loop
+    SQLResultQueue* resultQueue = new SQLResultQueue;
+    LoginDatabase.SetResultQueue(resultQueue);
+
+    ///- Launch the listening network socket, all connections are handled by the reactor of this thread
+    ACE_Reactor_Impl* imp = 0;
+
+#if defined (ACE_HAS_EVENT_POLL) || defined (ACE_HAS_DEV_POLL)
+    imp = new ACE_Dev_Poll_Reactor();
+    imp->max_notify_iterations(128);
+    imp->restart(1);
+#else
+    imp = new ACE_TP_Reactor();
+    imp->max_notify_iterations(128);
+#endif
+
+    ACE_Reactor* reactor = new ACE_Reactor(imp, 1);
+
+    uint16 rmport = sConfig.GetIntDefault("RealmServerPort", DEFAULT_REALMSERVER_PORT);
     std::string bind_ip = sConfig.GetStringDefault("BindIP", "0.0.0.0");
 
-    SocketHandler h;
-    ListenSocket<AuthSocket> authListenSocket(h);
-    if (authListenSocket.Bind(bind_ip.c_str(),rmport)) {
+    AuthSocket::Acceptor acceptor;
+    ACE_INET_Addr bind_addr(rmport, bind_ip.c_str());
+    if (acceptor.open(bind_addr, reactor, ACE_NONBLOCK) == -1) {
         sLog.outError("Trinity realm can not bind to %s:%d",bind_ip.c_str(), rmport);
         return 1;
     }
 
-    h.Add(&authListenSocket);
-
     ///- Catch termination signals
     HookSignals();
 
-    // maximum counter for next ping
-    uint32 numLoops = (sConfig.GetIntDefault("MaxPingTime", 30) * (MINUTE * 1000000 / 100000));
-    uint32 loopCounter = 0;
+    // maximum interval before next ping
+    uint32 pingInterval = sConfig.GetIntDefault("MaxPingTime", 30) * MINUTE * IN_MILLISECONDS;
+    uint32 lastPing = getMSTime();
+    uint32 lastBanExpiry = 0;
 
     ///- Wait for termination signal
-    omp_set_num_threads(4);
-
-    //while (!stopEvent) {
-#pragma omp parallel for shared(loopCounter)
-    for ( ; !stopEvent; ) {
-        h.Select(0, 100000);
+    while (!stopEvent) {
+        // short timeout, query answers are only handled between two reactor runs
+        ACE_Time_Value interval(0, 10000);
+        reactor->handle_events(interval);
+
+        resultQueue->Update();
+
+        if (GetMSTimeDiffToNow(lastBanExpiry) >= BAN_EXPIRY_INTERVAL) {
+            lastBanExpiry = getMSTime();
+            // logon lookups skip expired bans themselves, this only keeps the tables tidy
+            LoginDatabase.Execute("DELETE FROM ip_banned WHERE unbandate<=UNIX_TIMESTAMP() AND unbandate<>bandate");
+            LoginDatabase.Execute("UPDATE account_banned SET active = 0 WHERE unbandate<=UNIX_TIMESTAMP() AND unbandate<>bandate");
+        }
 
-        if ((++loopCounter) == numLoops) {
-            loopCounter = 0;
+        if (GetMSTimeDiffToNow(lastPing) >= pingInterval) {
+            lastPing = getMSTime();
             sLog.outDetail("Ping MySQL to keep connection alive");
             delete LoginDatabase.Query("SELECT 1 FROM realmlist LIMIT 1");
         }
     }
 
+    acceptor.close();
+    reactor->close();
+    delete reactor;
+
     ///- Wait for the delay thread to exit
     LoginDatabase.Close();
+    delete resultQueue;
 
     ///- Remove signal handling before leaving
     UnhookSignals();
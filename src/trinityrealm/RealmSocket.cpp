@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** \file
+    \ingroup realmd
+*/
+
+#include "RealmSocket.h"
+#include "Log.h"
+
+#include <ace/INET_Addr.h>
+#include <ace/Reactor.h>
+#include <ace/OS_NS_string.h>
+#include <ace/os_include/netinet/os_tcp.h>
+
+#define REALMSOCKET_INPUT_SIZE  4096
+// logon challenges carry a 16 bits size, nothing legitimate is bigger
+#define REALMSOCKET_INPUT_MAX   (0x10000 + 0x100)
+#define REALMSOCKET_OUTPUT_SIZE 4096
+
+static ssize_t SendNoSignal (ACE_SOCK_Stream& stream, const char* buf, size_t len)
+{
+#ifdef MSG_NOSIGNAL
+    return stream.send (buf, len, MSG_NOSIGNAL);
+#else
+    return stream.send (buf, len);
+#endif // MSG_NOSIGNAL
+}
+
+RealmSocket::RealmSocket (void) :
+    RealmHandler (),
+    m_Port (0),
+    m_InputBuffer (REALMSOCKET_INPUT_SIZE),
+    m_OutBuffer (REALMSOCKET_OUTPUT_SIZE),
+    m_OutActive (false),
+    m_CloseRequested (false),
+    m_Closed (false)
+{
+    reference_counting_policy ().value (ACE_Event_Handler::Reference_Counting_Policy::ENABLED);
+}
+
+RealmSocket::~RealmSocket (void)
+{
+    peer ().close ();
+}
+
+size_t RealmSocket::RecvLength (void) const
+{
+    return m_InputBuffer.length ();
+}
+
+bool RealmSocket::Recv (char* buf, size_t len)
+{
+    if (!RecvSoft (buf, len))
+        return false;
+
+    m_InputBuffer.rd_ptr (len);
+    return true;
+}
+
+bool RealmSocket::RecvSoft (char* buf, size_t len) const
+{
+    if (m_InputBuffer.length () < len)
+        return false;
+
+    ACE_OS::memcpy (buf, m_InputBuffer.rd_ptr (), len);
+    return true;
+}
+
+void RealmSocket::RecvSkip (size_t len)
+{
+    m_InputBuffer.rd_ptr (std::min (len, m_InputBuffer.length ()));
+}
+
+bool RealmSocket::SendBuf (const char* buf, size_t len)
+{
+    ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, false);
+
+    if (m_Closed || m_CloseRequested)
+        return false;
+
+    // nothing queued, try to send directly
+    if (m_OutBuffer.length () == 0)
+    {
+        ssize_t n = SendNoSignal (peer (), buf, len);
+
+        // hard errors are reported by handle_output
+        if (n < 0)
+            n = 0;
+
+        if (size_t (n) == len)
+            return true;
+
+        buf += n;
+        len -= n;
+    }
+
+    AppendOutput (buf, len);
+
+    return schedule_wakeup_output (Guard) != -1;
+}
+
+size_t RealmSocket::GetOutputLength (void) const
+{
+    ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, 0);
+
+    return m_OutBuffer.length ();
+}
+
+void RealmSocket::CloseSocket (void)
+{
+    ACE_GUARD (LockType, Guard, m_OutBufferLock);
+
+    if (m_Closed || m_CloseRequested)
+        return;
+
+    m_CloseRequested = true;
+
+    // handle_output closes the connection once the output buffer is empty
+    schedule_wakeup_output (Guard);
+}
+
+bool RealmSocket::IsClosed (void) const
+{
+    ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, true);
+
+    return m_Closed || m_CloseRequested;
+}
+
+const std::string& RealmSocket::GetRemoteAddress (void) const
+{
+    return m_Address;
+}
+
+uint16 RealmSocket::GetRemotePort (void) const
+{
+    return m_Port;
+}
+
+int RealmSocket::open (void*)
+{
+    ACE_INET_Addr remote_addr;
+
+    if (peer ().get_remote_addr (remote_addr) == -1)
+    {
+        sLog.outError ("RealmSocket::open: peer ().get_remote_addr errno = %s", ACE_OS::strerror (errno));
+        return -1;
+    }
+
+    m_Address = remote_addr.get_host_addr ();
+    m_Port = remote_addr.get_port_number ();
+
+    // commands and answers are tiny, don't let Nagle delay the handshake
+    int ndoption = 1;
+    peer ().set_option (ACE_IPPROTO_TCP, TCP_NODELAY, (void*) &ndoption, sizeof (ndoption));
+
+    // Register with ACE Reactor
+    if (reactor ()->register_handler (this, ACE_Event_Handler::READ_MASK) == -1)
+    {
+        sLog.outError ("RealmSocket::open: unable to register client handler errno = %s", ACE_OS::strerror (errno));
+        return -1;
+    }
+
+    // reactor takes care of the socket from now on
+    remove_reference ();
+
+    OnAccept ();
+
+    return 0;
+}
+
+int RealmSocket::close (int)
+{
+    shutdown ();
+
+    m_Closed = true;
+
+    remove_reference ();
+
+    return 0;
+}
+
+int RealmSocket::handle_input (ACE_HANDLE)
+{
+    if (IsClosed ())
+        return m_Closed ? -1 : 0;
+
+    for (;;)
+    {
+        if (m_InputBuffer.length () == 0)
+            m_InputBuffer.reset ();
+        else if (m_InputBuffer.space () == 0)
+            m_InputBuffer.crunch ();
+
+        if (m_InputBuffer.space () == 0)
+        {
+            if (m_InputBuffer.size () >= REALMSOCKET_INPUT_MAX)
+            {
+                sLog.outError ("RealmSocket::handle_input: %s sent an oversized command, closing connection", m_Address.c_str ());
+                return -1;
+            }
+
+            m_InputBuffer.size (std::min (m_InputBuffer.size () * 2, size_t (REALMSOCKET_INPUT_MAX)));
+        }
+
+        const size_t space = m_InputBuffer.space ();
+        const ssize_t n = peer ().recv (m_InputBuffer.wr_ptr (), space);
+
+        if (n < 0)
+        {
+            if (errno == EWOULDBLOCK || errno == EAGAIN)
+                return 0;
+
+            DEBUG_LOG ("RealmSocket::handle_input: Peer error closing connection errno = %s", ACE_OS::strerror (errno));
+            return -1;
+        }
+        else if (n == 0)
+        {
+            DEBUG_LOG ("RealmSocket::handle_input: Peer has closed connection");
+            return -1;
+        }
+
+        m_InputBuffer.wr_ptr (n);
+
+        OnRead ();
+
+        if (IsClosed ())
+            return 0;
+
+        // a short read emptied the kernel buffer, the reactor reports new data
+        if (size_t (n) < space)
+            return 0;
+    }
+
+    ACE_NOTREACHED (return -1);
+}
+
+int RealmSocket::handle_output (ACE_HANDLE)
+{
+    ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, -1);
+
+    if (m_Closed)
+        return -1;
+
+    if (m_OutBuffer.length () == 0)
+    {
+        if (m_CloseRequested)
+            return -1;
+
+        return cancel_wakeup_output (Guard);
+    }
+
+    const ssize_t n = SendNoSignal (peer (), m_OutBuffer.rd_ptr (), m_OutBuffer.length ());
+
+    if (n == 0)
+        return -1;
+    else if (n == -1)
+    {
+        if (errno == EWOULDBLOCK || errno == EAGAIN)
+            return schedule_wakeup_output (Guard);
+
+        return -1;
+    }
+
+    m_OutBuffer.rd_ptr (n);
+
+    if (m_OutBuffer.length () == 0)
+    {
+        m_OutBuffer.reset ();
+
+        if (m_CloseRequested)
+            return -1;
+
+        return cancel_wakeup_output (Guard);
+    }
+
+    // move the data to the base of the buffer
+    m_OutBuffer.crunch ();
+
+    return schedule_wakeup_output (Guard);
+}
+
+int RealmSocket::handle_close (ACE_HANDLE, ACE_Reactor_Mask)
+{
+    // Critical section
+    {
+        ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, -1);
+
+        if (m_Closed)
+            return 0;
+
+        m_Closed = true;
+    }
+
+    OnClose ();
+
+    reactor ()->remove_handler (this, ACE_Event_Handler::DONT_CALL | ACE_Event_Handler::ALL_EVENTS_MASK);
+
+    return 0;
+}
+
+void RealmSocket::AppendOutput (const char* buf, size_t len)
+{
+    if (m_OutBuffer.space () < len)
+        m_OutBuffer.crunch ();
+
+    if (m_OutBuffer.space () < len)
+        m_OutBuffer.size (m_OutBuffer.length () + std::max (len, m_OutBuffer.size ()));
+
+    m_OutBuffer.copy (buf, len);
+}
+
+int RealmSocket::cancel_wakeup_output (GuardType& g)
+{
+    if (!m_OutActive)
+        return 0;
+
+    m_OutActive = false;
+
+    g.release ();
+
+    if (reactor ()->cancel_wakeup
+        (this, ACE_Event_Handler::WRITE_MASK) == -1)
+    {
+        // would be good to store errno from reactor with errno guard
+        sLog.outError ("RealmSocket::cancel_wakeup_output");
+        return -1;
+    }
+
+    return 0;
+}
+
+int RealmSocket::schedule_wakeup_output (GuardType& g)
+{
+    if (m_OutActive)
+        return 0;
+
+    m_OutActive = true;
+
+    g.release ();
+
+    if (reactor ()->schedule_wakeup
+        (this, ACE_Event_Handler::WRITE_MASK) == -1)
+    {
+        sLog.outError ("RealmSocket::schedule_wakeup_output");
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2005-2008 MaNGOS <http://www.mangosproject.org/>
+ *
+ * Copyright (C) 2008 Trinity <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/// \addtogroup realmd
+/// @{
+/// \file
+
+#ifndef _REALMSOCKET_H
+#define _REALMSOCKET_H
+
+#include <ace/Basic_Types.h>
+#include <ace/Synch_Traits.h>
+#include <ace/Svc_Handler.h>
+#include <ace/SOCK_Stream.h>
+#include <ace/SOCK_Acceptor.h>
+#include <ace/Acceptor.h>
+#include <ace/Thread_Mutex.h>
+#include <ace/Guard_T.h>
+#include <ace/Message_Block.h>
+
+#include "Common.h"
+
+/// Handler that can communicate over stream sockets.
+typedef ACE_Svc_Handler<ACE_SOCK_STREAM, ACE_NULL_SYNCH> RealmHandler;
+
+/**
+ * RealmSocket.
+ *
+ * Non blocking client connection of the realm daemon, all connections
+ * are driven by the reactor of the main thread (epoll based
+ * ACE_Dev_Poll_Reactor where available).
+ * The class uses reference counting, once opened the socket is owned
+ * by the reactor and deleted when it is removed from it.
+ *
+ * For input the class uses one buffer (4K usually, grown for bigger
+ * commands). handle_input reads until the kernel buffer is empty and
+ * calls OnRead (), the derived class consumes complete commands with
+ * Recv/RecvSoft/RecvSkip and leaves incomplete ones in the buffer.
+ *
+ * For output SendBuf writes directly to the socket when nothing is
+ * pending, what can not be written is appended to the output buffer
+ * and sent when the socket becomes writable. SendBuf may be called
+ * from other threads (patch transfer).
+ *
+ * CloseSocket closes the connection once the pending output is sent.
+ */
+class RealmSocket : public RealmHandler
+{
+    public:
+        /// Mutex type used for various synchronizations.
+        typedef ACE_Thread_Mutex LockType;
+        typedef ACE_Guard<LockType> GuardType;
+
+        RealmSocket (void);
+        virtual ~RealmSocket (void);
+
+        /// Number of received bytes not consumed yet.
+        size_t RecvLength (void) const;
+
+        /// Consume len bytes of the input, false if less are available.
+        bool Recv (char* buf, size_t len);
+
+        /// Copy len bytes of the input without consuming them, false if less are available.
+        bool RecvSoft (char* buf, size_t len) const;
+
+        /// Drop len bytes of the input.
+        void RecvSkip (size_t len);
+
+        /// Send data on the socket, this function is reentrant.
+        /// @return false if the socket is closed
+        bool SendBuf (const char* buf, size_t len);
+
+        /// Number of bytes waiting for the socket to become writable.
+        size_t GetOutputLength (void) const;
+
+        /// Close the connection when the pending output is sent.
+        void CloseSocket (void);
+
+        /// Check if socket is closed or about to be.
+        bool IsClosed (void) const;
+
+        /// Get address of connected peer.
+        const std::string& GetRemoteAddress (void) const;
+        uint16 GetRemotePort (void) const;
+
+        /// Called on open from ACE_Acceptor.
+        virtual int open (void*);
+
+        /// Called on failures inside of the acceptor, don't call from your code.
+        virtual int close (int);
+
+        /// Called when we can read from the socket.
+        virtual int handle_input (ACE_HANDLE = ACE_INVALID_HANDLE);
+
+        /// Called when the socket can write.
+        virtual int handle_output (ACE_HANDLE = ACE_INVALID_HANDLE);
+
+        /// Called when connection is closed or error happens.
+        virtual int handle_close (ACE_HANDLE = ACE_INVALID_HANDLE,
+            ACE_Reactor_Mask = ACE_Event_Handler::ALL_EVENTS_MASK);
+
+    protected:
+        /// Connection accepted and registered in the reactor.
+        virtual void OnAccept (void) {}
+
+        /// New data is in the input buffer.
+        virtual void OnRead (void) = 0;
+
+        /// Connection is closed, the socket is deleted after this call.
+        virtual void OnClose (void) {}
+
+    private:
+        /// Append data to the output buffer, m_OutBufferLock must be held.
+        void AppendOutput (const char* buf, size_t len);
+
+        /// Helper functions for scheduling output, called with m_OutBufferLock held.
+        int cancel_wakeup_output (GuardType& g);
+        int schedule_wakeup_output (GuardType& g);
+
+        /// Address of the remote peer.
+        std::string m_Address;
+        uint16 m_Port;
+
+        /// Input buffer, only touched by the reactor thread.
+        ACE_Message_Block m_InputBuffer;
+
+        /// Mutex for protecting output related data.
+        mutable LockType m_OutBufferLock;
+
+        /// Buffer used for writing output.
+        ACE_Message_Block m_OutBuffer;
+
+        /// True if the socket is registered with the reactor for output.
+        bool m_OutActive;
+
+        /// Close requested, the connection is closed when the output buffer is empty.
+        bool m_CloseRequested;
+
+        /// Socket closed, no more data is read or sent.
+        bool m_Closed;
+};
+
+#endif
+/// @}